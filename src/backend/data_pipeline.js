@@ -532,6 +532,293 @@ app.get('/api/status', (req, res) => {
   });
 });
 
+// ===========================================
+// LORAWAN UPLINK DECODING
+// ===========================================
+
+// Compact sensor codec - must match src/lorawan/sensor_codec.h
+const SENSOR_CODEC_VERSION = 1;
+const SENSOR_CODEC_PORT = 6;
+
+// Quantisation table (version 1): minimum, step, keyframe bits, delta class bits
+// (deltaBits [0, 0, 0] = raw value when changed)
+const SENSOR_CODEC_FIELDS = [
+  { name: 'temperature',    minimum: -40,  step: 0.1, keyBits: 11, deltaBits: [3, 5, 8] },
+  { name: 'humidity',       minimum: 0,    step: 0.5, keyBits: 8,  deltaBits: [2, 4, 6] },
+  { name: 'pressure',       minimum: 300,  step: 0.1, keyBits: 13, deltaBits: [3, 5, 8] },
+  { name: 'gas_resistance', minimum: 0,    step: 16,  keyBits: 12, deltaBits: [4, 6, 9] },
+  { name: 'iaq',            minimum: 0,    step: 1,   keyBits: 9,  deltaBits: [3, 5, 7] },
+  { name: 'battery',        minimum: 0,    step: 1,   keyBits: 7,  deltaBits: [2, 4, 7] },
+  { name: 'status',         minimum: 0,    step: 1,   keyBits: 8,  deltaBits: [0, 0, 0] }
+];
+
+// Decoder state per device: last quantised values and sequence number
+const sensorCodecStates = new Map();
+
+function readBits(bytes, reader, bits) {
+  if (reader.pos + bits > bytes.length * 8) {
+    throw new Error('Truncated codec frame');
+  }
+
+  let value = 0;
+  for (let i = 0; i < bits; i++) {
+    const bit = (bytes[reader.pos >> 3] >> (7 - (reader.pos & 7))) & 1;
+    value = value * 2 + bit;
+    reader.pos++;
+  }
+  return value;
+}
+
+/**
+ * Decode a compact sensor codec frame.
+ * Returns the reading, or null when a delta frame cannot be applied
+ * (no keyframe yet, or a lost frame broke the sequence).
+ */
+function decodeSensorCodecFrame(deviceId, bytes) {
+  const reader = { pos: 0 };
+  const version = readBits(bytes, reader, 3);
+  const keyframe = readBits(bytes, reader, 1) === 1;
+  const sequence = readBits(bytes, reader, 4);
+
+  if (version !== SENSOR_CODEC_VERSION) {
+    throw new Error(`Unsupported codec version ${version}`);
+  }
+
+  const state = sensorCodecStates.get(deviceId);
+
+  if (!keyframe && (!state || sequence !== ((state.sequence + 1) & 0x0F))) {
+    sensorCodecStates.delete(deviceId);
+    return null;
+  }
+
+  const values = SENSOR_CODEC_FIELDS.map((field, i) => {
+    if (keyframe) {
+      return readBits(bytes, reader, field.keyBits);
+    }
+
+    const cls = readBits(bytes, reader, 2);
+    if (cls === 0) {
+      return state.values[i];
+    }
+    if (field.deltaBits[0] === 0) {
+      return readBits(bytes, reader, field.keyBits);
+    }
+
+    const zigzag = readBits(bytes, reader, field.deltaBits[cls - 1]);
+    const delta = (zigzag & 1) ? -((zigzag + 1) / 2) : zigzag / 2;
+    return state.values[i] + delta;
+  });
+
+  sensorCodecStates.set(deviceId, { values, sequence });
+
+  const reading = { keyframe };
+  SENSOR_CODEC_FIELDS.forEach((field, i) => {
+    reading[field.name] = Math.round((field.minimum + values[i] * field.step) * 100) / 100;
+  });
+  return reading;
+}
+
+// Store-and-forward replay from the gateway flash log: concatenated
+// SensorDataPackets (packet_types.h), little-endian, CRC-16/MODBUS trailer
+const BACKFILL_PORT = 7;
+const SENSOR_PACKET_SIZE = 21;
+const PACKET_MAGIC = 0xA5A5;
+const PACKET_TYPE_SENSOR = 0x01;
+
+function crc16Modbus(bytes, length) {
+  let crc = 0xFFFF;
+  for (let i = 0; i < length; i++) {
+    crc ^= bytes[i];
+    for (let bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >>> 1) ^ 0xA001 : crc >>> 1;
+    }
+  }
+  return crc;
+}
+
+/**
+ * Decode a backfill uplink into readings with their original timestamps.
+ * Packets with a bad magic, type or checksum are skipped.
+ */
+function decodeBackfillPackets(bytes) {
+  const readings = [];
+
+  for (let offset = 0; offset + SENSOR_PACKET_SIZE <= bytes.length; offset += SENSOR_PACKET_SIZE) {
+    const packet = bytes.subarray(offset, offset + SENSOR_PACKET_SIZE);
+    if (packet.readUInt16LE(0) !== PACKET_MAGIC || packet[2] !== PACKET_TYPE_SENSOR ||
+        packet.readUInt16LE(19) !== crc16Modbus(packet, 19)) {
+      continue;
+    }
+
+    readings.push({
+      timestamp: packet.readUInt32LE(3),
+      temperature: packet.readInt16LE(7) / 100,
+      humidity: packet.readUInt16LE(9) / 100,
+      pressure: packet.readUInt16LE(11) / 10,
+      gas_resistance: packet.readUInt16LE(13),
+      iaq: packet.readUInt16LE(15)
+    });
+  }
+  return readings;
+}
+
+// Aggregated records (packet_types.h): header magic(2) type(1) count(1)
+// baseTimestamp(4), records recordType(1) timeOffset(2) body, CRC-16 trailer
+const AGGREGATE_PORT = 5;
+const AGGREGATE_HEADER_SIZE = 8;
+const PACKET_TYPE_DETECTION = 0x02;
+const PACKET_TYPE_STATUS = 0x03;
+const PACKET_TYPE_AGGREGATE = 0x05;
+const AGGREGATE_BODY_SIZES = {
+  [PACKET_TYPE_SENSOR]: 12,
+  [PACKET_TYPE_DETECTION]: 4,
+  [PACKET_TYPE_STATUS]: 10
+};
+
+/**
+ * Decode an aggregated uplink. Sensor records become readings with their
+ * own timestamps; detection and status records are counted as skipped
+ * (they carry no camera / device fields for those tables).
+ */
+function decodeAggregateFrame(bytes) {
+  if (bytes.length < AGGREGATE_HEADER_SIZE + 2 ||
+      bytes.readUInt16LE(0) !== PACKET_MAGIC || bytes[2] !== PACKET_TYPE_AGGREGATE ||
+      bytes.readUInt16LE(bytes.length - 2) !== crc16Modbus(bytes, bytes.length - 2)) {
+    throw new Error('Invalid aggregate frame');
+  }
+
+  const count = bytes[3];
+  const baseTimestamp = bytes.readUInt32LE(4);
+  const end = bytes.length - 2;
+  const readings = [];
+  let skipped = 0;
+  let offset = AGGREGATE_HEADER_SIZE;
+
+  for (let i = 0; i < count; i++) {
+    const bodySize = AGGREGATE_BODY_SIZES[bytes[offset]];
+    if (bodySize === undefined || offset + 3 + bodySize > end) {
+      throw new Error('Truncated aggregate record');
+    }
+
+    const body = offset + 3;
+    if (bytes[offset] === PACKET_TYPE_SENSOR) {
+      readings.push({
+        timestamp: baseTimestamp + bytes.readUInt16LE(offset + 1),
+        temperature: bytes.readInt16LE(body) / 100,
+        humidity: bytes.readUInt16LE(body + 2) / 100,
+        pressure: bytes.readUInt16LE(body + 4) / 10,
+        gas_resistance: bytes.readUInt16LE(body + 6),
+        iaq: bytes.readUInt16LE(body + 8)
+      });
+    } else {
+      skipped++;
+    }
+    offset = body + bodySize;
+  }
+  return { readings, skipped };
+}
+
+function insertBackfillReadings(deviceId, readings, res) {
+  const stmt = db.prepare(`
+    INSERT INTO sensor_readings
+    (device_id, temperature, humidity, pressure, gas_resistance, timestamp)
+    VALUES (?, ?, ?, ?, ?, ?)
+  `);
+
+  let remaining = readings.length;
+  let failed = false;
+
+  readings.forEach((reading) => {
+    stmt.run([deviceId, reading.temperature, reading.humidity, reading.pressure,
+              reading.gas_resistance, reading.timestamp], (err) => {
+      if (err) {
+        console.error('Error inserting backfill reading:', err);
+        failed = true;
+      }
+      if (--remaining === 0) {
+        if (failed) {
+          return res.status(500).json({ error: 'Database error' });
+        }
+        res.status(201).json({ success: true, backfilled: readings.length });
+      }
+    });
+  });
+
+  stmt.finalize();
+}
+
+// POST /api/lorawan/uplink - Raw uplink forwarded by the network server
+// Body: { device_id, port, payload (base64), timestamp }
+app.post('/api/lorawan/uplink', (req, res) => {
+  const { device_id, port, payload, timestamp = Math.floor(Date.now() / 1000) } = req.body;
+
+  if (!device_id || port === undefined || !payload) {
+    return res.status(400).json({ error: 'Missing required fields' });
+  }
+
+  if (port === BACKFILL_PORT) {
+    const readings = decodeBackfillPackets(Buffer.from(payload, 'base64'));
+    if (readings.length === 0) {
+      return res.status(400).json({ error: 'No valid packets in backfill uplink' });
+    }
+    return insertBackfillReadings(device_id, readings, res);
+  }
+
+  if (port === AGGREGATE_PORT) {
+    let frame;
+    try {
+      frame = decodeAggregateFrame(Buffer.from(payload, 'base64'));
+    } catch (err) {
+      return res.status(400).json({ error: err.message });
+    }
+    if (frame.readings.length === 0) {
+      return res.status(202).json({ success: true, stored: 0, skipped: frame.skipped });
+    }
+    return insertBackfillReadings(device_id, frame.readings, res);
+  }
+
+  if (port !== SENSOR_CODEC_PORT) {
+    return res.status(422).json({ error: `Unsupported port ${port}` });
+  }
+
+  let reading;
+  try {
+    reading = decodeSensorCodecFrame(device_id, Buffer.from(payload, 'base64'));
+  } catch (err) {
+    return res.status(400).json({ error: err.message });
+  }
+
+  if (!reading) {
+    // Accepted but not decodable until the next keyframe
+    return res.status(202).json({ success: false, waiting_for_keyframe: true });
+  }
+
+  const stmt = db.prepare(`
+    INSERT INTO sensor_readings
+    (device_id, temperature, humidity, pressure, gas_resistance, timestamp)
+    VALUES (?, ?, ?, ?, ?, ?)
+  `);
+
+  stmt.run([device_id, reading.temperature, reading.humidity, reading.pressure,
+            reading.gas_resistance, timestamp], function(err) {
+    if (err) {
+      console.error('Error inserting decoded uplink:', err);
+      return res.status(500).json({ error: 'Database error' });
+    }
+
+    broadcast('sensor_data', {
+      id: this.lastID,
+      device_id,
+      ...reading,
+      timestamp
+    });
+
+    res.status(201).json({ success: true, id: this.lastID, reading });
+  });
+
+  stmt.finalize();
+});
+
 // ===========================================
 // SERVE DASHBOARD
 // ===========================================
@@ -0,0 +1,127 @@
+/**
+ * Detection Regression Checks
+ *
+ * Integer IoU and class-aware NMS (detection_postprocess.h) and the
+ * tracker fixes (detection_tracker.h): tracks age by time across
+ * motion-gated frames, and a new detection never evicts a track matched
+ * in the same update. Run by ctest; exit status is the number of failed
+ * checks.
+ */
+
+#include <stdio.h>
+
+#include "vision/detection_postprocess.h"
+#include "vision/detection_tracker.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+  if (!condition) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+Detection box(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t classId, float confidence) {
+  Detection d;
+  d.x0 = x0;
+  d.y0 = y0;
+  d.x1 = x1;
+  d.y1 = y1;
+  d.classId = classId;
+  d.confidence = confidence;
+  return d;
+}
+
+/**
+ * Half-overlapping 10x10 boxes: inter 50, union 150, IoU 85.33/256
+ */
+void integerIou() {
+  Detection a = box(0, 0, 10, 10, 1, 0.9f);
+  Detection b = box(5, 0, 15, 10, 1, 0.8f);
+  check(detectionsOverlap(a, b, 85), "IoU above 85/256");
+  check(!detectionsOverlap(a, b, 86), "IoU below 86/256");
+  check(!detectionsOverlap(a, box(10, 0, 20, 10, 1, 0.8f), 0), "touching boxes do not overlap");
+}
+
+void classAwareNms() {
+  static DetectionCandidates candidates;
+  candidates.reset(0.1f);
+  candidates.items[0] = box(1, 0, 11, 10, 1, 0.8f);    // Suppressed by the 0.9 box
+  candidates.items[1] = box(100, 100, 120, 120, 1, 0.6f);
+  candidates.items[2] = box(0, 0, 10, 10, 1, 0.9f);
+  candidates.items[3] = box(0, 0, 10, 10, 2, 0.7f);    // Same box, other class
+  candidates.count = 4;
+
+  Detection out[4];
+  uint8_t kept = nonMaxSuppression(candidates, 0.5f, out, 4);
+  check(kept == 3, "one overlapping same-class box suppressed");
+  check(kept == 3 && out[0].confidence == 0.9f && out[1].confidence == 0.7f &&
+        out[2].confidence == 0.6f, "kept strongest first across classes");
+
+  kept = nonMaxSuppression(candidates, 0.5f, out, 2);
+  check(kept == 2 && out[1].classId == 2, "maxOutput caps the strongest");
+}
+
+/**
+ * A confirmed track that is never inferred again (motion gate skipping
+ * every frame) is flagged stale, then expired as lost
+ */
+void tracksAgeAcrossGatedFrames() {
+  DetectionTracker tracker;
+  Detection d = box(50, 50, 70, 70, 1, 0.8f);
+  for (uint32_t now = 0; now <= 200; now += 100) {
+    tracker.update(&d, 1, now);
+  }
+
+  TrackEvent event;
+  check(tracker.pollEvent(event) && event.type == TRACK_EVENT_CONFIRMED, "confirmed after 3 hits");
+
+  check(tracker.staleCount(1199, 1000) == 0, "not stale before the verify age");
+  check(tracker.staleCount(1200, 1000) == 1, "stale at the verify age");
+
+  tracker.expire(5200, 5000);
+  check(tracker.activeCount() == 1, "kept at exactly the max age");
+  tracker.expire(5201, 5000);
+  check(tracker.activeCount() == 0, "expired past the max age");
+  check(tracker.pollEvent(event) && event.type == TRACK_EVENT_LOST, "expired track reported lost");
+}
+
+/**
+ * With every slot tentative, a new detection replaces the weakest track
+ * not matched in this update, even when a matched one is weaker
+ */
+void spawnKeepsMatchedTracks() {
+  DetectionTracker tracker;
+  Detection seeds[TRACKER_MAX_TRACKS];
+  for (uint8_t i = 0; i < TRACKER_MAX_TRACKS; i++) {
+    int16_t x = 40 * i;
+    seeds[i] = box(x, 0, x + 20, 20, 1, i == 0 ? 0.50f : 0.60f + 0.01f * i);
+  }
+
+  tracker.update(seeds, TRACKER_MAX_TRACKS, 0);
+  tracker.update(seeds + 1, TRACKER_MAX_TRACKS - 1, 100);  // Tracks 1.. reach 2 hits
+
+  // Track 0 is matched (2 hits, lowest peak), track 1 is the weakest unmatched
+  Detection frame[2] = {seeds[0], box(0, 200, 20, 220, 1, 0.9f)};
+  uint16_t matchedId = tracker.track(0).id;
+  tracker.update(frame, 2, 200);
+
+  check(tracker.track(0).active && tracker.track(0).id == matchedId, "matched track kept");
+  check(tracker.track(0).hits == 2, "matched track keeps its hits");
+  check(tracker.track(1).box.y0 == 200 && tracker.track(1).hits == 1,
+        "weakest unmatched tentative track replaced");
+  check(tracker.activeCount() == TRACKER_MAX_TRACKS, "no slot lost");
+}
+
+}  // namespace
+
+int main() {
+  integerIou();
+  classAwareNms();
+  tracksAgeAcrossGatedFrames();
+  spawnKeepsMatchedTracks();
+  return failures;
+}
@@ -0,0 +1,89 @@
+/**
+ * JSON Writer Regression Checks
+ *
+ * Fixed-point formatting and the overflow latch of json_writer.h: once a
+ * write is dropped, nothing more is appended and no partial number is
+ * left behind. Run by ctest; exit status is the number of failed checks.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "firmware/json_writer.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+  if (!condition) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+void formatting() {
+  char buffer[128];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.beginObject();
+  json.fieldString("type", "s\"1\n");
+  json.fieldFloat("temp", 21.456f, 2);
+  json.fieldFloat("neg", -1.25f, 1);
+  json.fieldFixed("small", 5, 2);
+  json.fieldInt("min", -2147483647 - 1);
+  json.fieldFloat("nan", NAN, 1);
+  json.key("list");
+  json.beginArray();
+  json.valueUInt(0);
+  json.valueBool(true);
+  json.endArray();
+  json.endObject();
+
+  const char* expected =
+    "{\"type\":\"s\\\"1\\u000a\",\"temp\":21.46,\"neg\":-1.3,\"small\":0.05,"
+    "\"min\":-2147483648,\"nan\":null,\"list\":[0,true]}";
+  check(!json.overflow(), "fits without overflow");
+  check(strcmp(json.c_str(), expected) == 0, "members, escapes and fixed point");
+  check(json.length() == strlen(expected), "length matches the output");
+}
+
+/**
+ * A number that runs out of room mid-way is removed whole, and the
+ * closing brace that would still fit is not appended after the drop
+ */
+void overflowLatches() {
+  char buffer[14];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.beginObject();
+  json.fieldUInt("a", 1);
+  json.fieldUInt("b", 12345);  // "{"a":1,"b":" is 11 bytes, two digits fit
+  json.endObject();
+
+  check(json.overflow(), "overflow reported");
+  check(strcmp(json.c_str(), "{\"a\":1,\"b\":") == 0, "no partial or reversed digits");
+  check(json.length() == strlen(json.c_str()), "length matches after rollback");
+
+  json.fieldUInt("c", 1);
+  check(strcmp(json.c_str(), "{\"a\":1,\"b\":") == 0, "nothing appended once latched");
+}
+
+void emptyBuffer() {
+  char buffer[1] = {'x'};
+  JsonWriter zero(buffer, 0);
+  zero.beginObject();
+  check(zero.overflow() && buffer[0] == 'x', "size 0 writes nothing");
+
+  JsonWriter one(buffer, sizeof(buffer));
+  one.beginObject();
+  check(one.overflow() && buffer[0] == '\0', "size 1 holds only the terminator");
+}
+
+}  // namespace
+
+int main() {
+  formatting();
+  overflowLatches();
+  emptyBuffer();
+  return failures;
+}
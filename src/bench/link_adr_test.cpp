@@ -0,0 +1,54 @@
+/**
+ * Device ADR Regression Checks
+ *
+ * Plain host checks for decide() sequences that went wrong before; run by
+ * ctest. Exit status is the number of failed checks.
+ */
+
+#include <stdio.h>
+
+#include "lorawan/link_adr.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+ * After a missed-ACK back-off, only samples taken since then count:
+ * +10 dB before the loss must not lift the DR once the link is at -10 dB
+ */
+void backoffDropsOldSamples() {
+    LinkAdr adr(2, 14, 64, 32);
+
+    for (int i = 0; i < 5; i++) {
+        adr.addSample(-60, 40);
+    }
+    adr.reportUplink(true, false, false);
+    adr.reportUplink(true, false, false);
+
+    LinkAdrDecision decision = adr.decide(3, 14);
+    check(decision.reason == LINK_ADR_MISSED_ACK, "back-off on missed ACKs");
+    check(decision.dataRate == 2, "back-off lowers DR3 to DR2");
+    check(adr.getSampleCount() == 0, "back-off clears the window");
+
+    for (int i = 0; i < LINK_ADR_MIN_SAMPLES; i++) {
+        adr.addSample(-120, -40);
+    }
+    decision = adr.decide(decision.dataRate, decision.txPower);
+    check(decision.dataRate == 2 && decision.txPower == 14, "weak link holds DR2 at full power");
+    check(adr.getStats().marginX4 < 0, "margin from post-loss samples only");
+}
+
+}  // namespace
+
+int main() {
+    backoffDropsOldSamples();
+    return failures;
+}
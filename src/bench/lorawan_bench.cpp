@@ -0,0 +1,287 @@
+/**
+ * LoRaWAN Path Benchmarks
+ *
+ * Replays sensor streams through what runs between a reading and the
+ * radio: compact codec, packet checksums, serial framing between the
+ * boards, JSON formatting, duty-cycle accounting, airtime and device ADR.
+ * The region is LoRaWANRegion (EU868 unless a CFG_* region is defined, as
+ * on the node).
+ * LMIC itself is not built on the host.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "lorawan/crc16.h"
+#include "lorawan/packet_types.h"
+#include "lorawan/sensor_codec.h"
+#include "lorawan/lorawan_region.h"
+#include "lorawan/link_adr.h"
+#include "lorawan/trace.h"
+#include "firmware/serial_frame.h"
+#include "firmware/json_writer.h"
+#include "replay.h"
+
+namespace {
+
+const std::vector<SensorReading>& readings() {
+  static const std::vector<SensorReading> data = benchSensorReadings();
+  return data;
+}
+
+SensorDataPacket toPacket(const SensorReading& r, uint32_t timestamp) {
+  SensorDataPacket packet;
+  memset(&packet, 0, sizeof(packet));
+  packet.magic = PACKET_MAGIC;
+  packet.type = PACKET_TYPE_SENSOR;
+  packet.timestamp = timestamp;
+  packet.temperature = (int16_t)(r.temperature * 100);
+  packet.humidity = (uint16_t)(r.humidity * 100);
+  packet.pressure = (uint16_t)(r.pressure * 10);
+  packet.gasResistance = (uint16_t)(r.gasResistance < 65535.0f ? r.gasResistance : 65535.0f);
+  packet.iaq = r.iaq;
+  packet.battery = r.battery;
+  packet.status = r.status;
+  packetSetChecksum(packet);
+  return packet;
+}
+
+}  // namespace
+
+// ===========================================
+// PAYLOAD ENCODING
+// ===========================================
+
+/**
+ * Codec over the replayed stream; bytes/s counts encoded output
+ */
+static void BM_SensorCodecEncode(benchmark::State& state) {
+  const std::vector<SensorReading>& stream = readings();
+  SensorCodecState codec;
+  sensorCodecReset(codec);
+  uint8_t frame[SENSOR_CODEC_MAX_FRAME];
+  size_t index = 0;
+  uint64_t bytes = 0;
+
+  for (auto _ : state) {
+    size_t size = sensorCodecEncode(codec, stream[index++ % stream.size()], frame, sizeof(frame));
+    benchmark::DoNotOptimize(frame);
+    bytes += size;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(bytes);
+  state.counters["bytes_per_reading"] = benchmark::Counter((double)bytes / state.iterations());
+}
+BENCHMARK(BM_SensorCodecEncode);
+
+static void BM_SensorCodecDecode(benchmark::State& state) {
+  const std::vector<SensorReading>& stream = readings();
+  std::vector<uint8_t> frames;
+  std::vector<uint8_t> sizes;
+  SensorCodecState encoder;
+  sensorCodecReset(encoder);
+  for (size_t i = 0; i < stream.size(); i++) {
+    uint8_t frame[SENSOR_CODEC_MAX_FRAME];
+    size_t size = sensorCodecEncode(encoder, stream[i], frame, sizeof(frame));
+    frames.insert(frames.end(), frame, frame + size);
+    sizes.push_back((uint8_t)size);
+  }
+
+  SensorCodecState decoder;
+  SensorReading reading;
+  for (auto _ : state) {
+    sensorCodecReset(decoder);
+    const uint8_t* p = frames.data();
+    for (size_t i = 0; i < sizes.size(); i++) {
+      sensorCodecDecode(decoder, p, sizes[i], reading);
+      p += sizes[i];
+    }
+    benchmark::DoNotOptimize(reading);
+  }
+  state.SetItemsProcessed(state.iterations() * sizes.size());
+}
+BENCHMARK(BM_SensorCodecDecode);
+
+static void BM_PacketChecksum(benchmark::State& state) {
+  const std::vector<SensorReading>& stream = readings();
+  size_t index = 0;
+  for (auto _ : state) {
+    SensorDataPacket packet = toPacket(stream[index % stream.size()], index);
+    benchmark::DoNotOptimize(packetIsValid(packet));
+    index++;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * sizeof(SensorDataPacket) * 2);
+}
+BENCHMARK(BM_PacketChecksum);
+
+/**
+ * CRC-16 throughput (arg: buffer size)
+ */
+static void BM_Crc16(benchmark::State& state) {
+  std::vector<uint8_t> data(state.range(0));
+  uint32_t noise = 5;
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = (uint8_t)benchRandom(noise);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(crc16(data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Crc16)->Arg(19)->Arg(64)->Arg(242);
+
+// ===========================================
+// SERIAL LINK
+// ===========================================
+
+/**
+ * Nicla -> gateway: COBS frame per packet, then decode the replayed bytes
+ */
+static void BM_SerialFrameRoundTrip(benchmark::State& state) {
+  const std::vector<SensorReading>& stream = readings();
+  std::vector<uint8_t> wire;
+  for (size_t i = 0; i < stream.size(); i++) {
+    SensorDataPacket packet = toPacket(stream[i], i);
+    uint8_t encoded[SERIAL_FRAME_MAX_ENCODED];
+    size_t size = serialFrameEncode(packet.type, 0, &packet, sizeof(packet), encoded);
+    wire.insert(wire.end(), encoded, encoded + size);
+  }
+
+  BufferStream port(wire.data(), wire.size());
+  SerialFrameReceiver receiver;
+  SerialFrame frame;
+  uint64_t frames = 0;
+  for (auto _ : state) {
+    port.rewind();
+    while (receiver.poll(port, frame)) {
+      frames++;
+    }
+  }
+  state.SetItemsProcessed(frames);
+  state.SetBytesProcessed(state.iterations() * wire.size());
+}
+BENCHMARK(BM_SerialFrameRoundTrip);
+
+// ===========================================
+// JSON OUTPUT
+// ===========================================
+
+/**
+ * Gateway sensor JSON (formatSensorDataJSON). Arg 0: the former snprintf
+ * with %.2f, arg 1: JsonWriter fixed point
+ */
+static void BM_SensorJson(benchmark::State& state) {
+  const std::vector<SensorReading>& stream = readings();
+  char buffer[256];
+  size_t index = 0;
+  uint64_t bytes = 0;
+
+  for (auto _ : state) {
+    const SensorReading& r = stream[index++ % stream.size()];
+    if (state.range(0) == 0) {
+      bytes += snprintf(buffer, sizeof(buffer),
+                        "{\"type\":\"sensor\",\"temp\":%.2f,\"hum\":%.2f,\"pres\":%.2f,"
+                        "\"gas\":%.0f,\"iaq\":%.0f,\"ts\":%lu,\"uptime\":%lu}",
+                        r.temperature, r.humidity, r.pressure, r.gasResistance,
+                        (float)r.iaq, (unsigned long)index, (unsigned long)index);
+    } else {
+      JsonWriter json(buffer, sizeof(buffer));
+      json.beginObject();
+      json.fieldString("type", "sensor");
+      json.fieldFloat("temp", r.temperature, 2);
+      json.fieldFloat("hum", r.humidity, 2);
+      json.fieldFloat("pres", r.pressure, 2);
+      json.fieldFloat("gas", r.gasResistance, 0);
+      json.fieldFloat("iaq", r.iaq, 0);
+      json.fieldUInt("ts", index);
+      json.fieldUInt("uptime", index);
+      json.endObject();
+      bytes += json.length();
+    }
+    benchmark::DoNotOptimize(buffer);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_SensorJson)->Arg(0)->Arg(1);
+
+// ===========================================
+// RADIO ACCOUNTING
+// ===========================================
+
+static void BM_Airtime(benchmark::State& state) {
+  uint8_t size = 1;
+  uint8_t dr = LoRaWANRegion::MIN_DR;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LoRaWANRegion::airtimeMs(size, dr));
+    size = size % 51 + 1;
+    dr = dr < LoRaWANRegion::MAX_DR ? dr + 1 : LoRaWANRegion::MIN_DR;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Airtime);
+
+/**
+ * One uplink every 30 s for the replayed stream: record() then delayFor()
+ */
+static void BM_DutyCycleLedger(benchmark::State& state) {
+  const std::vector<SensorReading>& stream = readings();
+  DutyCycleLedger ledger;
+  uint32_t now = 0;
+  uint8_t band = LoRaWANRegion::subBand(LoRaWANRegion::DEFAULT_UPLINK_HZ);
+  uint32_t airtime = LoRaWANRegion::airtimeMs(SENSOR_CODEC_MAX_FRAME, LoRaWANRegion::MIN_DR);
+  uint64_t blocked = 0;
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < stream.size(); i++) {
+      now += 30000;
+      if (ledger.delayFor(band, airtime, now) == 0) {
+        ledger.record(band, airtime, now);
+      } else {
+        blocked++;
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * stream.size());
+  state.counters["blocked"] = benchmark::Counter((double)blocked / (state.iterations() * stream.size()));
+}
+BENCHMARK(BM_DutyCycleLedger);
+
+static void BM_LinkAdr(benchmark::State& state) {
+  LinkAdr adr(2, 14, 64, 32);
+  uint32_t noise = 9;
+  uint8_t dr = LoRaWANRegion::MIN_DR;
+  int8_t power = 14;
+  for (auto _ : state) {
+    bool downlink = (benchRandom(noise) & 7) != 0;
+    if (downlink) {
+      adr.addSample(-90 - (int16_t)(benchRandom(noise) % 30), (int8_t)(benchRandom(noise) % 40));
+    }
+    adr.reportUplink(false, false, downlink);
+    LinkAdrDecision decision = adr.decide(dr, power);
+    dr = decision.dataRate;
+    power = decision.txPower;
+    benchmark::DoNotOptimize(decision);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LinkAdr);
+
+// ===========================================
+// INSTRUMENTATION
+// ===========================================
+
+/**
+ * Cost of one traced span (begin + end), the overhead trace.h adds
+ */
+static void BM_TraceSpan(benchmark::State& state) {
+  tracer().reset();
+  for (auto _ : state) {
+    tracer().begin(TRACE_INVOKE);
+    tracer().end(TRACE_INVOKE);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TraceSpan);
+
+BENCHMARK_MAIN();
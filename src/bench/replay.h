@@ -0,0 +1,195 @@
+/**
+ * Replay Data
+ *
+ * Recorded inputs for the benchmarks. Each set is read from the file named
+ * by an environment variable; without it a deterministic synthetic set is
+ * generated, so the benchmarks always run (and compare like with like).
+ *
+ * - IOT_BENCH_FRAMES   raw RGB565 frames (little-endian, BENCH_FRAME_WIDTH
+ *                      x BENCH_FRAME_HEIGHT each, concatenated), as dumped
+ *                      from the camera frame buffer
+ * - IOT_BENCH_OUTPUTS  raw int8 YOLO grid outputs (BENCH_YOLO_GRID^2 x
+ *                      BENCH_YOLO_ANCHORS x (5 + BENCH_YOLO_CLASSES) each)
+ * - IOT_BENCH_SENSORS  CSV, one reading per line:
+ *                      temperature,humidity,pressure,gas,iaq,battery,status
+ *                      (lines starting with '#' or a letter are skipped)
+ */
+
+#ifndef BENCH_REPLAY_H
+#define BENCH_REPLAY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "lorawan/sensor_codec.h"
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+// Matches the Nicla Vision pipeline (dual_camera_ml.cpp)
+#define BENCH_FRAME_WIDTH        320
+#define BENCH_FRAME_HEIGHT       240
+#define BENCH_FRAME_BYTES        (BENCH_FRAME_WIDTH * BENCH_FRAME_HEIGHT * 2)
+#define BENCH_MODEL_WIDTH        96
+#define BENCH_MODEL_HEIGHT       96
+
+#define BENCH_YOLO_GRID          12
+#define BENCH_YOLO_ANCHORS       3
+#define BENCH_YOLO_CLASSES       2
+#define BENCH_YOLO_BYTES         (BENCH_YOLO_GRID * BENCH_YOLO_GRID * BENCH_YOLO_ANCHORS * (5 + BENCH_YOLO_CLASSES))
+
+#define BENCH_SYNTHETIC_FRAMES   8
+#define BENCH_SYNTHETIC_OUTPUTS  4
+#define BENCH_SYNTHETIC_READINGS 256
+
+// ===========================================
+// LOADING
+// ===========================================
+
+/**
+ * Read a file of fixed-size records
+ * @return false if the variable is unset or the file holds no whole record
+ */
+static inline bool benchLoadRecords(const char* variable, size_t recordSize,
+                                    std::vector<uint8_t>& data) {
+  const char* path = getenv(variable);
+  if (path == nullptr) {
+    return false;
+  }
+
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    fprintf(stderr, "ERROR: cannot open %s=%s\n", variable, path);
+    return false;
+  }
+
+  uint8_t chunk[4096];
+  size_t read;
+  data.clear();
+  while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    data.insert(data.end(), chunk, chunk + read);
+  }
+  fclose(file);
+
+  data.resize(data.size() - data.size() % recordSize);
+  return !data.empty();
+}
+
+static inline uint32_t benchRandom(uint32_t& state) {
+  state = state * 1664525 + 1013904223;    // LCG: identical sets on every host
+  return state >> 8;
+}
+
+/**
+ * RGB565 frames: gradient background with a bright square moving across;
+ * models the motion the gate and the detector see
+ */
+static inline std::vector<uint8_t> benchFrames() {
+  std::vector<uint8_t> data;
+  if (benchLoadRecords("IOT_BENCH_FRAMES", BENCH_FRAME_BYTES, data)) {
+    return data;
+  }
+
+  data.resize((size_t)BENCH_SYNTHETIC_FRAMES * BENCH_FRAME_BYTES);
+  uint32_t noise = 1;
+  for (uint32_t f = 0; f < BENCH_SYNTHETIC_FRAMES; f++) {
+    uint16_t* pixels = (uint16_t*)&data[(size_t)f * BENCH_FRAME_BYTES];
+    uint32_t squareX = 40 + f * 24;
+    for (uint32_t y = 0; y < BENCH_FRAME_HEIGHT; y++) {
+      for (uint32_t x = 0; x < BENCH_FRAME_WIDTH; x++) {
+        bool square = x >= squareX && x < squareX + 48 && y >= 96 && y < 144;
+        uint32_t r = square ? 31 : (x * 31) / BENCH_FRAME_WIDTH;
+        uint32_t g = square ? 63 : (y * 63) / BENCH_FRAME_HEIGHT;
+        uint32_t b = (benchRandom(noise) & 3) + 8;
+        pixels[y * BENCH_FRAME_WIDTH + x] = (uint16_t)((r << 11) | (g << 5) | b);
+      }
+    }
+  }
+  return data;
+}
+
+/**
+ * YOLO grid outputs: low logits everywhere, overlapping hot anchors around
+ * a few objects (exercises the threshold, decode and NMS paths)
+ */
+static inline std::vector<uint8_t> benchYoloOutputs() {
+  std::vector<uint8_t> data;
+  if (benchLoadRecords("IOT_BENCH_OUTPUTS", BENCH_YOLO_BYTES, data)) {
+    return data;
+  }
+
+  const uint32_t stride = 5 + BENCH_YOLO_CLASSES;
+  data.resize((size_t)BENCH_SYNTHETIC_OUTPUTS * BENCH_YOLO_BYTES);
+  uint32_t noise = 7;
+  for (uint32_t o = 0; o < BENCH_SYNTHETIC_OUTPUTS; o++) {
+    int8_t* grid = (int8_t*)&data[(size_t)o * BENCH_YOLO_BYTES];
+    for (uint32_t i = 0; i < BENCH_YOLO_BYTES; i++) {
+      grid[i] = (int8_t)(-100 + (int)(benchRandom(noise) % 20));
+    }
+    for (uint32_t object = 0; object < 3; object++) {
+      uint32_t cx = (o * 3 + object * 4) % (BENCH_YOLO_GRID - 2);
+      uint32_t cy = (object * 5 + o) % (BENCH_YOLO_GRID - 2);
+      for (uint32_t dy = 0; dy < 2; dy++) {
+        for (uint32_t dx = 0; dx < 2; dx++) {
+          for (uint32_t a = 0; a < BENCH_YOLO_ANCHORS; a++) {
+            int8_t* p = grid + (((cy + dy) * BENCH_YOLO_GRID + cx + dx) * BENCH_YOLO_ANCHORS + a) * stride;
+            p[0] = p[1] = 0;
+            p[2] = p[3] = (int8_t)(benchRandom(noise) % 10);
+            p[4] = (int8_t)(40 + benchRandom(noise) % 60);
+            p[5 + object % BENCH_YOLO_CLASSES] = 80;
+          }
+        }
+      }
+    }
+  }
+  return data;
+}
+
+/**
+ * Sensor readings: slow random walk around indoor conditions
+ */
+static inline std::vector<SensorReading> benchSensorReadings() {
+  std::vector<SensorReading> readings;
+
+  const char* path = getenv("IOT_BENCH_SENSORS");
+  FILE* file = path ? fopen(path, "r") : nullptr;
+  if (path && !file) {
+    fprintf(stderr, "ERROR: cannot open IOT_BENCH_SENSORS=%s\n", path);
+  }
+  if (file) {
+    char line[160];
+    while (fgets(line, sizeof(line), file)) {
+      SensorReading r;
+      unsigned iaq, battery, status;
+      if (sscanf(line, "%f,%f,%f,%f,%u,%u,%u", &r.temperature, &r.humidity, &r.pressure,
+                 &r.gasResistance, &iaq, &battery, &status) == 7) {
+        r.iaq = (uint16_t)iaq;
+        r.battery = (uint8_t)battery;
+        r.status = (uint8_t)status;
+        readings.push_back(r);
+      }
+    }
+    fclose(file);
+    if (!readings.empty()) {
+      return readings;
+    }
+  }
+
+  SensorReading r = {22.0f, 45.0f, 1013.0f, 50000.0f, 50, 100, 0x01};
+  uint32_t noise = 3;
+  for (uint32_t i = 0; i < BENCH_SYNTHETIC_READINGS; i++) {
+    r.temperature += ((int)(benchRandom(noise) % 21) - 10) * 0.01f;
+    r.humidity += ((int)(benchRandom(noise) % 21) - 10) * 0.05f;
+    r.pressure += ((int)(benchRandom(noise) % 21) - 10) * 0.02f;
+    r.gasResistance += ((int)(benchRandom(noise) % 201) - 100) * 10.0f;
+    r.iaq = (uint16_t)(50 + (i / 16) % 40);
+    r.battery = (uint8_t)(100 - i / 32);
+    readings.push_back(r);
+  }
+  return readings;
+}
+
+#endif  // BENCH_REPLAY_H
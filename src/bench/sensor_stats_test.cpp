@@ -0,0 +1,95 @@
+/**
+ * Sensor Statistics Regression Checks
+ *
+ * The O(1) Welford replace-oldest update of sensor_stats.h against a
+ * two-pass mean and variance over the same window, plus the deadband
+ * report-on-change. Run by ctest; exit status is the number of failed
+ * checks.
+ */
+
+#include <stdio.h>
+
+#include "firmware/sensor_stats.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+  if (!condition) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+/**
+ * Pressure-like channel: large offset, small noise, a 4 hPa step every
+ * 1000 samples (worst case for float rounding in the running sums, which
+ * used to accumulate without bound)
+ */
+void windowMatchesTwoPass() {
+  const int total = 20000;
+  static float values[total];
+  uint32_t seed = 12345;
+  for (int i = 0; i < total; i++) {
+    seed = seed * 1103515245UL + 12345UL;
+    float noise = (float)((seed >> 16) & 0x3FF) / 1023.0f - 0.5f;
+    values[i] = 1013.0f + ((i / 1000) % 2 ? 4.0f : 0.0f) + noise;
+  }
+
+  ChannelStats stats;
+  stats.begin(0.2f, 0.5f);
+  bool meanOk = true;
+  bool varianceOk = true;
+  for (int i = 0; i < total; i++) {
+    stats.add(values[i]);
+
+    int n = i + 1 < SENSOR_STATS_WINDOW ? i + 1 : SENSOR_STATS_WINDOW;
+    double mean = 0.0;
+    for (int k = i + 1 - n; k <= i; k++) mean += values[k];
+    mean /= n;
+    double m2 = 0.0;
+    for (int k = i + 1 - n; k <= i; k++) m2 += (values[k] - mean) * (values[k] - mean);
+    double variance = n > 1 ? m2 / (n - 1) : 0.0;
+
+    meanOk = meanOk && fabs(stats.mean - mean) <= 1e-3;
+    varianceOk = varianceOk && fabs(stats.variance() - variance) <= 0.05 * variance + 1e-3;
+  }
+
+  check(stats.count == SENSOR_STATS_WINDOW, "window saturates");
+  check(meanOk, "windowed mean tracks the two-pass mean");
+  check(varianceOk, "windowed variance stays within 5% of the two-pass variance");
+}
+
+void flatWindow() {
+  ChannelStats stats;
+  stats.begin(0.2f, 0.5f);
+  for (int i = 0; i < 3 * SENSOR_STATS_WINDOW; i++) {
+    stats.add(21.7f);
+  }
+  check(stats.m2 >= 0.0f && stats.variance() < 1e-6f, "flat window has no variance");
+  check(!stats.isOutlier(22.1f, 3.0f), "deadband is the outlier noise floor");
+  check(stats.isOutlier(22.3f, 3.0f), "step beyond the deadband is an outlier");
+}
+
+void reportOnChange() {
+  ChannelStats stats;
+  stats.begin(1.0f, 0.5f);  // EWMA follows the sample exactly
+  check(!stats.changed(), "nothing to report before the first sample");
+  stats.add(20.0f);
+  check(stats.changed(), "first sample is reported");
+  stats.markReported();
+  stats.add(20.4f);
+  check(!stats.changed(), "inside the deadband");
+  stats.add(20.6f);
+  check(stats.changed(), "leaving the deadband");
+}
+
+}  // namespace
+
+int main() {
+  windowMatchesTwoPass();
+  flatWindow();
+  reportOnChange();
+  return failures;
+}
@@ -0,0 +1,124 @@
+/**
+ * Serial Frame Regression Checks
+ *
+ * COBS framing and CRC of serial_frame.h: round trips, zero bytes in the
+ * payload, resynchronisation after noise and rejected corrupt frames.
+ * Run by ctest; exit status is the number of failed checks.
+ */
+
+#include <stdio.h>
+
+#include "firmware/serial_frame.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+  if (!condition) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+/**
+ * Feed encoded bytes; true if exactly the last byte completed a frame
+ */
+bool feed(SerialFrameReceiver& receiver, const uint8_t* data, size_t size, SerialFrame& frame) {
+  bool complete = false;
+  for (size_t i = 0; i < size; i++) {
+    complete = receiver.push(data[i], frame);
+    if (complete && i + 1 != size) {
+      return false;
+    }
+  }
+  return complete;
+}
+
+SensorDataPacket makeSensorPacket() {
+  SensorDataPacket packet;
+  memset(&packet, 0, sizeof(packet));  // Plenty of zero bytes to stuff
+  packet.magic = PACKET_MAGIC;
+  packet.type = PACKET_TYPE_SENSOR;
+  packet.timestamp = 1700000000UL;
+  packet.temperature = -1250;
+  packet.humidity = 4500;
+  packet.status = STATUS_SENSOR_OK;
+  packetSetChecksum(packet);
+  return packet;
+}
+
+void packetRoundTrip() {
+  SensorDataPacket packet = makeSensorPacket();
+  uint8_t encoded[SERIAL_FRAME_MAX_ENCODED];
+  size_t size = serialFrameEncode(packet.type, 2, &packet, sizeof(packet), encoded);
+
+  check(size > 0 && encoded[size - 1] == 0x00, "frame ends with the delimiter");
+  check(memchr(encoded, 0x00, size - 1) == nullptr, "no zero byte inside the frame");
+
+  SerialFrameReceiver receiver;
+  SerialFrame frame;
+  SensorDataPacket decoded;
+  check(feed(receiver, encoded, size, frame), "frame decoded at the delimiter");
+  check(frame.type == PACKET_TYPE_SENSOR && frame.source == 2, "type and source kept");
+  check(serialFramePacket(frame, decoded) && memcmp(&decoded, &packet, sizeof(packet)) == 0,
+        "packet bytes and checksum kept");
+  check(receiver.frames == 1 && receiver.crcErrors == 0 && receiver.framingErrors == 0,
+        "one clean frame counted");
+}
+
+void payloadEdges() {
+  uint8_t payload[SERIAL_FRAME_MAX_PAYLOAD];
+  uint8_t encoded[SERIAL_FRAME_MAX_ENCODED];
+  SerialFrameReceiver receiver;
+  SerialFrame frame;
+
+  // All zeros and no zeros at the maximum length, and an empty poll
+  const uint8_t fills[] = {0x00, 0x11};
+  for (uint8_t fill : fills) {
+    memset(payload, fill, sizeof(payload));
+    size_t size = serialFrameEncode(0x42, 0, payload, sizeof(payload), encoded);
+    check(size > 0 && size <= SERIAL_FRAME_MAX_ENCODED, "max payload fits the encoded bound");
+    check(feed(receiver, encoded, size, frame) && frame.length == sizeof(payload) &&
+          memcmp(frame.payload, payload, sizeof(payload)) == 0, "max payload round trip");
+  }
+
+  size_t size = serialFrameEncode(SERIAL_FRAME_REQUEST, 0, nullptr, 0, encoded);
+  check(feed(receiver, encoded, size, frame) && frame.type == SERIAL_FRAME_REQUEST &&
+        frame.length == 0, "empty request frame");
+
+  check(serialFrameEncode(0x42, 0, payload, SERIAL_FRAME_MAX_PAYLOAD + 1, encoded) == 0,
+        "oversized payload rejected");
+}
+
+void resyncAndCorruption() {
+  SensorDataPacket packet = makeSensorPacket();
+  uint8_t encoded[SERIAL_FRAME_MAX_ENCODED];
+  size_t size = serialFrameEncode(packet.type, 0, &packet, sizeof(packet), encoded);
+
+  SerialFrameReceiver receiver;
+  SerialFrame frame;
+
+  // Tail of a frame whose start was lost
+  const uint8_t noise[] = {0x37, 0x05, 0x99, 0x00};
+  check(!feed(receiver, noise, sizeof(noise), frame), "noise is not a frame");
+  check(receiver.framingErrors == 1, "noise counted as a framing error");
+  check(feed(receiver, encoded, size, frame), "next frame decodes after noise");
+
+  // A flipped data byte (kept non-zero so the framing stays intact)
+  uint8_t corrupt[SERIAL_FRAME_MAX_ENCODED];
+  memcpy(corrupt, encoded, size);
+  corrupt[size / 2] ^= (corrupt[size / 2] == 0x01) ? 0x03 : 0x01;
+  check(!feed(receiver, corrupt, size, frame), "corrupt frame rejected");
+  check(receiver.crcErrors + receiver.framingErrors == 2, "corrupt frame counted");
+  check(feed(receiver, encoded, size, frame), "receiver recovers after a bad frame");
+}
+
+}  // namespace
+
+int main() {
+  packetRoundTrip();
+  payloadEdges();
+  resyncAndCorruption();
+  return failures;
+}
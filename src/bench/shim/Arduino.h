@@ -0,0 +1,106 @@
+/**
+ * Host Arduino Shim
+ *
+ * The subset of the Arduino core used by the shared headers (trace.h,
+ * serial_frame.h, sensor_stats.h): timing, min/max, Print and Stream. Print writes to stdout so
+ * printSummary() output lands in the benchmark log.
+ */
+
+#ifndef BENCH_ARDUINO_H
+#define BENCH_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+
+#define DEC 10
+#define HEX 16
+
+using std::min;
+using std::max;
+
+static inline uint32_t micros() {
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return (uint32_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+static inline uint32_t millis() {
+  return micros() / 1000;
+}
+
+class Print {
+ public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t byte) {
+    return fputc(byte, stdout) == EOF ? 0 : 1;
+  }
+
+  virtual size_t write(const uint8_t* data, size_t length) {
+    size_t written = 0;
+    while (written < length && write(data[written])) {
+      written++;
+    }
+    return written;
+  }
+
+  size_t print(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned long value, int base = DEC) { return printNumber(value, base); }
+  size_t print(unsigned int value, int base = DEC) { return printNumber(value, base); }
+  size_t print(long value, int base = DEC) {
+    return value < 0 ? print('-') + printNumber(-(unsigned long)value, base) : printNumber(value, base);
+  }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(double value, int digits = 2) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.*f", digits, value);
+    return print(text);
+  }
+
+  size_t println() { return print('\n'); }
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(T value, int format) { return print(value, format) + println(); }
+
+ private:
+  size_t printNumber(unsigned long value, int base) {
+    char text[24];
+    snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+    return print(text);
+  }
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+};
+
+/**
+ * Stream over a memory buffer (replays recorded serial traffic)
+ */
+class BufferStream : public Stream {
+ public:
+  BufferStream(const uint8_t* data, size_t length) : _data(data), _length(length), _pos(0) {}
+
+  int available() override { return (int)(_length - _pos); }
+  int read() override { return _pos < _length ? _data[_pos++] : -1; }
+  size_t write(uint8_t) override { return 1; }
+  void rewind() { _pos = 0; }
+
+ private:
+  const uint8_t* _data;
+  size_t _length;
+  size_t _pos;
+};
+
+static Print Serial;
+
+#endif  // BENCH_ARDUINO_H
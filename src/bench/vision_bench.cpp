@@ -0,0 +1,300 @@
+/**
+ * Vision Pipeline Benchmarks
+ *
+ * Replays RGB565 frames through the kernels dual_camera_ml.cpp runs per
+ * frame: motion gate, resize + quantize into the input tensor, output
+ * decode and NMS. The TFLM Invoke() step is replaced by replayed output
+ * tensors (replay.h); it depends on the model and the CMSIS-NN build and
+ * is profiled on target with the TRACE_INVOKE span.
+ *
+ * Items/s is frames (or candidates for NMS); bytes/s is source frame bytes.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "vision/image_preprocessing.h"
+#include "vision/detection_postprocess.h"
+#include "vision/motion_gate.h"
+#include "vision/tile_scheduler.h"
+#include "vision/detection_tracker.h"
+#include "replay.h"
+
+namespace {
+
+const std::vector<uint8_t>& frames() {
+  static const std::vector<uint8_t> data = benchFrames();
+  return data;
+}
+
+const std::vector<uint8_t>& yoloOutputs() {
+  static const std::vector<uint8_t> data = benchYoloOutputs();
+  return data;
+}
+
+size_t frameCount() { return frames().size() / BENCH_FRAME_BYTES; }
+
+const uint8_t* frame(size_t index) {
+  return &frames()[(index % frameCount()) * BENCH_FRAME_BYTES];
+}
+
+// Same values as the MOTION_* settings in dual_camera_ml.cpp
+const MotionGateConfig motionConfig = {12, 2, 3, 16, 96, 50};
+
+const float yoloAnchors[BENCH_YOLO_ANCHORS * 2] = {0.10f, 0.15f, 0.25f, 0.35f, 0.55f, 0.70f};
+
+const YoloConfig yoloConfig = {
+  BENCH_YOLO_GRID, BENCH_YOLO_GRID, BENCH_YOLO_ANCHORS, BENCH_YOLO_CLASSES, yoloAnchors, false
+};
+
+const DetectionFrame fullFrame = {0, 0, BENCH_FRAME_WIDTH, BENCH_FRAME_HEIGHT};
+
+// Input quantizations as found in the model zoo
+bool buildQuantization(InputQuantization& quant, int64_t kind) {
+  switch (kind) {
+    case 0: return buildInputQuantization(quant, INPUT_FORMAT_UINT8, 1.0f, 0, 0.0f, 1.0f);          // identity
+    case 1: return buildInputQuantization(quant, INPUT_FORMAT_INT8, 1.0f, -128, 0.0f, 1.0f);        // XOR 0x80
+    case 2: return buildInputQuantization(quant, INPUT_FORMAT_INT8, 1.0f / 128, 0, 127.5f, 127.5f); // table
+    default: return buildInputQuantization(quant, INPUT_FORMAT_FLOAT32, 1.0f, 0, 0.0f, 255.0f);     // float
+  }
+}
+
+const char* const QUANT_NAMES[] = {"uint8", "int8_xor", "int8_table", "float32"};
+const char* const MODE_NAMES[] = {"nearest", "bilinear", "area"};
+
+}  // namespace
+
+// ===========================================
+// PREPROCESSING
+// ===========================================
+
+/**
+ * Full-frame resize into the model input (args: ResizeMode, quantization)
+ */
+static void BM_Preprocess(benchmark::State& state) {
+  ResizeMode mode = (ResizeMode)state.range(0);
+  InputQuantization quant;
+  ResizeLUT lut;
+  if (!buildQuantization(quant, state.range(1)) ||
+      !buildResizeLUT(lut, BENCH_FRAME_WIDTH, 0, 0, BENCH_FRAME_WIDTH, BENCH_FRAME_HEIGHT,
+                      BENCH_MODEL_WIDTH, BENCH_MODEL_HEIGHT, mode)) {
+    state.SkipWithError("unsupported geometry");
+    return;
+  }
+
+  std::vector<float> tensor(BENCH_MODEL_WIDTH * BENCH_MODEL_HEIGHT * 3);
+  size_t index = 0;
+  for (auto _ : state) {
+    resizeRGB565toTensor(frame(index++), tensor.data(), lut, quant);
+    benchmark::DoNotOptimize(tensor.data());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * BENCH_FRAME_BYTES);
+  state.SetLabel(std::string(MODE_NAMES[mode]) + "/" + QUANT_NAMES[state.range(1)]);
+}
+BENCHMARK(BM_Preprocess)->ArgsProduct({{RESIZE_NEAREST, RESIZE_BILINEAR, RESIZE_AREA}, {0, 1, 2, 3}});
+
+/**
+ * LUT rebuild per frame, as when the motion gate moves the crop
+ */
+static void BM_BuildResizeLUT(benchmark::State& state) {
+  ResizeMode mode = (ResizeMode)state.range(0);
+  ResizeLUT lut;
+  uint16_t x = 0;
+  for (auto _ : state) {
+    lut.valid = false;
+    buildResizeLUT(lut, BENCH_FRAME_WIDTH, x, 0, 160, 160, BENCH_MODEL_WIDTH, BENCH_MODEL_HEIGHT, mode);
+    benchmark::DoNotOptimize(lut.col);
+    x = (x + 8) % (BENCH_FRAME_WIDTH - 160);
+  }
+  state.SetLabel(MODE_NAMES[mode]);
+}
+BENCHMARK(BM_BuildResizeLUT)->DenseRange(RESIZE_NEAREST, RESIZE_AREA);
+
+static void BM_MotionGate(benchmark::State& state) {
+  MotionGate gate;
+  MotionRegion region;
+  size_t index = 0;
+  uint32_t runs = 0;
+  for (auto _ : state) {
+    runs += updateMotionGate(gate, frame(index++), BENCH_FRAME_WIDTH, BENCH_FRAME_HEIGHT,
+                             motionConfig, BENCH_MODEL_WIDTH, BENCH_MODEL_HEIGHT, region);
+    benchmark::DoNotOptimize(region);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * BENCH_FRAME_BYTES);
+  state.counters["run_rate"] = benchmark::Counter((double)runs / state.iterations());
+}
+BENCHMARK(BM_MotionGate);
+
+/**
+ * Motion gate plus tile priorities and selection (2 tiles per frame)
+ */
+static void BM_TileSchedule(benchmark::State& state) {
+  MotionGate gate;
+  MotionRegion region;
+  TileScheduler scheduler;
+  scheduler.configure(BENCH_FRAME_WIDTH, BENCH_FRAME_HEIGHT,
+                      BENCH_MODEL_WIDTH, BENCH_MODEL_HEIGHT, 24);
+  uint8_t tiles[2];
+  size_t index = 0;
+  uint64_t selected = 0;
+
+  for (auto _ : state) {
+    updateMotionGate(gate, frame(index++), BENCH_FRAME_WIDTH, BENCH_FRAME_HEIGHT,
+                     motionConfig, BENCH_MODEL_WIDTH, BENCH_MODEL_HEIGHT, region);
+    scheduler.beginFrame();
+    scheduler.markMotion(gate);
+    uint8_t count = scheduler.select(tiles, 2);
+    for (uint8_t i = 0; i < count; i++) {
+      scheduler.ran(tiles[i]);
+    }
+    selected += count;
+    benchmark::DoNotOptimize(tiles);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["tiles"] = benchmark::Counter((double)selected / state.iterations());
+}
+BENCHMARK(BM_TileSchedule);
+
+// ===========================================
+// POST-PROCESSING
+// ===========================================
+
+static void BM_DecodeYolo(benchmark::State& state) {
+  const std::vector<uint8_t>& outputs = yoloOutputs();
+  size_t count = outputs.size() / BENCH_YOLO_BYTES;
+  TensorView view = {nullptr, TENSOR_ELEMENT_INT8, 0.1f, 0};
+  static DetectionCandidates candidates;
+  size_t index = 0;
+  uint64_t decoded = 0;
+
+  for (auto _ : state) {
+    view.data = &outputs[(index++ % count) * BENCH_YOLO_BYTES];
+    candidates.reset(0.5f);
+    decodeYoloGrid(view, yoloConfig, fullFrame, candidates);
+    decoded += candidates.count;
+    benchmark::DoNotOptimize(candidates.count);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["candidates"] = benchmark::Counter((double)decoded / state.iterations());
+}
+BENCHMARK(BM_DecodeYolo);
+
+/**
+ * Top-class decode of an int8 classification output (arg: classes)
+ */
+static void BM_DecodeClassification(benchmark::State& state) {
+  std::vector<int8_t> scores(state.range(0));
+  uint32_t noise = 17;
+  for (size_t i = 0; i < scores.size(); i++) {
+    scores[i] = (int8_t)(benchRandom(noise) & 0xFF);
+  }
+  TensorView view = {scores.data(), TENSOR_ELEMENT_INT8, 1.0f / 256, -128};
+  uint8_t classId = 0;
+  float confidence = 0.0f;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(decodeClassification(view, (uint16_t)scores.size(), 0.5f,
+                                                  classId, confidence));
+    benchmark::DoNotOptimize(confidence);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeClassification)->Arg(3)->Arg(1000);
+
+/**
+ * NMS over a pool of overlapping candidates (arg: pool size)
+ */
+static void BM_NonMaxSuppression(benchmark::State& state) {
+  static DetectionCandidates candidates;
+  candidates.reset(0.0f);
+  uint32_t noise = 11;
+  for (int64_t i = 0; i < state.range(0); i++) {
+    float x = (benchRandom(noise) % 200) / 320.0f;
+    float y = (benchRandom(noise) % 140) / 240.0f;
+    candidates.push(fullFrame, y, x, y + 0.3f, x + 0.25f, (uint8_t)(i & 1),
+                    (benchRandom(noise) % 1000) / 1000.0f);
+  }
+
+  Detection kept[16];
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(nonMaxSuppression(candidates, 0.5f, kept, 16));
+  }
+  state.SetItemsProcessed(state.iterations() * candidates.count);
+}
+BENCHMARK(BM_NonMaxSuppression)->RangeMultiplier(4)->Range(8, DETPOST_MAX_CANDIDATES);
+
+/**
+ * Tracker update with objects drifting across the frame (arg: objects)
+ */
+static void BM_DetectionTracker(benchmark::State& state) {
+  DetectionTracker tracker;
+  Detection boxes[TRACKER_MAX_TRACKS];
+  uint8_t count = (uint8_t)state.range(0);
+  uint32_t noise = 13;
+  uint32_t frameIndex = 0;
+  TrackEvent event;
+
+  for (auto _ : state) {
+    for (uint8_t i = 0; i < count; i++) {
+      int16_t x = (int16_t)((i * 40 + frameIndex * 3) % 260);
+      int16_t y = (int16_t)(i * 28 + benchRandom(noise) % 4);
+      boxes[i] = {x, y, (int16_t)(x + 40), (int16_t)(y + 60), (uint8_t)(i & 1), 0.8f};
+    }
+    tracker.update(boxes, count, frameIndex++);
+    while (tracker.pollEvent(event)) {
+    }
+    benchmark::DoNotOptimize(tracker.confirmedCount());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DetectionTracker)->Arg(1)->Arg(4)->Arg(TRACKER_MAX_TRACKS);
+
+// ===========================================
+// FRAME REPLAY
+// ===========================================
+
+/**
+ * Per-frame host cost of the pipeline: gate, crop LUT, int8 resize,
+ * replayed model output, decode and NMS
+ */
+static void BM_FrameReplay(benchmark::State& state) {
+  const std::vector<uint8_t>& outputs = yoloOutputs();
+  size_t outputCount = outputs.size() / BENCH_YOLO_BYTES;
+  MotionGate gate;
+  MotionRegion region;
+  ResizeLUT lut;
+  InputQuantization quant;
+  buildQuantization(quant, 1);
+  std::vector<int8_t> tensor(BENCH_MODEL_WIDTH * BENCH_MODEL_HEIGHT * 3);
+  static DetectionCandidates candidates;
+  Detection kept[16];
+  TensorView view = {nullptr, TENSOR_ELEMENT_INT8, 0.1f, 0};
+  size_t index = 0;
+  uint64_t inferences = 0;
+
+  for (auto _ : state) {
+    const uint8_t* pixels = frame(index);
+    if (updateMotionGate(gate, pixels, BENCH_FRAME_WIDTH, BENCH_FRAME_HEIGHT, motionConfig,
+                         BENCH_MODEL_WIDTH, BENCH_MODEL_HEIGHT, region) &&
+        buildResizeLUT(lut, BENCH_FRAME_WIDTH, region.x, region.y, region.width, region.height,
+                       BENCH_MODEL_WIDTH, BENCH_MODEL_HEIGHT, RESIZE_BILINEAR)) {
+      resizeRGB565toTensor(pixels, tensor.data(), lut, quant);
+
+      DetectionFrame crop = {region.x, region.y, region.width, region.height};
+      view.data = &outputs[(index % outputCount) * BENCH_YOLO_BYTES];
+      candidates.reset(0.5f);
+      decodeYoloGrid(view, yoloConfig, crop, candidates);
+      benchmark::DoNotOptimize(nonMaxSuppression(candidates, 0.5f, kept, 16));
+      inferences++;
+    }
+    index++;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["inference_rate"] = benchmark::Counter((double)inferences / state.iterations());
+}
+BENCHMARK(BM_FrameReplay);
+
+BENCHMARK_MAIN();
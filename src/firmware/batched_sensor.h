@@ -0,0 +1,84 @@
+/**
+ * Batched Sensor (Arduino_BHY2)
+ *
+ * Wraps a BHY2 virtual sensor so that every sample delivered from the
+ * BHI260AP FIFO is seen, not only the latest value(). With a batch
+ * latency configured, the BHI260AP keeps sampling at the requested rate
+ * and buffers samples in its own FIFO; one BHY2.update() then drains the
+ * whole batch, calling setData() once per sample.
+ *
+ * Each wrapper accumulates the samples since the last take(): count,
+ * mean, min and max. The host reads one summary per batch instead of
+ * polling every sensor at the sample rate.
+ */
+
+#ifndef BATCHED_SENSOR_H
+#define BATCHED_SENSOR_H
+
+#include <Arduino.h>
+#include <Arduino_BHY2.h>
+
+/**
+ * Per-batch summary
+ */
+struct SensorBatch {
+  uint16_t count;
+  float mean;
+  float minimum;
+  float maximum;
+};
+
+template <typename Base>
+class BatchedSensor : public Base {
+ public:
+  explicit BatchedSensor(uint8_t id)
+    : Base(id), _count(0), _sum(0.0f), _min(0.0f), _max(0.0f) {}
+
+  using Base::setData;
+
+  // Called by the BHY2 sensor manager for each sample drained from the FIFO
+  void setData(SensorDataPacket& data) override {
+    Base::setData(data);
+
+    float sample = Base::value();
+    if (_count == 0) {
+      _min = sample;
+      _max = sample;
+    } else {
+      _min = min(_min, sample);
+      _max = max(_max, sample);
+    }
+    _sum += sample;
+    if (_count < 0xFFFF) {
+      _count++;
+    }
+  }
+
+  /**
+   * Summarise and clear the samples received since the last call.
+   * An empty batch reports the latest value with count = 0.
+   */
+  SensorBatch take() {
+    SensorBatch batch;
+    batch.count = _count;
+    if (_count > 0) {
+      batch.mean = _sum / _count;
+      batch.minimum = _min;
+      batch.maximum = _max;
+    } else {
+      batch.mean = batch.minimum = batch.maximum = Base::value();
+    }
+
+    _count = 0;
+    _sum = 0.0f;
+    return batch;
+  }
+
+ private:
+  uint16_t _count;
+  float _sum;
+  float _min;
+  float _max;
+};
+
+#endif  // BATCHED_SENSOR_H
@@ -0,0 +1,142 @@
+/**
+ * Event Scheduler
+ *
+ * Deadline table for the gateway's periodic work (sensor reads, camera
+ * polls, uplinks, heartbeat, ...). Instead of comparing millis() against
+ * every interval on each pass, the state machine asks for the next due
+ * event and for how long nothing is due, and sleeps for that long.
+ *
+ * - Each event id owns one slot: period and absolute due time
+ * - takeDue() returns the most overdue event and re-arms it one period
+ *   later; if several periods were missed (long sleep, blocking modem
+ *   call) it re-arms from now instead of firing a burst
+ * - Times are 32-bit milliseconds and compared with wrap-around, so the
+ *   clock may roll over (every ~49 days)
+ *
+ * A linear scan is used: the gateway has a handful of events, which is
+ * cheaper than keeping a wheel or heap ordered.
+ */
+
+#ifndef EVENT_SCHEDULER_H
+#define EVENT_SCHEDULER_H
+
+#include <Arduino.h>
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+#define SCHEDULER_MAX_EVENTS     12
+#define SCHEDULER_NONE           -1          // takeDue(): nothing due
+#define SCHEDULER_IDLE           0xFFFFFFFFUL  // timeUntilNext(): no event armed
+
+class EventScheduler {
+ public:
+  EventScheduler() {
+    for (uint8_t i = 0; i < SCHEDULER_MAX_EVENTS; i++) {
+      _events[i].period = 0;
+      _events[i].due = 0;
+      _events[i].enabled = false;
+    }
+  }
+
+  /**
+   * Arm a periodic event
+   * @param id     Event slot, 0 to SCHEDULER_MAX_EVENTS - 1
+   * @param period Interval in ms (0 = one-shot)
+   * @param now    Current scheduler time in ms
+   * @param delay  Time until the first occurrence
+   */
+  bool schedule(uint8_t id, uint32_t period, uint32_t now, uint32_t delay) {
+    if (id >= SCHEDULER_MAX_EVENTS) {
+      return false;
+    }
+    _events[id].period = period;
+    _events[id].due = now + delay;
+    _events[id].enabled = true;
+    return true;
+  }
+
+  void disable(uint8_t id) {
+    if (id < SCHEDULER_MAX_EVENTS) {
+      _events[id].enabled = false;
+    }
+  }
+
+  /**
+   * Pop the most overdue event and re-arm it
+   * @return Event id, or SCHEDULER_NONE if nothing is due
+   */
+  int takeDue(uint32_t now) {
+    int best = SCHEDULER_NONE;
+    int32_t bestLate = -1;
+
+    for (uint8_t i = 0; i < SCHEDULER_MAX_EVENTS; i++) {
+      if (!_events[i].enabled) {
+        continue;
+      }
+      int32_t late = (int32_t)(now - _events[i].due);
+      if (late > bestLate) {
+        best = i;
+        bestLate = late;
+      }
+    }
+
+    if (best != SCHEDULER_NONE) {
+      ScheduledEvent& event = _events[best];
+      if (event.period == 0) {
+        event.enabled = false;
+      } else if ((uint32_t)bestLate >= event.period) {
+        event.due = now + event.period;  // Missed occurrences: no burst
+      } else {
+        event.due += event.period;       // Keep the original phase
+      }
+    }
+    return best;
+  }
+
+  /**
+   * Time until the next armed event
+   * @return ms (0 if something is overdue), SCHEDULER_IDLE if none is armed
+   */
+  uint32_t timeUntilNext(uint32_t now) const {
+    uint32_t next = SCHEDULER_IDLE;
+
+    for (uint8_t i = 0; i < SCHEDULER_MAX_EVENTS; i++) {
+      if (!_events[i].enabled) {
+        continue;
+      }
+      int32_t wait = (int32_t)(_events[i].due - now);
+      if (wait <= 0) {
+        return 0;
+      }
+      if ((uint32_t)wait < next) {
+        next = wait;
+      }
+    }
+    return next;
+  }
+
+  /**
+   * Time until one event is due
+   * @return ms (0 if overdue), SCHEDULER_IDLE if the event is not armed
+   */
+  uint32_t timeUntil(uint8_t id, uint32_t now) const {
+    if (id >= SCHEDULER_MAX_EVENTS || !_events[id].enabled) {
+      return SCHEDULER_IDLE;
+    }
+    int32_t wait = (int32_t)(_events[id].due - now);
+    return (wait > 0) ? (uint32_t)wait : 0;
+  }
+
+ private:
+  struct ScheduledEvent {
+    uint32_t period;
+    uint32_t due;
+    bool enabled;
+  };
+
+  ScheduledEvent _events[SCHEDULER_MAX_EVENTS];
+};
+
+#endif  // EVENT_SCHEDULER_H
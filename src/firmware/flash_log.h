@@ -0,0 +1,220 @@
+/**
+ * Flash Log (store-and-forward)
+ *
+ * Append-only record log in a reserved region of SAMD21 program flash,
+ * used by the gateway to keep readings while no uplink is available and
+ * to replay them once a link is back.
+ *
+ * Layout: the region is a circle of 64-byte slots (one flash page each,
+ * four per 256-byte erase row):
+ *
+ *   seq(4) type(1) length(1) crc16(2) sent(4) payload(52)
+ *
+ * - seq:    record sequence number, increments forever
+ * - crc16:  CRC-16/MODBUS over seq, type, length and payload
+ * - sent:   0xFFFFFFFF when written, programmed to 0 once replayed
+ *           (a 1 -> 0 rewrite of one word, no erase needed)
+ *
+ * Wear levelling comes from the append-only order: a row is erased only
+ * when the head enters it, so every row is erased once per lap. When the
+ * log is full the oldest unsent records in that row are dropped and
+ * counted.
+ *
+ * begin() rebuilds head and replay cursor by scanning the slots, so the
+ * log survives resets and power loss. A torn write leaves a slot with a
+ * bad CRC, which is skipped. The region is part of the sketch image:
+ * uploading new firmware clears it.
+ */
+
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <Arduino.h>
+#include <FlashStorage.h>
+#include "../lorawan/crc16.h"
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+#define FLASH_LOG_SLOT_SIZE      64          // One flash page
+#define FLASH_LOG_ROW_SIZE       256         // SAMD21 erase granularity
+#define FLASH_LOG_SLOTS_PER_ROW  (FLASH_LOG_ROW_SIZE / FLASH_LOG_SLOT_SIZE)
+#define FLASH_LOG_HEADER_SIZE    12
+#define FLASH_LOG_MAX_PAYLOAD    (FLASH_LOG_SLOT_SIZE - FLASH_LOG_HEADER_SIZE)
+#define FLASH_LOG_UNSENT         0xFFFFFFFFUL
+
+/**
+ * Record as stored in one slot
+ */
+struct FlashLogRecord {
+  uint32_t seq;
+  uint8_t type;
+  uint8_t length;
+  uint16_t crc;
+  uint32_t sent;
+  uint8_t payload[FLASH_LOG_MAX_PAYLOAD];
+};
+
+static_assert(sizeof(FlashLogRecord) == FLASH_LOG_SLOT_SIZE, "FlashLogRecord must fill one slot");
+
+class FlashLog {
+ public:
+  /**
+   * @param flash FlashClass bound to the region
+   * @param base  Start of the region (256-byte aligned)
+   * @param size  Region size in bytes (multiple of FLASH_LOG_ROW_SIZE)
+   */
+  FlashLog(FlashClass& flash, const volatile void* base, uint32_t size)
+    : _flash(flash), _base((const volatile uint8_t*)base),
+      _slots(size / FLASH_LOG_SLOT_SIZE), _head(0), _cursor(0),
+      _nextSeq(0), _pending(0), _dropped(0), _batchSlots(0), _batchValid(0) {}
+
+  /**
+   * Scan the region and restore head, replay cursor and sequence number
+   */
+  void begin() {
+    bool any = false;
+    bool anyUnsent = false;
+    uint32_t newestSeq = 0;
+    uint32_t oldestUnsentSeq = 0;
+
+    for (uint32_t slot = 0; slot < _slots; slot++) {
+      FlashLogRecord record;
+      if (!readSlot(slot, record)) {
+        continue;
+      }
+
+      if (!any || (int32_t)(record.seq - newestSeq) > 0) {
+        newestSeq = record.seq;
+        _head = (slot + 1) % _slots;
+        any = true;
+      }
+      if (record.sent == FLASH_LOG_UNSENT &&
+          (!anyUnsent || (int32_t)(record.seq - oldestUnsentSeq) < 0)) {
+        oldestUnsentSeq = record.seq;
+        _cursor = slot;
+        anyUnsent = true;
+      }
+    }
+
+    _nextSeq = any ? newestSeq + 1 : 0;
+    if (anyUnsent) {
+      _pending = _nextSeq - oldestUnsentSeq;
+    } else {
+      _cursor = _head;
+      _pending = 0;
+    }
+    _batchSlots = 0;
+  }
+
+  /**
+   * Append a record
+   * @return false if the payload does not fit in a slot
+   */
+  bool append(uint8_t type, const void* data, uint8_t length) {
+    if (length > FLASH_LOG_MAX_PAYLOAD) {
+      return false;
+    }
+
+    // Entering a new row: erase it, dropping any unsent records it held
+    if (_head % FLASH_LOG_SLOTS_PER_ROW == 0) {
+      uint32_t keep = _slots - FLASH_LOG_SLOTS_PER_ROW;
+      if (_pending > keep) {
+        uint32_t lost = _pending - keep;
+        _cursor = (_cursor + lost) % _slots;
+        _pending -= lost;
+        _dropped += lost;
+        _batchSlots = 0;
+      }
+      _flash.erase(slotAddress(_head), FLASH_LOG_ROW_SIZE);
+    }
+
+    FlashLogRecord record;
+    memset(&record, 0xFF, sizeof(record));
+    record.seq = _nextSeq;
+    record.type = type;
+    record.length = length;
+    memcpy(record.payload, data, length);
+    record.crc = recordCrc(record);
+    record.sent = FLASH_LOG_UNSENT;
+
+    _flash.write(slotAddress(_head), &record, sizeof(record));
+
+    _head = (_head + 1) % _slots;
+    _nextSeq++;
+    _pending++;
+    return true;
+  }
+
+  /**
+   * Read up to `max` unsent records, oldest first. Corrupt slots are
+   * skipped. Call commit() once the batch has been delivered.
+   * @return Number of records written to `records`
+   */
+  uint8_t peek(FlashLogRecord* records, uint8_t max) {
+    _batchSlots = 0;
+    _batchValid = 0;
+
+    while (_batchValid < max && _batchSlots < _pending) {
+      uint32_t slot = (_cursor + _batchSlots) % _slots;
+      _batchSlots++;
+      if (readSlot(slot, records[_batchValid])) {
+        _batchValid++;
+      }
+    }
+    return _batchValid;
+  }
+
+  /**
+   * Mark the records returned by the last peek() as sent
+   */
+  void commit() {
+    for (uint32_t i = 0; i < _batchSlots; i++) {
+      uint32_t sent = 0;
+      uint32_t slot = (_cursor + i) % _slots;
+      _flash.write(slotAddress(slot) + offsetof(FlashLogRecord, sent), &sent, sizeof(sent));
+    }
+
+    _cursor = (_cursor + _batchSlots) % _slots;
+    _pending -= _batchSlots;
+    _batchSlots = 0;
+  }
+
+  uint32_t pending() const { return _pending; }
+  uint32_t dropped() const { return _dropped; }
+  uint32_t capacity() const { return _slots; }
+
+ private:
+  const volatile uint8_t* slotAddress(uint32_t slot) const {
+    return _base + slot * FLASH_LOG_SLOT_SIZE;
+  }
+
+  static uint16_t recordCrc(const FlashLogRecord& record) {
+    uint16_t crc = crc16Update(CRC16_INIT, &record, offsetof(FlashLogRecord, crc));
+    return crc16Update(crc, record.payload, record.length);
+  }
+
+  bool readSlot(uint32_t slot, FlashLogRecord& record) {
+    _flash.read(slotAddress(slot), &record, sizeof(record));
+
+    return record.seq != 0xFFFFFFFFUL &&
+           record.length <= FLASH_LOG_MAX_PAYLOAD &&
+           record.crc == recordCrc(record);
+  }
+
+  FlashClass& _flash;
+  const volatile uint8_t* _base;
+  uint32_t _slots;
+
+  uint32_t _head;          // Next slot to write
+  uint32_t _cursor;        // Oldest unsent slot
+  uint32_t _nextSeq;
+  uint32_t _pending;       // Slots from cursor to head
+  uint32_t _dropped;       // Unsent records overwritten while full
+
+  uint32_t _batchSlots;    // Slots covered by the last peek()
+  uint8_t _batchValid;
+};
+
+#endif  // FLASH_LOG_H
@@ -0,0 +1,227 @@
+/**
+ * JSON Writer
+ *
+ * Streaming JSON output straight into a caller-owned buffer (the MQTT /
+ * serial transmit buffer) without printf. Numbers are written as integers;
+ * floats are rounded to fixed point (value * 10^decimals) first, so the
+ * float printf of newlib-nano is never linked in.
+ *
+ * Every write is length-checked: output that does not fit is dropped, the
+ * buffer stays NUL-terminated and overflow() reports it. Commas between
+ * members and elements are inserted automatically. Rounding is done in
+ * float, so the last digit can differ from printf by one near a .5 tie.
+ *
+ *   JsonWriter json(buffer, sizeof(buffer));
+ *   json.beginObject();
+ *   json.fieldString("type", "sensor");
+ *   json.fieldFloat("temp", 21.456f, 2);   // "temp":21.46
+ *   json.endObject();
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+#define JSON_MAX_DECIMALS 6
+
+// ===========================================
+// WRITER
+// ===========================================
+
+class JsonWriter {
+ public:
+  JsonWriter(char* buffer, size_t size)
+    : _buffer(buffer), _size(size), _length(0),
+      _first(true), _afterKey(false), _overflow(size == 0) {
+    if (size > 0) {
+      _buffer[0] = '\0';
+    }
+  }
+
+  void beginObject() { separator(); put('{'); _first = true; }
+  void endObject() { put('}'); _first = false; }
+  void beginArray() { separator(); put('['); _first = true; }
+  void endArray() { put(']'); _first = false; }
+
+  /**
+   * Member name; the next value belongs to it
+   */
+  void key(const char* name) {
+    separator();
+    quoted(name);
+    put(':');
+    _afterKey = true;
+  }
+
+  void valueUInt(uint32_t value) {
+    separator();
+    digits(value, 0);
+  }
+
+  void valueInt(int32_t value) {
+    separator();
+    if (value < 0) {
+      put('-');
+      digits((uint32_t)0 - (uint32_t)value, 0);
+    } else {
+      digits((uint32_t)value, 0);
+    }
+  }
+
+  /**
+   * Fixed-point value: 12345 with 2 decimals is written as 123.45
+   */
+  void valueFixed(int32_t value, uint8_t decimals) {
+    separator();
+    if (value < 0) {
+      put('-');
+    }
+    uint32_t magnitude = value < 0 ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+    digits(magnitude, decimals > JSON_MAX_DECIMALS ? JSON_MAX_DECIMALS : decimals);
+  }
+
+  /**
+   * Float rounded half away from zero to `decimals` places. NaN and values
+   * outside the int32 fixed-point range are written as null.
+   */
+  void valueFloat(float value, uint8_t decimals) {
+    static const float scales[JSON_MAX_DECIMALS + 1] = {
+      1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f, 100000.0f, 1000000.0f
+    };
+    if (decimals > JSON_MAX_DECIMALS) {
+      decimals = JSON_MAX_DECIMALS;
+    }
+
+    float scaled = value * scales[decimals];
+    if (!(scaled > -2147483520.0f && scaled < 2147483520.0f)) {
+      valueNull();
+      return;
+    }
+    valueFixed((int32_t)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f), decimals);
+  }
+
+  void valueBool(bool value) {
+    separator();
+    raw(value ? "true" : "false");
+  }
+
+  void valueNull() {
+    separator();
+    raw("null");
+  }
+
+  void valueString(const char* value) {
+    separator();
+    quoted(value);
+  }
+
+  void fieldUInt(const char* name, uint32_t value) { key(name); valueUInt(value); }
+  void fieldInt(const char* name, int32_t value) { key(name); valueInt(value); }
+  void fieldFixed(const char* name, int32_t value, uint8_t decimals) {
+    key(name);
+    valueFixed(value, decimals);
+  }
+  void fieldFloat(const char* name, float value, uint8_t decimals) {
+    key(name);
+    valueFloat(value, decimals);
+  }
+  void fieldBool(const char* name, bool value) { key(name); valueBool(value); }
+  void fieldString(const char* name, const char* value) { key(name); valueString(value); }
+
+  const char* c_str() const { return _buffer; }
+  size_t length() const { return _length; }
+  bool overflow() const { return _overflow; }
+
+ private:
+  // Latches: once anything was dropped, nothing more is appended
+  void put(char c) {
+    if (_overflow || _length + 1 >= _size) {
+      _overflow = true;
+      return;
+    }
+    _buffer[_length++] = c;
+    _buffer[_length] = '\0';
+  }
+
+  void raw(const char* text) {
+    while (*text) {
+      put(*text++);
+    }
+  }
+
+  // Comma before every member / element but the first
+  void separator() {
+    if (_afterKey) {
+      _afterKey = false;
+      return;
+    }
+    if (!_first) {
+      put(',');
+    }
+    _first = false;
+  }
+
+  void quoted(const char* text) {
+    static const char hex[] = "0123456789abcdef";
+    put('"');
+    for (; text != nullptr && *text; text++) {
+      uint8_t c = (uint8_t)*text;
+      if (c == '"' || c == '\\') {
+        put('\\');
+        put((char)c);
+      } else if (c < 0x20) {
+        raw("\\u00");
+        put(hex[c >> 4]);
+        put(hex[c & 0x0F]);
+      } else {
+        put((char)c);
+      }
+    }
+    put('"');
+  }
+
+  /**
+   * Decimal digits of `value` with a point before the last `decimals`
+   * digits, written least significant first and reversed in place
+   */
+  void digits(uint32_t value, uint8_t decimals) {
+    size_t start = _length;
+    uint8_t count = 0;
+
+    do {
+      if (decimals > 0 && count == decimals) {
+        put('.');
+      }
+      put((char)('0' + value % 10));
+      value /= 10;
+      count++;
+    } while (value > 0 || count <= decimals);
+
+    if (_overflow) {
+      // Never leave a partial (reversed) number behind
+      _length = start < _length ? start : _length;
+      _buffer[_length] = '\0';
+      return;
+    }
+    for (size_t i = start, j = _length - 1; i < j; i++, j--) {
+      char c = _buffer[i];
+      _buffer[i] = _buffer[j];
+      _buffer[j] = c;
+    }
+  }
+
+  char* _buffer;
+  size_t _size;
+  size_t _length;
+  bool _first;
+  bool _afterKey;
+  bool _overflow;
+};
+
+#endif  // JSON_WRITER_H
@@ -13,14 +13,14 @@
  *
  * Key Features:
  * - I2C multiplexer (TCA9548A) control for dual Nicla Vision cameras
- * - Serial1 communication with Nicla Sense Me
+ * - Serial1 communication with Nicla Sense Me (DMA receive ring)
  * - Serial2/3 communication with dual Nicla Vision boards
  * - Data aggregation and binary/JSON formatting
  * - LoRaWAN OTAA with adaptive data rate
  * - WiFi fallback with MQTT support
  * - Non-blocking state machine architecture
  * - Comprehensive error handling and retry logic
- * - Low-power sleep modes
+ * - Deadline scheduler with RTC-alarm standby between events
  * - Watchdog timer integration
  * - RTCC backup for timestamp continuity
  *
@@ -57,6 +57,7 @@
 #include <SPI.h>
 #include <FlashStorage.h>
 #include <RTCZero.h>
+#include <wiring_private.h>
 #include <Adafruit_SleepyDog.h>
 
 // LoRaWAN library - supports both MKRWAN.h and ArduinoLoRaWAN.h
@@ -70,6 +71,30 @@
 #include <WiFiNINA.h>
 #include <ArduinoMqttClient.h>
 
+// Compact sensor codec (shared with the LoRaWAN node and backend decoder)
+#include "../lorawan/sensor_codec.h"
+#include "../lorawan/crc16.h"
+#include "serial_frame.h"
+#include "uart_dma_rx.h"
+#include "event_scheduler.h"
+#include "flash_log.h"
+#include "mqtt_publisher.h"
+#include "json_writer.h"
+#define TRACE_LEVEL 1                // Statistics only: no event ring in the SAMD21's 32 KB
+#include "../lorawan/trace.h"
+
+// Duty cycle tables follow the LoRaWAN region selected below
+#if defined(US)
+  #define CFG_us915
+#elif defined(AUSTRALIA)
+  #define CFG_au915
+#elif defined(ASIA)
+  #define CFG_as923
+#else
+  #define CFG_eu868
+#endif
+#include "transport_router.h"
+
 // ===========================================
 // CONFIGURATION CONSTANTS
 // ===========================================
@@ -82,6 +107,18 @@
 #define SERIAL_SENSOR            Serial1    // Nicla Sense Me
 #define SERIAL_VISION_1          Serial2    // Nicla Vision #1 (if using Serial2)
 #define SERIAL_VISION_2          Serial3    // Nicla Vision #2 (if using Serial3)
+#define VISION_SERIAL_ENABLED    0          // 1 once Serial2/3 are mapped to SERCOM UARTs
+
+// DMA receive (uart_dma_rx.h): SERCOM and DMAC channel behind each port
+#define SERIAL_SENSOR_SERCOM     SERCOM5    // Serial1 on the MKR boards
+#define SERIAL_SENSOR_DMA_TRIG   SERCOM5_DMAC_ID_RX
+#define SERIAL_SENSOR_DMA_CH     0
+#define SERIAL_VISION_1_SERCOM   SERCOM3    // Match the Uart definitions for Serial2/3
+#define SERIAL_VISION_1_DMA_TRIG SERCOM3_DMAC_ID_RX
+#define SERIAL_VISION_1_DMA_CH   1
+#define SERIAL_VISION_2_SERCOM   SERCOM1
+#define SERIAL_VISION_2_DMA_TRIG SERCOM1_DMAC_ID_RX
+#define SERIAL_VISION_2_DMA_CH   2
 
 // I2C Configuration
 #define I2C_SDA                  11
@@ -130,6 +167,8 @@ static const int MQTT_PORT              = 1883;
 static const char* MQTT_TOPIC_SENSOR    = "iot/sensors";
 static const char* MQTT_TOPIC_VISION    = "iot/vision";
 static const char* MQTT_TOPIC_STATUS    = "iot/status";
+static const char* MQTT_TOPIC_SENSOR_BIN = "iot/sensors/bin";  // Concatenated SensorDataPackets
+static const char* MQTT_CLIENT_ID       = "mkr-wan-gateway";
 
 // Timing Constants (non-blocking)
 #define LORAWAN_TRANSMIT_INTERVAL  60000      // 60 seconds between LoRa transmissions
@@ -138,11 +177,35 @@ static const char* MQTT_TOPIC_STATUS    = "iot/status";
 #define CAMERA_POLL_INTERVAL       1000       // 1 second between camera polls
 #define HEARTBEAT_INTERVAL         30000      // 30 seconds heartbeat
 #define WATCHDOG_FEED_INTERVAL     8000       // Feed watchdog every 8 seconds
+#define BATTERY_CHECK_INTERVAL     60000      // 1 minute between battery checks
+#define LORAWAN_RETRY_INTERVAL     30000      // 30 seconds between rejoin attempts
+#define LOW_POWER_MIN_SLEEP        2000       // Shortest standby worth entering (ms)
+
+// Store-and-forward log (flash_log.h)
+#define FLASH_LOG_SIZE             65536      // Reserved program flash (1024 records)
+#define BACKFILL_INTERVAL          20000      // 20 seconds between backfill batches
+#define BACKFILL_GUARD             5000       // Skip backfill if a live uplink is due sooner
+#define BACKFILL_PORT              7          // LoRaWAN FPort: concatenated SensorDataPackets
+#define BACKFILL_LORA_RECORDS      2          // Records per confirmed LoRaWAN uplink (21 B each)
+#define BACKFILL_WIFI_RECORDS      8          // Records per MQTT backfill batch
+#define BACKFILL_LORA_BURST        1          // LoRaWAN frames per backfill event
+#define BACKFILL_WIFI_BURST        4          // MQTT batches per backfill event
+
+// Transport routing
+#define ALARM_PORT                 4          // LoRaWAN FPort: DetectionDataPacket (LORAWAN_PORT_DETECTION)
+#define ALARM_HOLDOFF              10000      // Minimum time between alarms per camera
+#define STATS_UPLOAD_INTERVAL      WIFI_TRANSMIT_INTERVAL  // Bulk statistics over WiFi
+
+// MQTT batching
+#define MQTT_BINARY_PAYLOADS       1          // 0 = one JSON message per reading on iot/sensors
+#define MQTT_BATCH_RECORDS         8          // Readings per binary MQTT message
+#define MQTT_BATCH_MAX_AGE         WIFI_TRANSMIT_INTERVAL  // Oldest reading a batch may hold
+#define MQTT_SERVICE_INTERVAL      5000       // Reconnect / in-flight housekeeping
 
 // Buffer Sizes
 #define DATA_BUFFER_SIZE           512
 #define JSON_BUFFER_SIZE           768
-#define LORA_PAYLOAD_MAX_SIZE      242        // Max LoRaWAN payload (EU868)
+#define LORA_PAYLOAD_MAX_SIZE      LoRaWANRegion::largestPayload()  // Region plan maximum
 
 // Retry Configuration
 #define MAX_LORA_JOIN_RETRIES      5
@@ -194,6 +257,8 @@ struct SystemStats {
   uint32_t cameraReadCount;     // Total camera reads
   uint32_t errorCount;          // Total errors
   uint16_t loraJoinRetries;     // LoRaWAN join retry count
+  uint32_t serialDroppedBytes;  // UART bytes lost to receive ring overruns
+  uint32_t serialFrameErrors;   // Frames rejected (CRC or framing)
   uint8_t batteryLevel;         // Battery level (0-100%)
   float batteryVoltage;         // Battery voltage
   bool lowBattery;              // Low battery warning flag
@@ -208,6 +273,21 @@ SensorData sensorData = {0};
 VisionData visionData[2] = {0};  // Array for 2 cameras
 SystemStats systemStats = {0};
 
+// DMA-backed serial ports and frame receivers, one per link
+UartDmaRx sensorPort(SERIAL_SENSOR, SERIAL_SENSOR_SERCOM, SERIAL_SENSOR_DMA_TRIG,
+                     SERIAL_SENSOR_DMA_CH);
+SerialFrameReceiver sensorLinkRx;
+
+#if VISION_SERIAL_ENABLED
+UartDmaRx visionPorts[2] = {
+  UartDmaRx(SERIAL_VISION_1, SERIAL_VISION_1_SERCOM, SERIAL_VISION_1_DMA_TRIG,
+            SERIAL_VISION_1_DMA_CH),
+  UartDmaRx(SERIAL_VISION_2, SERIAL_VISION_2_SERCOM, SERIAL_VISION_2_DMA_TRIG,
+            SERIAL_VISION_2_DMA_CH)
+};
+#endif
+SerialFrameReceiver visionLinkRx[2];
+
 // Communication objects
 #ifdef ARDUINO_SAMD_MKRWAN1310
   LoRaModem modem;
@@ -217,6 +297,8 @@ SystemStats systemStats = {0};
 
 WiFiClient wifiClient;
 MqttClient mqttClient(wifiClient);
+MqttPublisher mqttPublisher(mqttClient, MQTT_BROKER, MQTT_PORT, MQTT_CLIENT_ID);
+PacketBatch sensorBatch;           // Readings waiting for the next MQTT message
 
 RTCZero rtc;
 
@@ -239,11 +321,23 @@ typedef enum {
 SystemState currentState = STATE_INIT;
 SystemState previousState = STATE_INIT;
 
+// Scheduled events (event_scheduler.h slots)
+typedef enum {
+  EVENT_SENSOR_READ,             // Request a reading from the Nicla Sense Me
+  EVENT_CAMERA_POLL,             // Poll the Nicla Vision cameras
+  EVENT_TRANSMIT,                // Aggregate and uplink
+  EVENT_HEARTBEAT,               // Print statistics
+  EVENT_BATTERY_CHECK,           // Sample the battery
+  EVENT_LORAWAN_RETRY,           // Rejoin while disconnected
+  EVENT_BACKFILL,                // Replay stored readings
+  EVENT_STATS_UPLOAD,            // Publish system statistics (WiFi only)
+  EVENT_MQTT_SERVICE             // MQTT reconnect and batch age check
+} ScheduledEventId;
+
 // Timing variables
-unsigned long lastTransmitTime = 0;
-unsigned long lastSensorReadTime = 0;
-unsigned long lastCameraPollTime = 0;
-unsigned long lastHeartbeatTime = 0;
+EventScheduler scheduler;
+uint32_t standbyMillis = 0;      // Time spent in standby, where millis() stops
+volatile bool serialWakePending = false;
 unsigned long lastWatchdogFeedTime = 0;
 unsigned long stateEnterTime = 0;
 
@@ -252,10 +346,18 @@ bool lorawanConnected = false;
 bool wifiConnected = false;
 bool mqttConnected = false;
 
+// Uplink selection and pending detection alarms
+TransportRouter router;
+DetectionDataPacket alarmPacket[2];
+bool alarmPending[2] = {false, false};
+uint32_t lastAlarmTime[2] = {0, 0};
+
 // Data buffers
 char dataBuffer[DATA_BUFFER_SIZE];
 char jsonBuffer[JSON_BUFFER_SIZE];
 uint8_t loraPayload[LORA_PAYLOAD_MAX_SIZE];
+size_t loraPayloadSize = 0;
+SensorCodecState loraCodecState;   // Delta reference for formatLoRaWANPayload()
 
 // Error handling
 char lastErrorMessage[256];
@@ -277,6 +379,12 @@ struct Config {
 Config config;
 FlashStorage(flash_config, Config);
 
+// Store-and-forward log region, reserved in program flash
+__attribute__((__aligned__(FLASH_LOG_ROW_SIZE)))
+static const uint8_t flashLogArea[FLASH_LOG_SIZE] = {};
+FlashClass flashLogFlash(flashLogArea, FLASH_LOG_SIZE);
+FlashLog flashLog(flashLogFlash, flashLogArea, FLASH_LOG_SIZE);
+
 // ===========================================
 // FUNCTION PROTOTYPES
 // ===========================================
@@ -318,19 +426,33 @@ void readCameraData(uint8_t cameraId);
 bool processSensorSerialData(void);
 bool processCameraSerialData(uint8_t cameraId);
 bool requestSensorData(void);
+bool handleSerialFrame(const SerialFrame& frame);
+void updateSerialLinkStats(void);
 bool requestCameraData(uint8_t cameraId);
 
 // Data processing
-void aggregateData(void);
-void formatSensorDataJSON(void);
-void formatVisionDataJSON(uint8_t cameraId);
+bool aggregateData(void);
+void formatSensorDataJSON(JsonWriter& json);
+void formatVisionDataJSON(JsonWriter& json, uint8_t cameraId);
 void formatLoRaWANPayload(void);
-void formatSystemStatsJSON(void);
+bool formatSystemStatsJSON(void);
 
 // Transmission
 bool transmitLoRaWAN(void);
 bool transmitWiFi(void);
 bool transmitMQTT(const char* topic, const char* payload);
+bool transmitMQTT(const char* topic, const uint8_t* data, size_t length);
+bool flushSensorBatch(bool spill);
+bool sendLoRaWANFrame(uint8_t port, const uint8_t* data, size_t length, bool confirmed);
+void updateTransportLinks(void);
+void sendPendingAlarms(void);
+bool transmitAlarm(uint8_t cameraId, TransportLink link);
+void uploadSystemStats(void);
+void buildSensorPacket(SensorDataPacket& packet, uint8_t status);
+void storeReading(void);
+void backfillStoredReadings(void);
+bool transmitBackfillLoRaWAN(const FlashLogRecord* records, uint8_t count);
+bool transmitBackfillMQTT(const FlashLogRecord* records, uint8_t count);
 bool reconnectLoRaWAN(void);
 bool reconnectWiFi(void);
 bool reconnectMQTT(void);
@@ -338,6 +460,9 @@ bool reconnectMQTT(void);
 // Power management
 void enterLowPowerMode(uint32_t sleepMs);
 void wakeFromLowPowerMode(void);
+void onSerialWake(void);
+uint32_t schedulerMillis(void);
+void scheduleEvents(void);
 void feedWatchdog(void);
 void checkBatteryLevel(void);
 bool prepareSleep(void);
@@ -396,6 +521,11 @@ void setup() {
     Serial.println("Default configuration saved");
   }
 
+  // Restore the store-and-forward log
+  flashLog.begin();
+  Serial.print("Stored readings awaiting replay: ");
+  Serial.println(flashLog.pending());
+
   // Initialize watchdog timer (8 seconds timeout)
   int watchdogSeconds = 0;
   #ifdef ADAFRUIT_SLEEPYDOG_H
@@ -424,8 +554,20 @@ void setup() {
 
   // Initialize sensor serial port
   Serial.println("\n=== Sensor Serial Port ===");
-  SERIAL_SENSOR.begin(SERIAL_BAUD);
-  Serial.println("Serial1 initialized for Nicla Sense Me");
+  if (sensorPort.begin(SERIAL_BAUD)) {
+    Serial.println("Serial1 initialized for Nicla Sense Me (DMA receive)");
+  } else {
+    Serial.println("ERROR: Serial1 DMA channel unavailable");
+  }
+
+  #if VISION_SERIAL_ENABLED
+    for (uint8_t i = 0; i < 2; i++) {
+      if (!visionPorts[i].begin(SERIAL_BAUD)) {
+        Serial.print("ERROR: Vision serial DMA channel unavailable for camera ");
+        Serial.println(i);
+      }
+    }
+  #endif
 
   // Initialize LoRaWAN
   Serial.println("\n=== LoRaWAN Initialization ===");
@@ -451,6 +593,8 @@ void setup() {
   Serial.println("Starting main loop...");
   blinkLED(LED_STATUS, 3, 100);
 
+  scheduleEvents();
+
   currentState = STATE_IDLE;
   stateEnterTime = millis();
 }
@@ -471,16 +615,19 @@ void loop() {
   }
 
   // Update system statistics
-  if (currentTime % 1000 == 0) {
-    systemStats.uptime = currentTime / 1000;
-  }
+  systemStats.uptime = schedulerMillis() / 1000;
 
   // Run state machine
   runStateMachine();
 
-  // Process incoming serial data from sensors (non-blocking)
-  if (SERIAL_SENSOR.available()) {
+  // Process incoming serial data (received by DMA while we were busy)
+  if (uartDmaTakePending() || sensorPort.available()) {
     processSensorSerialData();
+    #if VISION_SERIAL_ENABLED
+      processCameraSerialData(0);
+      processCameraSerialData(1);
+    #endif
+    updateSerialLinkStats();
   }
 
   // Maintain WiFi connection
@@ -492,24 +639,20 @@ void loop() {
     }
   }
 
-  // Maintain MQTT connection
+  // Maintain MQTT connection (reconnects run from EVENT_MQTT_SERVICE)
   if (wifiConnected && mqttConnected) {
-    mqttClient.poll();
-    if (!mqttClient.connected()) {
+    mqttPublisher.poll();
+    if (!mqttPublisher.connected()) {
       mqttConnected = false;
       Serial.println("MQTT connection lost");
     }
   }
+  updateTransportLinks();
 
-  // Check battery level
-  static unsigned long lastBatteryCheck = 0;
-  if (currentTime - lastBatteryCheck >= 60000) {  // Check every minute
-    lastBatteryCheck = currentTime;
-    checkBatteryLevel();
+  // Nothing due: idle the core until the next interrupt (SysTick, DMA, radio)
+  if (currentState == STATE_IDLE && scheduler.timeUntilNext(schedulerMillis()) > 0) {
+    __WFI();
   }
-
-  // Small delay to prevent watchdog issues
-  delay(10);
 }
 
 // ===========================================
@@ -598,6 +741,7 @@ void handleConnectLoRaWANState(void) {
 
       if (initializeLoRaWAN()) {
         lorawanConnected = true;
+        sensorCodecReset(loraCodecState);  // New session starts with a keyframe
         setStatusLED(LED_LORA, true);
         Serial.println("LoRaWAN connected successfully");
         retries = 0;
@@ -654,56 +798,73 @@ void handleConnectWiFiState(void) {
 }
 
 void handleIdleState(void) {
-  unsigned long currentTime = millis();
+  uint32_t now = schedulerMillis();
 
-  // Check for scheduled tasks
-  bool taskScheduled = false;
+  // Detections do not wait for the next transmit slot
+  sendPendingAlarms();
 
-  // Time to read sensors?
-  if (currentTime - lastSensorReadTime >= (config.sensorReadInterval * 1000)) {
-    enterState(STATE_READING_SENSORS);
-    taskScheduled = true;
-  }
+  // Run the most overdue event, one per pass
+  switch (scheduler.takeDue(now)) {
+    case EVENT_SENSOR_READ:
+      enterState(STATE_READING_SENSORS);
+      return;
 
-  // Time to poll cameras?
-  if (!taskScheduled && (currentTime - lastCameraPollTime >= CAMERA_POLL_INTERVAL)) {
-    enterState(STATE_READING_CAMERAS);
-    taskScheduled = true;
-  }
+    case EVENT_CAMERA_POLL:
+      enterState(STATE_READING_CAMERAS);
+      return;
 
-  // Time to transmit via LoRaWAN?
-  if (!taskScheduled && lorawanConnected &&
-      (currentTime - lastTransmitTime >= (config.transmitInterval * 60000))) {
-    enterState(STATE_PROCESSING_DATA);
-    taskScheduled = true;
-  }
+    case EVENT_TRANSMIT:
+      // Always process: without a link the reading goes to the flash log
+      enterState(STATE_PROCESSING_DATA);
+      return;
 
-  // Time for heartbeat?
-  if (!taskScheduled && (currentTime - lastHeartbeatTime >= HEARTBEAT_INTERVAL)) {
-    lastHeartbeatTime = currentTime;
-    printSystemStats();
-  }
+    case EVENT_HEARTBEAT:
+      printSystemStats();
+      break;
 
-  // Check for LoRaWAN reconnection if needed
-  if (!lorawanConnected && (currentTime % 30000 < 100)) {
-    // Every 30 seconds, try to reconnect
-    handleConnectLoRaWANState();
+    case EVENT_BATTERY_CHECK:
+      checkBatteryLevel();
+      break;
+
+    case EVENT_LORAWAN_RETRY:
+      if (!lorawanConnected) {
+        handleConnectLoRaWANState();
+      }
+      break;
+
+    case EVENT_BACKFILL:
+      backfillStoredReadings();
+      break;
+
+    case EVENT_STATS_UPLOAD:
+      uploadSystemStats();
+      break;
+
+    case EVENT_MQTT_SERVICE:
+      if (config.enableWiFiFallback) {
+        mqttPublisher.service(now, wifiConnected);
+        mqttConnected = mqttPublisher.connected();
+      }
+      if (sensorBatch.due(MQTT_BATCH_RECORDS, MQTT_BATCH_MAX_AGE, now)) {
+        flushSensorBatch(false);
+      }
+      break;
+
+    default:
+      break;
   }
 
-  // Enter low power mode if enabled and no tasks scheduled
-  if (!taskScheduled && config.enableLowPowerMode) {
-    // Only enter low power if nothing to do for at least 1 second
-    unsigned long timeToNextTask = config.sensorReadInterval * 1000 -
-                                   (currentTime - lastSensorReadTime);
-    if (timeToNextTask >= 1000) {
-      enterState(STATE_LOW_POWER);
-    }
+  // Sleep until the next event if low power mode is enabled.
+  // Standby gates the SERCOM clocks, so drain the receive rings first
+  if (config.enableLowPowerMode &&
+      scheduler.timeUntilNext(now) >= LOW_POWER_MIN_SLEEP &&
+      sensorPort.available() == 0) {
+    enterState(STATE_LOW_POWER);
   }
 }
 
 void handleReadingSensorsState(void) {
   Serial.println("\n=== Reading Sensors ===");
-  lastSensorReadTime = millis();
 
   // Request data from sensor
   if (requestSensorData()) {
@@ -737,7 +898,6 @@ void handleReadingSensorsState(void) {
 
 void handleReadingCamerasState(void) {
   Serial.println("\n=== Reading Cameras ===");
-  lastCameraPollTime = millis();
 
   // Read from both cameras
   for (uint8_t i = 0; i < 2; i++) {
@@ -775,17 +935,22 @@ void handleReadingCamerasState(void) {
 void handleProcessingDataState(void) {
   Serial.println("\n=== Processing Data ===");
 
-  // Aggregate all sensor and vision data
-  aggregateData();
+  // Codec frame on LoRaWAN while the duty cycle allows, JSON over WiFi
+  // otherwise; the payload is only built once the link is known
+  switch (router.route(MSG_SENSOR, SENSOR_CODEC_MAX_FRAME, config.loraDataRate, schedulerMillis())) {
+    case LINK_LORAWAN:
+      enterState(STATE_TRANSMITTING_LORAWAN);
+      break;
 
-  // Determine transmission method
-  if (lorawanConnected) {
-    enterState(STATE_TRANSMITTING_LORAWAN);
-  } else if (wifiConnected && config.enableWiFiFallback) {
-    enterState(STATE_TRANSMITTING_WIFI);
-  } else {
-    Serial.println("No connection available for transmission");
-    currentState = STATE_IDLE;
+    case LINK_WIFI:
+      enterState(STATE_TRANSMITTING_WIFI);
+      break;
+
+    default:
+      Serial.println("No connection available for transmission");
+      storeReading();
+      currentState = STATE_IDLE;
+      break;
   }
 }
 
@@ -794,7 +959,6 @@ void handleTransmittingLoRaWANState(void) {
 
   if (transmitLoRaWAN()) {
     systemStats.loraTransmitCount++;
-    lastTransmitTime = millis();
     Serial.println("LoRaWAN transmission successful");
     blinkLED(LED_LORA, 2, 100);
   } else {
@@ -802,11 +966,12 @@ void handleTransmittingLoRaWANState(void) {
     Serial.println("LoRaWAN transmission failed");
 
     // Try WiFi fallback
-    if (wifiConnected && config.enableWiFiFallback) {
+    if (router.usable(LINK_WIFI, schedulerMillis())) {
       Serial.println("Falling back to WiFi");
       enterState(STATE_TRANSMITTING_WIFI);
       return;
     }
+    storeReading();
   }
 
   currentState = STATE_IDLE;
@@ -816,13 +981,12 @@ void handleTransmittingWiFiState(void) {
   Serial.println("\n=== Transmitting via WiFi ===");
 
   if (transmitWiFi()) {
-    systemStats.wifiTransmitCount++;
-    lastTransmitTime = millis();
     Serial.println("WiFi transmission successful");
     blinkLED(LED_WIFI, 2, 100);
   } else {
     systemStats.errorCount++;
     Serial.println("WiFi transmission failed");
+    storeReading();
   }
 
   currentState = STATE_IDLE;
@@ -830,14 +994,12 @@ void handleTransmittingWiFiState(void) {
 
 void handleLowPowerMode(void) {
   Serial.println("\n=== Entering Low Power Mode ===");
-  Serial.flush();
 
-  // Calculate sleep time (wake up before next sensor read)
-  unsigned long timeToNextRead = (config.sensorReadInterval * 1000) -
-                                  (millis() - lastSensorReadTime);
-  uint32_t sleepMs = min(timeToNextRead - 1000, (unsigned long)5000); // Max 5 seconds
-
-  enterLowPowerMode(sleepMs);
+  // Sleep until the next scheduled event
+  uint32_t sleepMs = scheduler.timeUntilNext(schedulerMillis());
+  if (sleepMs >= LOW_POWER_MIN_SLEEP && sleepMs != SCHEDULER_IDLE) {
+    enterLowPowerMode(sleepMs);
+  }
 
   currentState = STATE_IDLE;
 }
@@ -1038,12 +1200,8 @@ bool saveConfiguration(void) {
 }
 
 uint32_t calculateChecksum(const Config* cfg) {
-  uint32_t sum = 0;
-  const uint8_t* data = (const uint8_t*)cfg;
-  for (size_t i = 0; i < sizeof(Config) - sizeof(uint32_t); i++) {
-    sum += data[i];
-  }
-  return sum;
+  // Same CRC16 as the LoRaWAN packets (a byte sum misses swapped bytes)
+  return crc16(cfg, offsetof(Config, checksum));
 }
 
 // ===========================================
@@ -1099,8 +1257,7 @@ bool testI2CDevice(uint8_t address) {
 // ===========================================
 
 bool requestSensorData(void) {
-  SERIAL_SENSOR.println("REQ");
-  return true;
+  return serialFrameWrite(SERIAL_SENSOR, SERIAL_FRAME_REQUEST, 0, nullptr, 0);
 }
 
 bool requestCameraData(uint8_t cameraId) {
@@ -1116,72 +1273,110 @@ bool requestCameraData(uint8_t cameraId) {
 }
 
 bool processSensorSerialData(void) {
-  static char buffer[256];
-  static int index = 0;
-
-  while (SERIAL_SENSOR.available()) {
-    char c = SERIAL_SENSOR.read();
-
-    if (c == '\n') {
-      buffer[index] = '\0';
+  SerialFrame frame;
 
-      // Parse data format: "SENS:temp,humidity,pressure,gas,iaq,timestamp"
-      if (strncmp(buffer, "SENS:", 5) == 0) {
-        char* ptr = buffer + 5;
+  // Dispatch every frame; only a sensor packet answers the request
+  while (sensorLinkRx.poll(sensorPort, frame)) {
+    TRACE_BEGIN(TRACE_UART_RX);
+    bool handled = handleSerialFrame(frame);
+    TRACE_END(TRACE_UART_RX);
 
-        sensorData.temperature = atof(ptr);
-        ptr = strchr(ptr, ',') + 1;
-
-        sensorData.humidity = atof(ptr);
-        ptr = strchr(ptr, ',') + 1;
-
-        sensorData.pressure = atof(ptr);
-        ptr = strchr(ptr, ',') + 1;
+    if (handled && frame.type == PACKET_TYPE_SENSOR) {
+      return true;
+    }
+  }
 
-        sensorData.gasResistance = atof(ptr);
-        ptr = strchr(ptr, ',') + 1;
+  return false;
+}
 
-        sensorData.iaq = atof(ptr);
-        ptr = strchr(ptr, ',') + 1;
+bool processCameraSerialData(uint8_t cameraId) {
+#if VISION_SERIAL_ENABLED
+  SerialFrame frame;
+  while (visionLinkRx[cameraId].poll(visionPorts[cameraId], frame)) {
+    TRACE_BEGIN(TRACE_UART_RX);
+    bool handled = handleSerialFrame(frame);
+    TRACE_END(TRACE_UART_RX);
+
+    if (handled && frame.type == PACKET_TYPE_DETECTION && frame.source == cameraId) {
+      return true;
+    }
+  }
+#else
+  (void)cameraId;
+#endif
 
-        sensorData.timestamp = strtoul(ptr, NULL, 10);
-        sensorData.valid = true;
+  return false;
+}
 
-        Serial.println("  Data received from Nicla Sense Me");
-        Serial.print("    Temperature: ");
-        Serial.print(sensorData.temperature, 1);
-        Serial.println(" °C");
-        Serial.print("    Humidity: ");
-        Serial.print(sensorData.humidity, 1);
-        Serial.println(" %");
-        Serial.print("    Pressure: ");
-        Serial.print(sensorData.pressure, 1);
-        Serial.println(" hPa");
-        Serial.print("    IAQ: ");
-        Serial.println(sensorData.iaq, 0);
+void updateSerialLinkStats(void) {
+  systemStats.serialDroppedBytes = sensorPort.droppedBytes();
+  systemStats.serialFrameErrors = sensorLinkRx.crcErrors + sensorLinkRx.framingErrors;
 
-        index = 0;
-        return true;
-      }
+  for (uint8_t i = 0; i < 2; i++) {
+    #if VISION_SERIAL_ENABLED
+      systemStats.serialDroppedBytes += visionPorts[i].droppedBytes();
+    #endif
+    systemStats.serialFrameErrors += visionLinkRx[i].crcErrors + visionLinkRx[i].framingErrors;
+  }
+}
 
-      index = 0;
-    } else if (index < sizeof(buffer) - 1) {
-      buffer[index++] = c;
+bool handleSerialFrame(const SerialFrame& frame) {
+  if (frame.type == PACKET_TYPE_SENSOR) {
+    SensorDataPacket packet;
+    if (!serialFramePacket(frame, packet)) {
+      return false;
     }
+
+    sensorData.temperature = packet.temperature / 100.0f;
+    sensorData.humidity = packet.humidity / 100.0f;
+    sensorData.pressure = packet.pressure / 10.0f;
+    sensorData.gasResistance = packet.gasResistance;
+    sensorData.iaq = packet.iaq;
+    sensorData.timestamp = packet.timestamp;
+    sensorData.valid = true;
+
+    Serial.println("  Data received from Nicla Sense Me");
+    Serial.print("    Temperature: ");
+    Serial.print(sensorData.temperature, 1);
+    Serial.println(" °C");
+    Serial.print("    Humidity: ");
+    Serial.print(sensorData.humidity, 1);
+    Serial.println(" %");
+    Serial.print("    Pressure: ");
+    Serial.print(sensorData.pressure, 1);
+    Serial.println(" hPa");
+    Serial.print("    IAQ: ");
+    Serial.println(sensorData.iaq, 0);
+    return true;
   }
 
-  return false;
-}
+  if (frame.type == PACKET_TYPE_DETECTION) {
+    DetectionDataPacket packet;
+    if (frame.source >= 2 || !serialFramePacket(frame, packet)) {
+      return false;
+    }
 
-bool processCameraSerialData(uint8_t cameraId) {
-  // Implement camera data parsing based on your protocol
-  // This is a placeholder - implement based on actual camera data format
-
-  // Example format: "CAM:id,class,confidence,x,y,w,h,timestamp"
-  // For now, just mark as valid if any data available
-  if (SERIAL_SENSOR.available()) {
-    visionData[cameraId].valid = true;
-    visionData[cameraId].timestamp = millis();
+    VisionData& vision = visionData[frame.source];
+    switch (packet.detectionType) {
+      case DETECTION_TYPE_PERSON:  vision.detectedClass = 1; break;
+      case DETECTION_TYPE_VEHICLE: vision.detectedClass = 2; break;
+      case DETECTION_TYPE_ANIMAL:  vision.detectedClass = 3; break;
+      default:                     vision.detectedClass = 0; break;
+    }
+    vision.cameraId = frame.source;
+    vision.confidence = packet.confidence / 100.0f;
+    vision.timestamp = packet.timestamp;
+    vision.detectionCount++;
+    vision.valid = true;
+
+    // Person / vehicle / animal raise an alarm, at most one per holdoff
+    uint32_t now = schedulerMillis();
+    if (vision.detectedClass != 0 &&
+        (alarmPending[frame.source] || lastAlarmTime[frame.source] == 0 ||
+         now - lastAlarmTime[frame.source] >= ALARM_HOLDOFF)) {
+      alarmPacket[frame.source] = packet;
+      alarmPending[frame.source] = true;
+    }
     return true;
   }
 
@@ -1202,124 +1397,109 @@ void readCameraData(uint8_t cameraId) {
 // DATA PROCESSING FUNCTIONS
 // ===========================================
 
-void aggregateData(void) {
+bool aggregateData(void) {
   // Create aggregated JSON payload
-  formatSensorDataJSON();
+  JsonWriter json(jsonBuffer, JSON_BUFFER_SIZE);
+  json.beginObject();
+  formatSensorDataJSON(json);
 
   // Add vision data if available
   if (visionData[0].valid || visionData[1].valid) {
+    json.key("vision");
+    json.beginArray();
     for (uint8_t i = 0; i < 2; i++) {
       if (visionData[i].valid) {
-        formatVisionDataJSON(i);
+        formatVisionDataJSON(json, i);
       }
     }
+    json.endArray();
   }
-}
 
-void formatSensorDataJSON(void) {
-  int charsWritten = snprintf(
-    jsonBuffer,
-    JSON_BUFFER_SIZE,
-    "{\"type\":\"sensor\","
-    "\"temp\":%.2f,"
-    "\"hum\":%.2f,"
-    "\"pres\":%.2f,"
-    "\"gas\":%.0f,"
-    "\"iaq\":%.0f,"
-    "\"ts\":%lu,"
-    "\"uptime\":%lu}",
-    sensorData.temperature,
-    sensorData.humidity,
-    sensorData.pressure,
-    sensorData.gasResistance,
-    sensorData.iaq,
-    sensorData.timestamp,
-    systemStats.uptime
-  );
-
-  if (charsWritten < 0 || charsWritten >= JSON_BUFFER_SIZE) {
+  json.endObject();
+
+  if (json.overflow()) {
     Serial.println("ERROR: JSON buffer overflow");
+    return false;
   }
+  return true;
 }
 
-void formatVisionDataJSON(uint8_t cameraId) {
-  char visionJson[256];
-  int charsWritten = snprintf(
-    visionJson,
-    sizeof(visionJson),
-    "{\"type\":\"vision\","
-    "\"cam\":%d,"
-    "\"class\":%d,"
-    "\"conf\":%.2f,"
-    "\"ts\":%lu}",
-    visionData[cameraId].cameraId,
-    visionData[cameraId].detectedClass,
-    visionData[cameraId].confidence,
-    visionData[cameraId].timestamp
-  );
+void formatSensorDataJSON(JsonWriter& json) {
+  json.fieldString("type", "sensor");
+  json.fieldFloat("temp", sensorData.temperature, 2);
+  json.fieldFloat("hum", sensorData.humidity, 2);
+  json.fieldFloat("pres", sensorData.pressure, 2);
+  json.fieldFloat("gas", sensorData.gasResistance, 0);
+  json.fieldFloat("iaq", sensorData.iaq, 0);
+  json.fieldUInt("ts", sensorData.timestamp);
+  json.fieldUInt("uptime", systemStats.uptime);
+}
 
-  if (charsWritten > 0 && charsWritten < (int)sizeof(visionJson)) {
-    // Could append to main JSON or send separately
-  }
+void formatVisionDataJSON(JsonWriter& json, uint8_t cameraId) {
+  json.beginObject();
+  json.fieldString("type", "vision");
+  json.fieldUInt("cam", visionData[cameraId].cameraId);
+  json.fieldUInt("class", visionData[cameraId].detectedClass);
+  json.fieldFloat("conf", visionData[cameraId].confidence, 2);
+  json.fieldUInt("ts", visionData[cameraId].timestamp);
+  json.endObject();
 }
 
 void formatLoRaWANPayload(void) {
-  // Create binary payload for LoRaWAN (more efficient than JSON)
-  // Format: [type(1), temp(2), hum(2), pres(2), gas(2), flags(1)]
-  // Type: 0x01 = sensor data
-
-  loraPayload[0] = 0x01;  // Packet type: sensor data
-
-  // Convert floats to uint16_t (scale by 100)
-  int16_t temp = (int16_t)(sensorData.temperature * 100);
-  uint16_t hum = (uint16_t)(sensorData.humidity * 100);
-  uint16_t pres = (uint16_t)(sensorData.pressure * 10);
-  uint16_t gas = (uint16_t)(sensorData.gasResistance);
-
-  // Pack data (big-endian)
-  loraPayload[1] = (temp >> 8) & 0xFF;
-  loraPayload[2] = temp & 0xFF;
-  loraPayload[3] = (hum >> 8) & 0xFF;
-  loraPayload[4] = hum & 0xFF;
-  loraPayload[5] = (pres >> 8) & 0xFF;
-  loraPayload[6] = pres & 0xFF;
-  loraPayload[7] = (gas >> 8) & 0xFF;
-  loraPayload[8] = gas & 0xFF;
-
-  // Flags byte
+  // Encode with the compact sensor codec (keyframe or 4-6 byte delta)
+  // Status byte flags: 0x01 = sensor valid, 0x02/0x04 = camera 0/1 valid
+  SensorReading reading;
+  reading.temperature = sensorData.temperature;
+  reading.humidity = sensorData.humidity;
+  reading.pressure = sensorData.pressure;
+  reading.gasResistance = sensorData.gasResistance;
+  reading.iaq = (uint16_t)sensorData.iaq;
+  reading.battery = systemStats.batteryLevel;
+
   uint8_t flags = 0;
   flags |= (sensorData.valid ? 0x01 : 0x00);
   flags |= (visionData[0].valid ? 0x02 : 0x00);
   flags |= (visionData[1].valid ? 0x04 : 0x00);
-  loraPayload[9] = flags;
-
-  // Payload size
-  uint8_t payloadSize = 10;
-}
-
-void formatSystemStatsJSON(void) {
-  snprintf(
-    jsonBuffer,
-    JSON_BUFFER_SIZE,
-    "{\"type\":\"stats\","
-    "\"uptime\":%lu,"
-    "\"lorawan\":{\"tx\":%lu,\"connected\":%s},"
-    "\"wifi\":{\"tx\":%lu,\"connected\":%s},"
-    "\"errors\":%lu,"
-    "\"battery\":{"
-    "\"level\":%d,"
-    "\"voltage\":%.2f,"
-    "\"low\":%s}}",
-    systemStats.uptime,
-    systemStats.loraTransmitCount,
-    lorawanConnected ? "true" : "false",
-    systemStats.wifiTransmitCount,
-    wifiConnected ? "true" : "false",
-    systemStats.errorCount,
-    systemStats.batteryLevel,
-    systemStats.batteryVoltage,
-    systemStats.lowBattery ? "true" : "false"
-  );
+  reading.status = flags;
+
+  loraPayloadSize = sensorCodecEncode(loraCodecState, reading, loraPayload, LORA_PAYLOAD_MAX_SIZE);
+}
+
+bool formatSystemStatsJSON(void) {
+  JsonWriter json(jsonBuffer, JSON_BUFFER_SIZE);
+  json.beginObject();
+  json.fieldString("type", "stats");
+  json.fieldUInt("uptime", systemStats.uptime);
+
+  json.key("lorawan");
+  json.beginObject();
+  json.fieldUInt("tx", systemStats.loraTransmitCount);
+  json.fieldBool("connected", lorawanConnected);
+  json.endObject();
+
+  json.key("wifi");
+  json.beginObject();
+  json.fieldUInt("tx", systemStats.wifiTransmitCount);
+  json.fieldBool("connected", wifiConnected);
+  json.endObject();
+
+  json.fieldUInt("airtime", router.loraAirtimeUsed(schedulerMillis()));
+  json.fieldUInt("errors", systemStats.errorCount);
+
+  json.key("battery");
+  json.beginObject();
+  json.fieldInt("level", systemStats.batteryLevel);
+  json.fieldFloat("voltage", systemStats.batteryVoltage, 2);
+  json.fieldBool("low", systemStats.lowBattery);
+  json.endObject();
+
+  json.endObject();
+
+  if (json.overflow()) {
+    Serial.println("ERROR: JSON buffer overflow");
+    return false;
+  }
+  return true;
 }
 
 // ===========================================
@@ -1335,31 +1515,51 @@ bool transmitLoRaWAN(void) {
 
     // Format payload
     formatLoRaWANPayload();
+    if (loraPayloadSize == 0) {
+      Serial.println("  ERROR: Payload encoding failed");
+      return false;
+    }
 
-    // Begin packet
+    if (sendLoRaWANFrame(SENSOR_CODEC_PORT, loraPayload, loraPayloadSize, true)) {
+      Serial.println("  Packet sent successfully");
+      return true;
+    }
+    return false;
+  #else
+    return false;
+  #endif
+}
+
+bool sendLoRaWANFrame(uint8_t port, const uint8_t* data, size_t length, bool confirmed) {
+  #ifdef ARDUINO_SAMD_MKRWAN1310
+    unsigned long start = millis();
+
+    TRACE_SCOPE(TRACE_LORA_TX);
+    modem.setPort(port);
     int result = modem.beginPacket();
     if (result != 1) {
       Serial.print("  ERROR: beginPacket failed (");
       Serial.print(result);
       Serial.println(")");
+      router.reportResult(LINK_LORAWAN, false, 0, schedulerMillis());
       return false;
     }
 
-    // Write payload
-    modem.write(loraPayload, 10);
+    modem.write(data, length);
+    result = modem.endPacket(confirmed);
 
-    // End packet and send
-    result = modem.endPacket(true);
+    // The frame was on air whether or not it was acknowledged
+    uint32_t now = schedulerMillis();
+    router.recordLoRaAirtime(length, config.loraDataRate, now);
+    router.reportResult(LINK_LORAWAN, result > 0, millis() - start, now);
 
-    if (result > 0) {
-      Serial.println("  Packet sent successfully");
-      return true;
-    } else {
+    if (result <= 0) {
       Serial.print("  ERROR: Packet send failed (");
       Serial.print(result);
       Serial.println(")");
       return false;
     }
+    return true;
   #else
     return false;
   #endif
@@ -1371,41 +1571,279 @@ bool transmitWiFi(void) {
     return false;
   }
 
-  // Format data
-  formatSensorDataJSON();
-
-  // Send via MQTT if connected
-  if (mqttConnected) {
-    return transmitMQTT(MQTT_TOPIC_SENSOR, jsonBuffer);
-  } else {
-    // Fallback: HTTP POST (implement if needed)
+  if (!mqttConnected) {
     Serial.println("  WiFi available but MQTT not connected");
     return false;
   }
+
+  #if MQTT_BINARY_PAYLOADS
+    // Coalesce: one binary message per MQTT_BATCH_RECORDS readings
+    SensorDataPacket packet;
+    buildSensorPacket(packet, STATUS_SENSOR_OK);
+
+    uint32_t now = schedulerMillis();
+    if (!sensorBatch.add(&packet, sizeof(packet), now)) {
+      flushSensorBatch(true);
+      sensorBatch.add(&packet, sizeof(packet), now);
+    }
+
+    if (sensorBatch.due(MQTT_BATCH_RECORDS, MQTT_BATCH_MAX_AGE, now)) {
+      flushSensorBatch(false);
+    }
+    return true;
+  #else
+    if (!aggregateData() || !transmitMQTT(MQTT_TOPIC_SENSOR, jsonBuffer)) {
+      return false;
+    }
+    systemStats.wifiTransmitCount++;
+    return true;
+  #endif
+}
+
+bool flushSensorBatch(bool spill) {
+  if (sensorBatch.count == 0) {
+    return true;
+  }
+
+  if (transmitMQTT(MQTT_TOPIC_SENSOR_BIN, sensorBatch.data, sensorBatch.length)) {
+    systemStats.wifiTransmitCount++;
+    sensorBatch.clear();
+    return true;
+  }
+
+  // Make room: hand the batch to the flash log for backfill
+  if (spill) {
+    for (uint16_t offset = 0; offset < sensorBatch.length; offset += sizeof(SensorDataPacket)) {
+      flashLog.append(PACKET_TYPE_SENSOR, sensorBatch.data + offset, sizeof(SensorDataPacket));
+    }
+    sensorBatch.clear();
+  }
+  return false;
 }
 
 bool transmitMQTT(const char* topic, const char* payload) {
-  if (!mqttClient.connected()) {
+  return transmitMQTT(topic, (const uint8_t*)payload, strlen(payload));
+}
+
+bool transmitMQTT(const char* topic, const uint8_t* data, size_t length) {
+  if (!mqttPublisher.connected()) {
     Serial.println("  ERROR: MQTT not connected");
     return false;
   }
 
-  Serial.print("  Publishing to '");
+  Serial.print("  Publishing ");
+  Serial.print(length);
+  Serial.print(" bytes to '");
   Serial.print(topic);
   Serial.println("'...");
 
-  if (mqttClient.beginMessage(topic)) {
-    mqttClient.print(payload);
-    if (mqttClient.endMessage()) {
-      Serial.println("  MQTT message sent successfully");
-      return true;
-    }
+  unsigned long start = millis();
+  if (mqttPublisher.publish(topic, data, length, schedulerMillis())) {
+    router.reportResult(LINK_WIFI, true, millis() - start, schedulerMillis());
+    Serial.println("  MQTT message sent successfully");
+    return true;
   }
 
+  // A full in-flight window is back-pressure, not a link failure
+  if (mqttPublisher.inFlight() < MQTT_INFLIGHT_WINDOW) {
+    router.reportResult(LINK_WIFI, false, 0, schedulerMillis());
+  }
   Serial.println("  ERROR: MQTT message failed");
   return false;
 }
 
+// ===========================================
+// TRANSPORT ROUTING FUNCTIONS
+// ===========================================
+
+void updateTransportLinks(void) {
+  router.setLinkUp(LINK_LORAWAN, lorawanConnected);
+  router.setLinkUp(LINK_WIFI, config.enableWiFiFallback && wifiConnected && mqttConnected);
+}
+
+void sendPendingAlarms(void) {
+  for (uint8_t i = 0; i < 2; i++) {
+    if (!alarmPending[i]) {
+      continue;
+    }
+
+    TransportLink link = router.route(MSG_ALARM, sizeof(DetectionDataPacket),
+                                      config.loraDataRate, schedulerMillis());
+    if (link == LINK_NONE) {
+      continue;  // Kept pending until a link can take it
+    }
+
+    Serial.print("\n=== Alarm: camera ");
+    Serial.print(i);
+    Serial.println(link == LINK_WIFI ? " via WiFi ===" : " via LoRaWAN ===");
+
+    if (transmitAlarm(i, link)) {
+      alarmPending[i] = false;
+      lastAlarmTime[i] = schedulerMillis();
+      if (link == LINK_WIFI) {
+        systemStats.wifiTransmitCount++;
+      } else {
+        systemStats.loraTransmitCount++;
+      }
+    } else {
+      systemStats.errorCount++;
+    }
+  }
+}
+
+bool transmitAlarm(uint8_t cameraId, TransportLink link) {
+  if (link == LINK_LORAWAN) {
+    // Unconfirmed: an alarm is worth more early than acknowledged
+    return sendLoRaWANFrame(ALARM_PORT, (const uint8_t*)&alarmPacket[cameraId],
+                            sizeof(DetectionDataPacket), false);
+  }
+
+  // Confidence is already fixed point (percent)
+  const DetectionDataPacket& packet = alarmPacket[cameraId];
+  JsonWriter json(jsonBuffer, JSON_BUFFER_SIZE);
+  json.beginObject();
+  json.fieldString("type", "alarm");
+  json.fieldUInt("cam", cameraId);
+  json.fieldUInt("class", visionData[cameraId].detectedClass);
+  json.fieldFixed("conf", packet.confidence, 2);
+  json.fieldUInt("duration", packet.duration);
+  json.fieldUInt("ts", packet.timestamp);
+  json.endObject();
+
+  if (json.overflow()) {
+    Serial.println("ERROR: JSON buffer overflow");
+    return false;
+  }
+  return transmitMQTT(MQTT_TOPIC_VISION, jsonBuffer);
+}
+
+void uploadSystemStats(void) {
+  // Bulk JSON never goes over LoRaWAN; skip the slot without WiFi
+  if (router.route(MSG_STATS, 0, config.loraDataRate, schedulerMillis()) != LINK_WIFI) {
+    return;
+  }
+
+  if (formatSystemStatsJSON() && transmitMQTT(MQTT_TOPIC_STATUS, jsonBuffer)) {
+    systemStats.wifiTransmitCount++;
+  } else {
+    systemStats.errorCount++;
+  }
+}
+
+// ===========================================
+// STORE-AND-FORWARD FUNCTIONS
+// ===========================================
+
+void buildSensorPacket(SensorDataPacket& packet, uint8_t status) {
+  // Same fixed-point layout as the Nicla link; timestamp is RTC epoch
+  packet.magic = PACKET_MAGIC;
+  packet.type = PACKET_TYPE_SENSOR;
+  packet.timestamp = getTimestamp();
+  packet.temperature = (int16_t)(sensorData.temperature * 100);
+  packet.humidity = (uint16_t)(sensorData.humidity * 100);
+  packet.pressure = (uint16_t)(sensorData.pressure * 10);
+  packet.gasResistance = (uint16_t)min(sensorData.gasResistance, 65535.0f);
+  packet.iaq = (uint16_t)sensorData.iaq;
+  packet.status = status;
+  packet.battery = systemStats.batteryLevel;
+  packetSetChecksum(packet);
+}
+
+void storeReading(void) {
+  if (!sensorData.valid) {
+    return;
+  }
+
+  SensorDataPacket packet;
+  buildSensorPacket(packet, STATUS_SENSOR_OK | STATUS_NETWORK_ERROR);
+
+  if (flashLog.append(PACKET_TYPE_SENSOR, &packet, sizeof(packet))) {
+    Serial.print("  Reading stored for replay (");
+    Serial.print(flashLog.pending());
+    Serial.println(" pending)");
+  } else {
+    Serial.println("  ERROR: Failed to store reading");
+  }
+}
+
+void backfillStoredReadings(void) {
+  if (flashLog.pending() == 0) {
+    return;
+  }
+
+  // Live data has priority: stay clear of the next regular uplink
+  if (scheduler.timeUntil(EVENT_TRANSMIT, schedulerMillis()) < BACKFILL_GUARD) {
+    return;
+  }
+
+  // WiFi drains several batches per event; LoRaWAN only what the budget allows
+  const size_t loraSize = BACKFILL_LORA_RECORDS * sizeof(SensorDataPacket);
+  uint32_t now = schedulerMillis();
+  TransportLink link = router.route(MSG_BACKFILL, loraSize, config.loraDataRate, now);
+  uint8_t batches = router.burstFrames(link, loraSize, config.loraDataRate, now,
+                                       (link == LINK_WIFI) ? BACKFILL_WIFI_BURST
+                                                           : BACKFILL_LORA_BURST);
+
+  FlashLogRecord records[BACKFILL_WIFI_RECORDS];
+  uint32_t total = 0;
+
+  for (uint8_t batch = 0; batch < batches && flashLog.pending() > 0; batch++) {
+    uint8_t count;
+    bool sent;
+
+    if (link == LINK_LORAWAN) {
+      count = flashLog.peek(records, BACKFILL_LORA_RECORDS);
+      sent = (count == 0) || transmitBackfillLoRaWAN(records, count);
+    } else {
+      count = flashLog.peek(records, BACKFILL_WIFI_RECORDS);
+      sent = (count == 0) || transmitBackfillMQTT(records, count);
+    }
+
+    // count == 0: only corrupt slots were left in the batch, skip them
+    if (!sent) {
+      break;
+    }
+    flashLog.commit();
+    total += count;
+  }
+
+  if (total > 0) {
+    Serial.print("  Backfilled ");
+    Serial.print(total);
+    Serial.print(" readings, ");
+    Serial.print(flashLog.pending());
+    Serial.println(" pending");
+  }
+}
+
+bool transmitBackfillLoRaWAN(const FlashLogRecord* records, uint8_t count) {
+  size_t length = 0;
+  for (uint8_t i = 0; i < count && length + records[i].length <= LORA_PAYLOAD_MAX_SIZE; i++) {
+    memcpy(loraPayload + length, records[i].payload, records[i].length);
+    length += records[i].length;
+  }
+
+  // Confirmed: records are only marked sent once the network acks
+  return sendLoRaWANFrame(BACKFILL_PORT, loraPayload, length, true);
+}
+
+bool transmitBackfillMQTT(const FlashLogRecord* records, uint8_t count) {
+  // Same binary layout as live batches; the packets carry their own timestamps
+  PacketBatch batch;
+  batch.clear();
+  for (uint8_t i = 0; i < count; i++) {
+    if (records[i].type == PACKET_TYPE_SENSOR && records[i].length == sizeof(SensorDataPacket)) {
+      batch.add(records[i].payload, records[i].length, 0);
+    }
+  }
+  if (batch.count == 0) {
+    return true;
+  }
+
+  // A lost batch is resent whole: delivery is at-least-once
+  return transmitMQTT(MQTT_TOPIC_SENSOR_BIN, batch.data, batch.length);
+}
+
 bool reconnectLoRaWAN(void) {
   // Try to reconnect to LoRaWAN
   return initializeLoRaWAN();
@@ -1425,21 +1863,15 @@ bool reconnectMQTT(void) {
   Serial.print(MQTT_BROKER);
   Serial.println("'...");
 
-  mqttClient.setId("mkr-wan-gateway");
   mqttClient.onMessage([](int messageSize) {
     // Handle incoming MQTT messages
     Serial.println("Received MQTT message");
   });
 
-  if (mqttClient.connect(MQTT_BROKER, MQTT_PORT)) {
-    Serial.println("  MQTT connected");
-    mqttConnected = true;
-    return true;
-  } else {
-    Serial.println("  MQTT connection failed");
-    mqttConnected = false;
-    return false;
-  }
+  // Later drops are reconnected from EVENT_MQTT_SERVICE with backoff
+  mqttConnected = mqttPublisher.connect(schedulerMillis());
+  Serial.println(mqttConnected ? "  MQTT connected" : "  MQTT connection failed");
+  return mqttConnected;
 }
 
 // ===========================================
@@ -1447,28 +1879,94 @@ bool reconnectMQTT(void) {
 // ===========================================
 
 void enterLowPowerMode(uint32_t sleepMs) {
+  // The RTC alarm has 1 second resolution: round down to wake early
+  uint32_t sleepSeconds = sleepMs / 1000;
+  if (sleepSeconds == 0) {
+    return;
+  }
+
   Serial.print("  Sleeping for ");
-  Serial.print(sleepMs);
-  Serial.println(" ms...");
+  Serial.print(sleepSeconds);
+  Serial.println(" s...");
 
   Serial.flush();
 
+  uint32_t sleepStart = rtc.getEpoch();
+  rtc.setAlarmEpoch(sleepStart + sleepSeconds);
+  rtc.enableAlarm(rtc.MATCH_YYMMDDHHMMSS);
+
+  // Wake on a start bit from the Nicla Sense Me as well. The RX pin is
+  // handed to the EIC (level detection needs no clock in standby); the
+  // frame that wakes us is lost and counted as a framing error
+  serialWakePending = false;
+  attachInterrupt(digitalPinToInterrupt(PIN_SERIAL1_RX), onSerialWake, LOW);
+
   #ifdef ADAFRUIT_SLEEPYDOG_H
-    // Sleep with watchdog enabled
-    int actualSleep = Watchdog.sleep(sleepMs);
+    // The sleep may be longer than the watchdog timeout
+    Watchdog.disable();
+  #endif
 
-    Serial.print("  Woke after ");
-    Serial.print(actualSleep);
-    Serial.println(" ms");
-  #else
-    // Fallback: use delay
-    delay(sleepMs);
+  rtc.standbyMode();
+
+  #ifdef ADAFRUIT_SLEEPYDOG_H
+    Watchdog.enable(8000);
   #endif
+
+  detachInterrupt(digitalPinToInterrupt(PIN_SERIAL1_RX));
+  pinPeripheral(PIN_SERIAL1_RX, g_APinDescription[PIN_SERIAL1_RX].ulPinType);
+  rtc.disableAlarm();
+
+  // millis() does not advance in standby; account for it from the RTC
+  uint32_t sleptSeconds = rtc.getEpoch() - sleepStart;
+  standbyMillis += sleptSeconds * 1000;
+  TRACE_RECORD(TRACE_SLEEP, sleptSeconds * 1000000UL);  // micros() stops in standby too
+
+  Serial.print("  Woke after ");
+  Serial.print(sleptSeconds);
+  Serial.println(serialWakePending ? " s (serial)" : " s (alarm)");
+
+  wakeFromLowPowerMode();
 }
 
 void wakeFromLowPowerMode(void) {
   // Reinitialize peripherals if needed
   Serial.println("  Waking from low power mode");
+  feedWatchdog();
+}
+
+void onSerialWake(void) {
+  // Level interrupt: detach so it does not retrigger while RX is low
+  serialWakePending = true;
+  detachInterrupt(digitalPinToInterrupt(PIN_SERIAL1_RX));
+}
+
+// ===========================================
+// SCHEDULING FUNCTIONS
+// ===========================================
+
+uint32_t schedulerMillis(void) {
+  return millis() + standbyMillis;
+}
+
+void scheduleEvents(void) {
+  uint32_t now = schedulerMillis();
+  uint32_t sensorPeriod = config.sensorReadInterval * 1000UL;
+  uint32_t transmitPeriod = config.transmitInterval * 60000UL;
+
+  scheduler.schedule(EVENT_SENSOR_READ, sensorPeriod, now, sensorPeriod);
+  scheduler.schedule(EVENT_TRANSMIT, transmitPeriod, now, transmitPeriod);
+  scheduler.schedule(EVENT_HEARTBEAT, HEARTBEAT_INTERVAL, now, HEARTBEAT_INTERVAL);
+  scheduler.schedule(EVENT_BATTERY_CHECK, BATTERY_CHECK_INTERVAL, now, 0);
+  scheduler.schedule(EVENT_LORAWAN_RETRY, LORAWAN_RETRY_INTERVAL, now, LORAWAN_RETRY_INTERVAL);
+  scheduler.schedule(EVENT_BACKFILL, BACKFILL_INTERVAL, now, BACKFILL_INTERVAL);
+  scheduler.schedule(EVENT_STATS_UPLOAD, STATS_UPLOAD_INTERVAL, now, STATS_UPLOAD_INTERVAL);
+  scheduler.schedule(EVENT_MQTT_SERVICE, MQTT_SERVICE_INTERVAL, now, MQTT_SERVICE_INTERVAL);
+
+  // Camera frames need the vision links; without them polling only
+  // records failures and keeps the board from ever sleeping
+  #if VISION_SERIAL_ENABLED
+    scheduler.schedule(EVENT_CAMERA_POLL, CAMERA_POLL_INTERVAL, now, CAMERA_POLL_INTERVAL);
+  #endif
 }
 
 void feedWatchdog(void) {
@@ -1513,6 +2011,7 @@ bool prepareSleep(void) {
   // Prepare system for sleep
   // Disconnect WiFi to save power
   if (wifiConnected) {
+    flushSensorBatch(true);
     WiFi.disconnect();
     wifiConnected = false;
     setStatusLED(LED_WIFI, false);
@@ -1599,11 +2098,38 @@ void printSystemStats(void) {
   Serial.println(systemStats.wifiTransmitCount);
   Serial.print("Errors: ");
   Serial.println(systemStats.errorCount);
+  Serial.print("Serial dropped bytes: ");
+  Serial.println(systemStats.serialDroppedBytes);
+  Serial.print("Serial frame errors: ");
+  Serial.println(systemStats.serialFrameErrors);
+  Serial.print("Stored readings: ");
+  Serial.print(flashLog.pending());
+  Serial.print(" pending, ");
+  Serial.print(flashLog.dropped());
+  Serial.println(" dropped");
+  Serial.print("MQTT messages: ");
+  Serial.print(mqttPublisher.published());
+  Serial.print(" published, ");
+  Serial.print(mqttPublisher.inFlight());
+  Serial.print(" in flight, ");
+  Serial.print(mqttPublisher.replayed());
+  Serial.println(" replayed");
+  Serial.print("LoRaWAN airtime (1 h): ");
+  Serial.print(router.loraAirtimeUsed(schedulerMillis()));
+  Serial.print(" ms, send time ");
+  Serial.print(router.health(LINK_LORAWAN).latencyMs);
+  Serial.print(" ms / WiFi send time ");
+  Serial.print(router.health(LINK_WIFI).latencyMs);
+  Serial.println(" ms");
   Serial.print("Battery: ");
   Serial.print(systemStats.batteryLevel);
   Serial.print("% (");
   Serial.print(systemStats.batteryVoltage, 2);
   Serial.println("V)");
+#if TRACE_LEVEL > 0
+  Serial.println("Spans (us):");
+  tracer().printSummary(Serial);
+#endif
   Serial.println("========================\n");
 }
 
@@ -0,0 +1,239 @@
+/**
+ * MQTT Publisher
+ *
+ * Keeps one broker connection per gateway and publishes batches over it,
+ * instead of a JSON message per reading:
+ *
+ * - PacketBatch coalesces fixed-size binary records (SensorDataPacket,
+ *   21 bytes) into one message; a batch of 8 readings is 168 bytes
+ *   versus ~8 x 110 bytes of JSON, and no float formatting
+ * - Messages go out at QoS 1 with a persistent session, inside a window
+ *   of MQTT_INFLIGHT_WINDOW unconfirmed messages
+ * - service() reconnects in the background with exponential backoff;
+ *   the caller never blocks on a reconnect from loop()
+ *
+ * ArduinoMqttClient consumes PUBACKs in poll() without reporting them, so
+ * an in-flight message is retired once it has been out for
+ * MQTT_ACK_TIMEOUT on a live connection. Messages still in the window
+ * when the connection drops are republished with DUP set after the
+ * reconnect: delivery is at-least-once.
+ */
+
+#ifndef MQTT_PUBLISHER_H
+#define MQTT_PUBLISHER_H
+
+#include <Arduino.h>
+#include <ArduinoMqttClient.h>
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+#define MQTT_MESSAGE_MAX_SIZE    256         // Largest message kept for replay
+#define MQTT_INFLIGHT_WINDOW     4           // Unconfirmed QoS 1 messages
+#define MQTT_ACK_TIMEOUT         10000       // In-flight -> assumed delivered (ms)
+#define MQTT_RECONNECT_BASE      2000        // First reconnect backoff (ms)
+#define MQTT_RECONNECT_MAX       120000      // Longest reconnect backoff (ms)
+#define MQTT_CONNECT_TIMEOUT     3000        // CONNACK wait (ms)
+#define MQTT_KEEPALIVE           60000       // Broker keep-alive (ms)
+#define MQTT_QOS                 1
+
+/**
+ * Binary records accumulated for one message
+ */
+struct PacketBatch {
+  uint8_t data[MQTT_MESSAGE_MAX_SIZE];
+  uint16_t length;
+  uint8_t count;
+  uint32_t openedAt;           // Time of the first record
+
+  void clear() {
+    length = 0;
+    count = 0;
+  }
+
+  /**
+   * @return false if the record does not fit (flush first)
+   */
+  bool add(const void* record, size_t size, uint32_t now) {
+    if (length + size > sizeof(data)) {
+      return false;
+    }
+    if (count == 0) {
+      openedAt = now;
+    }
+    memcpy(data + length, record, size);
+    length += size;
+    count++;
+    return true;
+  }
+
+  /**
+   * True once the batch holds `records` records or is `maxAge` ms old
+   */
+  bool due(uint8_t records, uint32_t maxAge, uint32_t now) const {
+    return count > 0 && (count >= records || now - openedAt >= maxAge);
+  }
+};
+
+class MqttPublisher {
+ public:
+  MqttPublisher(MqttClient& client, const char* broker, int port, const char* clientId)
+    : _client(client), _broker(broker), _port(port), _clientId(clientId),
+      _connected(false), _failures(0), _retryAt(0), _head(0), _count(0),
+      _published(0), _replayed(0), _connects(0) {}
+
+  /**
+   * Connect now, ignoring the backoff (e.g. right after WiFi came up)
+   */
+  bool connect(uint32_t now) {
+    _client.setId(_clientId);
+    _client.setCleanSession(false);        // Broker keeps the session across reconnects
+    _client.setKeepAliveInterval(MQTT_KEEPALIVE);
+    _client.setConnectionTimeout(MQTT_CONNECT_TIMEOUT);
+
+    if (!_client.connect(_broker, _port)) {
+      _connected = false;
+      if (_failures < 16) {
+        _failures++;
+      }
+      uint32_t backoff = (_failures > 8) ? MQTT_RECONNECT_MAX
+                                         : MQTT_RECONNECT_BASE << (_failures - 1);
+      _retryAt = now + min(backoff, (uint32_t)MQTT_RECONNECT_MAX);
+      return false;
+    }
+
+    _connected = true;
+    _failures = 0;
+    _connects++;
+    replay(now);
+    return true;
+  }
+
+  /**
+   * Keep-alive and PUBACK processing; call every loop pass
+   */
+  void poll() {
+    if (!_connected) {
+      return;
+    }
+    _client.poll();
+    if (!_client.connected()) {
+      _connected = false;                  // In-flight messages wait for the reconnect
+    }
+  }
+
+  /**
+   * Background work: reconnect when the backoff has expired and retire
+   * in-flight messages that have been out long enough
+   * @param networkUp WiFi is associated
+   */
+  void service(uint32_t now, bool networkUp) {
+    if (!networkUp) {
+      _connected = false;
+      return;
+    }
+
+    if (!_connected) {
+      if (_failures == 0 || (int32_t)(now - _retryAt) >= 0) {
+        connect(now);
+      }
+      return;
+    }
+
+    while (_count > 0 && now - _window[_head].sentAt >= MQTT_ACK_TIMEOUT) {
+      _head = (_head + 1) % MQTT_INFLIGHT_WINDOW;
+      _count--;
+    }
+  }
+
+  /**
+   * Publish at QoS 1
+   * @return false if not connected, the window is full or the send failed
+   */
+  bool publish(const char* topic, const uint8_t* data, size_t length, uint32_t now) {
+    if (!_connected || length > MQTT_MESSAGE_MAX_SIZE) {
+      return false;
+    }
+
+    // Window full: retire the oldest if it has timed out, else back-pressure
+    service(now, true);
+    if (_count == MQTT_INFLIGHT_WINDOW) {
+      return false;
+    }
+
+    if (!send(topic, data, length, false)) {
+      return false;
+    }
+
+    InFlight& slot = _window[(_head + _count) % MQTT_INFLIGHT_WINDOW];
+    slot.topic = topic;
+    slot.length = length;
+    slot.sentAt = now;
+    memcpy(slot.data, data, length);
+    _count++;
+    _published++;
+    return true;
+  }
+
+  bool publish(const char* topic, const char* text, uint32_t now) {
+    return publish(topic, (const uint8_t*)text, strlen(text), now);
+  }
+
+  bool connected() const { return _connected; }
+  uint8_t inFlight() const { return _count; }
+  uint32_t published() const { return _published; }
+  uint32_t replayed() const { return _replayed; }
+  uint32_t connects() const { return _connects; }
+
+ private:
+  struct InFlight {
+    const char* topic;           // Points at a static topic string
+    uint16_t length;
+    uint32_t sentAt;
+    uint8_t data[MQTT_MESSAGE_MAX_SIZE];
+  };
+
+  bool send(const char* topic, const uint8_t* data, size_t length, bool dup) {
+    if (!_client.beginMessage(topic, (unsigned long)length, false, MQTT_QOS, dup)) {
+      return false;
+    }
+    _client.write(data, length);
+    if (!_client.endMessage()) {
+      _connected = _client.connected();
+      return false;
+    }
+    return true;
+  }
+
+  // Republish what was unconfirmed when the previous connection dropped
+  void replay(uint32_t now) {
+    for (uint8_t i = 0; i < _count; i++) {
+      InFlight& slot = _window[(_head + i) % MQTT_INFLIGHT_WINDOW];
+      if (!send(slot.topic, slot.data, slot.length, true)) {
+        return;
+      }
+      slot.sentAt = now;
+      _replayed++;
+    }
+  }
+
+  MqttClient& _client;
+  const char* _broker;
+  int _port;
+  const char* _clientId;
+
+  bool _connected;
+  uint8_t _failures;           // Consecutive failed connects
+  uint32_t _retryAt;
+
+  InFlight _window[MQTT_INFLIGHT_WINDOW];
+  uint8_t _head;
+  uint8_t _count;
+
+  uint32_t _published;
+  uint32_t _replayed;
+  uint32_t _connects;
+};
+
+#endif  // MQTT_PUBLISHER_H
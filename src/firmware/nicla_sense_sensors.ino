@@ -65,6 +65,15 @@
 #include <Arduino.h>
 #include <Arduino_BHY2.h>
 
+// Binary serial link to the gateway (Arduino_BHY2 declares its own
+// SensorDataPacket, so the shared packet types stay in iot_packets::)
+#define PACKET_TYPES_NO_GLOBAL
+#include "serial_frame.h"
+#include "sensor_stats.h"
+#include "batched_sensor.h"
+#include "json_writer.h"
+#include "../lorawan/trace.h"
+
 // Watchdog timer (optional)
 #ifdef ADAFRUIT_SLEEPYDOG_H
   #include <Adafruit_SleepyDog.h>
@@ -77,6 +86,7 @@
 // Serial communication
 #define SERIAL_BAUD              115200
 #define SERIAL_TIMEOUT           1000
+#define SERIAL_GATEWAY           Serial1    // UART to the MKR WAN gateway
 
 // Sensor configuration
 #define SENSOR_UPDATE_RATE       100        // Sensor update rate (100ms = 10Hz)
@@ -84,6 +94,14 @@
 #define SENSOR_LATENCY           NORMAL     // Sensor latency mode
 #define BSEC_STATE_SAVE_INTERVAL 3600000    // Save BSEC state every hour
 
+// Batched acquisition: the BHI260AP samples at SENSOR_SAMPLE_RATE into its
+// own FIFO and the host drains one batch per SENSOR_BATCH_LATENCY
+#define SENSOR_BATCHING          true       // false: read every SENSOR_READ_INTERVAL
+#define SENSOR_BATCH_LATENCY     30000      // Max time a sample waits in the FIFO (ms)
+#define BATCH_IDLE_SLEEP         100        // Loop sleep while batching (ms), bounds request latency
+// Define BHY2_INT_PIN to drain on the BHI260AP host interrupt (FIFO
+// watermark/latency) instead of the host-side latency timer
+
 // Timing (non-blocking)
 #define SENSOR_READ_INTERVAL     2000       // 2 seconds between sensor reads
 #define TRANSMIT_INTERVAL        5000       // 5 seconds between transmissions
@@ -91,6 +109,16 @@
 #define WATCHDOG_FEED_INTERVAL   8000       // Feed watchdog every 8 seconds
 #define CALIBRATION_INTERVAL     86400000   // 24 hours between calibration
 
+// Windowed statistics and report-on-change (sensor_stats.h)
+#define STATS_EWMA_ALPHA         0.2f       // EWMA weight of the newest sample
+#define STATS_OUTLIER_SIGMA      3.0f       // Anomaly if |x - mean| > sigma * stddev
+#define REPORT_WINDOW_SAMPLES    SENSOR_STATS_WINDOW  // Report at least once per window
+#define DEADBAND_TEMPERATURE     0.2f       // °C
+#define DEADBAND_HUMIDITY        1.0f       // %
+#define DEADBAND_PRESSURE        0.5f       // hPa
+#define DEADBAND_GAS             5000.0f    // Ohm
+#define DEADBAND_IAQ             10.0f      // IAQ index
+
 // Data validation thresholds
 #define TEMP_MIN                 -40.0      // Minimum temperature (°C)
 #define TEMP_MAX                 85.0       // Maximum temperature (°C)
@@ -160,6 +188,7 @@ struct SystemStats {
   uint32_t transmissions;       // Total transmissions
   uint32_t errors;              // Total errors
   uint16_t calibrationCount;    // Number of calibrations performed
+  uint32_t batchedSamples;      // Samples drained from the BHI260AP FIFO
   float avgTemperature;         // Average temperature
   float avgHumidity;            // Average humidity
   float avgPressure;            // Average pressure
@@ -167,6 +196,18 @@ struct SystemStats {
   float avgIaq;                 // Average IAQ
 };
 
+/**
+ * @brief Statistics channels, one ChannelStats each
+ */
+typedef enum {
+  STAT_TEMPERATURE,
+  STAT_HUMIDITY,
+  STAT_PRESSURE,
+  STAT_GAS,
+  STAT_IAQ,
+  STAT_CHANNELS
+} StatChannel;
+
 /**
  * @brief System state enumeration
  */
@@ -185,10 +226,12 @@ typedef enum {
 // ===========================================
 
 // Sensor objects (using Arduino_BHY2 library)
-SensorTemperature temperature(SENSOR_ID_TEMP);
-SensorHumidity humidity(SENSOR_ID_HUM);
-SensorPressure pressure(SENSOR_ID_BARO);
-SensorGas gas(SENSOR_ID_GAS);
+// Batched wrappers see every sample drained from the FIFO (batched_sensor.h)
+BatchedSensor<SensorTemperature> temperature(SENSOR_ID_TEMP);
+BatchedSensor<SensorHumidity> humidity(SENSOR_ID_HUM);
+BatchedSensor<SensorPressure> pressure(SENSOR_ID_BARO);
+BatchedSensor<SensorGas> gas(SENSOR_ID_GAS);
+volatile bool sensorInterrupt = false;   // Set by the BHI260AP host interrupt
 
 // Advanced sensors (if available)
 SensorGas gasSensorQR(SENSOR_ID_GAS_RGB);
@@ -221,6 +264,14 @@ unsigned long errorTime = 0;
 char dataBuffer[DATA_BUFFER_SIZE];
 char jsonBuffer[JSON_BUFFER_SIZE];
 
+// Gateway link
+SerialFrameReceiver gatewayRx;
+
+// Windowed statistics
+ChannelStats channelStats[STAT_CHANNELS];
+uint8_t samplesSinceReport = 0;
+bool anomalyActive = false;
+
 // Sensor calibration
 bool sensorCalibrated = false;
 float tempOffset = 0.0;
@@ -235,6 +286,8 @@ float presOffset = 0.0;
 bool initializeSystem(void);
 bool initializeSensors(void);
 bool calibrateSensors(void);
+void configureSensorRates(uint32_t latencyMs);
+void onSensorInterrupt(void);
 
 // State machine
 void runStateMachine(void);
@@ -247,6 +300,7 @@ void handleTransmittingState(void);
 void handleErrorState(void);
 
 // Sensor functions
+bool batchReady(void);
 void readSensors(void);
 bool validateSensorData(void);
 void applyCalibration(void);
@@ -254,14 +308,18 @@ uint8_t classifyIAQ(float iaq);
 const char* getIAQDescription(uint8_t classification);
 
 // Data processing
+void initializeStatistics(void);
 void processData(void);
 void calculateAverages(void);
 void detectAnomalies(void);
+bool shouldReport(void);
+void markReported(void);
 
 // Transmission functions
 bool transmitData(void);
-void formatSensorJSON(void);
-void formatStatusJSON(void);
+bool reportOnRequest(void);
+void buildSensorPacket(iot_packets::SensorDataPacket& packet);
+bool formatStatusJSON(void);
 
 // LED functions
 void setLED(uint8_t color);
@@ -284,7 +342,9 @@ uint32_t getFreeMemory(void);
 void setup() {
   // Initialize serial for debugging and communication
   Serial.begin(SERIAL_BAUD);
+  SERIAL_GATEWAY.begin(SERIAL_BAUD);
   delay(2000);  // Wait for serial monitor
+  tracer().begin();
 
   // Print system information
   printSystemInfo();
@@ -304,6 +364,9 @@ void setup() {
     return;
   }
 
+  // Windowed statistics (restarted again after each calibration)
+  initializeStatistics();
+
   // Calibrate sensors
   Serial.println("\n=== Sensor Calibration ===");
   enterState(STATE_CALIBRATING);
@@ -341,13 +404,14 @@ void loop() {
     lastWatchdogFeedTime = currentTime;
   }
 
-  // Update BHY2 sensors (must call regularly)
-  BHY2.update();
+  // Update BHY2 sensors (must call regularly unless batching: the FIFO
+  // is then drained by readSensors() once per batch)
+  if (!SENSOR_BATCHING) {
+    BHY2.update();
+  }
 
   // Update statistics
-  if (currentTime % 1000 == 0) {
-    stats.uptime = currentTime / 1000;
-  }
+  stats.uptime = currentTime / 1000;
 
   // Update LED status based on IAQ
   updateLEDStatus();
@@ -355,21 +419,26 @@ void loop() {
   // Run state machine
   runStateMachine();
 
-  // Process incoming serial commands
+  // Process requests from the gateway
+  SerialFrame frame;
+  if (gatewayRx.poll(SERIAL_GATEWAY, frame) && frame.type == SERIAL_FRAME_REQUEST) {
+    TRACE_SCOPE(TRACE_UART_RX);
+    reportOnRequest();
+  }
+
+  // Process incoming serial commands (USB, for debugging)
   if (Serial.available()) {
     String command = Serial.readStringUntil('\n');
     command.trim();
 
     if (command == "REQ") {
       // Gateway requesting data
-      readSensors();
-      if (validateSensorData()) {
-        transmitData();
-      }
+      reportOnRequest();
     } else if (command == "STAT") {
       // Send status
-      formatStatusJSON();
-      Serial.println(jsonBuffer);
+      if (formatStatusJSON()) {
+        Serial.println(jsonBuffer);
+      }
     } else if (command == "CAL") {
       // Force recalibration
       enterState(STATE_CALIBRATING);
@@ -377,8 +446,11 @@ void loop() {
     }
   }
 
-  // Small delay to prevent watchdog issues
-  delay(10);
+  // Small delay to prevent watchdog issues; longer while the BHI260AP
+  // batches, so the host spends most of its time asleep
+  TRACE_BEGIN(TRACE_SLEEP);
+  delay(SENSOR_BATCHING ? BATCH_IDLE_SLEEP : 10);
+  TRACE_END(TRACE_SLEEP);
 }
 
 // ===========================================
@@ -443,16 +515,17 @@ void handleCalibratingState(void) {
 void handleIdleState(void) {
   unsigned long currentTime = millis();
 
-  // Check if it's time to read sensors
-  if (currentTime - lastSensorReadTime >= SENSOR_READ_INTERVAL) {
+  // Check if it's time to read sensors (or drain the FIFO batch)
+  if (SENSOR_BATCHING ? batchReady()
+                      : (currentTime - lastSensorReadTime >= SENSOR_READ_INTERVAL)) {
     lastSensorReadTime = currentTime;
     enterState(STATE_READING);
   }
 
-  // Check if it's time to transmit
+  // Check if it's time to transmit (only on change or when a window closes)
   if (currentTime - lastTransmitTime >= TRANSMIT_INTERVAL) {
     lastTransmitTime = currentTime;
-    if (currentData.valid) {
+    if (currentData.valid && shouldReport()) {
       enterState(STATE_TRANSMITTING);
     }
   }
@@ -583,6 +656,10 @@ bool initializeSensors(void) {
   gas.begin(SENSOR_SAMPLE_RATE);
   Serial.println("    Gas: OK");
 
+  #ifdef BHY2_INT_PIN
+    attachInterrupt(digitalPinToInterrupt(BHY2_INT_PIN), onSensorInterrupt, RISING);
+  #endif
+
   // Wait for sensors to stabilize
   Serial.println("  Stabilizing sensors...");
   delay(2000);
@@ -594,9 +671,31 @@ bool initializeSensors(void) {
   return true;
 }
 
+void configureSensorRates(uint32_t latencyMs) {
+  // latencyMs = 0 reports every sample as it is taken
+  temperature.configure(SENSOR_SAMPLE_RATE, latencyMs);
+  humidity.configure(SENSOR_SAMPLE_RATE, latencyMs);
+  pressure.configure(SENSOR_SAMPLE_RATE, latencyMs);
+  gas.configure(SENSOR_SAMPLE_RATE, latencyMs);
+
+  // Start the next batch clean
+  BHY2.update();
+  temperature.take();
+  humidity.take();
+  pressure.take();
+  gas.take();
+}
+
+void onSensorInterrupt(void) {
+  sensorInterrupt = true;
+}
+
 bool calibrateSensors(void) {
   Serial.println("  Calibrating sensors...");
 
+  // Calibration needs live values, not batches
+  configureSensorRates(0);
+
   // Take multiple readings and average for calibration
   const int calibrationReadings = 10;
   float tempSum = 0.0;
@@ -637,6 +736,13 @@ bool calibrateSensors(void) {
 
   stats.calibrationCount++;
 
+  // The offsets shift every channel: start the windows over
+  initializeStatistics();
+
+  if (SENSOR_BATCHING) {
+    configureSensorRates(SENSOR_BATCH_LATENCY);
+  }
+
   return true;
 }
 
@@ -644,21 +750,27 @@ bool calibrateSensors(void) {
 // SENSOR FUNCTIONS
 // ===========================================
 
+bool batchReady(void) {
+  return sensorInterrupt || (millis() - lastSensorReadTime >= SENSOR_BATCH_LATENCY);
+}
+
 void readSensors(void) {
-  // Update sensor data
+  // Update sensor data; when batching this drains the whole FIFO
   BHY2.update();
+  sensorInterrupt = false;
 
-  // Read temperature
-  currentData.temperature = temperature.value();
-
-  // Read humidity
-  currentData.humidity = humidity.value();
+  // One reading per batch: the mean of the samples since the last read
+  SensorBatch tempBatch = temperature.take();
+  SensorBatch humBatch = humidity.take();
+  SensorBatch presBatch = pressure.take();
+  SensorBatch gasBatch = gas.take();
 
-  // Read pressure
-  currentData.pressure = pressure.value();
+  stats.batchedSamples += tempBatch.count + humBatch.count + presBatch.count + gasBatch.count;
 
-  // Read gas resistance
-  currentData.gasResistance = gas.value();
+  currentData.temperature = tempBatch.mean;
+  currentData.humidity = humBatch.mean;
+  currentData.pressure = presBatch.mean;
+  currentData.gasResistance = gasBatch.mean;
 
   // Calculate IAQ (simplified version)
   // In production, you would use BSEC library for advanced IAQ calculation
@@ -837,64 +949,99 @@ void applyCalibration(void) {
 // DATA PROCESSING FUNCTIONS
 // ===========================================
 
+void initializeStatistics(void) {
+  channelStats[STAT_TEMPERATURE].begin(STATS_EWMA_ALPHA, DEADBAND_TEMPERATURE);
+  channelStats[STAT_HUMIDITY].begin(STATS_EWMA_ALPHA, DEADBAND_HUMIDITY);
+  channelStats[STAT_PRESSURE].begin(STATS_EWMA_ALPHA, DEADBAND_PRESSURE);
+  channelStats[STAT_GAS].begin(STATS_EWMA_ALPHA, DEADBAND_GAS);
+  channelStats[STAT_IAQ].begin(STATS_EWMA_ALPHA, DEADBAND_IAQ);
+  samplesSinceReport = 0;
+  anomalyActive = false;
+}
+
 void processData(void) {
   // Store previous data for anomaly detection
   previousData = currentData;
 
+  // Test against the window before the sample joins it
+  detectAnomalies();
+
   // Calculate averages
   calculateAverages();
-
-  // Detect anomalies
-  detectAnomalies();
 }
 
 void calculateAverages(void) {
-  // Update running averages
-  if (stats.sensorReads == 0) {
-    stats.avgTemperature = currentData.temperature;
-    stats.avgHumidity = currentData.humidity;
-    stats.avgPressure = currentData.pressure;
-    stats.avgGas = currentData.gasResistance;
-    stats.avgIaq = currentData.iaq;
-  } else {
-    float n = (float)stats.sensorReads + 1.0;
-    stats.avgTemperature = (stats.avgTemperature * (n - 1.0) + currentData.temperature) / n;
-    stats.avgHumidity = (stats.avgHumidity * (n - 1.0) + currentData.humidity) / n;
-    stats.avgPressure = (stats.avgPressure * (n - 1.0) + currentData.pressure) / n;
-    stats.avgGas = (stats.avgGas * (n - 1.0) + currentData.gasResistance) / n;
-    stats.avgIaq = (stats.avgIaq * (n - 1.0) + currentData.iaq) / n;
+  // Feed the sliding windows; the reported averages are windowed means
+  channelStats[STAT_TEMPERATURE].add(currentData.temperature);
+  channelStats[STAT_HUMIDITY].add(currentData.humidity);
+  channelStats[STAT_PRESSURE].add(currentData.pressure);
+  channelStats[STAT_GAS].add(currentData.gasResistance);
+  channelStats[STAT_IAQ].add(currentData.iaq);
+
+  if (samplesSinceReport < 0xFF) {
+    samplesSinceReport++;
   }
+
+  stats.avgTemperature = channelStats[STAT_TEMPERATURE].mean;
+  stats.avgHumidity = channelStats[STAT_HUMIDITY].mean;
+  stats.avgPressure = channelStats[STAT_PRESSURE].mean;
+  stats.avgGas = channelStats[STAT_GAS].mean;
+  stats.avgIaq = channelStats[STAT_IAQ].mean;
 }
 
 void detectAnomalies(void) {
-  // Check for unusual conditions
-
-  // High temperature warning
-  if (currentData.temperature > 30.0) {
-    Serial.println("  WARNING: High temperature detected");
-  }
-
-  // Low humidity warning
-  if (currentData.humidity < 20.0) {
-    Serial.println("  WARNING: Low humidity detected");
-  }
-
-  // High humidity warning
-  if (currentData.humidity > 80.0) {
-    Serial.println("  WARNING: High humidity detected");
+  // Flag samples that fall outside the recent distribution of their channel
+  static const char* const channelNames[STAT_CHANNELS] = {
+    "temperature", "humidity", "pressure", "gas resistance", "IAQ"
+  };
+  const float values[STAT_CHANNELS] = {
+    currentData.temperature,
+    currentData.humidity,
+    currentData.pressure,
+    currentData.gasResistance,
+    currentData.iaq
+  };
+
+  anomalyActive = false;
+  for (uint8_t i = 0; i < STAT_CHANNELS; i++) {
+    if (channelStats[i].isOutlier(values[i], STATS_OUTLIER_SIGMA)) {
+      Serial.print("  WARNING: Unusual ");
+      Serial.print(channelNames[i]);
+      Serial.print(" (");
+      Serial.print(values[i], 1);
+      Serial.print(", window mean ");
+      Serial.print(channelStats[i].mean, 1);
+      Serial.println(")");
+      anomalyActive = true;
+    }
   }
 
   // Poor air quality warning
-  if (currentData.iaq > 200.0) {
+  if (classifyIAQ(currentData.iaq) >= IAQ_POOR) {
     Serial.print("  WARNING: Poor air quality detected (IAQ: ");
     Serial.print(currentData.iaq, 0);
     Serial.println(")");
   }
+}
 
-  // High gas resistance (possible pollutants)
-  if (currentData.gasResistance > 200000.0) {
-    Serial.println("  WARNING: High gas resistance detected");
+bool shouldReport(void) {
+  // Report on anomalies, a closed window, or any channel leaving its deadband
+  if (anomalyActive || samplesSinceReport >= REPORT_WINDOW_SAMPLES) {
+    return true;
   }
+  for (uint8_t i = 0; i < STAT_CHANNELS; i++) {
+    if (channelStats[i].changed()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void markReported(void) {
+  for (uint8_t i = 0; i < STAT_CHANNELS; i++) {
+    channelStats[i].markReported();
+  }
+  samplesSinceReport = 0;
 }
 
 // ===========================================
@@ -902,74 +1049,82 @@ void detectAnomalies(void) {
 // ===========================================
 
 bool transmitData(void) {
-  // Format sensor data as JSON
-  formatSensorJSON();
+  // Send the reading to the gateway as a binary frame
+  iot_packets::SensorDataPacket packet;
+  buildSensorPacket(packet);
 
-  // Transmit via Serial
-  Serial.println(jsonBuffer);
+  if (!serialFrameWritePacket(SERIAL_GATEWAY, 0, packet)) {
+    return false;
+  }
+  markReported();
+  return true;
+}
 
+bool reportOnRequest(void) {
+  // Polled report: the sample goes through the statistics like a scheduled
+  // read, so the windows transmitData() resets include it
+  readSensors();
+  if (!validateSensorData()) {
+    currentData.errorCount++;
+    stats.errors++;
+    return false;
+  }
+  processData();
+  stats.sensorReads++;
+
+  if (!transmitData()) {
+    stats.errors++;
+    return false;
+  }
+  stats.transmissions++;
   return true;
 }
 
-void formatSensorJSON(void) {
+void buildSensorPacket(iot_packets::SensorDataPacket& packet) {
   /**
-   * Format sensor data as JSON
-   * Format: {"type":"sensor","temp":22.5,"hum":45.2,"pres":1013.2,"gas":50000,"iaq":50,"iaq_class":"Good","ts":1234567890}
+   * Fixed-point packet, same layout as the LoRaWAN uplink:
+   * temperature x100, humidity x100, pressure x10, gas in Ohms (saturated)
    */
-
-  int charsWritten = snprintf(
-    jsonBuffer,
-    JSON_BUFFER_SIZE,
-    "{\"type\":\"sensor\","
-    "\"temp\":%.2f,"
-    "\"hum\":%.2f,"
-    "\"pres\":%.2f,"
-    "\"gas\":%.0f,"
-    "\"iaq\":%.0f,"
-    "\"iaq_class\":\"%s\","
-    "\"ts\":%lu}",
-    currentData.temperature,
-    currentData.humidity,
-    currentData.pressure,
-    currentData.gasResistance,
-    currentData.iaq,
-    getIAQDescription(currentData.iaqClassification),
-    currentData.timestamp
-  );
-
-  if (charsWritten < 0 || charsWritten >= JSON_BUFFER_SIZE) {
-    Serial.println("ERROR: JSON buffer overflow");
+  packet.magic = PACKET_MAGIC;
+  packet.type = PACKET_TYPE_SENSOR;
+  packet.timestamp = currentData.timestamp / 1000;
+  packet.temperature = (int16_t)(currentData.temperature * 100);
+  packet.humidity = (uint16_t)(currentData.humidity * 100);
+  packet.pressure = (uint16_t)(currentData.pressure * 10);
+  packet.gasResistance = (uint16_t)min(currentData.gasResistance, 65535.0f);
+  packet.iaq = (uint16_t)currentData.iaq;
+  packet.status = currentData.valid ? STATUS_SENSOR_OK : STATUS_SENSOR_ERROR;
+  if (anomalyActive) {
+    packet.status |= STATUS_ALARM_ACTIVE;
   }
+  packet.battery = 0xFF;  // Not measured on this board
+  iot_packets::packetSetChecksum(packet);
 }
 
-void formatStatusJSON(void) {
+bool formatStatusJSON(void) {
   /**
    * Format system status as JSON
    */
 
-  snprintf(
-    jsonBuffer,
-    JSON_BUFFER_SIZE,
-    "{\"type\":\"status\","
-    "\"uptime\":%lu,"
-    "\"reads\":%lu,"
-    "\"tx\":%lu,"
-    "\"errors\":%lu,"
-    "\"calibrations\":%d,"
-    "\"avg_temp\":%.1f,"
-    "\"avg_hum\":%.1f,"
-    "\"avg_pres\":%.1f,"
-    "\"avg_iaq\":%.0f}",
-    stats.uptime,
-    stats.sensorReads,
-    stats.transmissions,
-    stats.errors,
-    stats.calibrationCount,
-    stats.avgTemperature,
-    stats.avgHumidity,
-    stats.avgPressure,
-    stats.avgIaq
-  );
+  JsonWriter json(jsonBuffer, JSON_BUFFER_SIZE);
+  json.beginObject();
+  json.fieldString("type", "status");
+  json.fieldUInt("uptime", stats.uptime);
+  json.fieldUInt("reads", stats.sensorReads);
+  json.fieldUInt("tx", stats.transmissions);
+  json.fieldUInt("errors", stats.errors);
+  json.fieldInt("calibrations", stats.calibrationCount);
+  json.fieldFloat("avg_temp", stats.avgTemperature, 1);
+  json.fieldFloat("avg_hum", stats.avgHumidity, 1);
+  json.fieldFloat("avg_pres", stats.avgPressure, 1);
+  json.fieldFloat("avg_iaq", stats.avgIaq, 0);
+  json.endObject();
+
+  if (json.overflow()) {
+    Serial.println("ERROR: JSON buffer overflow");
+    return false;
+  }
+  return true;
 }
 
 // ===========================================
@@ -1107,6 +1262,8 @@ void printSystemStats(void) {
   Serial.println(stats.errors);
   Serial.print("Calibrations: ");
   Serial.println(stats.calibrationCount);
+  Serial.print("Batched samples: ");
+  Serial.println(stats.batchedSamples);
   Serial.println("\n--- Averages ---");
   Serial.print("Temperature: ");
   Serial.print(stats.avgTemperature, 1);
@@ -1122,6 +1279,10 @@ void printSystemStats(void) {
   Serial.print(" (");
   Serial.print(getIAQDescription(classifyIAQ(stats.avgIaq)));
   Serial.println(")");
+#if TRACE_LEVEL > 0
+  Serial.println("\n--- Spans (us) ---");
+  tracer().printSummary(Serial);
+#endif
   Serial.println("========================\n");
 }
 
@@ -61,7 +61,7 @@
 
 // TensorFlow Lite Micro includes
 #include <TensorFlowLite.h>
-#include <tensorflow/lite/micro/all_ops_resolver.h>
+#include <tensorflow/lite/micro/micro_mutable_op_resolver.h>
 #include <tensorflow/lite/micro/micro_error_reporter.h>
 #include <tensorflow/lite/micro/micro_interpreter.h>
 #include <tensorflow/lite/schema/schema_generated.h>
@@ -70,6 +70,12 @@
 // Image processing includes
 #include <cmath>
 #include <algorithm>
+#include "../vision/image_preprocessing.h"
+#include "../vision/detection_postprocess.h"
+#include "../vision/memory_map.h"
+#include "../vision/model_ops.h"
+#include "serial_frame.h"
+#include "../lorawan/trace.h"
 
 // ===========================================
 // CONFIGURATION CONSTANTS
@@ -78,6 +84,8 @@
 // Serial communication
 #define SERIAL_BAUD              115200
 #define SERIAL_TIMEOUT           1000
+#define SERIAL_GATEWAY           Serial1    // Binary frames to the MKR WAN gateway
+#define CAMERA_ID                0          // Camera index reported to the gateway
 
 // Camera configuration
 #define CAMERA_WIDTH             320        // QVGA width (optimized for ML)
@@ -86,10 +94,17 @@
 #define CAMERA_FPS               15         // Target frames per second
 
 // ML Model configuration
-#define TENSOR_ARENA_SIZE        (500 * 1024)  // 500KB for tensors
+#if MODEL_OPS_GENERATED
+#define TENSOR_ARENA_SIZE        MODEL_ARENA_SIZE_MAX  // Generated from the model
+#else
+#define TENSOR_ARENA_SIZE        (500 * 1024)  // Placeholder model_ops.h: sizes are not this model's
+#endif
 #define MODEL_INPUT_WIDTH        224           // Model input size (MobileNet)
 #define MODEL_INPUT_HEIGHT       224
 #define MODEL_INPUT_CHANNELS     3             // RGB
+#define RESIZE_MODE              RESIZE_BILINEAR  // Mild scaling: interpolate
+#define MODEL_INPUT_MEAN         0.0f          // real = (pixel - mean) / std
+#define MODEL_INPUT_STD          255.0f
 
 // Detection classes
 #define CLASS_UNKNOWN            0
@@ -112,7 +127,6 @@
 
 // Buffer sizes
 #define FRAME_BUFFER_SIZE        (CAMERA_WIDTH * CAMERA_HEIGHT * 2)  // RGB565 = 2 bytes/pixel
-#define JSON_BUFFER_SIZE         512
 #define TRANSMIT_BUFFER_SIZE     256
 
 // LED indicators
@@ -186,9 +200,10 @@ typedef enum {
 // GLOBAL VARIABLES
 // ===========================================
 
-// Camera buffer
-uint8_t frameBuffer[FRAME_BUFFER_SIZE];
-uint8_t resizedBuffer[MODEL_INPUT_WIDTH * MODEL_INPUT_HEIGHT * MODEL_INPUT_CHANNELS];
+// Camera buffer (DMA-aligned, placed by memory_map.h)
+DMA_BUFFER(FRAME_BUFFER_REGION) uint8_t frameBuffer[FRAME_BUFFER_SIZE];
+MEMORY_PLACE(HOT_DATA_REGION) ResizeLUT resizeLUT;
+InputQuantization inputQuant;   // Pixel -> input tensor encoding
 
 // State machine
 SystemState currentState = STATE_INIT;
@@ -226,11 +241,14 @@ const tflite::Model* model = nullptr;
 // Interpreter
 tflite::MicroInterpreter* interpreter = nullptr;
 
-// Tensor arena
-uint8_t tensorArena[TENSOR_ARENA_SIZE];
+// Tensor arena (the int8 input tensor alone must fit, whatever
+// model_ops.h claims)
+static_assert(MODEL_INPUT_WIDTH * MODEL_INPUT_HEIGHT * MODEL_INPUT_CHANNELS <= TENSOR_ARENA_SIZE,
+              "Tensor arena is smaller than the model input tensor");
+MEMORY_PLACE(TENSOR_ARENA_REGION) alignas(16) uint8_t tensorArena[TENSOR_ARENA_SIZE];
 
-// Operation resolver
-tflite::AllOpsResolver resolver;
+// Operation resolver (only the model's ops, see model_ops.h)
+ModelOpResolver resolver;
 
 // Class labels
 const char* classLabels[] = {
@@ -265,17 +283,17 @@ void handleErrorState(void);
 bool captureImage(void);
 bool preprocessImage(void);
 bool resizeImage(uint8_t* input, uint16_t inputWidth, uint16_t inputHeight,
-                 uint8_t* output, uint16_t outputWidth, uint16_t outputHeight);
+                 TfLiteTensor* output);
+bool configureInputQuantization(TfLiteTensor* input);
 
 // ML functions
+bool outputTensorView(TensorView& view);
 bool runInference(void);
 bool processInferenceResults(void);
 float getClassConfidence(uint8_t classId);
 
 // Transmission functions
 bool transmitResults(void);
-void formatDetectionJSON(void);
-void formatStatusJSON(void);
 
 // LED functions
 void setLEDColor(uint8_t color);
@@ -299,7 +317,10 @@ bool validateDetectionResult(void);
 void setup() {
   // Initialize serial for debugging and communication
   Serial.begin(SERIAL_BAUD);
+  SERIAL_GATEWAY.begin(SERIAL_BAUD);
   delay(2000);  // Wait for serial monitor
+  tracer().begin();
+  resizeLUT.valid = false;  // Section-placed buffers are not zeroed
 
   // Print system information
   printSystemInfo();
@@ -446,7 +467,11 @@ void handleCapturingState(void) {
   Serial.println("Capturing image...");
   setLEDColor(LED_CYAN);
 
-  if (captureImage()) {
+  TRACE_BEGIN(TRACE_CAPTURE);
+  bool captured = captureImage();
+  TRACE_END(TRACE_CAPTURE);
+
+  if (captured) {
     stats.framesCaptured++;
     enterState(STATE_PREPROCESSING);
   } else {
@@ -457,7 +482,11 @@ void handleCapturingState(void) {
 void handlePreprocessingState(void) {
   Serial.println("Preprocessing image...");
 
-  if (preprocessImage()) {
+  TRACE_BEGIN(TRACE_PREPROCESS);
+  bool preprocessed = preprocessImage();
+  TRACE_END(TRACE_PREPROCESS);
+
+  if (preprocessed) {
     enterState(STATE_INFERENCE);
   } else {
     handleError("Image preprocessing failed", 11);
@@ -469,11 +498,19 @@ void handleInferenceState(void) {
   setLEDColor(LED_YELLOW);
   inferenceStartTime = millis();
 
-  if (runInference()) {
+  TRACE_BEGIN(TRACE_INVOKE);
+  bool inferred = runInference();
+  TRACE_END(TRACE_INVOKE);
+
+  if (inferred) {
     float inferenceTime = millis() - inferenceStartTime;
     updateStatistics(inferenceTime);
 
-    if (processInferenceResults()) {
+    TRACE_BEGIN(TRACE_POSTPROCESS);
+    bool detected = processInferenceResults();
+    TRACE_END(TRACE_POSTPROCESS);
+
+    if (detected) {
       enterState(STATE_TRANSMITTING);
     } else {
       // No significant detection, return to idle
@@ -611,6 +648,12 @@ bool initializeML(void) {
     return false;
   }
 
+  // Register only the operators the model uses
+  if (!registerModelOps(resolver)) {
+    errorReporter->Report("Failed to register model operators");
+    return false;
+  }
+
   // Create interpreter
   static tflite::MicroInterpreter staticInterpreter(
     model, resolver, tensorArena, TENSOR_ARENA_SIZE, errorReporter
@@ -624,6 +667,21 @@ bool initializeML(void) {
     return false;
   }
 
+  Serial.print("  Tensor arena used: ");
+  Serial.print(interpreter->arena_used_bytes());
+  Serial.print(" / ");
+  Serial.print(TENSOR_ARENA_SIZE);
+  Serial.print(" (");
+  Serial.print(memoryRegionName(memoryRegionOf(tensorArena)));
+  Serial.println(")");
+
+  // model_ops.h registers int8-only (CMSIS-NN) kernels for int8 models
+  if (MODEL_OPS_INT8 &&
+      (interpreter->input(0)->type != kTfLiteInt8 || interpreter->output(0)->type != kTfLiteInt8)) {
+    errorReporter->Report("Model is not int8 end to end (see MODEL_OPS_INT8)");
+    return false;
+  }
+
   // Get input tensor info
   TfLiteTensor* input = interpreter->input(0);
   Serial.print("  Input tensor dimensions: ");
@@ -633,6 +691,11 @@ bool initializeML(void) {
   Serial.print("x");
   Serial.println(input->dims->data[3]);
 
+  if (!configureInputQuantization(input)) {
+    errorReporter->Report("Unsupported input tensor type");
+    return false;
+  }
+
   // Get output tensor info
   TfLiteTensor* output = interpreter->output(0);
   Serial.print("  Output tensor size: ");
@@ -672,11 +735,15 @@ bool captureImage(void) {
 }
 
 bool preprocessImage(void) {
+  if (interpreter == nullptr) {
+    // Simulation mode - no input tensor to fill
+    return true;
+  }
+
   Serial.println("  Resizing image for ML model...");
 
-  // Resize RGB565 image to model input size (224x224 RGB888)
-  if (!resizeImage(frameBuffer, CAMERA_WIDTH, CAMERA_HEIGHT,
-                   resizedBuffer, MODEL_INPUT_WIDTH, MODEL_INPUT_HEIGHT)) {
+  // Resize RGB565 image straight into the input tensor (224x224x3)
+  if (!resizeImage(frameBuffer, CAMERA_WIDTH, CAMERA_HEIGHT, interpreter->input(0))) {
     Serial.println("  ERROR: Image resize failed");
     return false;
   }
@@ -686,65 +753,73 @@ bool preprocessImage(void) {
 }
 
 bool resizeImage(uint8_t* input, uint16_t inputWidth, uint16_t inputHeight,
-                 uint8_t* output, uint16_t outputWidth, uint16_t outputHeight) {
+                 TfLiteTensor* output) {
   /**
-   * Resize image using nearest neighbor interpolation
+   * Resize image with the shared preprocessing kernel
    * Input format: RGB565 (16-bit)
-   * Output format: RGB888 (24-bit)
+   * Output format: input tensor encoding (uint8/int8/float32 RGB),
+   * quantized in the same pass
    */
 
-  float xRatio = (float)inputWidth / outputWidth;
-  float yRatio = (float)inputHeight / outputHeight;
-
-  for (uint16_t y = 0; y < outputHeight; y++) {
-    for (uint16_t x = 0; x < outputWidth; x++) {
-      // Find corresponding pixel in input
-      uint16_t px = (uint16_t)(x * xRatio);
-      uint16_t py = (uint16_t)(y * yRatio);
+  // NHWC input: [1, height, width, channels]
+  if (output->dims->size != 4 || output->dims->data[3] != MODEL_INPUT_CHANNELS) {
+    return false;
+  }
 
-      // Ensure bounds
-      px = min(px, inputWidth - 1);
-      py = min(py, inputHeight - 1);
+  uint16_t outputHeight = output->dims->data[1];
+  uint16_t outputWidth = output->dims->data[2];
 
-      // Get RGB565 pixel
-      uint16_t pixel = ((uint16_t*)input)[py * inputWidth + px];
+  if (!buildResizeLUT(resizeLUT, inputWidth, 0, 0, inputWidth, inputHeight,
+                      outputWidth, outputHeight, RESIZE_MODE)) {
+    return false;
+  }
 
-      // Convert RGB565 to RGB888
-      uint8_t r5 = (pixel >> 11) & 0x1F;
-      uint8_t g6 = (pixel >> 5) & 0x3F;
-      uint8_t b5 = pixel & 0x1F;
+  return resizeRGB565toTensor(input, output->data.data, resizeLUT, inputQuant);
+}
 
-      uint8_t r8 = (r5 * 255) / 31;
-      uint8_t g8 = (g6 * 255) / 63;
-      uint8_t b8 = (b5 * 255) / 31;
+bool configureInputQuantization(TfLiteTensor* input) {
+  InputFormat format;
 
-      // Store RGB888 pixel
-      uint32_t outputIdx = (y * outputWidth + x) * 3;
-      output[outputIdx + 0] = r8;
-      output[outputIdx + 1] = g8;
-      output[outputIdx + 2] = b8;
-    }
+  switch (input->type) {
+    case kTfLiteUInt8:   format = INPUT_FORMAT_UINT8;   break;
+    case kTfLiteInt8:    format = INPUT_FORMAT_INT8;    break;
+    case kTfLiteFloat32: format = INPUT_FORMAT_FLOAT32; break;
+    default:             return false;
   }
 
-  return true;
+  return buildInputQuantization(inputQuant, format,
+                                input->params.scale, input->params.zero_point,
+                                MODEL_INPUT_MEAN, MODEL_INPUT_STD);
 }
 
 // ===========================================
 // ML INFERENCE FUNCTIONS
 // ===========================================
 
+/**
+ * Wrap the output tensor for the shared decoders (scores stay quantized)
+ */
+bool outputTensorView(TensorView& view) {
+  TfLiteTensor* output = interpreter->output(0);
+  view.data = output->data.data;
+  view.scale = output->params.scale;
+  view.zeroPoint = output->params.zero_point;
+
+  switch (output->type) {
+    case kTfLiteFloat32: view.type = TENSOR_ELEMENT_FLOAT32; return true;
+    case kTfLiteUInt8:   view.type = TENSOR_ELEMENT_UINT8;   return view.scale > 0.0f;
+    case kTfLiteInt8:    view.type = TENSOR_ELEMENT_INT8;    return view.scale > 0.0f;
+    default:             return false;
+  }
+}
+
 bool runInference(void) {
   if (model == nullptr) {
     // Simulation mode - generate fake detection
     return simulateInference();
   }
 
-  // Get input tensor
-  TfLiteTensor* input = interpreter->input(0);
-
-  // Copy preprocessed image to input tensor
-  // Note: Input tensor format depends on your model
-  memcpy(input->data.uint8, resizedBuffer, input->bytes);
+  // Input tensor was filled in place by preprocessImage()
 
   // Run inference
   TfLiteStatus invokeStatus = interpreter->Invoke();
@@ -831,20 +906,18 @@ bool processInferenceResults(void) {
 
   // Get output tensor
   TfLiteTensor* output = interpreter->output(0);
+  TensorView scores;
+  if (!outputTensorView(scores)) {
+    Serial.println("  ERROR: Unsupported output tensor type");
+    return false;
+  }
 
-  // Find class with highest confidence
+  // Find class with highest confidence (argmax/threshold on raw scores,
+  // only the winner is dequantized)
+  uint8_t detectedClass = CLASS_UNKNOWN;
   float maxConfidence = 0.0;
-  int detectedClass = CLASS_UNKNOWN;
-
-  // Process output (assuming classification model)
-  for (int i = 0; i < output->dims->data[1]; i++) {
-    float confidence = output->data.f[i];
-
-    if (confidence > maxConfidence) {
-      maxConfidence = confidence;
-      detectedClass = i;
-    }
-  }
+  bool detected = decodeClassification(scores, output->dims->data[1], DETECTION_THRESHOLD,
+                                       detectedClass, maxConfidence);
 
   // Update detection result
   lastDetection.classId = detectedClass;
@@ -859,7 +932,7 @@ bool processInferenceResults(void) {
   }
 
   lastDetection.timestamp = millis();
-  lastDetection.valid = (maxConfidence >= DETECTION_THRESHOLD);
+  lastDetection.valid = detected;
 
   if (lastDetection.valid) {
     lastDetection.detectionCount++;
@@ -892,9 +965,10 @@ float getClassConfidence(uint8_t classId) {
 
   // Get confidence from model output
   TfLiteTensor* output = interpreter->output(0);
+  TensorView scores;
 
-  if (classId < output->dims->data[1]) {
-    return output->data.f[classId];
+  if (classId < output->dims->data[1] && outputTensorView(scores)) {
+    return tensorViewValue(scores, classId);
   }
 
   return 0.0;
@@ -905,72 +979,24 @@ float getClassConfidence(uint8_t classId) {
 // ===========================================
 
 bool transmitResults(void) {
-  // Format detection as JSON
-  formatDetectionJSON();
-
-  // Transmit via Serial
-  Serial.println(jsonBuffer);
-
-  return true;
-}
-
-void formatDetectionJSON(void) {
-  /**
-   * Format detection result as JSON
-   * Format: {"type":"detection","cam":0,"class":1,"name":"Person","conf":0.75,"bbox":[x,y,w,h],"ts":1234567890}
-   */
-
-  char jsonBuffer[JSON_BUFFER_SIZE];
-
-  int charsWritten = snprintf(
-    jsonBuffer,
-    JSON_BUFFER_SIZE,
-    "{\"type\":\"detection\","
-    "\"cam\":0,"
-    "\"class\":%d,"
-    "\"name\":\"%s\","
-    "\"conf\":%.2f,"
-    "\"bbox\":[%d,%d,%d,%d],"
-    "\"ts\":%lu}",
-    lastDetection.classId,
-    lastDetection.className,
-    lastDetection.confidence,
-    lastDetection.boundingBox[0],
-    lastDetection.boundingBox[1],
-    lastDetection.boundingBox[2],
-    lastDetection.boundingBox[3],
-    lastDetection.timestamp
-  );
-
-  if (charsWritten < 0 || charsWritten >= JSON_BUFFER_SIZE) {
-    Serial.println("ERROR: JSON buffer overflow");
+  // Send the detection to the gateway as a framed DetectionDataPacket
+  DetectionDataPacket packet;
+  packet.magic = PACKET_MAGIC;
+  packet.type = PACKET_TYPE_DETECTION;
+  packet.timestamp = lastDetection.timestamp / 1000;
+
+  switch (lastDetection.classId) {
+    case CLASS_PERSON:  packet.detectionType = DETECTION_TYPE_PERSON;  break;
+    case CLASS_VEHICLE: packet.detectionType = DETECTION_TYPE_VEHICLE; break;
+    case CLASS_ANIMAL:  packet.detectionType = DETECTION_TYPE_ANIMAL;  break;
+    default:            packet.detectionType = DETECTION_TYPE_OBJECT;  break;
   }
-}
 
-void formatStatusJSON(void) {
-  /**
-   * Format system status as JSON
-   */
+  packet.confidence = (uint8_t)constrain(lastDetection.confidence * 100.0f, 0.0f, 100.0f);
+  packet.duration = 0;
+  packetSetChecksum(packet);
 
-  char jsonBuffer[JSON_BUFFER_SIZE];
-
-  snprintf(
-    jsonBuffer,
-    JSON_BUFFER_SIZE,
-    "{\"type\":\"status\","
-    "\"uptime\":%lu,"
-    "\"frames\":%lu,"
-    "\"inferences\":%lu,"
-    "\"detections\":%lu,"
-    "\"fps\":%.1f,"
-    "\"mem\":%d}",
-    stats.uptime,
-    stats.framesCaptured,
-    stats.inferencesRun,
-    stats.detectionsMade,
-    stats.averageFPS,
-    stats.freeMemory
-  );
+  return serialFrameWritePacket(SERIAL_GATEWAY, CAMERA_ID, packet);
 }
 
 // ===========================================
@@ -1086,6 +1112,10 @@ void printSystemStats(void) {
   Serial.print("Free memory: ");
   Serial.print(stats.freeMemory);
   Serial.println(" bytes");
+#if TRACE_LEVEL > 0
+  Serial.println("Frame spans (us):");
+  tracer().printSummary(Serial);
+#endif
   Serial.println("========================\n");
 }
 
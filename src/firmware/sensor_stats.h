@@ -0,0 +1,169 @@
+/**
+ * Sensor Statistics
+ *
+ * Streaming statistics over a sliding window of recent samples, one
+ * ChannelStats per physical quantity (temperature, humidity, ...).
+ *
+ * - Ring of the last SENSOR_STATS_WINDOW samples
+ * - Windowed mean and variance, updated in O(1) per sample with Welford's
+ *   recurrence (add while filling, replace oldest once full), recomputed
+ *   from the window once per wrap so float rounding cannot accumulate
+ * - Windowed min/max, scanned on demand (only needed when reporting)
+ * - EWMA for a smoothed current value
+ * - Deadband report-on-change: changed() is true once the EWMA has moved
+ *   at least `deadband` away from the value last reported
+ * - isOutlier(): z-score test against the window, for anomaly detection
+ *
+ * No divides per sample once the window is full: 1/n is cached and only
+ * recomputed while the window is filling.
+ */
+
+#ifndef SENSOR_STATS_H
+#define SENSOR_STATS_H
+
+#include <Arduino.h>
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+#define SENSOR_STATS_WINDOW       32         // Samples kept per channel
+#define SENSOR_STATS_MIN_SAMPLES  8          // Before variance-based tests are trusted
+
+/**
+ * Sliding-window statistics for one channel
+ */
+struct ChannelStats {
+  float samples[SENSOR_STATS_WINDOW];
+  uint8_t head;              // Next slot to write
+  uint8_t count;             // Samples in the window
+  float invCount;            // 1 / count
+  float mean;
+  float m2;                  // Sum of squared deviations from the mean
+  float ewma;
+  float alpha;               // EWMA weight of the newest sample
+  float deadband;            // Report-on-change threshold
+  float lastReported;
+  bool reported;             // lastReported holds a value
+
+  /**
+   * @param ewmaAlpha  EWMA weight (0..1], higher follows faster
+   * @param band       Minimum change worth reporting, in channel units
+   */
+  void begin(float ewmaAlpha, float band) {
+    head = 0;
+    count = 0;
+    invCount = 0.0f;
+    mean = 0.0f;
+    m2 = 0.0f;
+    ewma = 0.0f;
+    alpha = ewmaAlpha;
+    deadband = band;
+    lastReported = 0.0f;
+    reported = false;
+  }
+
+  void add(float x) {
+    if (count < SENSOR_STATS_WINDOW) {
+      // Window filling: standard Welford update
+      count++;
+      invCount = 1.0f / count;
+      float delta = x - mean;
+      mean += delta * invCount;
+      m2 += delta * (x - mean);
+      ewma = (count == 1) ? x : ewma + alpha * (x - ewma);
+    } else {
+      // Window full: replace the oldest sample in one step
+      float oldest = samples[head];
+      float oldMean = mean;
+      mean += (x - oldest) * invCount;
+      m2 += (x - oldest) * (x - mean + oldest - oldMean);
+      if (m2 < 0.0f) {
+        m2 = 0.0f;  // Rounding
+      }
+      ewma += alpha * (x - ewma);
+    }
+
+    samples[head] = x;
+    head = (head + 1) % SENSOR_STATS_WINDOW;
+
+    // Rounding in the replace-oldest step accumulates without bound, so
+    // recompute from the window once per wrap (amortised O(1))
+    if (head == 0 && count == SENSOR_STATS_WINDOW) {
+      resync();
+    }
+  }
+
+  /**
+   * Exact two-pass mean and m2 over the window
+   */
+  void resync() {
+    float sum = 0.0f;
+    for (uint8_t i = 0; i < count; i++) {
+      sum += samples[i];
+    }
+    mean = sum * invCount;
+
+    float squares = 0.0f;
+    for (uint8_t i = 0; i < count; i++) {
+      float d = samples[i] - mean;
+      squares += d * d;
+    }
+    m2 = squares;
+  }
+
+  /**
+   * Sample variance of the window (0 with fewer than 2 samples)
+   */
+  float variance() const {
+    return (count > 1) ? m2 / (count - 1) : 0.0f;
+  }
+
+  float stddev() const {
+    return sqrtf(variance());
+  }
+
+  float minimum() const {
+    float value = count ? samples[0] : 0.0f;
+    for (uint8_t i = 1; i < count; i++) {
+      value = min(value, samples[i]);
+    }
+    return value;
+  }
+
+  float maximum() const {
+    float value = count ? samples[0] : 0.0f;
+    for (uint8_t i = 1; i < count; i++) {
+      value = max(value, samples[i]);
+    }
+    return value;
+  }
+
+  /**
+   * True if the smoothed value left the deadband around the last report
+   */
+  bool changed() const {
+    return count > 0 && (!reported || fabsf(ewma - lastReported) >= deadband);
+  }
+
+  void markReported() {
+    lastReported = ewma;
+    reported = true;
+  }
+
+  /**
+   * True if x is more than `sigma` standard deviations from the window
+   * mean. Call before add(x) so the sample does not mask itself.
+   */
+  bool isOutlier(float x, float sigma) const {
+    if (count < SENSOR_STATS_MIN_SAMPLES) {
+      return false;
+    }
+    float sd = stddev();
+    // A flat window would flag any step; the deadband sets the noise floor
+    float limit = max(sigma * sd, deadband);
+    return fabsf(x - mean) > limit;
+  }
+};
+
+#endif  // SENSOR_STATS_H
@@ -0,0 +1,227 @@
+/**
+ * Serial Frame Protocol
+ *
+ * Binary framing for the UART links between the Nicla boards and the
+ * MKR WAN gateway. Replaces the ASCII "SENS:..." lines and JSON output.
+ *
+ * Frame (before COBS encoding):
+ *   type(1) source(1) length(1) payload(length) crc16(2)
+ * - type:    PACKET_TYPE_* for data frames, SERIAL_FRAME_REQUEST for polls
+ * - source:  sending device (camera index for detections, 0 otherwise)
+ * - payload: the same packed structs that are uplinked (packet_types.h)
+ * - crc16:   CRC-16/MODBUS over type..payload, little-endian
+ *
+ * The frame is COBS encoded and terminated by 0x00, so a receiver can
+ * resynchronise on the next delimiter after noise or a dropped byte.
+ * Decoding is incremental, one byte at a time, straight from the UART
+ * receive buffer; no line buffer and no string-to-float conversion.
+ */
+
+#ifndef SERIAL_FRAME_H
+#define SERIAL_FRAME_H
+
+#include <Arduino.h>
+#include "../lorawan/crc16.h"
+#include "../lorawan/packet_types.h"
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+#define SERIAL_FRAME_REQUEST       0x10        // Gateway -> node: send a reading
+#define SERIAL_FRAME_MAX_PAYLOAD   64
+#define SERIAL_FRAME_HEADER_SIZE   3           // type, source, length
+#define SERIAL_FRAME_MAX_RAW       (SERIAL_FRAME_HEADER_SIZE + SERIAL_FRAME_MAX_PAYLOAD + 2)
+#define SERIAL_FRAME_MAX_ENCODED   (SERIAL_FRAME_MAX_RAW + SERIAL_FRAME_MAX_RAW / 254 + 2)
+
+/**
+ * Decoded frame
+ */
+struct SerialFrame {
+  uint8_t type;
+  uint8_t source;
+  uint8_t length;
+  uint8_t payload[SERIAL_FRAME_MAX_PAYLOAD];
+};
+
+// ===========================================
+// ENCODER
+// ===========================================
+
+/**
+ * COBS encode a frame and append the 0x00 delimiter
+ * @return Encoded size, 0 if the payload is too large
+ */
+static inline size_t serialFrameEncode(uint8_t type, uint8_t source, const void* payload,
+                                       uint8_t length, uint8_t* out) {
+  if (length > SERIAL_FRAME_MAX_PAYLOAD) {
+    return 0;
+  }
+
+  uint8_t raw[SERIAL_FRAME_MAX_RAW];
+  raw[0] = type;
+  raw[1] = source;
+  raw[2] = length;
+  if (length > 0) {
+    memcpy(raw + SERIAL_FRAME_HEADER_SIZE, payload, length);
+  }
+
+  size_t rawSize = SERIAL_FRAME_HEADER_SIZE + length;
+  uint16_t crc = crc16(raw, rawSize);
+  raw[rawSize++] = crc & 0xFF;
+  raw[rawSize++] = crc >> 8;
+
+  // COBS: each block starts with the distance to the next zero
+  size_t codeIndex = 0;
+  size_t outSize = 1;
+  uint8_t code = 1;
+
+  for (size_t i = 0; i < rawSize; i++) {
+    if (raw[i] == 0) {
+      out[codeIndex] = code;
+      codeIndex = outSize++;
+      code = 1;
+    } else {
+      out[outSize++] = raw[i];
+      if (++code == 0xFF) {
+        out[codeIndex] = code;
+        codeIndex = outSize++;
+        code = 1;
+      }
+    }
+  }
+  out[codeIndex] = code;
+  out[outSize++] = 0x00;
+
+  return outSize;
+}
+
+/**
+ * Encode and write a frame to a serial port
+ */
+static inline bool serialFrameWrite(Print& port, uint8_t type, uint8_t source,
+                                    const void* payload, uint8_t length) {
+  uint8_t encoded[SERIAL_FRAME_MAX_ENCODED];
+  size_t size = serialFrameEncode(type, source, payload, length, encoded);
+
+  return size > 0 && port.write(encoded, size) == size;
+}
+
+/**
+ * Send a packet struct (SensorDataPacket, DetectionDataPacket, ...) as a frame
+ */
+template <typename Packet>
+static inline bool serialFrameWritePacket(Print& port, uint8_t source, const Packet& packet) {
+  return serialFrameWrite(port, packet.type, source, &packet, sizeof(Packet));
+}
+
+// ===========================================
+// DECODER
+// ===========================================
+
+/**
+ * Incremental COBS decoder and frame validator, one per link
+ */
+struct SerialFrameReceiver {
+  uint8_t buffer[SERIAL_FRAME_MAX_RAW];
+  uint8_t size;
+  uint8_t blockLeft;         // Data bytes left in the current COBS block
+  bool pendingZero;          // Block ended short of 0xFF: a zero follows if more data comes
+  bool overflow;
+
+  // Link statistics
+  uint32_t frames;
+  uint32_t crcErrors;
+  uint32_t framingErrors;
+
+  SerialFrameReceiver()
+    : size(0), blockLeft(0), pendingZero(false), overflow(false),
+      frames(0), crcErrors(0), framingErrors(0) {}
+
+  void reset() {
+    size = 0;
+    blockLeft = 0;
+    pendingZero = false;
+    overflow = false;
+  }
+
+  void append(uint8_t byte) {
+    if (size < sizeof(buffer)) {
+      buffer[size++] = byte;
+    } else {
+      overflow = true;
+    }
+  }
+
+  /**
+   * Feed one received byte
+   * @return true when a complete, valid frame has been written to `frame`
+   */
+  bool push(uint8_t byte, SerialFrame& frame) {
+    if (byte != 0x00) {
+      if (blockLeft == 0) {
+        // Code byte
+        if (pendingZero) {
+          append(0x00);
+        }
+        blockLeft = byte - 1;
+        pendingZero = (byte != 0xFF);
+      } else {
+        append(byte);
+        blockLeft--;
+      }
+      return false;
+    }
+
+    // Delimiter: validate what was collected
+    bool complete = !overflow && blockLeft == 0 && size >= SERIAL_FRAME_HEADER_SIZE + 2;
+    bool valid = false;
+
+    if (complete && buffer[2] <= SERIAL_FRAME_MAX_PAYLOAD &&
+        size == SERIAL_FRAME_HEADER_SIZE + buffer[2] + 2) {
+      uint16_t crc = buffer[size - 2] | ((uint16_t)buffer[size - 1] << 8);
+
+      if (crc == crc16(buffer, size - 2)) {
+        frame.type = buffer[0];
+        frame.source = buffer[1];
+        frame.length = buffer[2];
+        memcpy(frame.payload, buffer + SERIAL_FRAME_HEADER_SIZE, frame.length);
+        frames++;
+        valid = true;
+      } else {
+        crcErrors++;
+      }
+    } else if (size > 0 || overflow) {
+      framingErrors++;
+    }
+
+    reset();
+    return valid;
+  }
+
+  /**
+   * Drain a port until a frame is complete or no bytes are left
+   */
+  bool poll(Stream& port, SerialFrame& frame) {
+    while (port.available() > 0) {
+      if (push((uint8_t)port.read(), frame)) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+/**
+ * Copy a frame payload into a packet struct, checking size and packet checksum
+ */
+template <typename Packet>
+static inline bool serialFramePacket(const SerialFrame& frame, Packet& packet) {
+  if (frame.length != sizeof(Packet)) {
+    return false;
+  }
+  memcpy(&packet, frame.payload, sizeof(Packet));
+  return iot_packets::packetIsValid(packet);
+}
+
+#endif  // SERIAL_FRAME_H
@@ -0,0 +1,236 @@
+/**
+ * Transport Router
+ *
+ * Picks the uplink for each outgoing message instead of a fixed
+ * "LoRaWAN first, WiFi as fallback" order. The choice depends on:
+ *
+ * - Message class: alarms go out at once over the fastest healthy link,
+ *   periodic readings prefer LoRaWAN (compact codec frames), bulk data
+ *   (statistics, backfill) prefers WiFi
+ * - Remaining LoRaWAN duty cycle: airtime of every uplink is entered in a
+ *   DutyCycleLedger; routine traffic may only use the budget down to
+ *   TRANSPORT_ALARM_RESERVE, the rest is kept for alarms
+ * - Link health: consecutive failures back the link off exponentially,
+ *   and the send time of successful messages is averaged (EWMA)
+ *
+ * burstFrames() tells how many frames a link can take right now, so bulk
+ * senders can drain a queue in one go on WiFi and stay inside the duty
+ * cycle on LoRaWAN.
+ *
+ * The MKRWAN modem keeps its duty cycle state to itself, so the ledger is
+ * our own estimate from the region plan in lorawan_region.h. Select the
+ * region with the CFG_* define before including.
+ */
+
+#ifndef TRANSPORT_ROUTER_H
+#define TRANSPORT_ROUTER_H
+
+#include <Arduino.h>
+#include "../lorawan/lorawan_region.h"
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+#define TRANSPORT_ALARM_RESERVE       25         // % of the LoRa budget kept for alarms
+#define TRANSPORT_BACKOFF_BASE        5000       // First backoff after a failure (ms)
+#define TRANSPORT_BACKOFF_MAX         300000     // Longest backoff (ms)
+#define TRANSPORT_LATENCY_SHIFT       2          // EWMA weight 1/4 for new samples
+#define TRANSPORT_LORA_LATENCY_SEED   2500       // Initial estimate: TX + RX windows
+#define TRANSPORT_WIFI_LATENCY_SEED   300        // Initial estimate: MQTT publish
+
+typedef enum {
+  LINK_NONE,
+  LINK_LORAWAN,
+  LINK_WIFI,
+  LINK_COUNT
+} TransportLink;
+
+typedef enum {
+  MSG_ALARM,                     // Detection: now, fastest link
+  MSG_SENSOR,                    // Periodic reading: compact codec on LoRaWAN
+  MSG_STATS,                     // Bulk JSON: WiFi only
+  MSG_BACKFILL                   // Stored readings: WiFi burst, LoRaWAN if budget allows
+} MessageClass;
+
+/**
+ * Health of one link
+ */
+struct LinkHealth {
+  bool up;                       // Joined / connected
+  uint8_t failures;              // Consecutive failed sends
+  uint32_t retryAt;              // End of the current backoff
+  uint32_t latencyMs;            // EWMA of successful send times
+  uint32_t sent;
+  uint32_t failed;
+};
+
+class TransportRouter {
+ public:
+  /**
+   * @param uplinkHz Channel frequency used to pick the duty cycle sub-band
+   */
+  explicit TransportRouter(uint32_t uplinkHz = LoRaWANRegion::DEFAULT_UPLINK_HZ)
+    : _band(LoRaWANRegion::subBand(uplinkHz)) {
+    memset(_links, 0, sizeof(_links));
+    _links[LINK_LORAWAN].latencyMs = TRANSPORT_LORA_LATENCY_SEED;
+    _links[LINK_WIFI].latencyMs = TRANSPORT_WIFI_LATENCY_SEED;
+  }
+
+  void setLinkUp(TransportLink link, bool up) {
+    if (link == LINK_NONE || link >= LINK_COUNT) {
+      return;
+    }
+    if (up && !_links[link].up) {
+      _links[link].failures = 0;   // Fresh connection: no backoff
+    }
+    _links[link].up = up;
+  }
+
+  /**
+   * True if the link is up and not backing off
+   */
+  bool usable(TransportLink link, uint32_t now) const {
+    if (link == LINK_NONE || link >= LINK_COUNT || !_links[link].up) {
+      return false;
+    }
+    return _links[link].failures == 0 || (int32_t)(now - _links[link].retryAt) >= 0;
+  }
+
+  /**
+   * True if a LoRaWAN frame fits the duty cycle budget now
+   * @param reserve Leave TRANSPORT_ALARM_RESERVE of the budget untouched
+   */
+  bool loraFits(size_t payloadSize, uint8_t dr, uint32_t now, bool reserve) const {
+    if (payloadSize == 0 || payloadSize > LoRaWANRegion::maxPayload(dr)) {
+      return false;
+    }
+    return _ledger.used(_band, now) + LoRaWANRegion::airtimeMs(payloadSize, dr) <= budgetMs(reserve);
+  }
+
+  /**
+   * Choose the link for a message
+   * @param cls         Message class
+   * @param loraSize    Payload size if sent over LoRaWAN (0 = no LoRa encoding)
+   * @param dr          Current LoRaWAN data rate
+   * @param now         Current time in ms (must not stop in sleep)
+   * @return LINK_NONE if the message should be deferred or stored
+   */
+  TransportLink route(MessageClass cls, size_t loraSize, uint8_t dr, uint32_t now) const {
+    bool lora = usable(LINK_LORAWAN, now);
+    bool wifi = usable(LINK_WIFI, now);
+
+    switch (cls) {
+      case MSG_ALARM:
+        // Fastest link that can take it; alarms may use the reserve
+        lora = lora && loraFits(loraSize, dr, now, false);
+        if (lora && wifi) {
+          return (_links[LINK_WIFI].latencyMs <= _links[LINK_LORAWAN].latencyMs) ? LINK_WIFI
+                                                                                  : LINK_LORAWAN;
+        }
+        return wifi ? LINK_WIFI : (lora ? LINK_LORAWAN : LINK_NONE);
+
+      case MSG_SENSOR:
+        if (lora && loraFits(loraSize, dr, now, true)) {
+          return LINK_LORAWAN;
+        }
+        return wifi ? LINK_WIFI : LINK_NONE;
+
+      case MSG_STATS:
+        return wifi ? LINK_WIFI : LINK_NONE;
+
+      case MSG_BACKFILL:
+        if (wifi) {
+          return LINK_WIFI;
+        }
+        return (lora && loraFits(loraSize, dr, now, true)) ? LINK_LORAWAN : LINK_NONE;
+
+      default:
+        return LINK_NONE;
+    }
+  }
+
+  /**
+   * Frames of one size a link can take back to back right now
+   * @param maxFrames Upper bound returned for links without a budget
+   */
+  uint8_t burstFrames(TransportLink link, size_t payloadSize, uint8_t dr, uint32_t now,
+                      uint8_t maxFrames) const {
+    if (!usable(link, now)) {
+      return 0;
+    }
+    if (link != LINK_LORAWAN) {
+      return maxFrames;
+    }
+
+    if (payloadSize == 0 || payloadSize > LoRaWANRegion::maxPayload(dr)) {
+      return 0;
+    }
+    uint32_t used = _ledger.used(_band, now);
+    uint32_t budget = budgetMs(true);
+    uint32_t airtime = LoRaWANRegion::airtimeMs(payloadSize, dr);
+    if (used >= budget || airtime == 0) {
+      return 0;
+    }
+    uint32_t frames = (budget - used) / airtime;
+    return (uint8_t)min(frames, (uint32_t)maxFrames);
+  }
+
+  /**
+   * Enter the airtime of a finished LoRaWAN uplink
+   */
+  void recordLoRaAirtime(size_t payloadSize, uint8_t dr, uint32_t now) {
+    _ledger.record(_band, LoRaWANRegion::airtimeMs(payloadSize, dr), now);
+  }
+
+  /**
+   * Report the outcome of a send
+   * @param latencyMs Time the send took (ignored on failure)
+   */
+  void reportResult(TransportLink link, bool ok, uint32_t latencyMs, uint32_t now) {
+    if (link == LINK_NONE || link >= LINK_COUNT) {
+      return;
+    }
+    LinkHealth& health = _links[link];
+
+    if (ok) {
+      health.sent++;
+      health.failures = 0;
+      health.latencyMs += ((int32_t)latencyMs - (int32_t)health.latencyMs) >> TRANSPORT_LATENCY_SHIFT;
+      return;
+    }
+
+    health.failed++;
+    if (health.failures < 16) {
+      health.failures++;
+    }
+    uint32_t backoff = TRANSPORT_BACKOFF_BASE << (health.failures - 1);
+    if (backoff > TRANSPORT_BACKOFF_MAX || health.failures > 8) {
+      backoff = TRANSPORT_BACKOFF_MAX;
+    }
+    health.retryAt = now + backoff;
+  }
+
+  const LinkHealth& health(TransportLink link) const {
+    return _links[(link < LINK_COUNT) ? link : LINK_NONE];
+  }
+
+  /**
+   * LoRaWAN airtime used in the current duty cycle window
+   */
+  uint32_t loraAirtimeUsed(uint32_t now) const {
+    return _ledger.used(_band, now);
+  }
+
+ private:
+  uint32_t budgetMs(bool reserve) const {
+    uint32_t budget = LoRaWANRegion::budgetMs(_band);
+    return reserve ? budget / 100 * (100 - TRANSPORT_ALARM_RESERVE) : budget;
+  }
+
+  uint8_t _band;
+  DutyCycleLedger _ledger;
+  LinkHealth _links[LINK_COUNT];
+};
+
+#endif  // TRANSPORT_ROUTER_H
@@ -0,0 +1,258 @@
+/**
+ * UART DMA Receiver (SAMD21)
+ *
+ * Receives a SERCOM USART straight into a ring buffer with the DMAC, so
+ * bytes keep arriving while loop() is blocked in the LoRa modem, WiFi or
+ * a delay(). The CPU is not involved per byte.
+ *
+ * - One DMAC channel per port, triggered by the SERCOM RX (RXC) request
+ * - The ring is a chain of UART_DMA_BLOCK_SIZE descriptors that loops
+ *   back on itself; each completed block raises the DMAC interrupt,
+ *   which sets uartDmaRxPending for the state machine
+ * - The write position is read from the channel's write-back descriptor,
+ *   so available() is exact between block interrupts
+ * - If the reader falls a full ring behind, the unread bytes are dropped
+ *   and counted; the COBS framing resynchronises on the next delimiter
+ *
+ * The Arduino core's SERCOM RX interrupt is disabled for the port, so the
+ * Uart object is only used for transmission once begin() has run. This
+ * module owns the DMAC descriptor base; do not combine it with other DMA
+ * libraries (Adafruit_ZeroDMA, I2S) in the same sketch.
+ * Reception stops in STANDBY sleep because the SERCOM clock is gated.
+ */
+
+#ifndef UART_DMA_RX_H
+#define UART_DMA_RX_H
+
+#include <Arduino.h>
+
+#if !defined(ARDUINO_ARCH_SAMD)
+  #error "uart_dma_rx.h requires a SAMD21 board (DMAC + SERCOM)"
+#endif
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+#define UART_DMA_CHANNELS        3           // Serial1, Serial2, Serial3
+#define UART_DMA_RING_SIZE       512         // Bytes per port, power of two
+#define UART_DMA_BLOCK_SIZE      32          // Bytes per descriptor / notification
+#define UART_DMA_BLOCKS          (UART_DMA_RING_SIZE / UART_DMA_BLOCK_SIZE)
+
+static_assert((UART_DMA_RING_SIZE & (UART_DMA_RING_SIZE - 1)) == 0,
+              "UART_DMA_RING_SIZE must be a power of two");
+static_assert(UART_DMA_RING_SIZE % UART_DMA_BLOCK_SIZE == 0,
+              "UART_DMA_RING_SIZE must be a multiple of UART_DMA_BLOCK_SIZE");
+
+// DMAC descriptor and write-back sections, indexed by channel
+__attribute__((aligned(16))) static DmacDescriptor uartDmaDescriptors[UART_DMA_CHANNELS];
+__attribute__((aligned(16))) static DmacDescriptor uartDmaWriteback[UART_DMA_CHANNELS];
+
+// Set from the DMAC interrupt whenever any port completes a block
+static volatile bool uartDmaRxPending = false;
+
+class UartDmaRx;
+static UartDmaRx* uartDmaPorts[UART_DMA_CHANNELS] = {nullptr};
+
+// ===========================================
+// RECEIVER
+// ===========================================
+
+class UartDmaRx : public Stream {
+ public:
+  /**
+   * @param uart     Core Uart object (used for begin() and transmit)
+   * @param sercom   SERCOM instance behind the Uart (e.g. SERCOM5 for Serial1)
+   * @param trigger  DMAC trigger source (e.g. SERCOM5_DMAC_ID_RX)
+   * @param channel  DMAC channel, 0 to UART_DMA_CHANNELS - 1
+   */
+  UartDmaRx(Uart& uart, Sercom* sercom, uint8_t trigger, uint8_t channel)
+    : _uart(uart), _sercom(sercom), _trigger(trigger), _channel(channel),
+      _blocks(0), _transferErrors(0),
+      _readCount(0), _droppedBytes(0) {}
+
+  /**
+   * Start the Uart and hand its receive side to the DMAC
+   * @return false if the channel is out of range or already taken
+   */
+  bool begin(unsigned long baud) {
+    if (_channel >= UART_DMA_CHANNELS || uartDmaPorts[_channel] != nullptr) {
+      return false;
+    }
+
+    _uart.begin(baud);
+
+    // The DMAC reads DATA on each RXC request; keep the core ISR off it
+    _sercom->USART.INTENCLR.reg = SERCOM_USART_INTENCLR_RXC | SERCOM_USART_INTENCLR_ERROR;
+
+    uartDmaEnableController();
+
+    // Descriptor chain: block 0 lives in the base section, the rest here
+    for (uint8_t i = 0; i < UART_DMA_BLOCKS; i++) {
+      DmacDescriptor& desc = (i == 0) ? uartDmaDescriptors[_channel] : _linked[i - 1];
+      DmacDescriptor& next = (i + 1 == UART_DMA_BLOCKS) ? uartDmaDescriptors[_channel]
+                                                        : _linked[i];
+
+      desc.BTCTRL.reg = DMAC_BTCTRL_VALID |
+                        DMAC_BTCTRL_BEATSIZE_BYTE |
+                        DMAC_BTCTRL_DSTINC |
+                        DMAC_BTCTRL_BLOCKACT_INT;
+      desc.BTCNT.reg = UART_DMA_BLOCK_SIZE;
+      desc.SRCADDR.reg = (uint32_t)&_sercom->USART.DATA.reg;
+      // Incrementing destination address points one past the last beat
+      desc.DSTADDR.reg = (uint32_t)(_buffer + (i + 1) * UART_DMA_BLOCK_SIZE);
+      desc.DESCADDR.reg = (uint32_t)&next;
+    }
+    uartDmaWriteback[_channel] = uartDmaDescriptors[_channel];
+
+    _blocks = 0;
+    _readCount = 0;
+    uartDmaPorts[_channel] = this;
+
+    noInterrupts();
+    DMAC->CHID.reg = DMAC_CHID_ID(_channel);
+    DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+    while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST);
+    DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) |
+                        DMAC_CHCTRLB_TRIGSRC(_trigger) |
+                        DMAC_CHCTRLB_TRIGACT_BEAT;
+    DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL | DMAC_CHINTENSET_TERR;
+    DMAC->CHCTRLA.reg |= DMAC_CHCTRLA_ENABLE;
+    interrupts();
+
+    return true;
+  }
+
+  // Stream interface: reads come from the ring, writes go to the Uart
+  int available() override {
+    uint32_t pending = written() - _readCount;
+
+    if (pending > UART_DMA_RING_SIZE) {
+      // Overrun: the DMAC has lapped unread data
+      _droppedBytes += pending;
+      _readCount += pending;
+      pending = 0;
+    }
+    return (int)pending;
+  }
+
+  int read() override {
+    if (available() == 0) {
+      return -1;
+    }
+    return _buffer[_readCount++ & (UART_DMA_RING_SIZE - 1)];
+  }
+
+  int peek() override {
+    if (available() == 0) {
+      return -1;
+    }
+    return _buffer[_readCount & (UART_DMA_RING_SIZE - 1)];
+  }
+
+  void flush() override { _uart.flush(); }
+  size_t write(uint8_t byte) override { return _uart.write(byte); }
+  size_t write(const uint8_t* buffer, size_t size) override { return _uart.write(buffer, size); }
+  using Print::write;
+
+  uint32_t droppedBytes() const { return _droppedBytes; }
+  uint32_t transferErrors() const { return _transferErrors; }
+
+  // Called from DMAC_Handler with the channel's interrupt flags
+  void onInterrupt(uint8_t flags) {
+    if (flags & DMAC_CHINTFLAG_TCMPL) {
+      _blocks++;
+      uartDmaRxPending = true;
+    }
+    if (flags & DMAC_CHINTFLAG_TERR) {
+      // A bus error disables the channel; count it and restart
+      _transferErrors++;
+      DMAC->CHCTRLA.reg |= DMAC_CHCTRLA_ENABLE;
+    }
+  }
+
+ private:
+  /**
+   * Total bytes stored by the DMAC since begin() (wraps at 2^32)
+   */
+  uint32_t written() {
+    noInterrupts();
+    DMAC->CHID.reg = DMAC_CHID_ID(_channel);
+    uint32_t blocks = _blocks;
+    uint16_t remaining = uartDmaWriteback[_channel].BTCNT.reg;
+    bool blockDone = DMAC->CHINTFLAG.reg & DMAC_CHINTFLAG_TCMPL;
+    interrupts();
+
+    uint32_t position = UART_DMA_BLOCK_SIZE - remaining;
+
+    // Block finished and the next one already started, ISR not run yet
+    if (blockDone && position < UART_DMA_BLOCK_SIZE) {
+      blocks++;
+    }
+    return blocks * UART_DMA_BLOCK_SIZE + position;
+  }
+
+  static void uartDmaEnableController() {
+    static bool enabled = false;
+    if (enabled) {
+      return;
+    }
+
+    PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+    PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+
+    DMAC->CTRL.reg &= ~DMAC_CTRL_DMAENABLE;
+    DMAC->CTRL.reg = DMAC_CTRL_SWRST;
+    while (DMAC->CTRL.reg & DMAC_CTRL_SWRST);
+    DMAC->BASEADDR.reg = (uint32_t)uartDmaDescriptors;
+    DMAC->WRBADDR.reg = (uint32_t)uartDmaWriteback;
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+
+    NVIC_SetPriority(DMAC_IRQn, 1);
+    NVIC_EnableIRQ(DMAC_IRQn);
+    enabled = true;
+  }
+
+  Uart& _uart;
+  Sercom* _sercom;
+  uint8_t _trigger;
+  uint8_t _channel;
+
+  volatile uint32_t _blocks;       // Completed blocks (ISR)
+  volatile uint32_t _transferErrors;
+
+  uint32_t _readCount;             // Bytes consumed by the reader
+  uint32_t _droppedBytes;
+
+  uint8_t _buffer[UART_DMA_RING_SIZE];
+  __attribute__((aligned(16))) DmacDescriptor _linked[UART_DMA_BLOCKS - 1];
+};
+
+/**
+ * DMAC interrupt: dispatch pending channels to their receivers
+ */
+void DMAC_Handler(void) {
+  while (DMAC->INTSTATUS.reg) {
+    uint8_t channel = DMAC->INTPEND.bit.ID;
+    DMAC->CHID.reg = DMAC_CHID_ID(channel);
+    uint8_t flags = DMAC->CHINTFLAG.reg;
+    DMAC->CHINTFLAG.reg = flags;
+
+    if (channel < UART_DMA_CHANNELS && uartDmaPorts[channel] != nullptr) {
+      uartDmaPorts[channel]->onInterrupt(flags);
+    }
+  }
+}
+
+/**
+ * Consume the global notify flag
+ * @return true if any port received a block since the last call
+ */
+static inline bool uartDmaTakePending() {
+  bool pending = uartDmaRxPending;
+  uartDmaRxPending = false;
+  return pending;
+}
+
+#endif  // UART_DMA_RX_H
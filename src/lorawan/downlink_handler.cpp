@@ -6,7 +6,10 @@
  *
  * Features:
  * - Binary command parsing
- * - Command queue management
+ * - Constexpr command table (parameter length + handler per CMD_* ID)
+ * - Single-producer/single-consumer downlink queue: the LMIC event only
+ *   stores the payload, commands run from processDownlink()
+ * - Responses coalesced into one uplink behind the next scheduled one
  * - Error handling and validation
  * - Response generation
  * - System configuration management
@@ -60,89 +63,160 @@ void initSystemConfig() {
 }
 
 // ===========================================
-// COMMAND QUEUE MANAGEMENT
+// COMMAND DISPATCH TABLE
 // ===========================================
 
-#define COMMAND_QUEUE_SIZE 10
+// Handlers take the parameter bytes after the command ID; the length has
+// already been checked against the table
+typedef void (*CommandHandler)(const uint8_t* payload, uint8_t payloadLength);
+
+void handlePing(const uint8_t* payload, uint8_t payloadLength);
+void handleSetInterval(const uint8_t* payload, uint8_t payloadLength);
+void handleSetDataRate(const uint8_t* payload, uint8_t payloadLength);
+void handleSetTxPower(const uint8_t* payload, uint8_t payloadLength);
+void handleReboot(const uint8_t* payload, uint8_t payloadLength);
+void handleGetStatus(const uint8_t* payload, uint8_t payloadLength);
+void handleSetLED(const uint8_t* payload, uint8_t payloadLength);
+void handleSetAlarm(const uint8_t* payload, uint8_t payloadLength);
+void handleGetBattery(const uint8_t* payload, uint8_t payloadLength);
+void handleSetADR(const uint8_t* payload, uint8_t payloadLength);
+void handleClearStats(const uint8_t* payload, uint8_t payloadLength);
+
+void queueResponse(const uint8_t* record, uint8_t size);
+void flushResponses();
+void sendAck();
+void sendNack();
+void sendStatus();
+void sendBatteryLevel();
+void sendErrorResponse(uint8_t errorCode);
+
+// Coalesced responses (see RESPONSE SENDERS)
+#define RESPONSE_BUFFER_SIZE       32
+#define RESPONSE_MAX_DELAY         TX_INTERVAL_60SEC   // Longest wait for a scheduled uplink
+
+uint8_t responseBuffer[RESPONSE_BUFFER_SIZE];
+uint8_t responseSize = 0;
+unsigned long responseStart = 0;
+bool rebootPending = false;                // REBOOT acknowledged, reset after TX
 
 /**
- * @brief Command queue entry
+ * @brief Command specification: accepted parameter length and handler
  */
-struct CommandQueueEntry {
-    uint8_t commandId;
-    uint8_t payload[16];
-    uint8_t payloadLength;
-    unsigned long timestamp;
+struct CommandSpec {
+    uint8_t minLength;             // Parameter bytes after the command ID
+    uint8_t maxLength;
+    CommandHandler handler;
 };
 
-CommandQueueEntry commandQueue[COMMAND_QUEUE_SIZE];
-uint8_t commandQueueHead = 0;
-uint8_t commandQueueTail = 0;
-bool commandQueueOverflow = false;
+// Indexed by CMD_* ID
+static constexpr CommandSpec COMMAND_TABLE[] = {
+    {0, 0, handlePing},            // CMD_PING
+    {4, 4, handleSetInterval},     // CMD_SET_INTERVAL
+    {1, 1, handleSetDataRate},     // CMD_SET_DATARATE
+    {1, 1, handleSetTxPower},      // CMD_SET_TXPOWER
+    {0, 0, handleReboot},          // CMD_REBOOT
+    {0, 0, handleGetStatus},       // CMD_GET_STATUS
+    {1, 1, handleSetLED},          // CMD_SET_LED
+    {1, 1, handleSetAlarm},        // CMD_SET_ALARM
+    {0, 0, handleGetBattery},      // CMD_GET_BATTERY
+    {1, 1, handleSetADR},          // CMD_SET_ADR
+    {0, 0, handleClearStats},      // CMD_CLEAR_STATS
+};
+
+#define COMMAND_COUNT (sizeof(COMMAND_TABLE) / sizeof(COMMAND_TABLE[0]))
+
+static_assert(COMMAND_COUNT == CMD_CLEAR_STATS + 1, "COMMAND_TABLE must cover every CMD_* ID");
+
+/**
+ * @brief Validate command ID
+ * @param commandId Command ID
+ * @return true if command is valid
+ */
+constexpr bool isValidCommand(uint8_t commandId) {
+    return commandId < COMMAND_COUNT && COMMAND_TABLE[commandId].handler != nullptr;
+}
+
+static_assert(isValidCommand(CMD_PING) && !isValidCommand(CMD_CLEAR_STATS + 1),
+              "Command table lookup");
+
+// ===========================================
+// DOWNLINK QUEUE (SINGLE PRODUCER / SINGLE CONSUMER)
+// ===========================================
+
+#define DOWNLINK_QUEUE_SIZE        8           // Slots, power of two
+#define DOWNLINK_MAX_SIZE          (1 + sizeof(DownlinkMessage::payload))
+
+static_assert((DOWNLINK_QUEUE_SIZE & (DOWNLINK_QUEUE_SIZE - 1)) == 0,
+              "DOWNLINK_QUEUE_SIZE must be a power of two");
+
+/**
+ * @brief Received downlink, stored once in its ring slot
+ */
+struct DownlinkSlot {
+    uint8_t data[DOWNLINK_MAX_SIZE];   // Command ID + parameters
+    uint8_t size;
+    int16_t rssi;
+};
+
+/**
+ * The LMIC event (producer) writes a slot and publishes it by advancing
+ * the tail; processDownlink() (consumer) runs the command straight from
+ * the slot and then advances the head. Each index has a single writer,
+ * so no lock is needed. LMIC reuses its frame buffer for the next
+ * uplink, which is why the payload is stored here rather than referenced.
+ */
+DownlinkSlot downlinkQueue[DOWNLINK_QUEUE_SIZE];
+volatile uint8_t downlinkHead = 0;     // Written by the consumer only
+volatile uint8_t downlinkTail = 0;     // Written by the producer only
+volatile uint32_t downlinkDropCount = 0;
 
 /**
  * @brief Initialize command queue
  */
 void initCommandQueue() {
-    commandQueueHead = 0;
-    commandQueueTail = 0;
-    commandQueueOverflow = false;
-    memset(commandQueue, 0, sizeof(commandQueue));
+    downlinkHead = 0;
+    downlinkTail = 0;
+    downlinkDropCount = 0;
 }
 
 /**
- * @brief Add command to queue
- * @param commandId Command ID
- * @param payload Payload data
- * @param payloadLength Payload length
- * @return true if command added successfully
+ * @brief Producer: store a downlink in the next free slot
+ * @return false if the queue is full or the payload is too large
  */
-bool enqueueCommand(uint8_t commandId, const uint8_t* payload, uint8_t payloadLength) {
-    uint8_t nextTail = (commandQueueTail + 1) % COMMAND_QUEUE_SIZE;
+bool enqueueCommand(const uint8_t* payload, size_t size, int rssi) {
+    uint8_t tail = downlinkTail;
 
-    if (nextTail == commandQueueHead) {
-        // Queue is full
-        commandQueueOverflow = true;
+    if ((uint8_t)(tail - downlinkHead) == DOWNLINK_QUEUE_SIZE || size > DOWNLINK_MAX_SIZE) {
+        downlinkDropCount++;
         return false;
     }
 
-    commandQueue[commandQueueTail].commandId = commandId;
-    commandQueue[commandQueueTail].payloadLength = payloadLength;
-    commandQueue[commandQueueTail].timestamp = millis();
-
-    if (payloadLength > 0 && payloadLength <= 16) {
-        memcpy(commandQueue[commandQueueTail].payload, payload, payloadLength);
-    }
+    DownlinkSlot& slot = downlinkQueue[tail & (DOWNLINK_QUEUE_SIZE - 1)];
+    memcpy(slot.data, payload, size);
+    slot.size = (uint8_t)size;
+    slot.rssi = (int16_t)rssi;
 
-    commandQueueTail = nextTail;
+    downlinkTail = tail + 1;           // Publish after the slot is written
     return true;
 }
 
 /**
- * @brief Get next command from queue
- * @param entry Command entry (output)
- * @return true if command retrieved successfully
+ * @brief Consumer: oldest queued downlink, left in place
+ * @return nullptr if the queue is empty
  */
-bool dequeueCommand(CommandQueueEntry* entry) {
-    if (commandQueueHead == commandQueueTail) {
-        // Queue is empty
-        return false;
+const DownlinkSlot* peekCommand() {
+    uint8_t head = downlinkHead;
+    if (head == downlinkTail) {
+        return nullptr;
     }
-
-    *entry = commandQueue[commandQueueHead];
-    commandQueueHead = (commandQueueHead + 1) % COMMAND_QUEUE_SIZE;
-    return true;
+    return &downlinkQueue[head & (DOWNLINK_QUEUE_SIZE - 1)];
 }
 
 /**
- * @brief Process command queue
+ * @brief Consumer: release the slot returned by peekCommand()
  */
-void processCommandQueue() {
-    CommandQueueEntry entry;
-
-    while (dequeueCommand(&entry)) {
-        executeCommand(entry.commandId, entry.payload, entry.payloadLength);
-    }
+void popCommand() {
+    downlinkHead = downlinkHead + 1;
 }
 
 // ===========================================
@@ -151,40 +225,28 @@ void processCommandQueue() {
 
 /**
  * @brief Handle incoming downlink message
+ *
+ * Runs in the LMIC event context, so it only queues the payload; the
+ * command is executed later from processDownlink().
+ *
  * @param payload Payload data
  * @param size Payload size
  * @param rssi Signal strength (dBm)
  */
 void handleDownlink(uint8_t* payload, size_t size, int rssi) {
-    Serial.println(F(""));
-    Serial.println(F("========== DOWNLINK RECEIVED =========="));
-    Serial.print(F("Size: "));
-    Serial.print(size);
-    Serial.println(F(" bytes"));
-    Serial.print(F("RSSI: "));
-    Serial.print(rssi);
-    Serial.println(F(" dBm"));
-
-    // Validate minimum size
-    if (size < 1) {
-        Serial.println(F("ERROR: Invalid payload size"));
-        sendErrorResponse(ERR_INVALID_PARAMETER);
+    if (size == 0) {
         return;
     }
+    enqueueCommand(payload, size, rssi);
+}
 
-    // Print payload in hex
-    Serial.print(F("Payload: "));
-    for (size_t i = 0; i < size; i++) {
-        if (payload[i] < 0x10) Serial.print(F("0"));
-        Serial.print(payload[i], HEX);
-        Serial.print(F(" "));
-    }
-    Serial.println(F(""));
-
-    // Parse command
-    uint8_t commandId = payload[0];
-
-    // Validate command ID
+/**
+ * @brief Execute command
+ * @param commandId Command ID
+ * @param payload Payload data
+ * @param payloadLength Payload length
+ */
+void executeCommand(uint8_t commandId, const uint8_t* payload, uint8_t payloadLength) {
     if (!isValidCommand(commandId)) {
         Serial.print(F("ERROR: Unknown command: 0x"));
         Serial.println(commandId, HEX);
@@ -192,108 +254,34 @@ void handleDownlink(uint8_t* payload, size_t size, int rssi) {
         return;
     }
 
-    // Extract payload (if any)
-    const uint8_t* commandPayload = nullptr;
-    uint8_t commandPayloadLength = 0;
-
-    if (size > 1) {
-        commandPayload = payload + 1;
-        commandPayloadLength = size - 1;
-    }
-
-    // Execute command
-    if (systemConfig.debugEnabled) {
-        Serial.println(F("Executing command..."));
+    const CommandSpec& spec = COMMAND_TABLE[commandId];
+    if (payloadLength < spec.minLength || payloadLength > spec.maxLength) {
+        Serial.println(F("ERROR: Invalid payload length"));
+        sendErrorResponse(ERR_INVALID_PARAMETER);
+        return;
     }
 
-    executeCommand(commandId, commandPayload, commandPayloadLength);
-
-    Serial.println(F("======================================"));
-    Serial.println(F(""));
+    spec.handler(payload, payloadLength);
 }
 
 /**
- * @brief Validate command ID
- * @param commandId Command ID
- * @return true if command is valid
+ * @brief Run one queued downlink from its slot
  */
-bool isValidCommand(uint8_t commandId) {
-    switch (commandId) {
-        case CMD_PING:
-        case CMD_SET_INTERVAL:
-        case CMD_SET_DATARATE:
-        case CMD_SET_TXPOWER:
-        case CMD_REBOOT:
-        case CMD_GET_STATUS:
-        case CMD_SET_LED:
-        case CMD_SET_ALARM:
-        case CMD_GET_BATTERY:
-        case CMD_SET_ADR:
-        case CMD_CLEAR_STATS:
-            return true;
-        default:
-            return false;
+void processQueuedDownlink(const DownlinkSlot& slot) {
+    if (systemConfig.debugEnabled) {
+        Serial.print(F("Downlink: "));
+        Serial.print(slot.size);
+        Serial.print(F(" bytes, RSSI "));
+        Serial.print(slot.rssi);
+        Serial.print(F(" dBm:"));
+        for (uint8_t i = 0; i < slot.size; i++) {
+            Serial.print(slot.data[i] < 0x10 ? F(" 0") : F(" "));
+            Serial.print(slot.data[i], HEX);
+        }
+        Serial.println();
     }
-}
-
-/**
- * @brief Execute command
- * @param commandId Command ID
- * @param payload Payload data
- * @param payloadLength Payload length
- */
-void executeCommand(uint8_t commandId, const uint8_t* payload, uint8_t payloadLength) {
-    switch (commandId) {
-        case CMD_PING:
-            handlePing();
-            break;
-
-        case CMD_SET_INTERVAL:
-            handleSetInterval(payload, payloadLength);
-            break;
-
-        case CMD_SET_DATARATE:
-            handleSetDataRate(payload, payloadLength);
-            break;
-
-        case CMD_SET_TXPOWER:
-            handleSetTxPower(payload, payloadLength);
-            break;
-
-        case CMD_REBOOT:
-            handleReboot();
-            break;
-
-        case CMD_GET_STATUS:
-            handleGetStatus();
-            break;
-
-        case CMD_SET_LED:
-            handleSetLED(payload, payloadLength);
-            break;
-
-        case CMD_SET_ALARM:
-            handleSetAlarm(payload, payloadLength);
-            break;
-
-        case CMD_GET_BATTERY:
-            handleGetBattery();
-            break;
-
-        case CMD_SET_ADR:
-            handleSetADR(payload, payloadLength);
-            break;
-
-        case CMD_CLEAR_STATS:
-            handleClearStats();
-            break;
 
-        default:
-            Serial.print(F("ERROR: Unhandled command: 0x"));
-            Serial.println(commandId, HEX);
-            sendErrorResponse(ERR_NOT_IMPLEMENTED);
-            break;
-    }
+    executeCommand(slot.data[0], slot.size > 1 ? slot.data + 1 : nullptr, slot.size - 1);
 }
 
 // ===========================================
@@ -306,7 +294,7 @@ void executeCommand(uint8_t commandId, const uint8_t* payload, uint8_t payloadLe
  * Request: [0x00]
  * Response: [0x80] (ACK)
  */
-void handlePing() {
+void handlePing(const uint8_t* payload, uint8_t payloadLength) {
     Serial.println(F("Command: PING"));
 
     sendAck();
@@ -322,15 +310,9 @@ void handlePing() {
 void handleSetInterval(const uint8_t* payload, uint8_t payloadLength) {
     Serial.println(F("Command: SET_INTERVAL"));
 
-    // Validate payload length
-    if (payloadLength != 4) {
-        Serial.println(F("ERROR: Invalid payload length"));
-        sendErrorResponse(ERR_INVALID_PARAMETER);
-        return;
-    }
-
-    // Extract interval (little-endian)
-    uint32_t interval = *((uint32_t*)payload);
+    // Extract interval (little-endian; the parameters are not word aligned)
+    uint32_t interval;
+    memcpy(&interval, payload, sizeof(interval));
 
     Serial.print(F("  Interval: "));
     Serial.print(interval / 1000);
@@ -365,13 +347,6 @@ void handleSetInterval(const uint8_t* payload, uint8_t payloadLength) {
 void handleSetDataRate(const uint8_t* payload, uint8_t payloadLength) {
     Serial.println(F("Command: SET_DATARATE"));
 
-    // Validate payload length
-    if (payloadLength != 1) {
-        Serial.println(F("ERROR: Invalid payload length"));
-        sendErrorResponse(ERR_INVALID_PARAMETER);
-        return;
-    }
-
     uint8_t dataRate = payload[0];
 
     Serial.print(F("  Data Rate: DR"));
@@ -406,13 +381,6 @@ void handleSetDataRate(const uint8_t* payload, uint8_t payloadLength) {
 void handleSetTxPower(const uint8_t* payload, uint8_t payloadLength) {
     Serial.println(F("Command: SET_TXPOWER"));
 
-    // Validate payload length
-    if (payloadLength != 1) {
-        Serial.println(F("ERROR: Invalid payload length"));
-        sendErrorResponse(ERR_INVALID_PARAMETER);
-        return;
-    }
-
     int8_t txPower = (int8_t)payload[0];
 
     Serial.print(F("  TX Power: "));
@@ -443,21 +411,14 @@ void handleSetTxPower(const uint8_t* payload, uint8_t payloadLength) {
  *
  * Request: [0x04]
  * Response: [0x80] (ACK)
- * Note: Device reboots after sending ACK
+ * Note: Device reboots once the ACK has been transmitted
  */
-void handleReboot() {
+void handleReboot(const uint8_t* payload, uint8_t payloadLength) {
     Serial.println(F("Command: REBOOT"));
 
-    // Send ACK first
+    // processDownlink() resets after the response frame is on air
     sendAck();
-
-    // Delay to allow transmission
-    delay(1000);
-
-    // Reboot
-    Serial.println(F("Rebooting..."));
-
-    NVIC_SystemReset();
+    rebootPending = true;
 }
 
 /**
@@ -466,7 +427,7 @@ void handleReboot() {
  * Request: [0x05]
  * Response: [0x82, interval_lsb, ..., interval_msb, dr, power, adr, tx_count_lsb, ..., tx_count_msb, rx_count_lsb, ..., rx_count_msb]
  */
-void handleGetStatus() {
+void handleGetStatus(const uint8_t* payload, uint8_t payloadLength) {
     Serial.println(F("Command: GET_STATUS"));
 
     sendStatus();
@@ -482,13 +443,6 @@ void handleGetStatus() {
 void handleSetLED(const uint8_t* payload, uint8_t payloadLength) {
     Serial.println(F("Command: SET_LED"));
 
-    // Validate payload length
-    if (payloadLength != 1) {
-        Serial.println(F("ERROR: Invalid payload length"));
-        sendErrorResponse(ERR_INVALID_PARAMETER);
-        return;
-    }
-
     uint8_t enabled = payload[0];
 
     Serial.print(F("  LED: "));
@@ -512,17 +466,10 @@ void handleSetLED(const uint8_t* payload, uint8_t payloadLength) {
 void handleSetAlarm(const uint8_t* payload, uint8_t payloadLength) {
     Serial.println(F("Command: SET_ALARM"));
 
-    // Validate payload length
-    if (payloadLength != 1) {
-        Serial.println(F("ERROR: Invalid payload length"));
-        sendErrorResponse(ERR_INVALID_PARAMETER);
-        return;
-    }
-
     uint8_t enabled = payload[0];
 
     Serial.print(F("  Alarm: "));
-    Serial.println(enabled ? F("ON") : F("OFF")));
+    Serial.println(enabled ? F("ON") : F("OFF"));
 
     // Update system configuration
     systemConfig.alarmEnabled = enabled;
@@ -539,7 +486,7 @@ void handleSetAlarm(const uint8_t* payload, uint8_t payloadLength) {
  *          percent: 1 byte (0-100)
  *          voltage: 1 byte (voltage x 10, e.g., 42 = 4.2V)
  */
-void handleGetBattery() {
+void handleGetBattery(const uint8_t* payload, uint8_t payloadLength) {
     Serial.println(F("Command: GET_BATTERY"));
 
     sendBatteryLevel();
@@ -555,17 +502,10 @@ void handleGetBattery() {
 void handleSetADR(const uint8_t* payload, uint8_t payloadLength) {
     Serial.println(F("Command: SET_ADR"));
 
-    // Validate payload length
-    if (payloadLength != 1) {
-        Serial.println(F("ERROR: Invalid payload length"));
-        sendErrorResponse(ERR_INVALID_PARAMETER);
-        return;
-    }
-
     uint8_t enabled = payload[0];
 
     Serial.print(F("  ADR: "));
-    Serial.println(enabled ? F("Enabled") : F("Disabled")));
+    Serial.println(enabled ? F("Enabled") : F("Disabled"));
 
     // Update system configuration
     systemConfig.adrEnabled = enabled;
@@ -581,7 +521,7 @@ void handleSetADR(const uint8_t* payload, uint8_t payloadLength) {
  * Request: [0x0A]
  * Response: [0x80] (ACK)
  */
-void handleClearStats() {
+void handleClearStats(const uint8_t* payload, uint8_t payloadLength) {
     Serial.println(F("Command: CLEAR_STATS"));
 
     LoRaWAN.resetStatistics();
@@ -594,6 +534,66 @@ void handleClearStats() {
 // RESPONSE SENDERS
 // ===========================================
 
+/**
+ * Responses are not transmitted on their own. They are collected into one
+ * frame on LORAWAN_PORT_COMMAND, records back to back:
+ *
+ *   ACK [0x80]  NACK [0x81]  STATUS [0x82 + 17]  BATTERY [0x83 + 2]
+ *   ERROR [0xFF + code]
+ *
+ * A repeated ACK/NACK/STATUS/BATTERY replaces the earlier one. The frame is
+ * queued behind the next scheduled uplink (or after RESPONSE_MAX_DELAY),
+ * so a burst of commands costs one extra frame instead of one per command
+ * and nothing is sent from the RX window.
+ */
+/**
+ * @brief Add a response record, replacing an earlier one with the same ID
+ */
+void queueResponse(const uint8_t* record, uint8_t size) {
+    if (record[0] != RESP_ERROR) {
+        for (uint8_t offset = 0; offset < responseSize; ) {
+            uint8_t existing;
+            switch (responseBuffer[offset]) {
+                case RESP_STATUS:  existing = 18; break;
+                case RESP_BATTERY: existing = 3;  break;
+                case RESP_ERROR:   existing = 2;  break;
+                default:           existing = 1;  break;
+            }
+            if (responseBuffer[offset] == record[0] && existing == size) {
+                memcpy(responseBuffer + offset, record, size);
+                return;
+            }
+            offset += existing;
+        }
+    }
+
+    if (responseSize + size > RESPONSE_BUFFER_SIZE) {
+        flushResponses();
+    }
+    if (responseSize + size > RESPONSE_BUFFER_SIZE) {
+        // Flush failed (uplink queue full): drop rather than overrun
+        Serial.println(F("ERROR: Response buffer full, record dropped"));
+        return;
+    }
+    if (responseSize == 0) {
+        responseStart = millis();
+    }
+    memcpy(responseBuffer + responseSize, record, size);
+    responseSize += size;
+}
+
+/**
+ * @brief Queue the collected responses as one uplink
+ */
+void flushResponses() {
+    if (responseSize == 0) {
+        return;
+    }
+    if (LoRaWAN.transmitResponse(responseBuffer, responseSize)) {
+        responseSize = 0;
+    }
+}
+
 /**
  * @brief Send ACK response
  */
@@ -601,9 +601,9 @@ void sendAck() {
     uint8_t response[1];
     response[0] = RESP_ACK;
 
-    LMIC_setTxData2(LORAWAN_PORT_COMMAND, response, sizeof(response), 0);
+    queueResponse(response, sizeof(response));
 
-    Serial.println(F("  Response: ACK sent"));
+    Serial.println(F("  Response: ACK queued"));
 }
 
 /**
@@ -613,9 +613,9 @@ void sendNack() {
     uint8_t response[1];
     response[0] = RESP_NACK;
 
-    LMIC_setTxData2(LORAWAN_PORT_COMMAND, response, sizeof(response), 0);
+    queueResponse(response, sizeof(response));
 
-    Serial.println(F("  Response: NACK sent"));
+    Serial.println(F("  Response: NACK queued"));
 }
 
 /**
@@ -661,9 +661,9 @@ void sendStatus() {
     response[16] = (rxCount >> 16) & 0xFF;
     response[17] = (rxCount >> 24) & 0xFF;
 
-    LMIC_setTxData2(LORAWAN_PORT_COMMAND, response, sizeof(response), 0);
+    queueResponse(response, sizeof(response));
 
-    Serial.println(F("  Response: STATUS sent"));
+    Serial.println(F("  Response: STATUS queued"));
 }
 
 /**
@@ -690,7 +690,7 @@ void sendBatteryLevel() {
     response[1] = batteryPercent;
     response[2] = (uint8_t)(batteryVoltage * 10);
 
-    LMIC_setTxData2(LORAWAN_PORT_COMMAND, response, sizeof(response), 0);
+    queueResponse(response, sizeof(response));
 
     Serial.print(F("  Battery: "));
     Serial.print(batteryPercent);
@@ -698,7 +698,7 @@ void sendBatteryLevel() {
     Serial.print(batteryVoltage, 2);
     Serial.println(F("V)"));
 
-    Serial.println(F("  Response: BATTERY sent"));
+    Serial.println(F("  Response: BATTERY queued"));
 }
 
 /**
@@ -711,11 +711,11 @@ void sendErrorResponse(uint8_t errorCode) {
     response[0] = RESP_ERROR;
     response[1] = errorCode;
 
-    LMIC_setTxData2(LORAWAN_PORT_COMMAND, response, sizeof(response), 0);
+    queueResponse(response, sizeof(response));
 
     Serial.print(F("  Response: ERROR ("));
     Serial.print(errorCode);
-    Serial.println(F(") sent"));
+    Serial.println(F(") queued"));
 
     // Print error description
     const char* errorDescription;
@@ -770,13 +770,29 @@ void setupDownlinkHandler() {
 /**
  * @brief Process downlink messages
  *
- * This function should be called in the main loop
+ * This function should be called in the main loop, after LoRaWAN.loop().
+ * Commands queued by the LMIC event run here, outside the RX path.
  */
 void processDownlink() {
-    // Process command queue
-    processCommandQueue();
+    const DownlinkSlot* slot;
+    while ((slot = peekCommand()) != nullptr) {
+        processQueuedDownlink(*slot);
+        popCommand();
+    }
+
+    // Responses ride behind the next scheduled uplink
+    if (responseSize > 0 &&
+        (rebootPending || LoRaWAN.getQueuedUplinks() > 0 ||
+         millis() - responseStart >= RESPONSE_MAX_DELAY)) {
+        flushResponses();
+    }
 
-    // LMIC event processing is handled by LoRaWAN.loop()
+    // Reboot once the ACK has left the queue
+    if (rebootPending && responseSize == 0 &&
+        LoRaWAN.getQueuedUplinks() == 0 && !LoRaWAN.isTransmitting()) {
+        Serial.println(F("Rebooting..."));
+        NVIC_SystemReset();
+    }
 }
 
 /**
@@ -0,0 +1,289 @@
+/**
+ * Device-Side Link ADR
+ *
+ * Picks the uplink data rate and TX power from what the node itself sees,
+ * for deployments where the network does not run ADR (LMIC ADR bit off):
+ *
+ * - Every downlink (ACK, command, MAC-only frame) adds an RSSI/SNR sample
+ *   to a rolling window of LINK_ADR_HISTORY samples
+ * - Step up: the link margin is the best SNR in the window minus the
+ *   demodulation floor of the current data rate minus an installation
+ *   margin. Each LINK_ADR_STEP of margin raises the DR one step, then
+ *   lowers TX power once the highest DR is reached
+ * - Back off fast: LINK_ADR_MISS_LIMIT missed ACKs on confirmed uplinks,
+ *   or ackLimit uplinks without any downlink (as ADR_ACK_LIMIT in
+ *   LoRaWAN), first restore full power, then lower the DR one step per
+ *   further ackDelay silent uplinks / missed ACK
+ *
+ * The window holds downlink SNR, which stands in for the uplink SNR the
+ * gateway measures; gateways usually hear better than nodes, so the
+ * estimate errs on the slow side. Decisions are counted in LinkAdrStats.
+ *
+ * Header-only and LMIC-free (SNR in LMIC's quarter-dB units).
+ *
+ * Author: Production-Ready Implementation
+ * Version: 2.0.0
+ * License: MIT
+ */
+
+#ifndef LINK_ADR_H
+#define LINK_ADR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "lorawan_region.h"
+
+// ===========================================
+// LINK ADR CONFIGURATION
+// ===========================================
+
+#define LINK_ADR_HISTORY           20          // Samples in the window (as network-server ADR)
+#define LINK_ADR_MIN_SAMPLES       6           // Samples since the last change before stepping up
+#define LINK_ADR_INSTALL_MARGIN    40          // 10 dB (quarter dB) kept in reserve
+#define LINK_ADR_STEP              12          // 3 dB (quarter dB) of margin per step
+#define LINK_ADR_POWER_STEP        2           // dB per TX power step
+#define LINK_ADR_MISS_LIMIT        2           // Consecutive missed ACKs before backing off
+
+/**
+ * Why the last decision was taken
+ */
+enum LinkAdrReason {
+    LINK_ADR_HOLD,                 // No change
+    LINK_ADR_MARGIN,               // Stepped on link margin
+    LINK_ADR_MISSED_ACK,           // Confirmed uplinks not acknowledged
+    LINK_ADR_NO_DOWNLINK           // ackLimit uplinks without any downlink
+};
+
+/**
+ * Data rate and TX power to use for the next uplink
+ */
+struct LinkAdrDecision {
+    uint8_t dataRate;
+    int8_t txPower;
+    LinkAdrReason reason;
+};
+
+/**
+ * Link and decision statistics
+ */
+struct LinkAdrStats {
+    uint32_t samples;              // Downlinks sampled
+    uint32_t missedAcks;
+    uint32_t dataRateUp;
+    uint32_t dataRateDown;
+    uint32_t powerUp;
+    uint32_t powerDown;
+    int16_t marginX4;              // Last computed margin (quarter dB)
+    int16_t lastRssi;
+    int8_t lastSnrX4;
+    LinkAdrReason lastReason;
+};
+
+/**
+ * @brief Demodulation floor of a LoRa rate (SX127x datasheet)
+ * @return Required SNR in quarter dB: -7.5 dB at SF7 down to -20 dB at
+ *         SF12, 3 dB more per bandwidth doubling above 125 kHz
+ */
+constexpr int16_t loraRequiredSnrX4(uint8_t sf, uint16_t bwKHz) {
+    return -(30 + 10 * (sf - 7)) + (bwKHz >= 500 ? 24 : (bwKHz >= 250 ? 12 : 0));
+}
+
+static_assert(loraRequiredSnrX4(7, 125) == -30 && loraRequiredSnrX4(12, 125) == -80,
+              "SF7 -7.5 dB, SF12 -20 dB");
+
+template <typename Plan>
+class BasicLinkAdr {
+private:
+    struct Sample {
+        int16_t rssi;
+        int8_t snrX4;
+    };
+
+    Sample _history[LINK_ADR_HISTORY];
+    uint8_t _head;                 // Next slot to write
+    uint8_t _count;
+    uint8_t _sinceChange;          // Samples since the last DR / power change
+
+    int8_t _minPower;
+    int8_t _maxPower;
+    uint16_t _ackLimit;
+    uint16_t _ackDelay;
+
+    uint8_t _missStreak;           // Consecutive missed ACKs
+    uint16_t _silentUplinks;       // Uplinks since the last downlink
+    LinkAdrReason _backoff;        // Pending back-off, LINK_ADR_HOLD if none
+
+    LinkAdrStats _stats;
+
+    int8_t bestSnrX4() const {
+        int8_t best = _history[0].snrX4;
+        for (uint8_t i = 1; i < _count; i++) {
+            if (_history[i].snrX4 > best) {
+                best = _history[i].snrX4;
+            }
+        }
+        return best;
+    }
+
+public:
+    /**
+     * @param minPower Lowest TX power (dBm)
+     * @param maxPower Highest TX power (dBm)
+     * @param ackLimit Uplinks without downlink before backing off
+     * @param ackDelay Further silent uplinks per additional back-off step
+     */
+    BasicLinkAdr(int8_t minPower, int8_t maxPower, uint16_t ackLimit, uint16_t ackDelay)
+        : _minPower(minPower)
+        , _maxPower(maxPower)
+        , _ackLimit(ackLimit)
+        , _ackDelay(ackDelay ? ackDelay : 1)
+    {
+        reset();
+        resetStatistics();
+    }
+
+    /**
+     * @brief Forget the window and any pending back-off (e.g. after a join)
+     */
+    void reset() {
+        _head = 0;
+        _count = 0;
+        _sinceChange = 0;
+        _missStreak = 0;
+        _silentUplinks = 0;
+        _backoff = LINK_ADR_HOLD;
+    }
+
+    void resetStatistics() {
+        memset(&_stats, 0, sizeof(_stats));
+        _stats.lastReason = LINK_ADR_HOLD;
+    }
+
+    void setAckLimit(uint16_t ackLimit, uint16_t ackDelay) {
+        _ackLimit = ackLimit;
+        _ackDelay = ackDelay ? ackDelay : 1;
+    }
+
+    /**
+     * @brief Add the RSSI/SNR of a received downlink
+     * @param snrX4 SNR in quarter dB (LMIC.snr)
+     */
+    void addSample(int16_t rssi, int8_t snrX4) {
+        _history[_head].rssi = rssi;
+        _history[_head].snrX4 = snrX4;
+        _head = (_head + 1) % LINK_ADR_HISTORY;
+        if (_count < LINK_ADR_HISTORY) {
+            _count++;
+        }
+        if (_sinceChange < 0xFF) {
+            _sinceChange++;
+        }
+
+        _silentUplinks = 0;
+        _stats.samples++;
+        _stats.lastRssi = rssi;
+        _stats.lastSnrX4 = snrX4;
+    }
+
+    /**
+     * @brief Report the outcome of an uplink
+     * @param confirmed The uplink asked for an ACK
+     * @param acked     The ACK arrived (ignored for unconfirmed uplinks)
+     * @param downlink  Any downlink arrived in the RX windows
+     */
+    void reportUplink(bool confirmed, bool acked, bool downlink) {
+        if (confirmed) {
+            if (acked) {
+                _missStreak = 0;
+            } else {
+                _stats.missedAcks++;
+                if (++_missStreak >= LINK_ADR_MISS_LIMIT) {
+                    _missStreak = 0;
+                    _backoff = LINK_ADR_MISSED_ACK;
+                }
+            }
+        }
+
+        if (downlink) {
+            return;
+        }
+        if (_silentUplinks < 0xFFFF) {
+            _silentUplinks++;
+        }
+        if (_silentUplinks >= _ackLimit && (_silentUplinks - _ackLimit) % _ackDelay == 0) {
+            _backoff = LINK_ADR_NO_DOWNLINK;
+        }
+    }
+
+    /**
+     * @brief Data rate and power for the next uplink
+     * @param dataRate Current data rate
+     * @param txPower  Current TX power (dBm)
+     */
+    LinkAdrDecision decide(uint8_t dataRate, int8_t txPower) {
+        LinkAdrDecision decision = {dataRate, txPower, LINK_ADR_HOLD};
+
+        if (_backoff != LINK_ADR_HOLD) {
+            decision.reason = _backoff;
+            _backoff = LINK_ADR_HOLD;
+
+            if (txPower < _maxPower) {
+                decision.txPower = _maxPower;
+                _stats.powerUp++;
+            } else if (dataRate > Plan::MIN_DR) {
+                decision.dataRate = dataRate - 1;
+                _stats.dataRateDown++;
+            }
+
+            // Samples from before the loss no longer describe the link
+            _head = 0;
+            _count = 0;
+            _sinceChange = 0;
+            _stats.lastReason = decision.reason;
+            return decision;
+        }
+
+        if (_count == 0 || _sinceChange < LINK_ADR_MIN_SAMPLES || !Plan::validDataRate(dataRate)) {
+            return decision;
+        }
+
+        const LoRaDataRate& rate = Plan::DATA_RATES[dataRate];
+        int16_t margin = bestSnrX4() - loraRequiredSnrX4(rate.sf, rate.bwKHz) - LINK_ADR_INSTALL_MARGIN;
+        int16_t steps = margin / LINK_ADR_STEP;
+        _stats.marginX4 = margin;
+
+        while (steps > 0 && decision.dataRate < Plan::MAX_DR && Plan::validDataRate(decision.dataRate + 1)) {
+            decision.dataRate++;
+            steps--;
+        }
+        while (steps > 0 && decision.txPower - LINK_ADR_POWER_STEP >= _minPower) {
+            decision.txPower -= LINK_ADR_POWER_STEP;
+            steps--;
+        }
+        while (steps < 0 && decision.txPower + LINK_ADR_POWER_STEP <= _maxPower) {
+            decision.txPower += LINK_ADR_POWER_STEP;
+            steps++;
+        }
+
+        if (decision.dataRate != dataRate || decision.txPower != txPower) {
+            decision.reason = LINK_ADR_MARGIN;
+            _stats.dataRateUp += decision.dataRate - dataRate;
+            if (decision.txPower < txPower) {
+                _stats.powerDown++;
+            } else if (decision.txPower > txPower) {
+                _stats.powerUp++;
+            }
+            _sinceChange = 0;
+            _stats.lastReason = decision.reason;
+        }
+        return decision;
+    }
+
+    uint8_t getSampleCount() const { return _count; }
+    const LinkAdrStats& getStats() const { return _stats; }
+};
+
+typedef BasicLinkAdr<LoRaWANRegion> LinkAdr;
+
+#endif // LINK_ADR_H
@@ -0,0 +1,277 @@
+/**
+ * LoRa Time-on-Air and Duty Cycle Ledger
+ *
+ * - Semtech SX127x time-on-air formula (AN1200.13), evaluated from SF,
+ *   bandwidth, coding rate, preamble length and low-data-rate optimisation
+ * - Data rate and sub-band descriptors with the per-symbol constants
+ *   precomputed at compile time
+ * - Per-sub-band sliding-window duty cycle ledger that reports exactly when
+ *   the next frame of a given airtime fits in the regulatory budget
+ *
+ * Header-only and LMIC-free so the same numbers can be used by host tools.
+ * The region tables live in lorawan_region.h.
+ *
+ * Author: Production-Ready Implementation
+ * Version: 2.0.0
+ * License: MIT
+ */
+
+#ifndef LORAWAN_AIRTIME_H
+#define LORAWAN_AIRTIME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ===========================================
+// FRAME CONFIGURATION
+// ===========================================
+
+#define LORA_PREAMBLE_SYMBOLS      8           // LoRaWAN uplink preamble
+#define LORA_CODING_RATE           1           // 1 = 4/5 ... 4 = 4/8
+#define LORA_LDRO_SYMBOL_US        16000       // LDRO mandated at >= 16 ms symbols
+#define LORAWAN_FRAME_OVERHEAD     13          // MHDR(1) + FHDR(7) + FPort(1) + MIC(4)
+
+// ===========================================
+// DUTY CYCLE LEDGER CONFIGURATION
+// ===========================================
+
+#define DUTY_LEDGER_WINDOW         3600000UL   // Sliding window: 1 hour
+#define DUTY_LEDGER_ENTRIES        16          // Transmissions tracked per sub-band
+#define DUTY_LEDGER_COALESCE       60000UL     // Merge uplinks closer than 60 s
+#define DUTY_LEDGER_NEVER          0xFFFFFFFFUL // Frame can never fit the budget
+
+// ===========================================
+// TIME-ON-AIR (constexpr, C++11 compatible)
+// ===========================================
+
+/**
+ * @brief Symbol duration
+ * @param sf Spreading factor (7-12)
+ * @param bwKHz Bandwidth in kHz (125, 250, 500)
+ * @return Symbol time in microseconds (exact for all LoRaWAN SF/BW pairs)
+ */
+constexpr uint32_t loraSymbolUs(uint8_t sf, uint16_t bwKHz) {
+    return ((uint32_t)1000 << sf) / bwKHz;
+}
+
+/**
+ * @brief Low data rate optimisation flag (DE)
+ */
+constexpr bool loraLowDataRate(uint8_t sf, uint16_t bwKHz) {
+    return loraSymbolUs(sf, bwKHz) >= LORA_LDRO_SYMBOL_US;
+}
+
+/**
+ * @brief Payload bits carried per coding block of 4 symbols: 4 * (SF - 2 * DE)
+ */
+constexpr uint8_t loraBitsPerBlock(uint8_t sf, uint16_t bwKHz) {
+    return 4 * (sf - (loraLowDataRate(sf, bwKHz) ? 2 : 0));
+}
+
+/**
+ * @brief Preamble duration: (n + 4.25) symbols, in microseconds
+ */
+constexpr uint32_t loraPreambleUs(uint8_t sf, uint16_t bwKHz) {
+    return (LORA_PREAMBLE_SYMBOLS * 4 + 17) * loraSymbolUs(sf, bwKHz) / 4;
+}
+
+/**
+ * @brief Payload symbols for an explicit-header uplink with CRC
+ * @param phyBytes PHY payload size (application payload + LoRaWAN overhead)
+ */
+constexpr uint32_t loraPayloadSymbols(uint16_t phyBytes, uint8_t sf, uint8_t bitsPerBlock) {
+    return 8 + ((8 * (int32_t)phyBytes - 4 * sf + 28 + 16) <= 0 ? 0 :
+                ((8 * (int32_t)phyBytes - 4 * sf + 28 + 16 + bitsPerBlock - 1) / bitsPerBlock) *
+                (LORA_CODING_RATE + 4));
+}
+
+/**
+ * @brief Time on air of a PHY payload
+ * @return Airtime in microseconds
+ */
+constexpr uint32_t loraTimeOnAirUs(uint16_t phyBytes, uint8_t sf, uint16_t bwKHz) {
+    return loraPreambleUs(sf, bwKHz) +
+           loraPayloadSymbols(phyBytes, sf, loraBitsPerBlock(sf, bwKHz)) * loraSymbolUs(sf, bwKHz);
+}
+
+// ===========================================
+// DATA RATE AND SUB-BAND DESCRIPTORS
+// ===========================================
+
+/**
+ * Uplink data rate, with the per-symbol constants derived at compile time
+ */
+struct LoRaDataRate {
+    uint8_t sf;              // 0 = not a LoRa uplink rate (FSK / downlink only)
+    uint16_t bwKHz;
+    uint8_t maxPayload;      // Max application payload (N) in bytes
+    uint32_t symbolUs;
+    uint32_t preambleUs;
+    uint8_t bitsPerBlock;
+};
+
+constexpr LoRaDataRate loraDataRate(uint8_t sf, uint16_t bwKHz, uint8_t maxPayload) {
+    return LoRaDataRate{sf, bwKHz, maxPayload,
+                        sf ? loraSymbolUs(sf, bwKHz) : 0,
+                        sf ? loraPreambleUs(sf, bwKHz) : 0,
+                        sf ? loraBitsPerBlock(sf, bwKHz) : (uint8_t)1};
+}
+
+/**
+ * Regulatory sub-band (frequency range sharing one duty cycle budget)
+ */
+struct LoRaSubBand {
+    uint32_t minHz;
+    uint32_t maxHz;
+    uint16_t dutyPermille;   // Allowed airtime per window, in 1/1000
+};
+
+// Reference values (Semtech LoRa calculator, CR 4/5, 8 symbol preamble, CRC on)
+static_assert(loraTimeOnAirUs(LORAWAN_FRAME_OVERHEAD, 7, 125) == 46336, "SF7 empty frame");
+static_assert(loraTimeOnAirUs(LORAWAN_FRAME_OVERHEAD + 51, 9, 125) == 390144, "SF9 51-byte frame");
+static_assert(loraTimeOnAirUs(LORAWAN_FRAME_OVERHEAD + 51, 12, 125) == 2793472, "SF12 51-byte frame (LDRO)");
+
+// ===========================================
+// DUTY CYCLE LEDGER
+// ===========================================
+
+/**
+ * Sliding-window airtime ledger, one ring of transmissions per sub-band.
+ *
+ * Each entry holds the end time of a transmission and its airtime; it stops
+ * counting once it is a full window old. When uplinks are close together or
+ * the ring fills up, entries are merged into the later one, which can only
+ * make the budget more conservative, never exceed it.
+ *
+ * Plan is a RegionPlan (lorawan_region.h): it sizes the band array and
+ * provides the per-band budget. Use the DutyCycleLedger typedef there.
+ */
+template <typename Plan>
+class BasicDutyCycleLedger {
+private:
+    struct Entry {
+        uint32_t timeMs;     // When the transmission ended
+        uint32_t airtimeMs;
+    };
+
+    struct Band {
+        Entry entries[DUTY_LEDGER_ENTRIES];
+        uint8_t head;        // Oldest entry
+        uint8_t count;
+    };
+
+    Band _bands[Plan::SUB_BAND_COUNT];
+
+    void expire(Band& b, uint32_t now) {
+        while (b.count > 0) {
+            Entry& oldest = b.entries[b.head];
+            if (now - oldest.timeMs < DUTY_LEDGER_WINDOW) {
+                break;
+            }
+            b.head = (b.head + 1) % DUTY_LEDGER_ENTRIES;
+            b.count--;
+        }
+    }
+
+public:
+    BasicDutyCycleLedger() { reset(); }
+
+    void reset() {
+        memset(_bands, 0, sizeof(_bands));
+    }
+
+    /**
+     * @brief Record a finished transmission
+     * @param band Sub-band index
+     * @param airtimeMs Airtime consumed
+     * @param now Current time (millis)
+     */
+    void record(uint8_t band, uint32_t airtimeMs, uint32_t now) {
+        if (band >= Plan::SUB_BAND_COUNT) {
+            return;
+        }
+
+        Band& b = _bands[band];
+        expire(b, now);
+
+        if (b.count > 0) {
+            Entry& newest = b.entries[(b.head + b.count - 1) % DUTY_LEDGER_ENTRIES];
+            if (now - newest.timeMs < DUTY_LEDGER_COALESCE) {
+                newest.timeMs = now;
+                newest.airtimeMs += airtimeMs;
+                return;
+            }
+        }
+
+        if (b.count == DUTY_LEDGER_ENTRIES) {
+            // Ring full: fold the oldest entry into the next one
+            Entry& oldest = b.entries[b.head];
+            b.head = (b.head + 1) % DUTY_LEDGER_ENTRIES;
+            b.entries[b.head].airtimeMs += oldest.airtimeMs;
+            b.count--;
+        }
+
+        Entry& entry = b.entries[(b.head + b.count) % DUTY_LEDGER_ENTRIES];
+        entry.timeMs = now;
+        entry.airtimeMs = airtimeMs;
+        b.count++;
+    }
+
+    /**
+     * @brief Airtime used in the current window
+     */
+    uint32_t used(uint8_t band, uint32_t now) const {
+        if (band >= Plan::SUB_BAND_COUNT) {
+            return 0;
+        }
+
+        const Band& b = _bands[band];
+        uint32_t usedMs = 0;
+        for (uint8_t i = 0; i < b.count; i++) {
+            const Entry& e = b.entries[(b.head + i) % DUTY_LEDGER_ENTRIES];
+            if (now - e.timeMs < DUTY_LEDGER_WINDOW) {
+                usedMs += e.airtimeMs;
+            }
+        }
+        return usedMs;
+    }
+
+    /**
+     * @brief Time until a frame of the given airtime fits the budget
+     * @return 0 if it can be sent now, milliseconds to wait otherwise,
+     *         DUTY_LEDGER_NEVER if it exceeds the whole budget
+     */
+    uint32_t delayFor(uint8_t band, uint32_t airtimeMs, uint32_t now) const {
+        if (band >= Plan::SUB_BAND_COUNT) {
+            return 0;
+        }
+
+        uint32_t budget = Plan::budgetMs(band);
+        if (airtimeMs > budget) {
+            return DUTY_LEDGER_NEVER;
+        }
+
+        uint32_t usedMs = used(band, now);
+        if (usedMs + airtimeMs <= budget) {
+            return 0;
+        }
+
+        // Walk from the oldest live entry until enough airtime has expired
+        const Band& b = _bands[band];
+        for (uint8_t i = 0; i < b.count; i++) {
+            const Entry& e = b.entries[(b.head + i) % DUTY_LEDGER_ENTRIES];
+            if (now - e.timeMs >= DUTY_LEDGER_WINDOW) {
+                continue;
+            }
+            usedMs -= e.airtimeMs;
+            if (usedMs + airtimeMs <= budget) {
+                return e.timeMs + DUTY_LEDGER_WINDOW - now;
+            }
+        }
+
+        return 0;
+    }
+};
+
+#endif // LORAWAN_AIRTIME_H
@@ -13,7 +13,8 @@
  */
 
 #include "lorawan_implementation.h"
-#include <CRC16.h>
+#include "crc16.h"
+#include <stddef.h>
 
 // ===========================================
 // LMIC GLOBAL CONFIGURATION
@@ -80,10 +81,10 @@ LoRaWANManager::LoRaWANManager()
     , _joining(false)
     , _adrEnabled(ADR_ENABLE)
     , _lastTransmission(0)
-    , _lastDutyCycleTime(0)
     , _lastJoinAttempt(0)
     , _transmitInterval(TX_INTERVAL_60SEC)
-    , _dutyCycleAccumulator(0)
+    , _txBand(Region::subBand(Region::DEFAULT_UPLINK_HZ))
+    , _txDataRate(DEFAULT_DATA_RATE)
     , _txCount(0)
     , _txSuccessCount(0)
     , _txFailCount(0)
@@ -91,6 +92,19 @@ LoRaWANManager::LoRaWANManager()
     , _joinRetryCount(0)
     , _retryCount(0)
     , _maxRetries(MAX_RETRIES)
+    , _queueHead(0)
+    , _queueTail(0)
+    , _queueDropCount(0)
+    , _txState(TX_STATE_IDLE)
+    , _txStartTime(0)
+    , _retryAt(0)
+    , _aggregateSize(0)
+    , _aggregationEnabled(false)
+    , _aggregateStart(0)
+    , _aggregateLatency(AGGREGATE_MAX_LATENCY)
+    , _linkAdr(MIN_TX_POWER, MAX_TX_POWER, ADR_ACK_LIMIT, 1 << ADR_ACK_DELAY_EXP)
+    , _linkAdrEnabled(LINK_ADR_ENABLE)
+    , _linkAdrPending(false)
     , _dataRate(DEFAULT_DATA_RATE)
     , _txPower(DEFAULT_TX_POWER)
     , _onJoinCallback(nullptr)
@@ -98,6 +112,7 @@ LoRaWANManager::LoRaWANManager()
     , _onDownlinkCallback(nullptr)
     , _onErrorCallback(nullptr)
 {
+    sensorCodecReset(_codecState);
     memset(_appEui, 0, sizeof(_appEui));
     memset(_devEui, 0, sizeof(_devEui));
     memset(_appKey, 0, sizeof(_appKey));
@@ -130,6 +145,7 @@ bool LoRaWANManager::beginOTAA(const uint8_t* appEui, const uint8_t* appKey, con
     // Initialize LMIC
     os_init();
     LMIC_reset();
+    tracer().begin();
 
     // Set RX1 and RX2 window parameters
     LMIC.rx1_delay = RX1_DELAY;
@@ -172,6 +188,7 @@ bool LoRaWANManager::beginABP(const uint8_t* nwkSKey, const uint8_t* appSKey, ui
     // Initialize LMIC
     os_init();
     LMIC_reset();
+    tracer().begin();
 
     // Set session keys
     LMIC_setSession(0x1, _devAddr, _nwkSKey, _appSKey);
@@ -285,23 +302,18 @@ bool LoRaWANManager::rejoin() {
 }
 
 /**
- * @brief Transmit raw packet
- * @param payload Payload data
+ * @brief Queue raw packet for transmission (non-blocking)
+ * @param payload Payload data (copied into the queue)
  * @param size Payload size
  * @param port LoRaWAN port
- * @return true if transmission successful
+ * @param confirmed Request a network acknowledgment
+ * @return true if the uplink was queued; the outcome is reported through
+ *         OnTxCompleteCallback once the uplink succeeds or exhausts its retries
  */
-bool LoRaWANManager::transmitPacket(const uint8_t* payload, size_t size, uint8_t port) {
-    if (!_connected) {
-        Serial.println(F("Cannot transmit: Not connected"));
-        if (_onErrorCallback) {
-            _onErrorCallback(ERR_NOT_JOINED);
-        }
-        return false;
-    }
-
+bool LoRaWANManager::transmitPacket(const uint8_t* payload, size_t size, uint8_t port,
+                                    bool confirmed) {
     // Check payload size
-    if (size > LMIC_MAX_PAYLOAD_LENGTH) {
+    if (size > UPLINK_MAX_PAYLOAD) {
         Serial.print(F("Payload too large: "));
         Serial.println(size);
         if (_onErrorCallback) {
@@ -310,12 +322,6 @@ bool LoRaWANManager::transmitPacket(const uint8_t* payload, size_t size, uint8_t
         return false;
     }
 
-    // Check duty cycle
-    if (!canTransmit()) {
-        Serial.println(F("Cannot transmit: Duty cycle limit reached"));
-        return false;
-    }
-
     // Validate packet if it has checksum
     if (size >= sizeof(uint16_t)) {
         uint16_t receivedChecksum = *((uint16_t*)(payload + size - sizeof(uint16_t)));
@@ -330,111 +336,198 @@ bool LoRaWANManager::transmitPacket(const uint8_t* payload, size_t size, uint8_t
         }
     }
 
-    // Calculate airtime
-    uint32_t airtimeMs = calculateAirtime(size);
-
-    // Attempt transmission with retries
-    _retryCount = 0;
-    bool success = false;
-
-    while (_retryCount < _maxRetries && !success) {
-        if (_retryCount > 0) {
-            unsigned long retryDelay = getRetryDelay();
-
-            Serial.print(F("Retry "));
-            Serial.print(_retryCount);
-            Serial.print(F(" in "));
-            Serial.print(retryDelay);
-            Serial.println(F("ms"));
+    return enqueueUplink(payload, size, port, confirmed);
+}
 
-            delay(retryDelay);
+/**
+ * @brief Copy an uplink into the queue (no payload validation)
+ * @return true if queued
+ */
+bool LoRaWANManager::enqueueUplink(const uint8_t* payload, size_t size, uint8_t port,
+                                   bool confirmed) {
+    if (size > UPLINK_MAX_PAYLOAD) {
+        if (_onErrorCallback) {
+            _onErrorCallback(ERR_BUFFER_OVERFLOW);
         }
+        return false;
+    }
 
-        // Prepare transmission
-        _txCount++;
+    uint8_t nextTail = (_queueTail + 1) % UPLINK_QUEUE_SIZE;
 
-        // Send payload
-        int result = LMIC_setTxData2(port, (xref2u1_t)payload, size, 0);
+    if (nextTail == _queueHead) {
+        // Queue is full
+        _queueDropCount++;
+        Serial.println(F("Uplink queue full, packet dropped"));
+        if (_onErrorCallback) {
+            _onErrorCallback(ERR_BUFFER_OVERFLOW);
+        }
+        return false;
+    }
 
-        if (result != 0) {
-            Serial.print(F("TX failed: "));
-            Serial.println(result);
+    UplinkQueueEntry& entry = _uplinkQueue[_queueTail];
+    memcpy(entry.payload, payload, size);
+    entry.size = size;
+    entry.port = port;
+    entry.retries = 0;
+    entry.confirmed = confirmed;
 
-            _txFailCount++;
-            _retryCount++;
+    _queueTail = nextTail;
 
-            if (_onErrorCallback) {
-                _onErrorCallback(result);
-            }
+    // Start right away if the radio is idle
+    processUplinkQueue();
 
-            continue;
-        }
+    return true;
+}
 
-        // Wait for transmission complete
-        Serial.print(F("TX in progress ("));
-        Serial.print(size);
-        Serial.println(F(" bytes)..."));
+/**
+ * @brief Number of uplinks waiting or in flight
+ */
+uint8_t LoRaWANManager::getQueuedUplinks() const {
+    return (_queueTail + UPLINK_QUEUE_SIZE - _queueHead) % UPLINK_QUEUE_SIZE;
+}
 
-        unsigned long txTimeout = 30000;  // 30 seconds
-        unsigned long txStartTime = millis();
+/**
+ * @brief Drop all queued uplinks (an uplink already handed to LMIC still completes)
+ */
+void LoRaWANManager::clearUplinkQueue() {
+    if (_txState == TX_STATE_PENDING) {
+        // Keep the in-flight entry so its completion can be matched
+        _queueTail = (_queueHead + 1) % UPLINK_QUEUE_SIZE;
+    } else {
+        _queueHead = _queueTail;
+        _txState = TX_STATE_IDLE;
+    }
+}
 
-        while (LMIC.opmode & OP_TXRXPEND) {
-            os_runloop_once();
+/**
+ * @brief Advance the transmit state machine (called from loop())
+ */
+void LoRaWANManager::processUplinkQueue() {
+    unsigned long now = millis();
 
-            if (millis() - txStartTime > txTimeout) {
+    switch (_txState) {
+        case TX_STATE_PENDING:
+            // EV_TXCOMPLETE normally ends this state
+            if (now - _txStartTime > TX_COMPLETE_TIMEOUT) {
                 Serial.println(F("TX timeout"));
-
-                _txFailCount++;
-                _retryCount++;
-
                 if (_onErrorCallback) {
                     _onErrorCallback(ERR_NETWORK_ERROR);
                 }
+                completeUplink(false);
+            }
+            return;
 
-                break;
+        case TX_STATE_BACKOFF:
+            if ((long)(now - _retryAt) < 0) {
+                return;
             }
+            _txState = TX_STATE_IDLE;
+            break;
 
-            delay(10);
-        }
+        case TX_STATE_IDLE:
+            break;
+    }
 
-        // Check if transmission was successful
-        success = !(LMIC.opmode & OP_TXRXPEND);
+    if (_queueHead == _queueTail || !_connected) {
+        return;
+    }
 
-        if (success) {
-            _txSuccessCount++;
-            _lastTransmission = millis();
-            recordTransmission(airtimeMs);
+    // Settle DR / power for this uplink before its airtime is checked
+    if (_linkAdrPending) {
+        applyLinkAdr();
+    }
 
-            Serial.print(F("TX successful (airtime: "));
-            Serial.print(airtimeMs);
-            Serial.println(F("ms)"));
+    // LMIC busy (e.g. join or MAC traffic) or duty cycle exhausted: try later
+    if ((LMIC.opmode & OP_TXRXPEND) || !canTransmit(_uplinkQueue[_queueHead].size)) {
+        return;
+    }
 
-            if (_onTxCompleteCallback) {
-                _onTxCompleteCallback(true);
-            }
-        } else {
-            _txFailCount++;
-            _retryCount++;
+    if (!startUplink(_uplinkQueue[_queueHead])) {
+        completeUplink(false);
+    }
+}
+
+/**
+ * @brief Hand the uplink at the head of the queue to LMIC
+ * @return true if LMIC accepted the frame
+ */
+bool LoRaWANManager::startUplink(UplinkQueueEntry& entry) {
+    _txCount++;
 
-            Serial.print(F("TX failed, retry "));
-            Serial.println(_retryCount);
+    int result = LMIC_setTxData2(entry.port, (xref2u1_t)entry.payload, entry.size,
+                                 entry.confirmed ? 1 : 0);
 
-            if (_onTxCompleteCallback) {
-                _onTxCompleteCallback(false);
-            }
+    if (result != 0) {
+        Serial.print(F("TX failed: "));
+        Serial.println(result);
+
+        if (_onErrorCallback) {
+            _onErrorCallback(result);
         }
+        return false;
     }
 
-    if (!success) {
-        Serial.println(F("TX failed after all retries"));
+    Serial.print(F("TX in progress ("));
+    Serial.print(entry.size);
+    Serial.println(F(" bytes)..."));
+
+    _txState = TX_STATE_PENDING;
+    _txStartTime = millis();
+    _txDataRate = LMIC.datarate;
+    TRACE_BEGIN(TRACE_LORA_TX);
+    return true;
+}
 
-        if (_onTxCompleteCallback) {
-            _onTxCompleteCallback(false);
+/**
+ * @brief Finish the current attempt: pop on success or final failure,
+ *        otherwise schedule a retry with exponential backoff
+ * @param success true if the uplink was sent (and acknowledged if confirmed)
+ */
+void LoRaWANManager::completeUplink(bool success) {
+    if (_queueHead == _queueTail) {
+        _txState = TX_STATE_IDLE;
+        return;
+    }
+
+    UplinkQueueEntry& entry = _uplinkQueue[_queueHead];
+
+    if (success) {
+        _txSuccessCount++;
+        _lastTransmission = millis();
+
+        Serial.print(F("TX successful (airtime: "));
+        Serial.print(Region::airtimeMs(entry.size, _txDataRate));
+        Serial.println(F("ms)"));
+    } else {
+        _txFailCount++;
+        entry.retries++;
+
+        if (entry.retries < _maxRetries) {
+            _retryCount = entry.retries;
+            unsigned long retryDelay = getRetryDelay();
+
+            Serial.print(F("Retry "));
+            Serial.print(entry.retries);
+            Serial.print(F(" in "));
+            Serial.print(retryDelay);
+            Serial.println(F("ms"));
+
+            _txState = TX_STATE_BACKOFF;
+            _retryAt = millis() + retryDelay;
+            return;
         }
+
+        Serial.println(F("TX failed after all retries"));
     }
 
+    // Done with this uplink
+    _queueHead = (_queueHead + 1) % UPLINK_QUEUE_SIZE;
     _retryCount = 0;
-    return success;
+    _txState = TX_STATE_IDLE;
+
+    if (_onTxCompleteCallback) {
+        _onTxCompleteCallback(success);
+    }
 }
 
 /**
@@ -443,6 +536,14 @@ bool LoRaWANManager::transmitPacket(const uint8_t* payload, size_t size, uint8_t
  * @return true if transmission successful
  */
 bool LoRaWANManager::transmitSensorData(const SensorDataPacket& packet) {
+    if (_aggregationEnabled) {
+        const size_t bodyStart = offsetof(SensorDataPacket, temperature);
+        return aggregateRecord(PACKET_TYPE_SENSOR, packet.timestamp,
+                               (const uint8_t*)&packet + bodyStart,
+                               offsetof(SensorDataPacket, checksum) - bodyStart,
+                               (const uint8_t*)&packet, sizeof(SensorDataPacket), LORAWAN_PORT_SENSOR);
+    }
+
     return transmitPacket((const uint8_t*)&packet, sizeof(SensorDataPacket), LORAWAN_PORT_SENSOR);
 }
 
@@ -452,6 +553,15 @@ bool LoRaWANManager::transmitSensorData(const SensorDataPacket& packet) {
  * @return true if transmission successful
  */
 bool LoRaWANManager::transmitDetection(const DetectionDataPacket& packet) {
+    if (_aggregationEnabled) {
+        const size_t bodyStart = offsetof(DetectionDataPacket, detectionType);
+        return aggregateRecord(PACKET_TYPE_DETECTION, packet.timestamp,
+                               (const uint8_t*)&packet + bodyStart,
+                               offsetof(DetectionDataPacket, checksum) - bodyStart,
+                               (const uint8_t*)&packet, sizeof(DetectionDataPacket),
+                               LORAWAN_PORT_DETECTION);
+    }
+
     return transmitPacket((const uint8_t*)&packet, sizeof(DetectionDataPacket), LORAWAN_PORT_DETECTION);
 }
 
@@ -461,9 +571,207 @@ bool LoRaWANManager::transmitDetection(const DetectionDataPacket& packet) {
  * @return true if transmission successful
  */
 bool LoRaWANManager::transmitStatus(const StatusDataPacket& packet) {
+    if (_aggregationEnabled) {
+        // Uptime is carried by the record offset
+        const size_t bodyStart = offsetof(StatusDataPacket, txCount);
+        return aggregateRecord(PACKET_TYPE_STATUS, packet.uptime,
+                               (const uint8_t*)&packet + bodyStart,
+                               offsetof(StatusDataPacket, checksum) - bodyStart,
+                               (const uint8_t*)&packet, sizeof(StatusDataPacket), LORAWAN_PORT_STATUS);
+    }
+
     return transmitPacket((const uint8_t*)&packet, sizeof(StatusDataPacket), LORAWAN_PORT_STATUS);
 }
 
+/**
+ * @brief Transmit status packet followed by the span trace summary
+ * @param packet Status data packet
+ * @return true if queued
+ *
+ * Appends as many TraceSummaryRecords as fit the current data rate (see
+ * packet_types.h). Sent on its own, never aggregated.
+ */
+bool LoRaWANManager::transmitStatusWithTrace(const StatusDataPacket& packet) {
+    uint8_t frame[UPLINK_MAX_PAYLOAD];
+    size_t limit = Region::validDataRate(LMIC.datarate) ? Region::maxPayload(LMIC.datarate)
+                                                        : sizeof(StatusDataPacket);
+    if (limit > sizeof(frame)) {
+        limit = sizeof(frame);
+    }
+
+    TraceSummaryRecord records[TRACE_SPAN_COUNT];
+    uint8_t count = 0;
+    if (limit > sizeof(StatusDataPacket)) {
+        count = tracer().summarize(records, (limit - sizeof(StatusDataPacket)) / sizeof(TraceSummaryRecord));
+    }
+
+    memcpy(frame, &packet, sizeof(StatusDataPacket));
+    memcpy(frame + sizeof(StatusDataPacket), records, count * sizeof(TraceSummaryRecord));
+
+    return enqueueUplink(frame, sizeof(StatusDataPacket) + count * sizeof(TraceSummaryRecord),
+                         LORAWAN_PORT_STATUS, false);
+}
+
+/**
+ * @brief Transmit a reading with the compact sensor codec (sensor_codec.h)
+ * @param reading Reading in engineering units
+ * @param forceKeyframe Send a full keyframe instead of a delta
+ * @return true if queued
+ *
+ * Codec frames carry no CRC of their own (the LoRaWAN MIC covers them),
+ * so they bypass transmitPacket() validation and aggregation.
+ */
+bool LoRaWANManager::transmitSensorReading(const SensorReading& reading, bool forceKeyframe) {
+    uint8_t frame[SENSOR_CODEC_MAX_FRAME];
+    size_t size = sensorCodecEncode(_codecState, reading, frame, sizeof(frame), forceKeyframe);
+
+    if (size == 0) {
+        return false;
+    }
+
+    return enqueueUplink(frame, size, LORAWAN_PORT_SENSOR_COMPACT, false);
+}
+
+/**
+ * @brief Queue a downlink response frame on the command port
+ * @param payload Response records (no CRC trailer, so transmitPacket() does not apply)
+ * @param size Frame size
+ * @return true if queued
+ */
+bool LoRaWANManager::transmitResponse(const uint8_t* payload, size_t size) {
+    if (size == 0 || size > UPLINK_MAX_PAYLOAD) {
+        return false;
+    }
+
+    return enqueueUplink(payload, size, LORAWAN_PORT_COMMAND, false);
+}
+
+/**
+ * @brief Enable/disable uplink aggregation
+ * @param enabled Buffer records into shared frames on LORAWAN_PORT_AGGREGATE
+ * @param maxLatency Longest a buffered record may wait before the frame is sent (ms)
+ */
+void LoRaWANManager::setAggregationEnabled(bool enabled, unsigned long maxLatency) {
+    if (!enabled) {
+        flushAggregate();
+    }
+
+    _aggregationEnabled = enabled;
+    _aggregateLatency = maxLatency;
+
+    Serial.print(F("Aggregation "));
+    Serial.println(enabled ? F("enabled") : F("disabled"));
+}
+
+/**
+ * @brief Number of records waiting in the aggregation buffer
+ */
+uint8_t LoRaWANManager::getAggregatedRecords() const {
+    return _aggregateSize ? ((const AggregateHeader*)_aggregateBuffer)->count : 0;
+}
+
+/**
+ * @brief Largest frame allowed at the current data rate
+ */
+size_t LoRaWANManager::aggregateLimit() const {
+    size_t limit = Region::maxPayload(LMIC.datarate);
+
+    if (limit == 0 || limit > UPLINK_MAX_PAYLOAD) {
+        limit = UPLINK_MAX_PAYLOAD;
+    }
+    return limit;
+}
+
+/**
+ * @brief Append a record to the aggregation buffer, flushing first if it does not fit
+ * @param recordType Packet type of the record
+ * @param timestamp Record timestamp (seconds)
+ * @param body Record fields between timestamp and checksum
+ * @param bodySize Body size in bytes
+ * @param packet Full packet, sent on its own if no aggregate frame can hold it
+ * @param packetSize Full packet size
+ * @param port Port for the stand-alone packet
+ * @return true if the record was buffered or queued
+ */
+bool LoRaWANManager::aggregateRecord(uint8_t recordType, uint32_t timestamp, const uint8_t* body,
+                                     size_t bodySize, const uint8_t* packet, size_t packetSize,
+                                     uint8_t port) {
+    const size_t recordSize = sizeof(AggregateRecordHeader) + bodySize;
+    const size_t limit = aggregateLimit();
+
+    // Too large to share a frame at this data rate
+    if (sizeof(AggregateHeader) + recordSize + sizeof(uint16_t) > limit) {
+        flushAggregate();
+        return transmitPacket(packet, packetSize, port);
+    }
+
+    AggregateHeader* header = (AggregateHeader*)_aggregateBuffer;
+
+    if (_aggregateSize > 0) {
+        bool fits = _aggregateSize + recordSize + sizeof(uint16_t) <= limit;
+        bool inRange = timestamp >= header->baseTimestamp &&
+                       timestamp - header->baseTimestamp <= AGGREGATE_MAX_DELTA;
+
+        if ((!fits || !inRange || header->count == 0xFF) && !flushAggregate()) {
+            // Earlier records still waiting for the queue: no room for this one
+            return false;
+        }
+    }
+
+    if (_aggregateSize == 0) {
+        header->magic = PACKET_MAGIC;
+        header->type = PACKET_TYPE_AGGREGATE;
+        header->count = 0;
+        header->baseTimestamp = timestamp;
+        _aggregateSize = sizeof(AggregateHeader);
+        _aggregateStart = millis();
+    }
+
+    AggregateRecordHeader* record = (AggregateRecordHeader*)(_aggregateBuffer + _aggregateSize);
+    record->recordType = recordType;
+    record->timeOffset = (uint16_t)(timestamp - header->baseTimestamp);
+    memcpy(_aggregateBuffer + _aggregateSize + sizeof(AggregateRecordHeader), body, bodySize);
+
+    _aggregateSize += recordSize;
+    header->count++;
+
+    // Flush once the frame is full at the current data rate (the record
+    // is buffered either way; a failed flush is retried from loop())
+    if (_aggregateSize + recordSize + sizeof(uint16_t) > limit) {
+        flushAggregate();
+    }
+
+    return true;
+}
+
+/**
+ * @brief Queue the buffered aggregate frame
+ * @return true if nothing was buffered or the frame was queued
+ */
+bool LoRaWANManager::flushAggregate() {
+    if (_aggregateSize == 0) {
+        return true;
+    }
+
+    uint16_t checksum = calculateCRC16(_aggregateBuffer, _aggregateSize);
+    memcpy(_aggregateBuffer + _aggregateSize, &checksum, sizeof(checksum));
+
+    size_t frameSize = _aggregateSize + sizeof(checksum);
+
+    // Keep the records for the next flush if the queue is full
+    if (!transmitPacket(_aggregateBuffer, frameSize, LORAWAN_PORT_AGGREGATE)) {
+        return false;
+    }
+    _aggregateSize = 0;
+
+    Serial.print(F("Flushed aggregate ("));
+    Serial.print(((AggregateHeader*)_aggregateBuffer)->count);
+    Serial.print(F(" records, "));
+    Serial.print(frameSize);
+    Serial.println(F(" bytes)"));
+    return true;
+}
+
 /**
  * @brief Send downlink message
  * @param payload Payload data
@@ -485,10 +793,10 @@ bool LoRaWANManager::sendDownlink(const uint8_t* payload, size_t size, uint8_t p
 
 /**
  * @brief Set data rate
- * @param dr Data rate (DR0-DR5)
+ * @param dr Data rate (MIN_DATA_RATE to MAX_DATA_RATE of the region plan)
  */
 void LoRaWANManager::setDataRate(uint8_t dr) {
-    if (dr < MIN_DATA_RATE || dr > MAX_DATA_RATE) {
+    if (!Region::validDataRate(dr)) {
         Serial.println(F("Invalid data rate"));
         return;
     }
@@ -547,6 +855,29 @@ void LoRaWANManager::setAdrEnabled(bool enabled) {
     Serial.println(enabled ? F("enabled") : F("disabled"));
 }
 
+/**
+ * @brief Enable/disable device-side ADR (link_adr.h)
+ * @param enabled Enable device-side ADR
+ *
+ * Only acts while network ADR is off; with network ADR on, the network
+ * server owns data rate and power.
+ */
+void LoRaWANManager::setLinkAdrEnabled(bool enabled) {
+    _linkAdrEnabled = enabled;
+
+    Serial.print(F("Device ADR "));
+    Serial.println(enabled ? F("enabled") : F("disabled"));
+}
+
+/**
+ * @brief Set how long device-side ADR waits for a downlink before backing off
+ * @param ackLimit Uplinks without any downlink before the first back-off step
+ * @param ackDelay Further silent uplinks per additional step
+ */
+void LoRaWANManager::setAdrAckLimit(uint16_t ackLimit, uint16_t ackDelay) {
+    _linkAdr.setAckLimit(ackLimit, ackDelay);
+}
+
 /**
  * @brief Set maximum retries
  * @param maxRetries Maximum number of retries
@@ -557,21 +888,20 @@ void LoRaWANManager::setMaxRetries(uint8_t maxRetries) {
 
 /**
  * @brief Get duty cycle usage
- * @return Duty cycle usage in percent
+ * @return Airtime used in the last DUTY_CYCLE_WINDOW on the current sub-band, in percent
  */
 float LoRaWANManager::getDutyCycleUsage() const {
-    unsigned long currentTime = millis();
-
-    // Calculate duty cycle usage in the current window
-    float usage = (float)_dutyCycleAccumulator / DUTY_CYCLE_WINDOW * 100.0f;
-
-    // Reset if window has passed
-    if (currentTime - _lastDutyCycleTime > DUTY_CYCLE_WINDOW) {
-        const_cast<LoRaWANManager*>(this)->_dutyCycleAccumulator = 0;
-        usage = 0;
-    }
+    return (float)_dutyLedger.used(_txBand, millis()) / DUTY_CYCLE_WINDOW * 100.0f;
+}
 
-    return usage;
+/**
+ * @brief Time until a payload of the given size may be sent
+ * @param payloadSize Application payload size in bytes
+ * @return 0 if allowed now, otherwise milliseconds to wait
+ *         (DUTY_LEDGER_NEVER if the frame exceeds the sub-band budget)
+ */
+uint32_t LoRaWANManager::getTransmitDelay(size_t payloadSize) const {
+    return _dutyLedger.delayFor(_txBand, calculateAirtime(payloadSize), millis());
 }
 
 /**
@@ -583,8 +913,7 @@ void LoRaWANManager::resetStatistics() {
     _txFailCount = 0;
     _rxCount = 0;
     _joinRetryCount = 0;
-    _dutyCycleAccumulator = 0;
-    _lastDutyCycleTime = millis();
+    _linkAdr.resetStatistics();
 
     Serial.println(F("Statistics reset"));
 }
@@ -603,6 +932,14 @@ void LoRaWANManager::setDownlinkCallback(OnDownlinkCallback callback) {
 void LoRaWANManager::loop() {
     // Process LMIC events
     os_runloop_once();
+
+    // Flush a partial aggregate once its oldest record hits the latency deadline
+    if (_aggregateSize > 0 && millis() - _aggregateStart >= _aggregateLatency) {
+        flushAggregate();
+    }
+
+    // Start, time out or retry queued uplinks
+    processUplinkQueue();
 }
 
 /**
@@ -647,6 +984,10 @@ void LoRaWANManager::onEvent(ev_t ev) {
             _joining = false;
             _joinRetryCount = 0;
 
+            // New session: the backend needs a keyframe before any delta
+            sensorCodecReset(_codecState);
+            _linkAdr.reset();
+
             printState();
             break;
 
@@ -688,9 +1029,11 @@ void LoRaWANManager::onEvent(ev_t ev) {
                 Serial.print(snr);
                 Serial.println(F(" dB"));
 
-                // Call downlink callback if registered
+                // Call downlink callback if registered (the application
+                // payload starts after the MAC header at dataBeg). It runs
+                // in this event, so it must only queue the command.
                 if (_onDownlinkCallback) {
-                    _onDownlinkCallback(LMIC.frame, LMIC.dataLen, rssi);
+                    _onDownlinkCallback(LMIC.frame + LMIC.dataBeg, LMIC.dataLen, rssi);
                 }
 
                 _rxCount++;
@@ -700,6 +1043,23 @@ void LoRaWANManager::onEvent(ev_t ev) {
             if (LMIC.txrxFlags & TXRX_ACK) {
                 Serial.println(F("ACK received"));
             }
+
+            // Any downlink (payload, ACK or MAC-only) is a link sample
+            if (LMIC.txrxFlags & (TXRX_DNW1 | TXRX_DNW2)) {
+                _linkAdr.addSample(LMIC.rssi, LMIC.snr);
+            }
+
+            // Complete the queued uplink (confirmed uplinks need the ACK).
+            // The frame was on air either way, so it counts against the budget.
+            if (_txState == TX_STATE_PENDING) {
+                TRACE_END(TRACE_LORA_TX);
+                recordTransmission(Region::airtimeMs(_uplinkQueue[_queueHead].size, _txDataRate));
+                bool confirmed = _uplinkQueue[_queueHead].confirmed;
+                bool acked = (LMIC.txrxFlags & TXRX_ACK) != 0;
+                _linkAdr.reportUplink(confirmed, acked, (LMIC.txrxFlags & (TXRX_DNW1 | TXRX_DNW2)) != 0);
+                _linkAdrPending = true;
+                completeUplink(!confirmed || acked);
+            }
             break;
 
         case EV_LOST_TSYNC:
@@ -783,6 +1143,31 @@ void LoRaWANManager::printStatistics() {
     Serial.print(F("Duty Cycle: "));
     Serial.print(getDutyCycleUsage(), 2);
     Serial.println(F("%"));
+
+    const LinkAdrStats& adr = _linkAdr.getStats();
+    Serial.print(F("Link: RSSI "));
+    Serial.print(adr.lastRssi);
+    Serial.print(F(" dBm, SNR "));
+    Serial.print(adr.lastSnrX4 / 4.0f, 1);
+    Serial.print(F(" dB, margin "));
+    Serial.print(adr.marginX4 / 4.0f, 1);
+    Serial.print(F(" dB ("));
+    Serial.print(_linkAdr.getSampleCount());
+    Serial.println(F(" samples)"));
+    Serial.print(F("Device ADR: DR +"));
+    Serial.print(adr.dataRateUp);
+    Serial.print(F(" / -"));
+    Serial.print(adr.dataRateDown);
+    Serial.print(F(", power -"));
+    Serial.print(adr.powerDown);
+    Serial.print(F(" / +"));
+    Serial.print(adr.powerUp);
+    Serial.print(F(", missed ACKs "));
+    Serial.println(adr.missedAcks);
+#if TRACE_LEVEL > 0
+    Serial.println(F("Spans (us):"));
+    tracer().printSummary(Serial);
+#endif
     Serial.println(F("========================="));
 }
 
@@ -797,20 +1182,7 @@ void LoRaWANManager::printStatistics() {
  * @return CRC16 checksum
  */
 uint16_t LoRaWANManager::calculateCRC16(const uint8_t* data, size_t length) {
-    uint16_t crc = 0xFFFF;
-
-    for (size_t i = 0; i < length; i++) {
-        crc ^= data[i];
-        for (int j = 0; j < 8; j++) {
-            if (crc & 0x0001) {
-                crc = (crc >> 1) ^ 0xA001;
-            } else {
-                crc >>= 1;
-            }
-        }
-    }
-
-    return crc;
+    return crc16(data, length);
 }
 
 /**
@@ -849,64 +1221,72 @@ unsigned long LoRaWANManager::getRetryDelay() {
 
 /**
  * @brief Check if transmission is allowed
- * @return true if transmission allowed
+ * @param payloadSize Application payload size in bytes
+ * @return true if the frame fits the sub-band duty cycle budget now
  */
-bool LoRaWANManager::canTransmit() {
-    return getDutyCycleUsage() < DUTY_CYCLE_LIMIT;
+bool LoRaWANManager::canTransmit(size_t payloadSize) {
+    return getTransmitDelay(payloadSize) == 0;
 }
 
 /**
- * @brief Record transmission time
+ * @brief Record transmission time against the sub-band of the last uplink
  * @param airtimeMs Airtime in milliseconds
  */
 void LoRaWANManager::recordTransmission(uint32_t airtimeMs) {
-    _dutyCycleAccumulator += airtimeMs;
-    _lastDutyCycleTime = millis();
-
-    // Reset duty cycle window if expired
-    resetDutyCycleWindow();
+    if (LMIC.freq != 0) {
+        _txBand = Region::subBand(LMIC.freq);
+    }
+    _dutyLedger.record(_txBand, airtimeMs, millis());
 }
 
 /**
- * @brief Reset duty cycle window if expired
+ * @brief Calculate airtime for payload at the current data rate
+ * @param payloadSize Payload size in bytes
+ * @return Airtime in milliseconds (Semtech time-on-air formula, rounded up)
  */
-void LoRaWANManager::resetDutyCycleWindow() {
-    unsigned long currentTime = millis();
-
-    if (currentTime - _lastDutyCycleTime > DUTY_CYCLE_WINDOW) {
-        _dutyCycleAccumulator = 0;
-        _lastDutyCycleTime = currentTime;
-    }
+uint32_t LoRaWANManager::calculateAirtime(size_t payloadSize) const {
+    return Region::airtimeMs(payloadSize, LMIC.datarate);
 }
 
 /**
- * @brief Calculate airtime for payload
- * @param payloadSize Payload size in bytes
- * @return Airtime in milliseconds
+ * @brief Apply the device-side ADR decision before the next uplink
+ *
+ * Never drops below the lowest data rate that still carries the queued
+ * frame, so a back-off cannot strand an aggregate that no longer fits.
  */
-uint32_t LoRaWANManager::calculateAirtime(size_t payloadSize) {
-    // Simplified airtime calculation
-    // Actual calculation depends on data rate, bandwidth, coding rate, etc.
+void LoRaWANManager::applyLinkAdr() {
+    _linkAdrPending = false;
 
-    uint8_t dr = LMIC.datarate;
+    if (!_linkAdrEnabled || _adrEnabled) {
+        return;
+    }
 
-    // Approximate bit rates for different data rates (kbps)
-    float bitRates[] = {
-        0.98f,   // DR0 (SF12)
-        1.76f,   // DR1 (SF11)
-        3.13f,   // DR2 (SF10)
-        5.47f,   // DR3 (SF9)
-        9.78f,   // DR4 (SF8)
-        17.3f    // DR5 (SF7)
-    };
+    LinkAdrDecision decision = _linkAdr.decide(_dataRate, _txPower);
+    if (decision.reason == LINK_ADR_HOLD) {
+        return;
+    }
 
-    uint8_t drIndex = min(dr, (uint8_t)5);
-    float bitRate = bitRates[drIndex] * 1000.0f;  // Convert to bps
+    uint8_t size = _uplinkQueue[_queueHead].size;
+    while (decision.dataRate < Region::MAX_DR && Region::maxPayload(decision.dataRate) < size) {
+        decision.dataRate++;
+    }
 
-    // Calculate airtime (including overhead)
-    uint32_t airtimeMs = ((payloadSize + 13) * 8 * 1000) / bitRate;
+    if (decision.dataRate == _dataRate && decision.txPower == _txPower) {
+        return;
+    }
 
-    return airtimeMs;
+    _dataRate = decision.dataRate;
+    _txPower = decision.txPower;
+    LMIC_setDrTxpow(_dataRate, _txPower);
+
+    Serial.print(F("Device ADR: DR"));
+    Serial.print(_dataRate);
+    Serial.print(F(", "));
+    Serial.print(_txPower);
+    Serial.print(F(" dBm ("));
+    Serial.print(decision.reason == LINK_ADR_MARGIN ? F("margin") :
+                 decision.reason == LINK_ADR_MISSED_ACK ? F("missed ACKs") : F("no downlink"));
+    Serial.println(F(")"));
 }
 
 /**
@@ -917,27 +1297,20 @@ void LoRaWANManager::configureChannels() {
 }
 
 /**
- * @brief Set default channels for current region
+ * @brief Apply the channel mask of the region plan
+ *
+ * Fixed-channel plans (US915, AU915) disable everything outside the
+ * sub-band; dynamic plans only make sure the default channels are on and
+ * leave the rest to the network.
  */
 void LoRaWANManager::setDefaultChannels() {
-    // LMIC automatically configures channels based on region setting
-    // This function can be used to override default channels if needed
-
-#if defined(CFG_eu868)
-    // EU868: All channels enabled by default
-    LMIC_enableChannel(0);
-    LMIC_enableChannel(1);
-    LMIC_enableChannel(2);
-
-#elif defined(CFG_us915)
-    // US915: Use default channels
-    // LMIC automatically uses channels 8-15 for join
-
-#elif defined(CFG_kr920)
-    // KR920: All channels enabled by default
-    // No specific configuration needed
-
-#endif
+    for (uint8_t channel = 0; channel < Region::CHANNEL_COUNT; channel++) {
+        if (Region::channelEnabled(channel)) {
+            LMIC_enableChannel(channel);
+        } else if (Region::FIXED_CHANNELS) {
+            LMIC_disableChannel(channel);
+        }
+    }
 }
 
 // ===========================================
@@ -970,21 +1343,7 @@ SensorDataPacket createSensorPacket(
     packet.battery = battery;
 
     // Calculate checksum
-    uint16_t checksum = 0xFFFF;
-    uint8_t* data = (uint8_t*)&packet;
-
-    for (size_t i = 0; i < sizeof(SensorDataPacket) - sizeof(uint16_t); i++) {
-        checksum ^= data[i];
-        for (int j = 0; j < 8; j++) {
-            if (checksum & 0x0001) {
-                checksum = (checksum >> 1) ^ 0xA001;
-            } else {
-                checksum >>= 1;
-            }
-        }
-    }
-
-    packet.checksum = checksum;
+    packetSetChecksum(packet);
 
     return packet;
 }
@@ -1007,21 +1366,7 @@ DetectionDataPacket createDetectionPacket(
     packet.duration = duration;
 
     // Calculate checksum
-    uint16_t checksum = 0xFFFF;
-    uint8_t* data = (uint8_t*)&packet;
-
-    for (size_t i = 0; i < sizeof(DetectionDataPacket) - sizeof(uint16_t); i++) {
-        checksum ^= data[i];
-        for (int j = 0; j < 8; j++) {
-            if (checksum & 0x0001) {
-                checksum = (checksum >> 1) ^ 0xA001;
-            } else {
-                checksum >>= 1;
-            }
-        }
-    }
-
-    packet.checksum = checksum;
+    packetSetChecksum(packet);
 
     return packet;
 }
@@ -1044,21 +1389,7 @@ StatusDataPacket createStatusPacket(
     packet.battery = battery;
 
     // Calculate checksum
-    uint16_t checksum = 0xFFFF;
-    uint8_t* data = (uint8_t*)&packet;
-
-    for (size_t i = 0; i < sizeof(StatusDataPacket) - sizeof(uint16_t); i++) {
-        checksum ^= data[i];
-        for (int j = 0; j < 8; j++) {
-            if (checksum & 0x0001) {
-                checksum = (checksum >> 1) ^ 0xA001;
-            } else {
-                checksum >>= 1;
-            }
-        }
-    }
-
-    packet.checksum = checksum;
+    packetSetChecksum(packet);
 
     return packet;
 }
@@ -8,11 +8,13 @@
  * Features:
  * - OTAA and ABP authentication modes
  * - All LMIC callbacks implemented
- * - Binary packet encoding/decoding (18-byte optimized packets)
- * - Adaptive data rate (ADR) support
- * - Duty cycle enforcement (1% rule per ETSI/FCC)
- * - Retransmission with exponential backoff
- * - Channel mask configuration for all regions
+ * - Binary packet encoding/decoding (packet_types.h)
+ * - Adaptive data rate (ADR): network-driven, or device-side from link history
+ * - Duty cycle enforcement per sub-band (sliding window, exact time-on-air)
+ * - Non-blocking uplink queue with retransmission and exponential backoff
+ * - Optional aggregation of sensor/detection/status records into one uplink
+ * - Compact keyframe/delta sensor codec (4-6 byte readings)
+ * - Compile-time region plans (data rates, sub-bands, channel masks)
  * - RX1/RX2 window configuration
  * - Complete downlink handling
  * - CRC16 validation
@@ -42,6 +44,22 @@
 // #define CFG_as923                // Asia (923 MHz)
 // #define CFG_au915                // Australia (915 MHz)
 
+// Region plan (data rates, sub-bands, channel mask) and duty cycle ledger,
+// selected by the CFG_* define above
+#include "lorawan_region.h"
+
+// Device-side ADR from downlink RSSI/SNR and ACK history
+#include "link_adr.h"
+
+// Span tracer (uplink latency, status trailer)
+#include "trace.h"
+
+// Compact delta/bit-packed sensor codec (shared with the gateway and backend)
+#include "sensor_codec.h"
+
+// Packet structures shared with the serial link and the other boards
+#include "packet_types.h"
+
 // ===========================================
 // LMIC CONFIGURATION
 // ===========================================
@@ -80,22 +98,8 @@
 // DUTY CYCLE CONFIGURATION
 // ===========================================
 
-// Duty cycle limits (per regulatory requirements)
-#define DUTY_CYCLE_LIMIT_EU        1.0f        // 1% for EU868 (ETSI)
-#define DUTY_CYCLE_LIMIT_US        1.0f        // 1% best practice for US915
-#define DUTY_CYCLE_LIMIT_KR        1.0f        // 1% for KR920
-#define DUTY_CYCLE_WINDOW          3600000     // 1 hour rolling window
-
-// Get duty cycle limit for current region
-#ifdef CFG_eu868
-    #define DUTY_CYCLE_LIMIT DUTY_CYCLE_LIMIT_EU
-#elif defined(CFG_us915)
-    #define DUTY_CYCLE_LIMIT DUTY_CYCLE_LIMIT_US
-#elif defined(CFG_kr920)
-    #define DUTY_CYCLE_LIMIT DUTY_CYCLE_LIMIT_KR
-#else
-    #define DUTY_CYCLE_LIMIT 1.0f
-#endif
+// Duty cycle limits are per sub-band in the region plan (lorawan_region.h)
+#define DUTY_CYCLE_WINDOW          DUTY_LEDGER_WINDOW  // 1 hour sliding window
 
 // ===========================================
 // RETRY CONFIGURATION
@@ -106,17 +110,36 @@
 #define RETRY_DELAY_MAX            60000       // Maximum retry delay: 60 seconds
 #define RETRY_BACKOFF_MULTIPLIER   2           // Exponential backoff multiplier
 
+// ===========================================
+// UPLINK QUEUE CONFIGURATION
+// ===========================================
+
+#define UPLINK_QUEUE_SIZE          8           // Queued uplinks (ring buffer)
+#define UPLINK_MAX_PAYLOAD         LMIC_MAX_PAYLOAD_LENGTH
+#define TX_COMPLETE_TIMEOUT        30000       // Max wait for EV_TXCOMPLETE (ms)
+
+// ===========================================
+// AGGREGATION CONFIGURATION
+// ===========================================
+
+#define AGGREGATE_MAX_LATENCY      300000      // Flush a partial frame after 5 minutes
+#define AGGREGATE_MAX_DELTA        0xFFFF      // Max record offset from base (seconds)
+
 // ===========================================
 // DATA RATE AND POWER CONFIGURATION
 // ===========================================
 
 // Default data rate (DR)
-// EU868: DR0=SF12, DR1=SF11, DR2=SF10, DR3=SF9, DR4=SF8, DR5=SF7, DR6=SF7
-// US915: DR0=SF10, DR1=SF9, DR2=SF8, DR3=SF7, DR4=SF8
+// EU868: DR0=SF12, DR1=SF11, DR2=SF10, DR3=SF9, DR4=SF8, DR5=SF7, DR6=SF7/250
+// US915: DR0=SF10, DR1=SF9, DR2=SF8, DR3=SF7, DR4=SF8/500
 // KR920: DR0=SF12, DR1=SF11, DR2=SF10, DR3=SF9, DR4=SF8, DR5=SF7
 #define DEFAULT_DATA_RATE          DR3         // Balance of speed and range
-#define MIN_DATA_RATE              DR0         // Slowest, longest range
-#define MAX_DATA_RATE              DR5         // Fastest, shortest range
+#define MIN_DATA_RATE              LoRaWANRegion::MIN_DR  // Slowest, longest range
+#define MAX_DATA_RATE              LoRaWANRegion::MAX_DR  // Fastest, shortest range
+
+static_assert(LoRaWANRegion::validDataRate(DEFAULT_DATA_RATE), "Default data rate not in region plan");
+static_assert(LoRaWANRegion::maxPayload(DEFAULT_DATA_RATE) >= SENSOR_CODEC_MAX_FRAME,
+              "Codec keyframe does not fit at the default data rate");
 
 // TX power configuration
 #define DEFAULT_TX_POWER           14          // 14 dBm (EIRP)
@@ -128,9 +151,12 @@
 // ===========================================
 
 #define ADR_ACK_DELAY_EXP          4           // ADR acknowledgment delay
-#define ADR_ACK_LIMIT              64          // ADR acknowledgment limit
+#define ADR_ACK_LIMIT              64          // ADR acknowledgment limit (default)
 #define ADR_ENABLE                 true        // Enable ADR by default
 
+// Device-side ADR (link_adr.h), used while network ADR is disabled
+#define LINK_ADR_ENABLE            true
+
 // ===========================================
 // PORT CONFIGURATION
 // ===========================================
@@ -139,88 +165,8 @@
 #define LORAWAN_PORT_STATUS        2           // Status data port
 #define LORAWAN_PORT_COMMAND       3           // Command port
 #define LORAWAN_PORT_DETECTION     4           // Detection event port
-
-// ===========================================
-// PACKET STRUCTURES - BINARY ENCODING
-// ===========================================
-
-// Packet type identifiers
-#define PACKET_TYPE_SENSOR         0x01
-#define PACKET_TYPE_DETECTION      0x02
-#define PACKET_TYPE_STATUS         0x03
-#define PACKET_TYPE_COMMAND        0x04
-#define PACKET_TYPE_ACK            0x80
-#define PACKET_TYPE_NACK           0xFF
-
-// Magic number for packet validation
-#define PACKET_MAGIC               0xA5A5
-
-// Sensor data packet (18 bytes optimized)
-#pragma pack(push, 1)
-typedef struct {
-    uint16_t magic;                // 0xA5A5 (2 bytes) - Packet validation
-    uint8_t type;                  // Packet type (1 byte)
-    uint32_t timestamp;            // Unix timestamp (4 bytes)
-    int16_t temperature;           // Temperature x100 (2 bytes, e.g., 2345 = 23.45°C)
-    uint16_t humidity;             // Humidity x100 (2 bytes, e.g., 6500 = 65.00%)
-    uint16_t pressure;             // Pressure x10 (2 bytes, e.g., 10132 = 1013.2 hPa)
-    uint16_t gasResistance;        // Gas resistance in Ohms (2 bytes)
-    uint16_t iaq;                  // Indoor Air Quality (2 bytes)
-    uint8_t status;                // Status flags (1 byte)
-    uint8_t battery;               // Battery level 0-100 (1 byte)
-    uint16_t checksum;             // CRC16 checksum (2 bytes)
-} SensorDataPacket;
-#pragma pack(pop)
-
-static_assert(sizeof(SensorDataPacket) == 18, "SensorDataPacket must be 18 bytes");
-
-// Detection event packet (12 bytes optimized)
-#pragma pack(push, 1)
-typedef struct {
-    uint16_t magic;                // 0xA5A5 (2 bytes)
-    uint8_t type;                  // PACKET_TYPE_DETECTION (1 byte)
-    uint32_t timestamp;            // Unix timestamp (4 bytes)
-    uint8_t detectionType;         // Detection type (1 byte)
-    uint8_t confidence;            // Confidence level 0-100 (1 byte)
-    uint16_t duration;             // Duration in seconds (2 bytes)
-    uint16_t checksum;             // CRC16 (2 bytes)
-} DetectionDataPacket;
-#pragma pack(pop)
-
-static_assert(sizeof(DetectionDataPacket) == 12, "DetectionDataPacket must be 12 bytes");
-
-// Status packet (15 bytes optimized)
-#pragma pack(push, 1)
-typedef struct {
-    uint16_t magic;                // 0xA5A5 (2 bytes)
-    uint8_t type;                  // PACKET_TYPE_STATUS (1 byte)
-    uint32_t uptime;               // Uptime in seconds (4 bytes)
-    uint32_t txCount;              // Total transmissions (4 bytes)
-    uint32_t rxCount;              // Total downlinks received (4 bytes)
-    uint8_t dataRate;              // Current data rate (1 byte)
-    uint8_t battery;               // Battery level (1 byte)
-    uint16_t checksum;             // CRC16 (2 bytes)
-} StatusDataPacket;
-#pragma pack(pop)
-
-static_assert(sizeof(StatusDataPacket) == 15, "StatusDataPacket must be 15 bytes");
-
-// Status flags bit definitions
-#define STATUS_SENSOR_OK           0x01        // All sensors operational
-#define STATUS_MOTION_DETECT       0x02        // Motion detected
-#define STATUS_OBJECT_DETECT       0x04        // Object detected
-#define STATUS_ALARM_ACTIVE        0x08        // Alarm active
-#define STATUS_LOW_BATTERY         0x10        // Battery < 20%
-#define STATUS_SENSOR_ERROR        0x20        // Sensor error
-#define STATUS_NETWORK_ERROR       0x40        // Network error
-#define STATUS_MEMORY_ERROR        0x80        // Memory error
-
-// Detection type definitions
-#define DETECTION_TYPE_MOTION      0x01
-#define DETECTION_TYPE_OBJECT      0x02
-#define DETECTION_TYPE_PERSON      0x03
-#define DETECTION_TYPE_VEHICLE     0x04
-#define DETECTION_TYPE_ANIMAL      0x05
+#define LORAWAN_PORT_AGGREGATE     5           // Aggregated records port
+#define LORAWAN_PORT_SENSOR_COMPACT SENSOR_CODEC_PORT // Codec sensor frames (6)
 
 // ===========================================
 // DOWNLINK COMMAND DEFINITIONS
@@ -254,6 +200,7 @@ static_assert(sizeof(StatusDataPacket) == 15, "StatusDataPacket must be 15 bytes
 #define ERR_BUFFER_OVERFLOW        0x04
 #define ERR_CHECKSUM_FAIL          0x05
 #define ERR_NOT_JOINED             0x06
+#define ERR_NETWORK_ERROR          0x07
 
 // Downlink message structure
 #pragma pack(push, 1)
@@ -270,6 +217,22 @@ typedef struct {
 } UplinkMessage;
 #pragma pack(pop)
 
+// Queued uplink (copied, so callers may reuse their buffers immediately)
+typedef struct {
+    uint8_t payload[UPLINK_MAX_PAYLOAD];
+    uint8_t size;
+    uint8_t port;
+    uint8_t retries;               // Failed attempts so far
+    bool confirmed;                // Request a network ACK
+} UplinkQueueEntry;
+
+// Transmit state machine (driven from LoRaWANManager::loop())
+enum TxState {
+    TX_STATE_IDLE,                 // Ready to start the next queued uplink
+    TX_STATE_PENDING,              // Handed to LMIC, waiting for EV_TXCOMPLETE
+    TX_STATE_BACKOFF               // Waiting out the retry delay
+};
+
 // ===========================================
 // LMIC CALLBACK FUNCTION POINTERS
 // ===========================================
@@ -285,6 +248,10 @@ typedef void (*OnErrorCallback)(uint8_t errorCode);
 // ===========================================
 
 class LoRaWANManager {
+public:
+    // Region plan of this build (LMIC is compiled for the same CFG_* region)
+    typedef LoRaWANRegion Region;
+
 private:
     // Connection state
     bool _connected;
@@ -293,10 +260,13 @@ private:
 
     // Timing
     unsigned long _lastTransmission;
-    unsigned long _lastDutyCycleTime;
     unsigned long _lastJoinAttempt;
     unsigned long _transmitInterval;
-    uint32_t _dutyCycleAccumulator;
+
+    // Duty cycle (airtime per sub-band over the last DUTY_CYCLE_WINDOW)
+    DutyCycleLedger _dutyLedger;
+    uint8_t _txBand;
+    uint8_t _txDataRate;
 
     // Statistics
     uint32_t _txCount;
@@ -309,6 +279,30 @@ private:
     uint8_t _retryCount;
     uint8_t _maxRetries;
 
+    // Uplink queue (ring buffer, head = in flight or next to send)
+    UplinkQueueEntry _uplinkQueue[UPLINK_QUEUE_SIZE];
+    uint8_t _queueHead;
+    uint8_t _queueTail;
+    uint32_t _queueDropCount;
+    TxState _txState;
+    unsigned long _txStartTime;
+    unsigned long _retryAt;
+
+    // Aggregation buffer (header + records, CRC appended on flush)
+    uint8_t _aggregateBuffer[UPLINK_MAX_PAYLOAD];
+    uint8_t _aggregateSize;
+    bool _aggregationEnabled;
+    unsigned long _aggregateStart;
+    unsigned long _aggregateLatency;
+
+    // Compact sensor codec (delta reference for transmitSensorReading)
+    SensorCodecState _codecState;
+
+    // Device-side ADR (decisions applied from loop(), not in the LMIC event)
+    LinkAdr _linkAdr;
+    bool _linkAdrEnabled;
+    bool _linkAdrPending;
+
     // Configuration
     uint8_t _dataRate;
     int8_t _txPower;
@@ -333,15 +327,28 @@ private:
     uint16_t calculateCRC16(const uint8_t* data, size_t length);
     bool validatePacket(const uint8_t* data, size_t length);
     unsigned long getRetryDelay();
-    bool canTransmit();
+    bool canTransmit(size_t payloadSize);
     void recordTransmission(uint32_t airtimeMs);
-    void resetDutyCycleWindow();
-    uint32_t calculateAirtime(size_t payloadSize);
+    uint32_t calculateAirtime(size_t payloadSize) const;
+
+    // Uplink queue processing
+    bool enqueueUplink(const uint8_t* payload, size_t size, uint8_t port, bool confirmed);
+    void processUplinkQueue();
+    bool startUplink(UplinkQueueEntry& entry);
+    void completeUplink(bool success);
+
+    // Aggregation
+    bool aggregateRecord(uint8_t recordType, uint32_t timestamp, const uint8_t* body,
+                         size_t bodySize, const uint8_t* packet, size_t packetSize, uint8_t port);
+    size_t aggregateLimit() const;
 
     // Channel configuration
     void configureChannels();
     void setDefaultChannels();
 
+    // Device-side ADR
+    void applyLinkAdr();
+
 public:
     // Constructor
     LoRaWANManager();
@@ -357,11 +364,28 @@ public:
     bool isJoining() const { return _joining; }
     bool rejoin();
 
-    // Data transmission
-    bool transmitPacket(const uint8_t* payload, size_t size, uint8_t port = LORAWAN_PORT_SENSOR);
+    // Data transmission (non-blocking: queues the uplink and returns;
+    // the result is reported through OnTxCompleteCallback)
+    bool transmitPacket(const uint8_t* payload, size_t size, uint8_t port = LORAWAN_PORT_SENSOR,
+                        bool confirmed = false);
     bool transmitSensorData(const SensorDataPacket& packet);
     bool transmitDetection(const DetectionDataPacket& packet);
     bool transmitStatus(const StatusDataPacket& packet);
+    bool transmitStatusWithTrace(const StatusDataPacket& packet);
+    bool transmitSensorReading(const SensorReading& reading, bool forceKeyframe = false);
+    bool transmitResponse(const uint8_t* payload, size_t size);
+
+    // Uplink queue
+    uint8_t getQueuedUplinks() const;
+    uint32_t getQueueDropCount() const { return _queueDropCount; }
+    bool isTransmitting() const { return _txState == TX_STATE_PENDING; }
+    void clearUplinkQueue();
+
+    // Aggregation (sensor/detection/status records share one frame on port 5)
+    void setAggregationEnabled(bool enabled, unsigned long maxLatency = AGGREGATE_MAX_LATENCY);
+    bool isAggregationEnabled() const { return _aggregationEnabled; }
+    bool flushAggregate();
+    uint8_t getAggregatedRecords() const;
 
     // Downlink handling
     void setDownlinkCallback(OnDownlinkCallback callback);
@@ -372,6 +396,8 @@ public:
     void setTxPower(int8_t power);
     void setTransmitInterval(unsigned long interval);
     void setAdrEnabled(bool enabled);
+    void setLinkAdrEnabled(bool enabled);
+    void setAdrAckLimit(uint16_t ackLimit, uint16_t ackDelay = 1 << ADR_ACK_DELAY_EXP);
     void setMaxRetries(uint8_t maxRetries);
 
     // Getters
@@ -379,7 +405,10 @@ public:
     int8_t getTxPower() const { return _txPower; }
     unsigned long getTransmitInterval() const { return _transmitInterval; }
     bool isAdrEnabled() const { return _adrEnabled; }
+    bool isLinkAdrEnabled() const { return _linkAdrEnabled; }
+    const LinkAdrStats& getLinkAdrStats() const { return _linkAdr.getStats(); }
     float getDutyCycleUsage() const;
+    uint32_t getTransmitDelay(size_t payloadSize) const;
     unsigned long getLastTransmission() const { return _lastTransmission; }
 
     // Statistics
@@ -395,7 +424,7 @@ public:
     void setOnErrorCallback(OnErrorCallback callback) { _onErrorCallback = callback; }
 
     // LMIC integration
-    void loop();                   // Must be called in main loop
+    void loop();                   // Must be called in main loop (drives the uplink queue)
     void onEvent(ev_t ev);         // LMIC event handler
 
     // Utility functions
@@ -0,0 +1,311 @@
+/**
+ * LoRaWAN Region Plans
+ *
+ * Regional parameters as compile-time traits: RegionPlan<EU868>,
+ * RegionPlan<US915>, RegionPlan<KR920>, RegionPlan<AS923> and
+ * RegionPlan<AU915> provide
+ *
+ * - Uplink data rates with max payload and time-on-air coefficients
+ * - Duty cycle sub-bands and their budget per DUTY_LEDGER_WINDOW
+ * - The channel mask applied at startup
+ *
+ * Every plan is always compiled, so host tools can check all regions from
+ * one source tree. The device itself uses LoRaWANRegion, which follows the
+ * CFG_* define that also configures LMIC. Everything is constexpr: with a
+ * constant payload size and data rate, the budget checks below reduce to
+ * constants.
+ *
+ * Author: Production-Ready Implementation
+ * Version: 2.0.0
+ * License: MIT
+ */
+
+#ifndef LORAWAN_REGION_H
+#define LORAWAN_REGION_H
+
+#include "lorawan_airtime.h"
+
+// ===========================================
+// REGION TAGS
+// ===========================================
+
+struct EU868 {};
+struct US915 {};
+struct KR920 {};
+struct AS923 {};
+struct AU915 {};
+
+// ===========================================
+// REGION TABLES
+// ===========================================
+
+/**
+ * Per-region tables. The unused second parameter keeps the specialisations
+ * templates, so their static arrays can be defined in this header.
+ *
+ * CHANNEL_MASK holds one bit per channel, channel 0 in bit 0 of byte 0.
+ * With FIXED_CHANNELS the channels outside the mask are disabled; in
+ * dynamic plans they are left to the network (CFList / NewChannelReq).
+ */
+template <typename Region, typename Unused = void>
+struct RegionTables;
+
+// EU868: DR0-DR6 LoRa, DR7 is FSK (not modelled)
+template <typename Unused>
+struct RegionTables<EU868, Unused> {
+    static constexpr LoRaDataRate DATA_RATES[] = {
+        loraDataRate(12, 125, 51),
+        loraDataRate(11, 125, 51),
+        loraDataRate(10, 125, 51),
+        loraDataRate(9, 125, 115),
+        loraDataRate(8, 125, 242),
+        loraDataRate(7, 125, 242),
+        loraDataRate(7, 250, 242),
+    };
+    // ETSI EN 300 220 sub-bands (h1.3 - h1.7)
+    static constexpr LoRaSubBand SUB_BANDS[] = {
+        {863000000UL, 868000000UL, 10},    // g   1%
+        {868000000UL, 868600000UL, 10},    // g1  1%   (default join channels)
+        {868700000UL, 869200000UL, 1},     // g2  0.1%
+        {869400000UL, 869650000UL, 100},   // g3  10%
+        {869700000UL, 870000000UL, 10},    // g4  1%
+    };
+    static constexpr uint8_t CHANNEL_MASK[] = {0x07, 0x00};   // 868.1 / 868.3 / 868.5
+    static constexpr uint8_t CHANNEL_COUNT = 16;
+    static constexpr bool FIXED_CHANNELS = false;
+    static constexpr uint32_t DEFAULT_UPLINK_HZ = 868100000UL;
+};
+
+// US915: DR0-DR4 uplink (DR8+ are downlink only); no duty cycle by FCC,
+// 1% kept as good practice
+template <typename Unused>
+struct RegionTables<US915, Unused> {
+    static constexpr LoRaDataRate DATA_RATES[] = {
+        loraDataRate(10, 125, 11),
+        loraDataRate(9, 125, 53),
+        loraDataRate(8, 125, 125),
+        loraDataRate(7, 125, 242),
+        loraDataRate(8, 500, 242),
+    };
+    static constexpr LoRaSubBand SUB_BANDS[] = {
+        {902000000UL, 928000000UL, 10},
+    };
+    // Sub-band 2 (channels 8-15 and 65), as used by TTN and most networks
+    static constexpr uint8_t CHANNEL_MASK[] = {0x00, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
+    static constexpr uint8_t CHANNEL_COUNT = 72;
+    static constexpr bool FIXED_CHANNELS = true;
+    static constexpr uint32_t DEFAULT_UPLINK_HZ = 903900000UL;
+};
+
+// KR920: DR0-DR5 uplink
+template <typename Unused>
+struct RegionTables<KR920, Unused> {
+    static constexpr LoRaDataRate DATA_RATES[] = {
+        loraDataRate(12, 125, 51),
+        loraDataRate(11, 125, 51),
+        loraDataRate(10, 125, 51),
+        loraDataRate(9, 125, 115),
+        loraDataRate(8, 125, 242),
+        loraDataRate(7, 125, 242),
+    };
+    static constexpr LoRaSubBand SUB_BANDS[] = {
+        {920900000UL, 923300000UL, 10},
+    };
+    static constexpr uint8_t CHANNEL_MASK[] = {0x07, 0x00};   // 922.1 / 922.3 / 922.5
+    static constexpr uint8_t CHANNEL_COUNT = 16;
+    static constexpr bool FIXED_CHANNELS = false;
+    static constexpr uint32_t DEFAULT_UPLINK_HZ = 922100000UL;
+};
+
+// AS923: DR0-DR6 uplink, uplink dwell time off
+template <typename Unused>
+struct RegionTables<AS923, Unused> {
+    static constexpr LoRaDataRate DATA_RATES[] = {
+        loraDataRate(12, 125, 59),
+        loraDataRate(11, 125, 59),
+        loraDataRate(10, 125, 59),
+        loraDataRate(9, 125, 123),
+        loraDataRate(8, 125, 250),
+        loraDataRate(7, 125, 250),
+        loraDataRate(7, 250, 250),
+    };
+    static constexpr LoRaSubBand SUB_BANDS[] = {
+        {915000000UL, 928000000UL, 10},
+    };
+    static constexpr uint8_t CHANNEL_MASK[] = {0x03, 0x00};   // 923.2 / 923.4
+    static constexpr uint8_t CHANNEL_COUNT = 16;
+    static constexpr bool FIXED_CHANNELS = false;
+    static constexpr uint32_t DEFAULT_UPLINK_HZ = 923200000UL;
+};
+
+// AU915: DR0-DR6 uplink
+template <typename Unused>
+struct RegionTables<AU915, Unused> {
+    static constexpr LoRaDataRate DATA_RATES[] = {
+        loraDataRate(12, 125, 51),
+        loraDataRate(11, 125, 51),
+        loraDataRate(10, 125, 51),
+        loraDataRate(9, 125, 115),
+        loraDataRate(8, 125, 242),
+        loraDataRate(7, 125, 242),
+        loraDataRate(8, 500, 242),
+    };
+    static constexpr LoRaSubBand SUB_BANDS[] = {
+        {915000000UL, 928000000UL, 10},
+    };
+    // Sub-band 2 (channels 8-15 and 65)
+    static constexpr uint8_t CHANNEL_MASK[] = {0x00, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02};
+    static constexpr uint8_t CHANNEL_COUNT = 72;
+    static constexpr bool FIXED_CHANNELS = true;
+    static constexpr uint32_t DEFAULT_UPLINK_HZ = 916800000UL;
+};
+
+// Out-of-class definitions (needed when a table is indexed at runtime)
+template <typename U> constexpr LoRaDataRate RegionTables<EU868, U>::DATA_RATES[];
+template <typename U> constexpr LoRaSubBand RegionTables<EU868, U>::SUB_BANDS[];
+template <typename U> constexpr uint8_t RegionTables<EU868, U>::CHANNEL_MASK[];
+template <typename U> constexpr LoRaDataRate RegionTables<US915, U>::DATA_RATES[];
+template <typename U> constexpr LoRaSubBand RegionTables<US915, U>::SUB_BANDS[];
+template <typename U> constexpr uint8_t RegionTables<US915, U>::CHANNEL_MASK[];
+template <typename U> constexpr LoRaDataRate RegionTables<KR920, U>::DATA_RATES[];
+template <typename U> constexpr LoRaSubBand RegionTables<KR920, U>::SUB_BANDS[];
+template <typename U> constexpr uint8_t RegionTables<KR920, U>::CHANNEL_MASK[];
+template <typename U> constexpr LoRaDataRate RegionTables<AS923, U>::DATA_RATES[];
+template <typename U> constexpr LoRaSubBand RegionTables<AS923, U>::SUB_BANDS[];
+template <typename U> constexpr uint8_t RegionTables<AS923, U>::CHANNEL_MASK[];
+template <typename U> constexpr LoRaDataRate RegionTables<AU915, U>::DATA_RATES[];
+template <typename U> constexpr LoRaSubBand RegionTables<AU915, U>::SUB_BANDS[];
+template <typename U> constexpr uint8_t RegionTables<AU915, U>::CHANNEL_MASK[];
+
+// ===========================================
+// REGION PLAN
+// ===========================================
+
+/**
+ * Lookups over one region's tables (all constexpr, C++11 compatible)
+ */
+template <typename Region>
+struct RegionPlan : RegionTables<Region> {
+    typedef RegionTables<Region> Tables;
+
+    static constexpr uint8_t DATA_RATE_COUNT = sizeof(Tables::DATA_RATES) / sizeof(LoRaDataRate);
+    static constexpr uint8_t SUB_BAND_COUNT = sizeof(Tables::SUB_BANDS) / sizeof(LoRaSubBand);
+    static constexpr uint8_t MIN_DR = 0;
+    static constexpr uint8_t MAX_DR = DATA_RATE_COUNT - 1;
+
+    /**
+     * @brief True for a LoRa uplink data rate of this region
+     */
+    static constexpr bool validDataRate(uint8_t dr) {
+        return dr < DATA_RATE_COUNT && Tables::DATA_RATES[dr].sf != 0;
+    }
+
+    /**
+     * @brief Largest application payload allowed at a data rate
+     */
+    static constexpr uint8_t maxPayload(uint8_t dr) {
+        return dr < DATA_RATE_COUNT ? Tables::DATA_RATES[dr].maxPayload : 0;
+    }
+
+    /**
+     * @brief Largest application payload at any data rate
+     */
+    static constexpr uint8_t largestPayload(uint8_t dr = 0) {
+        return dr >= DATA_RATE_COUNT ? 0 :
+               (maxPayload(dr) > largestPayload(dr + 1) ? maxPayload(dr) : largestPayload(dr + 1));
+    }
+
+    /**
+     * @brief Time on air of an uplink
+     * @param payloadSize Application payload size in bytes
+     * @param dr Data rate index
+     * @return Airtime in microseconds, 0 for unknown / non-LoRa rates
+     */
+    static constexpr uint32_t airtimeUs(size_t payloadSize, uint8_t dr) {
+        return !validDataRate(dr) ? 0 :
+               Tables::DATA_RATES[dr].preambleUs +
+               loraPayloadSymbols((uint16_t)(payloadSize + LORAWAN_FRAME_OVERHEAD),
+                                  Tables::DATA_RATES[dr].sf, Tables::DATA_RATES[dr].bitsPerBlock) *
+               Tables::DATA_RATES[dr].symbolUs;
+    }
+
+    /**
+     * @brief Time on air rounded up to whole milliseconds (ledger unit)
+     */
+    static constexpr uint32_t airtimeMs(size_t payloadSize, uint8_t dr) {
+        return (airtimeUs(payloadSize, dr) + 999) / 1000;
+    }
+
+    /**
+     * @brief Sub-band index for a channel frequency
+     * @return Index into SUB_BANDS (falls back to 0 if out of every range)
+     */
+    static constexpr uint8_t subBand(uint32_t freqHz, uint8_t band = 0) {
+        return band >= SUB_BAND_COUNT ? 0 :
+               (freqHz >= Tables::SUB_BANDS[band].minHz && freqHz < Tables::SUB_BANDS[band].maxHz)
+                   ? band : subBand(freqHz, band + 1);
+    }
+
+    /**
+     * @brief Airtime allowed per DUTY_LEDGER_WINDOW on a sub-band
+     */
+    static constexpr uint32_t budgetMs(uint8_t band) {
+        return band < SUB_BAND_COUNT ? DUTY_LEDGER_WINDOW / 1000 * Tables::SUB_BANDS[band].dutyPermille : 0;
+    }
+
+    /**
+     * @brief Frames of one size that fit a whole window on a sub-band
+     * @return 0 if the payload is too large for the data rate
+     */
+    static constexpr uint32_t framesPerWindow(size_t payloadSize, uint8_t dr, uint8_t band) {
+        return (payloadSize > maxPayload(dr) || airtimeMs(payloadSize, dr) == 0) ? 0 :
+               budgetMs(band) / airtimeMs(payloadSize, dr);
+    }
+
+    /**
+     * @brief True if a channel is enabled at startup
+     */
+    static constexpr bool channelEnabled(uint8_t channel) {
+        return channel < Tables::CHANNEL_COUNT &&
+               ((Tables::CHANNEL_MASK[channel / 8] >> (channel % 8)) & 1) != 0;
+    }
+};
+
+template <typename R> constexpr uint8_t RegionPlan<R>::DATA_RATE_COUNT;
+template <typename R> constexpr uint8_t RegionPlan<R>::SUB_BAND_COUNT;
+template <typename R> constexpr uint8_t RegionPlan<R>::MIN_DR;
+template <typename R> constexpr uint8_t RegionPlan<R>::MAX_DR;
+
+// Reference values: LoRaWAN Regional Parameters RP002-1.0.3, airtime from
+// the Semtech LoRa calculator
+static_assert(RegionPlan<EU868>::MAX_DR == 6 && RegionPlan<US915>::MAX_DR == 4, "EU868 DR6 / US915 DR4");
+static_assert(RegionPlan<US915>::maxPayload(0) == 11, "US915 DR0 payload");
+static_assert(RegionPlan<AS923>::largestPayload() == 250, "AS923 DR4+ payload");
+static_assert(RegionPlan<EU868>::airtimeUs(51, 0) == 2793472, "EU868 DR0 51-byte frame");
+static_assert(RegionPlan<EU868>::subBand(868100000UL) == 1, "EU868 join channels in g1");
+static_assert(RegionPlan<EU868>::subBand(869525000UL) == 3, "EU868 RX2 channel in g3");
+static_assert(RegionPlan<EU868>::budgetMs(2) == 3600, "EU868 g2 0.1%");
+static_assert(RegionPlan<EU868>::framesPerWindow(51, 0, 1) == 12, "EU868 SF12 51-byte frames per hour");
+static_assert(RegionPlan<US915>::channelEnabled(8) && RegionPlan<US915>::channelEnabled(65) &&
+              !RegionPlan<US915>::channelEnabled(7) && !RegionPlan<US915>::channelEnabled(64),
+              "US915 sub-band 2");
+
+// ===========================================
+// DEVICE REGION (follows LMIC's CFG_* define)
+// ===========================================
+
+#if defined(CFG_us915)
+typedef RegionPlan<US915> LoRaWANRegion;
+#elif defined(CFG_au915)
+typedef RegionPlan<AU915> LoRaWANRegion;
+#elif defined(CFG_kr920)
+typedef RegionPlan<KR920> LoRaWANRegion;
+#elif defined(CFG_as923)
+typedef RegionPlan<AS923> LoRaWANRegion;
+#else
+typedef RegionPlan<EU868> LoRaWANRegion;
+#endif
+
+typedef BasicDutyCycleLedger<LoRaWANRegion> DutyCycleLedger;
+
+#endif // LORAWAN_REGION_H
@@ -0,0 +1,171 @@
+/**
+ * Packet Types
+ *
+ * Binary packet structures shared by every board: uplinked by
+ * LoRaWANManager and carried unchanged over the serial link between the
+ * Nicla boards and the gateway (serial_frame.h). All packets are packed,
+ * little-endian and end with a CRC16 (crc16.h) over the preceding bytes.
+ *
+ * The structs live in namespace iot_packets and are imported into the
+ * global namespace, except when PACKET_TYPES_NO_GLOBAL is defined before
+ * including this header (Arduino_BHY2 declares its own SensorDataPacket).
+ *
+ * Author: Production-Ready Implementation
+ * Version: 2.0.0
+ * License: MIT
+ */
+
+#ifndef PACKET_TYPES_H
+#define PACKET_TYPES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "crc16.h"
+
+// ===========================================
+// PACKET STRUCTURES - BINARY ENCODING
+// ===========================================
+
+// Packet type identifiers
+#define PACKET_TYPE_SENSOR         0x01
+#define PACKET_TYPE_DETECTION      0x02
+#define PACKET_TYPE_STATUS         0x03
+#define PACKET_TYPE_COMMAND        0x04
+#define PACKET_TYPE_AGGREGATE      0x05
+#define PACKET_TYPE_ACK            0x80
+#define PACKET_TYPE_NACK           0xFF
+
+// Magic number for packet validation
+#define PACKET_MAGIC               0xA5A5
+
+namespace iot_packets {
+
+// Sensor data packet (21 bytes)
+#pragma pack(push, 1)
+typedef struct {
+    uint16_t magic;                // 0xA5A5 (2 bytes) - Packet validation
+    uint8_t type;                  // Packet type (1 byte)
+    uint32_t timestamp;            // Timestamp in seconds (4 bytes)
+    int16_t temperature;           // Temperature x100 (2 bytes, e.g., 2345 = 23.45°C)
+    uint16_t humidity;             // Humidity x100 (2 bytes, e.g., 6500 = 65.00%)
+    uint16_t pressure;             // Pressure x10 (2 bytes, e.g., 10132 = 1013.2 hPa)
+    uint16_t gasResistance;        // Gas resistance in Ohms (2 bytes)
+    uint16_t iaq;                  // Indoor Air Quality (2 bytes)
+    uint8_t status;                // Status flags (1 byte)
+    uint8_t battery;               // Battery level 0-100 (1 byte)
+    uint16_t checksum;             // CRC16 checksum (2 bytes)
+} SensorDataPacket;
+#pragma pack(pop)
+
+static_assert(sizeof(SensorDataPacket) == 21, "SensorDataPacket must be 21 bytes");
+
+// Detection event packet (13 bytes)
+#pragma pack(push, 1)
+typedef struct {
+    uint16_t magic;                // 0xA5A5 (2 bytes)
+    uint8_t type;                  // PACKET_TYPE_DETECTION (1 byte)
+    uint32_t timestamp;            // Timestamp in seconds (4 bytes)
+    uint8_t detectionType;         // Detection type (1 byte)
+    uint8_t confidence;            // Confidence level 0-100 (1 byte)
+    uint16_t duration;             // Duration in seconds (2 bytes)
+    uint16_t checksum;             // CRC16 (2 bytes)
+} DetectionDataPacket;
+#pragma pack(pop)
+
+static_assert(sizeof(DetectionDataPacket) == 13, "DetectionDataPacket must be 13 bytes");
+
+// Status packet (19 bytes)
+#pragma pack(push, 1)
+typedef struct {
+    uint16_t magic;                // 0xA5A5 (2 bytes)
+    uint8_t type;                  // PACKET_TYPE_STATUS (1 byte)
+    uint32_t uptime;               // Uptime in seconds (4 bytes)
+    uint32_t txCount;              // Total transmissions (4 bytes)
+    uint32_t rxCount;              // Total downlinks received (4 bytes)
+    uint8_t dataRate;              // Current data rate (1 byte)
+    uint8_t battery;               // Battery level (1 byte)
+    uint16_t checksum;             // CRC16 (2 bytes)
+} StatusDataPacket;
+#pragma pack(pop)
+
+static_assert(sizeof(StatusDataPacket) == 19, "StatusDataPacket must be 19 bytes");
+
+// Status frame with span trace (port 4, transmitStatusWithTrace()):
+//   StatusDataPacket (19 bytes, checksum over the packet only)
+//   then one TraceSummaryRecord per active span (trace.h, 6 bytes each):
+//   span(1) count(2) p50(1) p95(1) p99(1), percentiles as histogram
+//   bucket indices (lower bound 2^(b/2), +50% for odd b, in us)
+// Decoders that read 19 bytes ignore the trailer; the MIC covers it.
+
+// Aggregated frame (port 5), little-endian:
+//   header  magic(2) type(1) count(1) baseTimestamp(4)
+//   record  recordType(1) timeOffset(2, seconds after base) body
+//   trailer CRC16(2) over header and records
+// Record bodies are the packet fields between timestamp and checksum:
+//   sensor     temperature..battery (12 bytes)
+//   detection  detectionType, confidence, duration (4 bytes)
+//   status     txCount, rxCount, dataRate, battery (10 bytes, uptime = base + offset)
+#pragma pack(push, 1)
+typedef struct {
+    uint16_t magic;                // 0xA5A5 (2 bytes)
+    uint8_t type;                  // PACKET_TYPE_AGGREGATE (1 byte)
+    uint8_t count;                 // Number of records (1 byte)
+    uint32_t baseTimestamp;        // Timestamp of the first record (4 bytes)
+} AggregateHeader;
+
+typedef struct {
+    uint8_t recordType;            // PACKET_TYPE_SENSOR/DETECTION/STATUS (1 byte)
+    uint16_t timeOffset;           // Seconds after baseTimestamp (2 bytes)
+} AggregateRecordHeader;
+#pragma pack(pop)
+
+static_assert(sizeof(AggregateHeader) == 8, "AggregateHeader must be 8 bytes");
+static_assert(sizeof(AggregateRecordHeader) == 3, "AggregateRecordHeader must be 3 bytes");
+
+/**
+ * @brief Fill in a packet's trailing checksum
+ */
+template <typename Packet>
+static inline void packetSetChecksum(Packet& packet) {
+    packet.checksum = crc16(&packet, sizeof(Packet) - sizeof(uint16_t));
+}
+
+/**
+ * @brief Check a packet's magic and trailing checksum
+ */
+template <typename Packet>
+static inline bool packetIsValid(const Packet& packet) {
+    return packet.magic == PACKET_MAGIC &&
+           packet.checksum == crc16(&packet, sizeof(Packet) - sizeof(uint16_t));
+}
+
+} // namespace iot_packets
+
+#ifndef PACKET_TYPES_NO_GLOBAL
+using iot_packets::SensorDataPacket;
+using iot_packets::DetectionDataPacket;
+using iot_packets::StatusDataPacket;
+using iot_packets::AggregateHeader;
+using iot_packets::AggregateRecordHeader;
+using iot_packets::packetSetChecksum;
+using iot_packets::packetIsValid;
+#endif
+
+// Status flags bit definitions
+#define STATUS_SENSOR_OK           0x01        // All sensors operational
+#define STATUS_MOTION_DETECT       0x02        // Motion detected
+#define STATUS_OBJECT_DETECT       0x04        // Object detected
+#define STATUS_ALARM_ACTIVE        0x08        // Alarm active
+#define STATUS_LOW_BATTERY         0x10        // Battery < 20%
+#define STATUS_SENSOR_ERROR        0x20        // Sensor error
+#define STATUS_NETWORK_ERROR       0x40        // Network error
+#define STATUS_MEMORY_ERROR        0x80        // Memory error
+
+// Detection type definitions
+#define DETECTION_TYPE_MOTION      0x01
+#define DETECTION_TYPE_OBJECT      0x02
+#define DETECTION_TYPE_PERSON      0x03
+#define DETECTION_TYPE_VEHICLE     0x04
+#define DETECTION_TYPE_ANIMAL      0x05
+
+#endif // PACKET_TYPES_H
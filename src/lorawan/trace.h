@@ -0,0 +1,450 @@
+/**
+ * Frame-Level Tracing
+ *
+ * Low-overhead span timing shared by every board (Nicla Vision, Nicla
+ * Sense Me, MKR WAN gateway and LoRaWAN node). Code marks the begin and
+ * end of a span (capture, preprocess, invoke, ...); nothing is printed
+ * while measuring, results are dumped on request.
+ *
+ * Tiers (TRACE_LEVEL):
+ *   0  compiled out, the TRACE_* macros expand to nothing
+ *   1  per-span statistics: count, min, max, mean and a log-bucketed
+ *      latency histogram for p50 / p95 / p99
+ *   2  level 1 plus a ring of the last TRACE_RING_SIZE begin/end events
+ *
+ * Clock: the DWT cycle counter where the core has one (Cortex-M4/M7:
+ * nRF52840, STM32H747), micros() otherwise (Cortex-M0+: SAMD21). The
+ * cycle counter wraps within seconds and stops in sleep, so it is
+ * re-anchored on millis() at least every TRACE_RESYNC_MS and whenever the
+ * two clocks disagree. Spans timed by another clock (e.g. standby timed by
+ * the RTC) are entered with record().
+ *
+ * Histogram: two buckets per power of two (1, 2, 3, 4, 6, 8, 12, ... us),
+ * so percentiles are within 25% of the true value. Buckets are 16-bit;
+ * when one saturates, the span's histogram is halved, which keeps the
+ * shape.
+ *
+ * Status trailer: summarize() writes one TraceSummaryRecord per active
+ * span, for appending to a StatusDataPacket uplink (see packet_types.h).
+ *
+ * Call begin()/end() from one context (not from interrupts).
+ *
+ * Author: Production-Ready Implementation
+ * Version: 2.0.0
+ * License: MIT
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+// ===========================================
+// TRACE CONFIGURATION
+// ===========================================
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL                2           // 0 off, 1 statistics, 2 statistics + event ring
+#endif
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE            32          // Events kept at level 2
+#endif
+
+#define TRACE_BUCKETS              48          // Up to 2^24 us (16.7 s); longer spans share the last
+#define TRACE_RESYNC_MS            1000        // Re-anchor the cycle counter on millis()
+
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+#define TRACE_HAS_CYCCNT           1
+#else
+#define TRACE_HAS_CYCCNT           0
+#endif
+
+/**
+ * Traced spans
+ */
+enum TraceSpan {
+    TRACE_CAPTURE,                 // Camera frame capture
+    TRACE_PREPROCESS,              // Resize / quantise into the input tensor
+    TRACE_INVOKE,                  // Model inference
+    TRACE_POSTPROCESS,             // Decode, NMS, thresholds
+    TRACE_UART_RX,                 // Serial frame reception and dispatch
+    TRACE_LORA_TX,                 // LoRaWAN uplink until TX complete
+    TRACE_SLEEP,                   // Idle / low power
+    TRACE_SPAN_COUNT
+};
+
+static const char* const TRACE_SPAN_NAMES[TRACE_SPAN_COUNT] = {
+    "capture", "preprocess", "invoke", "postprocess", "uart_rx", "lora_tx", "sleep"
+};
+
+/**
+ * Span summary appended to a status uplink (6 bytes). Percentiles are
+ * histogram bucket indices, decoded with traceBucketUs().
+ */
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t span;                  // TraceSpan
+    uint16_t count;                // Spans since the last reset (saturates)
+    uint8_t p50;
+    uint8_t p95;
+    uint8_t p99;
+} TraceSummaryRecord;
+#pragma pack(pop)
+
+static_assert(sizeof(TraceSummaryRecord) == 6, "TraceSummaryRecord must be 6 bytes");
+
+// ===========================================
+// HISTOGRAM BUCKETS
+// ===========================================
+
+/**
+ * @brief Bucket of a duration: 2 * log2(us) plus the next bit
+ */
+static inline uint8_t traceBucket(uint32_t us) {
+    if (us < 2) {
+        return (uint8_t)us;
+    }
+    uint8_t msb = 31 - __builtin_clz(us);
+    uint8_t bucket = 2 * msb + ((us >> (msb - 1)) & 1);
+    return bucket < TRACE_BUCKETS ? bucket : TRACE_BUCKETS - 1;
+}
+
+/**
+ * @brief Lower bound of a bucket in microseconds
+ */
+constexpr uint32_t traceBucketUs(uint8_t bucket) {
+    return bucket < 2 ? bucket
+                      : ((uint32_t)1 << (bucket / 2)) + (bucket & 1) * ((uint32_t)1 << (bucket / 2 - 1));
+}
+
+static_assert(traceBucketUs(2) == 2 && traceBucketUs(5) == 6 && traceBucketUs(7) == 12,
+              "Two buckets per octave");
+
+// ===========================================
+// TRACER
+// ===========================================
+
+/**
+ * Statistics of one span
+ */
+struct TraceSpanStats {
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint16_t buckets[TRACE_BUCKETS];
+};
+
+/**
+ * Event in the ring (level 2)
+ */
+struct TraceEvent {
+    uint32_t timeUs;
+    uint8_t span;
+    bool end;
+};
+
+class Tracer {
+private:
+    TraceSpanStats _spans[TRACE_SPAN_COUNT];
+    uint32_t _openUs[TRACE_SPAN_COUNT];     // Begin time of each open span
+    uint8_t _open;                          // Bit per span: begin() seen
+
+#if TRACE_LEVEL >= 2
+    TraceEvent _ring[TRACE_RING_SIZE];
+    uint8_t _ringHead;                      // Next slot
+    uint8_t _ringCount;
+#endif
+
+#if TRACE_HAS_CYCCNT
+    uint32_t _cyclesPerUs;
+    uint32_t _syncCycles;
+    uint32_t _syncMs;
+    uint32_t _syncUs;
+#endif
+
+    void push(uint8_t span, bool end, uint32_t timeUs) {
+#if TRACE_LEVEL >= 2
+        TraceEvent& event = _ring[_ringHead];
+        event.timeUs = timeUs;
+        event.span = span;
+        event.end = end;
+        _ringHead = (_ringHead + 1) % TRACE_RING_SIZE;
+        if (_ringCount < TRACE_RING_SIZE) {
+            _ringCount++;
+        }
+#else
+        (void)span;
+        (void)end;
+        (void)timeUs;
+#endif
+    }
+
+    uint32_t percentileUs(const TraceSpanStats& stats, uint8_t percent) const {
+        uint8_t bucket = percentileBucket(stats, percent);
+        uint32_t low = traceBucketUs(bucket);
+        uint32_t high = (bucket + 1 < TRACE_BUCKETS) ? traceBucketUs(bucket + 1) : stats.maxUs;
+        uint32_t mid = low + (high - low) / 2;
+        return mid < stats.minUs ? stats.minUs : (mid > stats.maxUs ? stats.maxUs : mid);
+    }
+
+public:
+    Tracer() { reset(); }
+
+    /**
+     * @brief Start the cycle counter (call once from setup())
+     */
+    void begin() {
+#if TRACE_HAS_CYCCNT
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  #if defined(__CORTEX_M) && (__CORTEX_M == 7)
+        DWT->LAR = 0xC5ACCE55;              // Cortex-M7: unlock the DWT
+  #endif
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        _cyclesPerUs = SystemCoreClock / 1000000;
+        if (_cyclesPerUs == 0) {
+            _cyclesPerUs = 1;
+        }
+        _syncCycles = DWT->CYCCNT;
+        _syncMs = millis();
+        _syncUs = _syncMs * 1000;
+#endif
+    }
+
+    void reset() {
+        memset(_spans, 0, sizeof(_spans));
+        for (uint8_t i = 0; i < TRACE_SPAN_COUNT; i++) {
+            _spans[i].minUs = 0xFFFFFFFF;
+        }
+        _open = 0;
+#if TRACE_LEVEL >= 2
+        _ringHead = 0;
+        _ringCount = 0;
+#endif
+    }
+
+    /**
+     * @brief Current time in microseconds (wraps after ~71 minutes)
+     */
+    uint32_t nowUs() {
+#if TRACE_HAS_CYCCNT
+        uint32_t cycles = DWT->CYCCNT;
+        uint32_t elapsedMs = millis() - _syncMs;
+        uint32_t elapsedUs = (cycles - _syncCycles) / _cyclesPerUs;
+
+        // Counter wrapped or stopped in sleep: fall back to millis()
+        if (elapsedUs / 1000 + 1 < elapsedMs || elapsedMs + 1 < elapsedUs / 1000) {
+            elapsedUs = elapsedMs * 1000;
+        }
+        if (elapsedMs >= TRACE_RESYNC_MS) {
+            _syncCycles = cycles;
+            _syncMs += elapsedMs;
+            _syncUs += elapsedUs;
+            return _syncUs;
+        }
+        return _syncUs + elapsedUs;
+#else
+        return micros();
+#endif
+    }
+
+    void begin(TraceSpan span) {
+        uint32_t now = nowUs();
+        _openUs[span] = now;
+        _open |= 1 << span;
+        push(span, false, now);
+    }
+
+    /**
+     * @brief Close a span; ignored if it was not begun
+     */
+    void end(TraceSpan span) {
+        uint32_t now = nowUs();
+        if (!(_open & (1 << span))) {
+            return;
+        }
+        _open &= ~(1 << span);
+        push(span, true, now);
+        record(span, now - _openUs[span]);
+    }
+
+    /**
+     * @brief Enter a span measured elsewhere
+     */
+    void record(TraceSpan span, uint32_t durationUs) {
+        TraceSpanStats& stats = _spans[span];
+
+        stats.count++;
+        stats.totalUs += durationUs;
+        if (durationUs < stats.minUs) {
+            stats.minUs = durationUs;
+        }
+        if (durationUs > stats.maxUs) {
+            stats.maxUs = durationUs;
+        }
+
+        uint16_t& bucket = stats.buckets[traceBucket(durationUs)];
+        if (bucket == 0xFFFF) {
+            for (uint8_t i = 0; i < TRACE_BUCKETS; i++) {
+                stats.buckets[i] = (stats.buckets[i] + 1) / 2;
+            }
+        }
+        bucket++;
+    }
+
+    const TraceSpanStats& stats(TraceSpan span) const { return _spans[span]; }
+
+    uint32_t count(TraceSpan span) const { return _spans[span].count; }
+
+    /**
+     * @brief Mean duration in microseconds (0 if the span never ran)
+     */
+    uint32_t meanUs(TraceSpan span) const {
+        const TraceSpanStats& stats = _spans[span];
+        return stats.count > 0 ? (uint32_t)(stats.totalUs / stats.count) : 0;
+    }
+
+    /**
+     * @brief Bucket holding the given percentile
+     */
+    uint8_t percentileBucket(const TraceSpanStats& stats, uint8_t percent) const {
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < TRACE_BUCKETS; i++) {
+            total += stats.buckets[i];
+        }
+        if (total == 0) {
+            return 0;
+        }
+
+        uint32_t rank = (total * percent + 99) / 100;
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < TRACE_BUCKETS; i++) {
+            seen += stats.buckets[i];
+            if (seen >= rank) {
+                return i;
+            }
+        }
+        return TRACE_BUCKETS - 1;
+    }
+
+    /**
+     * @brief Percentile estimate in microseconds (0 if the span never ran)
+     */
+    uint32_t percentileUs(TraceSpan span, uint8_t percent) const {
+        return _spans[span].count > 0 ? percentileUs(_spans[span], percent) : 0;
+    }
+
+    /**
+     * @brief Write one summary record per span that has run
+     * @return Number of records written
+     */
+    uint8_t summarize(TraceSummaryRecord* records, uint8_t max) const {
+        uint8_t written = 0;
+        for (uint8_t i = 0; i < TRACE_SPAN_COUNT && written < max; i++) {
+            const TraceSpanStats& stats = _spans[i];
+            if (stats.count == 0) {
+                continue;
+            }
+            TraceSummaryRecord& record = records[written++];
+            record.span = i;
+            record.count = stats.count > 0xFFFF ? 0xFFFF : (uint16_t)stats.count;
+            record.p50 = percentileBucket(stats, 50);
+            record.p95 = percentileBucket(stats, 95);
+            record.p99 = percentileBucket(stats, 99);
+        }
+        return written;
+    }
+
+    /**
+     * @brief Print a table of every span that has run (times in us)
+     */
+    void printSummary(Print& out) const {
+        out.println("span         count      min      p50      p95      p99      max     mean");
+        for (uint8_t i = 0; i < TRACE_SPAN_COUNT; i++) {
+            const TraceSpanStats& stats = _spans[i];
+            if (stats.count == 0) {
+                continue;
+            }
+            uint32_t values[] = {
+                stats.count, stats.minUs, percentileUs(stats, 50), percentileUs(stats, 95),
+                percentileUs(stats, 99), stats.maxUs, meanUs((TraceSpan)i)
+            };
+
+            out.print(TRACE_SPAN_NAMES[i]);
+            for (size_t pad = strlen(TRACE_SPAN_NAMES[i]); pad < 12; pad++) {
+                out.print(' ');
+            }
+            for (uint8_t v = 0; v < sizeof(values) / sizeof(values[0]); v++) {
+                char column[10];
+                snprintf(column, sizeof(column), " %8lu", (unsigned long)values[v]);
+                out.print(column);
+            }
+            out.println();
+        }
+    }
+
+    /**
+     * @brief Print the event ring, oldest first, as "time_us,span,B|E"
+     */
+    void printEvents(Print& out) const {
+#if TRACE_LEVEL >= 2
+        uint8_t start = (_ringHead + TRACE_RING_SIZE - _ringCount) % TRACE_RING_SIZE;
+        for (uint8_t i = 0; i < _ringCount; i++) {
+            const TraceEvent& event = _ring[(start + i) % TRACE_RING_SIZE];
+            out.print(event.timeUs);
+            out.print(',');
+            out.print(TRACE_SPAN_NAMES[event.span]);
+            out.println(event.end ? ",E" : ",B");
+        }
+#else
+        (void)out;
+#endif
+    }
+};
+
+/**
+ * Single instance shared by every translation unit (a static member of a
+ * class template may be defined in a header)
+ */
+template <typename Unused = void>
+struct TraceStorage {
+    static Tracer instance;
+};
+
+template <typename Unused>
+Tracer TraceStorage<Unused>::instance;
+
+static inline Tracer& tracer() {
+    return TraceStorage<>::instance;
+}
+
+/**
+ * Span that ends when the scope is left
+ */
+class TraceScope {
+private:
+    TraceSpan _span;
+
+public:
+    explicit TraceScope(TraceSpan span) : _span(span) { tracer().begin(span); }
+    ~TraceScope() { tracer().end(_span); }
+};
+
+// ===========================================
+// INSTRUMENTATION MACROS
+// ===========================================
+
+#if TRACE_LEVEL > 0
+#define TRACE_BEGIN(span)          tracer().begin(span)
+#define TRACE_END(span)            tracer().end(span)
+#define TRACE_RECORD(span, us)     tracer().record(span, us)
+#define TRACE_SCOPE(span)          TraceScope traceScope_##span(span)
+#else
+#define TRACE_BEGIN(span)          ((void)0)
+#define TRACE_END(span)            ((void)0)
+#define TRACE_RECORD(span, us)     ((void)0)
+#define TRACE_SCOPE(span)          ((void)0)
+#endif
+
+#endif // TRACE_H
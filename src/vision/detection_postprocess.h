@@ -0,0 +1,554 @@
+/**
+ * Detection Post-Processing
+ *
+ * Output decoders and non-maximum suppression for multi-object models:
+ * - SSD with the TFLite_Detection_PostProcess op (boxes/classes/scores/count)
+ * - SSD raw outputs (box encodings + class scores) decoded against anchors
+ * - YOLO-style grid outputs [1, H, W, anchors * (5 + classes)]
+ * - Classification outputs [1, C] (top class, quantized argmax)
+ *
+ * Decoders read int8/uint8/float32 tensors directly. Score thresholds are
+ * converted to the tensor's quantized domain once, so only candidates that
+ * pass are dequantized and decoded. NMS sorts an index array and compares
+ * boxes with integer IoU, so hundreds of anchors stay within the frame
+ * budget.
+ *
+ * Boxes are returned in camera-frame pixels: the decoder maps normalised
+ * model coordinates through the frame region the model input was taken
+ * from (the full frame, or a crop).
+ */
+
+#ifndef DETECTION_POSTPROCESS_H
+#define DETECTION_POSTPROCESS_H
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+// Candidate pool size before NMS. When it fills up, the weaker half is
+// dropped and the score threshold is raised to the median.
+#ifndef DETPOST_MAX_CANDIDATES
+#define DETPOST_MAX_CANDIDATES 128
+#endif
+
+// IoU thresholds are expressed in 1/256 units for the integer comparison
+#define DETPOST_IOU_ONE 256
+
+// ===========================================
+// TENSOR VIEW
+// ===========================================
+
+enum TensorElementType {
+  TENSOR_ELEMENT_FLOAT32,
+  TENSOR_ELEMENT_UINT8,
+  TENSOR_ELEMENT_INT8
+};
+
+/**
+ * Framework-independent view of an output tensor
+ */
+struct TensorView {
+  const void* data;
+  TensorElementType type;
+  float scale;
+  int32_t zeroPoint;
+};
+
+/**
+ * Per-element-type threshold conversion and dequantization
+ */
+template <typename T>
+struct QuantTraits {
+  typedef int32_t Threshold;
+
+  // Smallest raw value whose real value is >= t (clamped so +-inf
+  // thresholds stay representable)
+  static Threshold threshold(const TensorView& view, float t) {
+    float q = ceilf(t / view.scale) + view.zeroPoint;
+    if (q < -65536.0f) return -65536;
+    if (q > 65536.0f) return 65536;
+    return (int32_t)q;
+  }
+
+  static float dequantize(const TensorView& view, T raw) {
+    return (raw - view.zeroPoint) * view.scale;
+  }
+};
+
+template <>
+struct QuantTraits<float> {
+  typedef float Threshold;
+
+  static Threshold threshold(const TensorView&, float t) {
+    return t;
+  }
+
+  static float dequantize(const TensorView&, float raw) {
+    return raw;
+  }
+};
+
+static inline float detpostSigmoid(float x) {
+  return 1.0f / (1.0f + expf(-x));
+}
+
+static inline float detpostLogit(float p) {
+  if (p <= 0.0f) return -1e30f;
+  if (p >= 1.0f) return 1e30f;
+  return logf(p / (1.0f - p));
+}
+
+// ===========================================
+// CANDIDATES
+// ===========================================
+
+/**
+ * Frame region covered by the model input, in camera pixels
+ */
+struct DetectionFrame {
+  uint16_t x;
+  uint16_t y;
+  uint16_t width;
+  uint16_t height;
+};
+
+/**
+ * Decoded detection in camera-frame pixels (corner form)
+ */
+struct Detection {
+  int16_t x0;
+  int16_t y0;
+  int16_t x1;
+  int16_t y1;
+  uint8_t classId;
+  float confidence;
+
+  uint32_t area() const {
+    return (uint32_t)(x1 - x0) * (uint32_t)(y1 - y0);
+  }
+};
+
+/**
+ * Bounded candidate pool with an adaptive score threshold
+ */
+struct DetectionCandidates {
+  Detection items[DETPOST_MAX_CANDIDATES];
+  uint16_t count;
+  float threshold;
+
+  void reset(float scoreThreshold) {
+    count = 0;
+    threshold = scoreThreshold;
+  }
+
+  /**
+   * Add a candidate. Returns true if the threshold was raised, in which
+   * case decoders must refresh their quantized threshold.
+   */
+  bool push(const DetectionFrame& frame, float ymin, float xmin, float ymax, float xmax,
+            uint8_t classId, float confidence) {
+    if (confidence < threshold) {
+      return false;
+    }
+
+    bool raised = false;
+    if (count == DETPOST_MAX_CANDIDATES) {
+      raised = compact();
+      if (confidence < threshold) {
+        return raised;
+      }
+    }
+
+    Detection& d = items[count];
+    d.x0 = mapCoordinate(xmin, frame.x, frame.width);
+    d.y0 = mapCoordinate(ymin, frame.y, frame.height);
+    d.x1 = mapCoordinate(xmax, frame.x, frame.width);
+    d.y1 = mapCoordinate(ymax, frame.y, frame.height);
+    d.classId = classId;
+    d.confidence = confidence;
+
+    // Degenerate boxes cannot survive NMS or be reported
+    if (d.x1 > d.x0 && d.y1 > d.y0) {
+      count++;
+    }
+    return raised;
+  }
+
+private:
+  static int16_t mapCoordinate(float normalized, uint16_t origin, uint16_t extent) {
+    if (normalized < 0.0f) normalized = 0.0f;
+    if (normalized > 1.0f) normalized = 1.0f;
+    return (int16_t)(origin + normalized * extent + 0.5f);
+  }
+
+  // Keep the stronger half; raise the threshold to the weakest kept score
+  bool compact() {
+    uint16_t keep = DETPOST_MAX_CANDIDATES / 2;
+    std::nth_element(items, items + keep - 1, items + count,
+                     [](const Detection& a, const Detection& b) {
+                       return a.confidence > b.confidence;
+                     });
+    count = keep;
+    float raisedTo = items[keep - 1].confidence;
+    bool raised = raisedTo > threshold;
+    threshold = std::max(threshold, raisedTo);
+    return raised;
+  }
+};
+
+// ===========================================
+// SSD (TFLITE_DETECTION_POSTPROCESS)
+// ===========================================
+
+template <typename T>
+static inline void decodeSSDPostprocessedT(const TensorView& boxes, const TensorView& classes,
+                                           const TensorView& scores, uint16_t count,
+                                           const DetectionFrame& frame,
+                                           DetectionCandidates& out) {
+  const T* box = (const T*)boxes.data;
+  const T* cls = (const T*)classes.data;
+  const T* score = (const T*)scores.data;
+  typename QuantTraits<T>::Threshold minScore = QuantTraits<T>::threshold(scores, out.threshold);
+
+  for (uint16_t i = 0; i < count; i++) {
+    if (score[i] < minScore) continue;
+
+    // Box layout: [ymin, xmin, ymax, xmax], normalised
+    const T* b = box + 4 * i;
+    float confidence = QuantTraits<T>::dequantize(scores, score[i]);
+    uint8_t classId = (uint8_t)(QuantTraits<T>::dequantize(classes, cls[i]) + 0.5f);
+
+    if (out.push(frame,
+                 QuantTraits<T>::dequantize(boxes, b[0]), QuantTraits<T>::dequantize(boxes, b[1]),
+                 QuantTraits<T>::dequantize(boxes, b[2]), QuantTraits<T>::dequantize(boxes, b[3]),
+                 classId, confidence)) {
+      minScore = QuantTraits<T>::threshold(scores, out.threshold);
+    }
+  }
+}
+
+/**
+ * Collect detections from the four outputs of TFLite_Detection_PostProcess.
+ * The op has already decoded and suppressed the boxes; this thresholds
+ * them and maps them into the camera frame.
+ */
+static inline bool decodeSSDPostprocessed(const TensorView& boxes, const TensorView& classes,
+                                          const TensorView& scores, uint16_t count,
+                                          const DetectionFrame& frame,
+                                          DetectionCandidates& out) {
+  if (boxes.type != classes.type || boxes.type != scores.type) {
+    return false;
+  }
+
+  switch (scores.type) {
+    case TENSOR_ELEMENT_FLOAT32:
+      decodeSSDPostprocessedT<float>(boxes, classes, scores, count, frame, out);
+      return true;
+    case TENSOR_ELEMENT_UINT8:
+      decodeSSDPostprocessedT<uint8_t>(boxes, classes, scores, count, frame, out);
+      return true;
+    case TENSOR_ELEMENT_INT8:
+      decodeSSDPostprocessedT<int8_t>(boxes, classes, scores, count, frame, out);
+      return true;
+  }
+  return false;
+}
+
+// ===========================================
+// SSD (RAW OUTPUTS + ANCHORS)
+// ===========================================
+
+/**
+ * SSD anchor (TF Object Detection API order), normalised
+ */
+struct SsdAnchor {
+  float yCenter;
+  float xCenter;
+  float height;
+  float width;
+};
+
+struct SsdConfig {
+  const SsdAnchor* anchors;
+  uint16_t numAnchors;
+  uint16_t numClasses;      // Including the background class
+  uint8_t classOffset;      // 1 if class 0 is background
+  float yScale;             // Box coder scales (10, 10, 5, 5 by default)
+  float xScale;
+  float hScale;
+  float wScale;
+};
+
+template <typename TBox, typename TScore>
+static inline void decodeSSDAnchorsT(const TensorView& encodings, const TensorView& scores,
+                                     const SsdConfig& cfg, const DetectionFrame& frame,
+                                     DetectionCandidates& out) {
+  const TBox* enc = (const TBox*)encodings.data;
+  const TScore* score = (const TScore*)scores.data;
+  typename QuantTraits<TScore>::Threshold minScore =
+    QuantTraits<TScore>::threshold(scores, out.threshold);
+
+  for (uint16_t a = 0; a < cfg.numAnchors; a++) {
+    const TScore* row = score + (uint32_t)a * cfg.numClasses;
+
+    // Best foreground class in the raw domain (dequantization is monotonic)
+    uint16_t best = cfg.classOffset;
+    for (uint16_t c = cfg.classOffset + 1; c < cfg.numClasses; c++) {
+      if (row[c] > row[best]) best = c;
+    }
+    if (row[best] < minScore) continue;
+
+    // Decode the box only for anchors that pass
+    const TBox* e = enc + 4 * (uint32_t)a;
+    const SsdAnchor& anchor = cfg.anchors[a];
+    float ty = QuantTraits<TBox>::dequantize(encodings, e[0]) / cfg.yScale;
+    float tx = QuantTraits<TBox>::dequantize(encodings, e[1]) / cfg.xScale;
+    float th = QuantTraits<TBox>::dequantize(encodings, e[2]) / cfg.hScale;
+    float tw = QuantTraits<TBox>::dequantize(encodings, e[3]) / cfg.wScale;
+
+    float yc = ty * anchor.height + anchor.yCenter;
+    float xc = tx * anchor.width + anchor.xCenter;
+    float halfH = 0.5f * expf(th) * anchor.height;
+    float halfW = 0.5f * expf(tw) * anchor.width;
+
+    if (out.push(frame, yc - halfH, xc - halfW, yc + halfH, xc + halfW,
+                 (uint8_t)(best - cfg.classOffset),
+                 QuantTraits<TScore>::dequantize(scores, row[best]))) {
+      minScore = QuantTraits<TScore>::threshold(scores, out.threshold);
+    }
+  }
+}
+
+/**
+ * Decode raw SSD outputs: box encodings [1, A, 4] and class scores
+ * [1, A, C] (already passed through the score converter, e.g. sigmoid)
+ */
+static inline bool decodeSSDAnchors(const TensorView& encodings, const TensorView& scores,
+                                    const SsdConfig& cfg, const DetectionFrame& frame,
+                                    DetectionCandidates& out) {
+  if (cfg.anchors == nullptr || cfg.numClasses <= cfg.classOffset) {
+    return false;
+  }
+
+  if (encodings.type == TENSOR_ELEMENT_FLOAT32 && scores.type == TENSOR_ELEMENT_FLOAT32) {
+    decodeSSDAnchorsT<float, float>(encodings, scores, cfg, frame, out);
+  } else if (encodings.type == TENSOR_ELEMENT_UINT8 && scores.type == TENSOR_ELEMENT_UINT8) {
+    decodeSSDAnchorsT<uint8_t, uint8_t>(encodings, scores, cfg, frame, out);
+  } else if (encodings.type == TENSOR_ELEMENT_INT8 && scores.type == TENSOR_ELEMENT_INT8) {
+    decodeSSDAnchorsT<int8_t, int8_t>(encodings, scores, cfg, frame, out);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// ===========================================
+// YOLO GRID
+// ===========================================
+
+struct YoloConfig {
+  uint16_t gridWidth;
+  uint16_t gridHeight;
+  uint8_t numAnchors;
+  uint8_t numClasses;
+  const float* anchors;     // (width, height) pairs, normalised to the input
+  bool activated;           // true if x/y/objectness/classes are already sigmoid
+};
+
+template <typename T>
+static inline void decodeYoloGridT(const TensorView& view, const YoloConfig& cfg,
+                                   const DetectionFrame& frame, DetectionCandidates& out) {
+  const T* data = (const T*)view.data;
+  const uint16_t stride = 5 + cfg.numClasses;
+
+  // Objectness bounds the final score (class probability <= 1), so it is
+  // thresholded first, in the raw domain
+  float objThreshold = cfg.activated ? out.threshold : detpostLogit(out.threshold);
+  typename QuantTraits<T>::Threshold minObj = QuantTraits<T>::threshold(view, objThreshold);
+
+  for (uint16_t gy = 0; gy < cfg.gridHeight; gy++) {
+    for (uint16_t gx = 0; gx < cfg.gridWidth; gx++) {
+      const T* cell = data + ((uint32_t)gy * cfg.gridWidth + gx) * cfg.numAnchors * stride;
+
+      for (uint8_t a = 0; a < cfg.numAnchors; a++) {
+        const T* p = cell + a * stride;
+        if (p[4] < minObj) continue;
+
+        uint8_t best = 0;
+        for (uint8_t c = 1; c < cfg.numClasses; c++) {
+          if (p[5 + c] > p[5 + best]) best = c;
+        }
+
+        float obj = QuantTraits<T>::dequantize(view, p[4]);
+        float cls = QuantTraits<T>::dequantize(view, p[5 + best]);
+        float tx = QuantTraits<T>::dequantize(view, p[0]);
+        float ty = QuantTraits<T>::dequantize(view, p[1]);
+        if (!cfg.activated) {
+          obj = detpostSigmoid(obj);
+          cls = detpostSigmoid(cls);
+          tx = detpostSigmoid(tx);
+          ty = detpostSigmoid(ty);
+        }
+
+        float confidence = obj * cls;
+        if (confidence < out.threshold) continue;
+
+        float xc = (gx + tx) / cfg.gridWidth;
+        float yc = (gy + ty) / cfg.gridHeight;
+        float halfW = 0.5f * cfg.anchors[2 * a] * expf(QuantTraits<T>::dequantize(view, p[2]));
+        float halfH = 0.5f * cfg.anchors[2 * a + 1] * expf(QuantTraits<T>::dequantize(view, p[3]));
+
+        if (out.push(frame, yc - halfH, xc - halfW, yc + halfH, xc + halfW, best, confidence)) {
+          objThreshold = cfg.activated ? out.threshold : detpostLogit(out.threshold);
+          minObj = QuantTraits<T>::threshold(view, objThreshold);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Decode a YOLO-style grid output [1, H, W, anchors * (5 + classes)],
+ * per anchor: [x, y, w, h, objectness, class scores...]
+ */
+static inline bool decodeYoloGrid(const TensorView& view, const YoloConfig& cfg,
+                                  const DetectionFrame& frame, DetectionCandidates& out) {
+  if (cfg.anchors == nullptr || cfg.numClasses == 0) {
+    return false;
+  }
+
+  switch (view.type) {
+    case TENSOR_ELEMENT_FLOAT32:
+      decodeYoloGridT<float>(view, cfg, frame, out);
+      return true;
+    case TENSOR_ELEMENT_UINT8:
+      decodeYoloGridT<uint8_t>(view, cfg, frame, out);
+      return true;
+    case TENSOR_ELEMENT_INT8:
+      decodeYoloGridT<int8_t>(view, cfg, frame, out);
+      return true;
+  }
+  return false;
+}
+
+// ===========================================
+// CLASSIFICATION
+// ===========================================
+
+template <typename T>
+static inline bool decodeClassificationT(const TensorView& view, uint16_t numClasses, float threshold,
+                                         uint8_t& classId, float& confidence) {
+  const T* score = (const T*)view.data;
+
+  // Argmax and threshold in the raw domain (dequantization is monotonic)
+  uint16_t best = 0;
+  for (uint16_t c = 1; c < numClasses; c++) {
+    if (score[c] > score[best]) best = c;
+  }
+
+  classId = (uint8_t)best;
+  confidence = QuantTraits<T>::dequantize(view, score[best]);
+  return score[best] >= QuantTraits<T>::threshold(view, threshold);
+}
+
+/**
+ * Top class of a classification output [1, C]: only the winning score is
+ * dequantized. classId/confidence are set even below the threshold.
+ * @return true if the top score reaches the threshold
+ */
+static inline bool decodeClassification(const TensorView& view, uint16_t numClasses, float threshold,
+                                        uint8_t& classId, float& confidence) {
+  if (numClasses == 0) {
+    return false;
+  }
+
+  switch (view.type) {
+    case TENSOR_ELEMENT_FLOAT32:
+      return decodeClassificationT<float>(view, numClasses, threshold, classId, confidence);
+    case TENSOR_ELEMENT_UINT8:
+      return decodeClassificationT<uint8_t>(view, numClasses, threshold, classId, confidence);
+    case TENSOR_ELEMENT_INT8:
+      return decodeClassificationT<int8_t>(view, numClasses, threshold, classId, confidence);
+  }
+  return false;
+}
+
+/**
+ * Real value of one element (for reporting a single score)
+ */
+static inline float tensorViewValue(const TensorView& view, uint32_t index) {
+  switch (view.type) {
+    case TENSOR_ELEMENT_FLOAT32:
+      return ((const float*)view.data)[index];
+    case TENSOR_ELEMENT_UINT8:
+      return QuantTraits<uint8_t>::dequantize(view, ((const uint8_t*)view.data)[index]);
+    case TENSOR_ELEMENT_INT8:
+      return QuantTraits<int8_t>::dequantize(view, ((const int8_t*)view.data)[index]);
+  }
+  return 0.0f;
+}
+
+// ===========================================
+// NON-MAXIMUM SUPPRESSION
+// ===========================================
+
+/**
+ * Integer IoU test: inter / union > iouQ8 / 256
+ */
+static inline bool detectionsOverlap(const Detection& a, const Detection& b, uint32_t iouQ8) {
+  int32_t ix0 = std::max(a.x0, b.x0);
+  int32_t iy0 = std::max(a.y0, b.y0);
+  int32_t ix1 = std::min(a.x1, b.x1);
+  int32_t iy1 = std::min(a.y1, b.y1);
+  if (ix1 <= ix0 || iy1 <= iy0) return false;
+
+  uint32_t inter = (uint32_t)(ix1 - ix0) * (uint32_t)(iy1 - iy0);
+  uint32_t unionArea = a.area() + b.area() - inter;
+  return (uint64_t)inter * DETPOST_IOU_ONE > (uint64_t)iouQ8 * unionArea;
+}
+
+/**
+ * Class-aware greedy NMS. Candidates are ranked through an index sort
+ * (O(n log n)); each is only compared against the boxes already kept, so
+ * the pass is O(n * maxOutput).
+ * Returns the number of detections written to `out`, strongest first.
+ */
+static inline uint8_t nonMaxSuppression(const DetectionCandidates& candidates, float iouThreshold,
+                                        Detection* out, uint8_t maxOutput) {
+  uint16_t order[DETPOST_MAX_CANDIDATES];
+  for (uint16_t i = 0; i < candidates.count; i++) {
+    order[i] = i;
+  }
+
+  const Detection* items = candidates.items;
+  std::sort(order, order + candidates.count, [items](uint16_t a, uint16_t b) {
+    return items[a].confidence > items[b].confidence;
+  });
+
+  uint32_t iouQ8 = (uint32_t)(iouThreshold * DETPOST_IOU_ONE + 0.5f);
+  uint8_t kept = 0;
+
+  for (uint16_t i = 0; i < candidates.count && kept < maxOutput; i++) {
+    const Detection& candidate = items[order[i]];
+
+    bool suppressed = false;
+    for (uint8_t k = 0; k < kept; k++) {
+      if (out[k].classId == candidate.classId && detectionsOverlap(out[k], candidate, iouQ8)) {
+        suppressed = true;
+        break;
+      }
+    }
+
+    if (!suppressed) {
+      out[kept++] = candidate;
+    }
+  }
+
+  return kept;
+}
+
+#endif  // DETECTION_POSTPROCESS_H
@@ -0,0 +1,355 @@
+/**
+ * Detection Tracker
+ *
+ * Associates per-frame detections into tracks so alarms and reports are
+ * raised once per object instead of once per frame:
+ * - Each frame, tracks are moved by their velocity, then matched to the
+ *   new detections of the same class greedily by integer IoU; boxes that
+ *   no longer overlap (fast motion, skipped frames) can still match by
+ *   centroid distance
+ * - A track is confirmed after TRACKER_CONFIRM_HITS matches and dropped
+ *   after TRACKER_MAX_MISSES frames without one; isolated false positives
+ *   never confirm
+ * - TRACK_EVENT_CONFIRMED / TRACK_EVENT_LOST are queued once per track
+ *
+ * predict() advances tracks one frame without detections, so inference
+ * can run on every other frame and coast in between. Frames skipped
+ * altogether (motion gate) do not count as misses; staleCount() and
+ * expire() age tracks by lastSeenMs instead.
+ *
+ * Uses the Detection boxes from detection_postprocess.h (camera pixels).
+ */
+
+#ifndef DETECTION_TRACKER_H
+#define DETECTION_TRACKER_H
+
+#include <stdint.h>
+#include "detection_postprocess.h"
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+#ifndef TRACKER_MAX_TRACKS
+#define TRACKER_MAX_TRACKS 8
+#endif
+
+#define TRACKER_MATCH_IOU 77          // Minimum IoU to match, 1/256 units (0.3)
+#define TRACKER_CENTROID_GATE 2       // Centroid match within (w + h) / 2^gate of the track
+#define TRACKER_CONFIRM_HITS 3        // Matches before a track is reported
+#define TRACKER_MAX_MISSES 4          // Frames without a match before a track is dropped
+#define TRACKER_EVENT_QUEUE 8
+#define TRACKER_ANY_CLASS 0xFF
+
+// ===========================================
+// TRACKS AND EVENTS
+// ===========================================
+
+struct Track {
+  Detection box;                // Last matched (or predicted) box
+  int16_t vx;                   // Centroid velocity, 1/16 px per frame
+  int16_t vy;
+  float peakConfidence;
+  uint32_t firstSeenMs;
+  uint32_t lastSeenMs;
+  uint16_t id;
+  uint16_t hits;
+  uint8_t misses;
+  uint8_t coasted;              // Frames predicted since the last match
+  bool active;
+  bool confirmed;
+};
+
+enum TrackEventType {
+  TRACK_EVENT_CONFIRMED,        // New object: report / alarm once
+  TRACK_EVENT_LOST              // Confirmed object left the scene
+};
+
+struct TrackEvent {
+  TrackEventType type;
+  Track track;                  // Copy at the time of the event
+};
+
+class DetectionTracker {
+ public:
+  DetectionTracker() : _nextId(1), _eventHead(0), _eventCount(0), _droppedEvents(0) {
+    reset();
+  }
+
+  void reset() {
+    for (uint8_t i = 0; i < TRACKER_MAX_TRACKS; i++) {
+      _tracks[i].active = false;
+    }
+    _eventHead = 0;
+    _eventCount = 0;
+  }
+
+  /**
+   * Advance all tracks one frame without detections (skipped inference)
+   */
+  void predict() {
+    for (uint8_t i = 0; i < TRACKER_MAX_TRACKS; i++) {
+      if (_tracks[i].active) {
+        move(_tracks[i]);
+      }
+    }
+  }
+
+  /**
+   * Feed the detections of one inferred frame (after NMS)
+   */
+  void update(const Detection* detections, uint8_t count, uint32_t now) {
+    predict();
+
+    // Greedy association: repeatedly take the best remaining pair
+    bool trackUsed[TRACKER_MAX_TRACKS] = {false};
+    uint32_t detectionUsed = 0;
+
+    for (;;) {
+      int16_t bestTrack = -1;
+      uint8_t bestDetection = 0;
+      int32_t bestScore = 0;
+
+      for (uint8_t t = 0; t < TRACKER_MAX_TRACKS; t++) {
+        if (!_tracks[t].active || trackUsed[t]) continue;
+        for (uint8_t d = 0; d < count && d < 32; d++) {
+          if (detectionUsed & (1UL << d)) continue;
+          int32_t score = matchScore(_tracks[t], detections[d]);
+          if (score > bestScore) {
+            bestScore = score;
+            bestTrack = t;
+            bestDetection = d;
+          }
+        }
+      }
+
+      if (bestTrack < 0) break;
+      trackUsed[bestTrack] = true;
+      detectionUsed |= 1UL << bestDetection;
+      hit(_tracks[bestTrack], detections[bestDetection], now);
+    }
+
+    // Unmatched tracks miss; confirmed ones that run out are reported lost
+    for (uint8_t t = 0; t < TRACKER_MAX_TRACKS; t++) {
+      Track& track = _tracks[t];
+      if (!track.active || trackUsed[t]) continue;
+      if (++track.misses > TRACKER_MAX_MISSES) {
+        track.active = false;
+        if (track.confirmed) {
+          pushEvent(TRACK_EVENT_LOST, track);
+        }
+      }
+    }
+
+    // Unmatched detections start tentative tracks
+    for (uint8_t d = 0; d < count && d < 32; d++) {
+      if (!(detectionUsed & (1UL << d))) {
+        spawn(detections[d], now, trackUsed);
+      }
+    }
+  }
+
+  /**
+   * Confirmed tracks not matched for at least ageMs: the caller should
+   * run inference instead of skipping the frame, to re-find or lose them
+   */
+  uint8_t staleCount(uint32_t now, uint32_t ageMs) const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < TRACKER_MAX_TRACKS; i++) {
+      const Track& track = _tracks[i];
+      if (track.active && track.confirmed && now - track.lastSeenMs >= ageMs) {
+        n++;
+      }
+    }
+    return n;
+  }
+
+  /**
+   * Drop tracks not matched for more than maxAgeMs, however many frames
+   * were inferred meanwhile; confirmed ones are reported lost
+   */
+  void expire(uint32_t now, uint32_t maxAgeMs) {
+    for (uint8_t i = 0; i < TRACKER_MAX_TRACKS; i++) {
+      Track& track = _tracks[i];
+      if (track.active && now - track.lastSeenMs > maxAgeMs) {
+        track.active = false;
+        if (track.confirmed) {
+          pushEvent(TRACK_EVENT_LOST, track);
+        }
+      }
+    }
+  }
+
+  /**
+   * Take the oldest pending event
+   */
+  bool pollEvent(TrackEvent& event) {
+    if (_eventCount == 0) {
+      return false;
+    }
+    event = _events[_eventHead];
+    _eventHead = (_eventHead + 1) % TRACKER_EVENT_QUEUE;
+    _eventCount--;
+    return true;
+  }
+
+  /**
+   * Confirmed tracks, optionally of one class
+   */
+  uint8_t confirmedCount(uint8_t classId = TRACKER_ANY_CLASS) const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < TRACKER_MAX_TRACKS; i++) {
+      const Track& track = _tracks[i];
+      if (track.active && track.confirmed &&
+          (classId == TRACKER_ANY_CLASS || track.box.classId == classId)) {
+        n++;
+      }
+    }
+    return n;
+  }
+
+  uint8_t activeCount() const {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < TRACKER_MAX_TRACKS; i++) {
+      n += _tracks[i].active;
+    }
+    return n;
+  }
+
+  const Track& track(uint8_t index) const { return _tracks[index]; }
+  uint32_t droppedEvents() const { return _droppedEvents; }
+
+ private:
+  static int32_t centerX(const Detection& d) { return ((int32_t)d.x0 + d.x1) / 2; }
+  static int32_t centerY(const Detection& d) { return ((int32_t)d.y0 + d.y1) / 2; }
+
+  /**
+   * Match quality: IoU (1/256) when above TRACKER_MATCH_IOU, a small
+   * positive score within the centroid gate, 0 for no match
+   */
+  static int32_t matchScore(const Track& track, const Detection& d) {
+    if (track.box.classId != d.classId) {
+      return 0;
+    }
+
+    const Detection& a = track.box;
+    int32_t ix0 = std::max(a.x0, d.x0);
+    int32_t iy0 = std::max(a.y0, d.y0);
+    int32_t ix1 = std::min(a.x1, d.x1);
+    int32_t iy1 = std::min(a.y1, d.y1);
+    if (ix1 > ix0 && iy1 > iy0) {
+      uint32_t inter = (uint32_t)(ix1 - ix0) * (uint32_t)(iy1 - iy0);
+      uint32_t unionArea = a.area() + d.area() - inter;
+      int32_t iou = (int32_t)((uint64_t)inter * DETPOST_IOU_ONE / unionArea);
+      if (iou >= TRACKER_MATCH_IOU) {
+        return iou;
+      }
+    }
+
+    int32_t gate = ((a.x1 - a.x0) + (a.y1 - a.y0)) >> TRACKER_CENTROID_GATE;
+    int32_t dx = centerX(d) - centerX(a);
+    int32_t dy = centerY(d) - centerY(a);
+    if (dx < 0) dx = -dx;
+    if (dy < 0) dy = -dy;
+    return (dx + dy < gate) ? 1 : 0;
+  }
+
+  static void move(Track& track) {
+    int16_t dx = track.vx / 16;
+    int16_t dy = track.vy / 16;
+    track.box.x0 += dx;
+    track.box.x1 += dx;
+    track.box.y0 += dy;
+    track.box.y1 += dy;
+    if (track.coasted < 0xFF) {
+      track.coasted++;
+    }
+  }
+
+  void hit(Track& track, const Detection& d, uint32_t now) {
+    // The predicted box already moved by the old velocity: the residual
+    // over the coasted frames corrects it (EMA, 1/2 weight)
+    int32_t frames = track.coasted > 0 ? track.coasted : 1;
+    int32_t mx = (centerX(d) - centerX(track.box)) * 16 / frames + track.vx;
+    int32_t my = (centerY(d) - centerY(track.box)) * 16 / frames + track.vy;
+    track.vx = (int16_t)((track.vx + mx) / 2);
+    track.vy = (int16_t)((track.vy + my) / 2);
+
+    track.box = d;
+    track.lastSeenMs = now;
+    track.misses = 0;
+    track.coasted = 0;
+    if (d.confidence > track.peakConfidence) {
+      track.peakConfidence = d.confidence;
+    }
+    if (track.hits < 0xFFFF) {
+      track.hits++;
+    }
+    if (!track.confirmed && track.hits >= TRACKER_CONFIRM_HITS) {
+      track.confirmed = true;
+      pushEvent(TRACK_EVENT_CONFIRMED, track);
+    }
+  }
+
+  void spawn(const Detection& d, uint32_t now, const bool* trackUsed) {
+    // Free slot, else replace the weakest tentative track (fewest hits,
+    // then lowest peak confidence) not matched in this update
+    int16_t slot = -1;
+    for (uint8_t i = 0; i < TRACKER_MAX_TRACKS && slot < 0; i++) {
+      if (!_tracks[i].active) slot = i;
+    }
+    if (slot < 0) {
+      for (uint8_t i = 0; i < TRACKER_MAX_TRACKS; i++) {
+        const Track& candidate = _tracks[i];
+        if (candidate.confirmed || trackUsed[i]) continue;
+        if (slot < 0 || candidate.hits < _tracks[slot].hits ||
+            (candidate.hits == _tracks[slot].hits &&
+             candidate.peakConfidence < _tracks[slot].peakConfidence)) {
+          slot = i;
+        }
+      }
+    }
+    if (slot < 0) {
+      return;
+    }
+
+    Track& track = _tracks[slot];
+    track.box = d;
+    track.vx = 0;
+    track.vy = 0;
+    track.peakConfidence = d.confidence;
+    track.firstSeenMs = now;
+    track.lastSeenMs = now;
+    track.id = _nextId++;
+    if (_nextId == 0) _nextId = 1;
+    track.hits = 1;
+    track.misses = 0;
+    track.coasted = 0;
+    track.active = true;
+    track.confirmed = TRACKER_CONFIRM_HITS <= 1;
+    if (track.confirmed) {
+      pushEvent(TRACK_EVENT_CONFIRMED, track);
+    }
+  }
+
+  void pushEvent(TrackEventType type, const Track& track) {
+    if (_eventCount == TRACKER_EVENT_QUEUE) {
+      _droppedEvents++;
+      return;
+    }
+    TrackEvent& event = _events[(_eventHead + _eventCount) % TRACKER_EVENT_QUEUE];
+    event.type = type;
+    event.track = track;
+    _eventCount++;
+  }
+
+  Track _tracks[TRACKER_MAX_TRACKS];
+  uint16_t _nextId;
+
+  TrackEvent _events[TRACKER_EVENT_QUEUE];
+  uint8_t _eventHead;
+  uint8_t _eventCount;
+  uint32_t _droppedEvents;
+};
+
+#endif  // DETECTION_TRACKER_H
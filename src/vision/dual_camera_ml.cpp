@@ -4,7 +4,7 @@
  * Complete production-ready implementation with:
  * - I2C multiplexer (TCA9548A) control for dual cameras
  * - TensorFlow Lite Micro integration
- * - Model loading and initialization
+ * - Multi-model registry (one interpreter per resident model)
  * - Camera switching logic
  * - Image capture from both cameras
  * - Preprocessing pipeline
@@ -12,18 +12,21 @@
  * - Post-processing (NMS, thresholding)
  * - Detection buffering
  * - Performance profiling
+ * - Pipelined capture/inference (DCMI DMA) with target-FPS scheduling
+ * - Motion-gated inference on a region of interest
  *
  * Board: Arduino Nicla Vision (x2)
  * Communication: I2C via TCA9548A multiplexer
  * ML Framework: TensorFlow Lite for Microcontrollers
  *
  * Memory Requirements:
- * - Tensor Arena: 500KB
+ * - Tensor Arena: sum of the scheduled models' arenas (see model_ops.h)
  * - Frame Buffers: 320x240x2x2 = 307KB (2 cameras)
  * - Detection Buffer: Configurable (default: 10 entries)
  */
 
 #include <Arduino.h>
+#include <new>
 #include <Wire.h>
 #include <Arduino_OV5640.h>
 #include <TensorFlowLite.h>
@@ -32,12 +35,22 @@
 // TENSORFLOW LITE MICRO HEADERS
 // ===========================================
 
-#include <tensorflow/lite/micro/all_ops_resolver.h>
+#include <tensorflow/lite/micro/micro_mutable_op_resolver.h>
 #include <tensorflow/lite/micro/micro_error_reporter.h>
 #include <tensorflow/lite/micro/micro_interpreter.h>
 #include <tensorflow/lite/schema/schema_generated.h>
+#include <tensorflow/lite/schema/schema_utils.h>
 #include <tensorflow/lite/version.h>
 
+#include "image_preprocessing.h"
+#include "detection_postprocess.h"
+#include "detection_tracker.h"
+#include "motion_gate.h"
+#include "tile_scheduler.h"
+#include "memory_map.h"
+#include "model_ops.h"
+#include "../lorawan/trace.h"
+
 // ===========================================
 // I2C MULTIPLEXER CONFIGURATION
 // ===========================================
@@ -62,6 +75,78 @@
 
 #define FRAME_BUFFER_SIZE (CAMERA_WIDTH * CAMERA_HEIGHT * 2)  // RGB565
 
+// ===========================================
+// PIPELINE CONFIGURATION
+// ===========================================
+
+// Overlap capture and inference: while one camera's frame is being
+// preprocessed and run through the model, the DCMI DMA fills the other
+// camera's frame buffer. Set to 0 for the sequential capture-then-infer path.
+#ifndef PIPELINE_ENABLED
+#define PIPELINE_ENABLED 1
+#endif
+
+// Sequential mode captures and processes one camera at a time, so both
+// cameras can share one frame buffer (saves FRAME_BUFFER_SIZE of SRAM)
+#ifndef FRAME_BUFFER_SHARED
+#define FRAME_BUFFER_SHARED (PIPELINE_ENABLED ? 0 : 1)
+#endif
+
+#if FRAME_BUFFER_SHARED && PIPELINE_ENABLED
+#error "FRAME_BUFFER_SHARED requires PIPELINE_ENABLED 0"
+#endif
+
+#define FRAME_BUFFER_COUNT (FRAME_BUFFER_SHARED ? 1 : 2)
+
+// Combined frame rate across both cameras (frames per second)
+#define TARGET_FPS 10
+#define FRAME_INTERVAL_US (1000000UL / TARGET_FPS)
+
+// Maximum time to wait for a frame-ready event
+#define FRAME_READY_TIMEOUT_MS 200
+
+// ===========================================
+// MOTION GATING
+// ===========================================
+
+// Skip Invoke() on static frames; when there is motion, the model sees a
+// crop around the moving blocks instead of the full frame
+#ifndef MOTION_GATE_ENABLED
+#define MOTION_GATE_ENABLED 1
+#endif
+
+#define MOTION_BLOCK_THRESHOLD 12      // Luma change per 16x16 block
+#define MOTION_MIN_BLOCKS 2            // Moving blocks needed to infer
+#define MOTION_LEARN_SHIFT 3           // Background adapts at 1/8 per frame
+#define MOTION_ROI_MARGIN 16           // Pixels around the motion box
+#define MOTION_MIN_ROI 96              // Smallest crop edge (model input size)
+#define MOTION_MAX_SKIPPED_FRAMES 50   // Force a full-frame check per camera
+
+// ===========================================
+// TILING
+// ===========================================
+
+// Fine-scale pass for small, distant objects (tile_scheduler.h): next to
+// the coarse pass (full frame or motion ROI resized to the model input),
+// up to TILING_MAX_TILES_PER_FRAME overlapping tiles at model resolution
+// are run around recent motion and small tracked objects
+#ifndef TILING_ENABLED
+#define TILING_ENABLED 0
+#endif
+
+#define TILE_WIDTH MODEL_INPUT_WIDTH      // 1:1 source pixels
+#define TILE_HEIGHT MODEL_INPUT_HEIGHT
+#define TILE_OVERLAP 24                   // Objects up to this size are whole in some tile
+#define TILING_MAX_TILES_PER_FRAME 2      // Worst case per frame: 1 + 2 Invoke()
+#define TILING_COARSE_SCALE 2             // No tiles when the coarse crop is within 2x of a tile
+
+#if PIPELINE_ENABLED
+#include "stm32h7xx_hal.h"
+
+// DCMI handle owned by the board camera driver
+extern DCMI_HandleTypeDef hdcmi;
+#endif
+
 // ===========================================
 // ML MODEL CONFIGURATION
 // ===========================================
@@ -71,6 +156,15 @@
 #define MODEL_INPUT_HEIGHT 96
 #define MODEL_INPUT_CHANNELS 3  // RGB
 
+// Input normalization: real = (pixel - MEAN) / STD, then quantized with the
+// input tensor's scale/zero_point during preprocessing
+#define MODEL_INPUT_MEAN 0.0f
+#define MODEL_INPUT_STD 255.0f
+
+// Resampling used by the preprocessing kernel
+// (RESIZE_NEAREST, RESIZE_BILINEAR or RESIZE_AREA)
+#define PREPROCESS_RESIZE_MODE RESIZE_NEAREST
+
 // Detection thresholds
 #define DETECTION_THRESHOLD 0.5f  // 50% confidence minimum
 #define CONFIDENCE_THRESHOLD 0.6f  // 60% for alarm trigger
@@ -85,6 +179,33 @@
 // Maximum number of detections per inference
 #define MAX_DETECTIONS_PER_INFERENCE 10
 
+// Tracking (detection_tracker.h): inference runs on every Nth frame per
+// camera while it has tracks, which coast on their velocity in between
+#define TRACKER_INFERENCE_STRIDE 1
+#define TRACKER_VERIFY_MS 1000     // Confirmed track unseen this long: infer even if nothing moved
+#define TRACKER_MAX_AGE_MS 5000    // Tracks unseen this long are dropped
+#define CROWD_TRACKS 3  // Confirmed tracks on one camera that raise the alarm
+
+// Output decoders for multi-object models (selected per model from its
+// output tensors, see detectOutputDecoder())
+enum OutputDecoder {
+  DECODER_CLASSIFICATION,   // [1, classes] -> one full-frame detection
+  DECODER_SSD_POSTPROCESS,  // TFLite_Detection_PostProcess (4 outputs)
+  DECODER_SSD_ANCHORS,      // Raw box encodings + class scores
+  DECODER_YOLO_GRID         // [1, H, W, anchors * (5 + classes)]
+};
+
+// SSD box coder scales (TF Object Detection API defaults)
+#define SSD_Y_SCALE 10.0f
+#define SSD_X_SCALE 10.0f
+#define SSD_H_SCALE 5.0f
+#define SSD_W_SCALE 5.0f
+
+// YOLO anchors (width, height) normalised to the model input; replace with
+// the anchors your model was trained with
+#define YOLO_NUM_ANCHORS 3
+#define YOLO_OUTPUTS_ACTIVATED false  // true if the export applies sigmoid
+
 // Class names
 const char* classNames[NUM_CLASSES] = {
   "Person",
@@ -100,6 +221,36 @@ enum ModelType {
   MODEL_TYPE_CUSTOM
 };
 
+#define NUM_MODEL_SLOTS (MODEL_TYPE_CUSTOM + 1)
+
+// Model run on each camera, e.g. person on the footpath camera and vehicle
+// on the gate lane camera. Every scheduled model stays resident.
+#ifndef CAMERA_1_MODEL
+#define CAMERA_1_MODEL MODEL_TYPE_PERSON_DETECTION
+#endif
+#ifndef CAMERA_2_MODEL
+#define CAMERA_2_MODEL MODEL_TYPE_PERSON_DETECTION
+#endif
+
+// Model slots that get an arena partition (bit per ModelType). Only the
+// scheduled models by default; add a bit to switch to another model at
+// runtime, at the cost of its partition.
+#ifndef RESIDENT_MODEL_MASK
+#define RESIDENT_MODEL_MASK ((1u << CAMERA_1_MODEL) | (1u << CAMERA_2_MODEL))
+#endif
+
+// A generated partition may exceed the model's measured arena_used_bytes()
+// by this much (planner estimate plus headroom); more means model_ops.h
+// was generated from a different model
+#ifndef MODEL_ARENA_TOLERANCE_PERCENT
+#define MODEL_ARENA_TOLERANCE_PERCENT 25
+#endif
+
+// Arena reserved for loadCustomModel() (0 = custom models disabled)
+#ifndef CUSTOM_MODEL_ARENA_SIZE
+#define CUSTOM_MODEL_ARENA_SIZE 0
+#endif
+
 // Model metadata
 struct ModelMetadata {
   const char* name;
@@ -163,54 +314,6 @@ struct DetectionResult {
   bool isValid() const {
     return valid && confidence >= DETECTION_THRESHOLD;
   }
-
-  // Check if detection should trigger alarm
-  bool shouldAlarm() const {
-    return valid && confidence >= CONFIDENCE_THRESHOLD;
-  }
-};
-
-// ===========================================
-// DETECTION BUFFER
-// ===========================================
-
-#define DETECTION_BUFFER_SIZE 10
-
-struct DetectionBuffer {
-  DetectionResult detections[DETECTION_BUFFER_SIZE];
-  uint8_t head;
-  uint8_t tail;
-  uint8_t count;
-
-  DetectionBuffer() : head(0), tail(0), count(0) {}
-
-  void add(const DetectionResult& result) {
-    if (count < DETECTION_BUFFER_SIZE) {
-      detections[head] = result;
-      head = (head + 1) % DETECTION_BUFFER_SIZE;
-      count++;
-    } else {
-      // Buffer full, overwrite oldest
-      detections[tail] = result;
-      tail = (tail + 1) % DETECTION_BUFFER_SIZE;
-    }
-  }
-
-  DetectionResult* getLatest(uint8_t n) {
-    if (n >= count) return nullptr;
-    int8_t idx = (head - n - 1 + DETECTION_BUFFER_SIZE) % DETECTION_BUFFER_SIZE;
-    return &detections[idx];
-  }
-
-  void clear() {
-    head = 0;
-    tail = 0;
-    count = 0;
-  }
-
-  uint8_t size() const {
-    return count;
-  }
 };
 
 // ===========================================
@@ -226,13 +329,17 @@ struct PerformanceMetrics {
   uint32_t failedCaptures;
   uint32_t totalPreprocessingTimeUs;
   uint32_t totalPostprocessingTimeUs;
+  uint32_t skippedInferences;
+  uint32_t tileInferences;
 
   PerformanceMetrics() : totalInferences(0), totalInferenceTimeUs(0),
                          minInferenceTimeUs(0xFFFFFFFF), maxInferenceTimeUs(0),
                          totalCaptures(0), failedCaptures(0),
-                         totalPreprocessingTimeUs(0), totalPostprocessingTimeUs(0) {}
+                         totalPreprocessingTimeUs(0), totalPostprocessingTimeUs(0),
+                         skippedInferences(0), tileInferences(0) {}
 
   void recordInference(uint32_t timeUs) {
+    TRACE_RECORD(TRACE_INVOKE, timeUs);
     totalInferences++;
     totalInferenceTimeUs += timeUs;
     if (timeUs < minInferenceTimeUs) minInferenceTimeUs = timeUs;
@@ -245,13 +352,29 @@ struct PerformanceMetrics {
   }
 
   void recordPreprocessing(uint32_t timeUs) {
+    TRACE_RECORD(TRACE_PREPROCESS, timeUs);
     totalPreprocessingTimeUs += timeUs;
   }
 
   void recordPostprocessing(uint32_t timeUs) {
+    TRACE_RECORD(TRACE_POSTPROCESS, timeUs);
     totalPostprocessingTimeUs += timeUs;
   }
 
+  void recordSkippedInference() {
+    skippedInferences++;
+  }
+
+  // Extra Invoke() on a tile (also counted in totalInferences)
+  void recordTileInference() {
+    tileInferences++;
+  }
+
+  float getSkipRate() const {
+    uint32_t frames = totalInferences - tileInferences + skippedInferences;
+    return frames > 0 ? (float)skippedInferences / frames : 0.0f;
+  }
+
   float getAverageInferenceTime() const {
     return totalInferences > 0 ? (float)totalInferenceTimeUs / totalInferences : 0.0f;
   }
@@ -263,13 +386,22 @@ struct PerformanceMetrics {
   void print() const {
     Serial.println("=== Performance Metrics ===");
     Serial.print("Total Inferences: "); Serial.println(totalInferences);
+    Serial.print("Skipped Inferences: "); Serial.print(skippedInferences);
+    Serial.print(" ("); Serial.print(getSkipRate() * 100); Serial.println("%)");
+    Serial.print("Tile Inferences: "); Serial.println(tileInferences);
     Serial.print("Avg Inference Time: "); Serial.print(getAverageInferenceTime() / 1000.0); Serial.println(" ms");
     Serial.print("Min Inference Time: "); Serial.print(minInferenceTimeUs / 1000.0); Serial.println(" ms");
     Serial.print("Max Inference Time: "); Serial.print(maxInferenceTimeUs / 1000.0); Serial.println(" ms");
     Serial.print("Total Captures: "); Serial.println(totalCaptures);
     Serial.print("Capture Success Rate: "); Serial.print(getCaptureSuccessRate() * 100); Serial.println("%");
-    Serial.print("Avg Preprocessing Time: "); Serial.print(totalPreprocessingTimeUs / (float)totalInferences / 1000.0); Serial.println(" ms");
-    Serial.print("Avg Postprocessing Time: "); Serial.print(totalPostprocessingTimeUs / (float)totalInferences / 1000.0); Serial.println(" ms");
+    if (totalInferences > 0) {
+      Serial.print("Avg Preprocessing Time: "); Serial.print(totalPreprocessingTimeUs / (float)totalInferences / 1000.0); Serial.println(" ms");
+      Serial.print("Avg Postprocessing Time: "); Serial.print(totalPostprocessingTimeUs / (float)totalInferences / 1000.0); Serial.println(" ms");
+    }
+#if TRACE_LEVEL > 0
+    Serial.println("--- Frame spans (us) ---");
+    tracer().printSummary(Serial);
+#endif
     Serial.println("===========================");
   }
 };
@@ -282,54 +414,226 @@ struct PerformanceMetrics {
 #define ALARM_LED_PIN LED_BUILTIN
 #define ALARM_BUZZER_PIN 2
 
-// Alarm duration
+// Alarm held after the last alarming track is lost
 #define ALARM_DURATION_MS 5000  // 5 seconds
 
+enum AlarmState {
+  ALARM_IDLE,
+  ALARM_ACTIVE,   // An alarming track (or a crowd) is in view
+  ALARM_HOLD      // Condition cleared, indicators held for ALARM_DURATION_MS
+};
+
 // ===========================================
 // GLOBAL VARIABLES
 // ===========================================
 
-// Frame buffers for both cameras
-uint8_t frameBuffer1[FRAME_BUFFER_SIZE];
-uint8_t frameBuffer2[FRAME_BUFFER_SIZE];
+// Frame buffers for both cameras (cache-line aligned for D-cache
+// maintenance after DMA transfers; placed by memory_map.h)
+static_assert(FRAME_BUFFER_SIZE % MEMORY_CACHE_LINE == 0, "Frame buffer must be whole cache lines");
+
+DMA_BUFFER(FRAME_BUFFER_REGION) uint8_t frameBuffer1[FRAME_BUFFER_SIZE];
+#if FRAME_BUFFER_SHARED
+uint8_t* const frameBuffer2 = frameBuffer1;
+#else
+DMA_BUFFER(FRAME_BUFFER_REGION) uint8_t frameBuffer2[FRAME_BUFFER_SIZE];
+#endif
 
-// Preprocessing buffer (resized image for model input)
-uint8_t preprocessingBuffer[MODEL_INPUT_WIDTH * MODEL_INPUT_HEIGHT * MODEL_INPUT_CHANNELS];
+// Resize lookup table (rebuilt only when the geometry changes; read per
+// output pixel, so kept in DTCM when sections are enabled)
+MEMORY_PLACE(HOT_DATA_REGION) ResizeLUT preprocessLUT;
 
-// Current active camera
+// Current active camera (selected on the I2C multiplexer)
 uint8_t activeCamera = CAMERA_1_ID;
 
+// Camera whose frame is currently being run through the model. Differs from
+// activeCamera while the pipeline captures the other camera in the background.
+uint8_t inferenceCamera = CAMERA_1_ID;
+
+// Part of the frame fed to the model (full frame, or the motion ROI).
+// Detections are mapped back through it into camera-frame pixels.
+DetectionFrame inputRegion = {0, 0, CAMERA_WIDTH, CAMERA_HEIGHT};
+
+// Per-camera background models for the motion gate
+MEMORY_PLACE(HOT_DATA_REGION) MotionGate motionGates[2];
+
+#if TILING_ENABLED
+// Per-camera fine-scale tile layout and priorities
+TileScheduler tileSchedulers[2];
+#endif
+
+const MotionGateConfig motionConfig = {
+  MOTION_BLOCK_THRESHOLD,
+  MOTION_MIN_BLOCKS,
+  MOTION_LEARN_SHIFT,
+  MOTION_ROI_MARGIN,
+  MOTION_MIN_ROI,
+  MOTION_MAX_SKIPPED_FRAMES
+};
+
 // Detection results
 DetectionResult lastDetection1;
 DetectionResult lastDetection2;
 
-// Detection buffers for both cameras
-DetectionBuffer detectionBuffer1;
-DetectionBuffer detectionBuffer2;
+// Object tracks for both cameras
+DetectionTracker tracker1;
+DetectionTracker tracker2;
+uint8_t trackerFrame[2] = {0, 0};  // Frames since the last inference
 
 // Alarm state
-bool alarmActive = false;
-unsigned long alarmStartTime = 0;
+AlarmState alarmState = ALARM_IDLE;
+unsigned long alarmHoldStart = 0;
+uint32_t alarmCount = 0;
 
-// Detection statistics
+// Detection statistics (one per confirmed track)
 uint32_t totalDetections = 0;
 uint32_t detectionCounts[NUM_CLASSES] = {0};
+float detectionConfidenceSum = 0.0f;
 
 // Performance metrics
 PerformanceMetrics metrics;
 
+// ===========================================
+// CAPTURE PIPELINE STATE
+// ===========================================
+
+// Per-camera pipeline slot
+struct CameraSlot {
+  uint8_t cameraId;
+  uint8_t* frameBuffer;
+  DetectionResult* result;
+  DetectionTracker* tracker;
+};
+
+CameraSlot cameraSlots[2] = {
+  {CAMERA_1_ID, frameBuffer1, &lastDetection1, &tracker1},
+  {CAMERA_2_ID, frameBuffer2, &lastDetection2, &tracker2}
+};
+
+#define NO_CAPTURE_IN_FLIGHT -1
+
+// Set from the DCMI frame interrupt when the DMA transfer has completed
+volatile bool frameReady = false;
+
+// Slot being filled by the DMA, or NO_CAPTURE_IN_FLIGHT
+int8_t captureSlot = NO_CAPTURE_IN_FLIGHT;
+unsigned long captureStartTime = 0;
+
+// Next slot to process when running sequentially
+uint8_t sequentialSlot = 0;
+
+// Target-FPS scheduler deadline (micros)
+unsigned long nextFrameTime = 0;
+
 // ===========================================
 // TENSORFLOW LITE MICRO SETUP
 // ===========================================
 
 // TFLite globals
 tflite::ErrorReporter* error_reporter = nullptr;
+
+// Active model (aliases into the registry, switched in O(1))
 const tflite::Model* model = nullptr;
 tflite::MicroInterpreter* interpreter = nullptr;
 
-// Tensor arena
-constexpr int kTensorArenaSize = 500 * 1024;
-uint8_t tensor_arena[kTensorArenaSize];
+// Partition of one model slot: its generated size (16-byte aligned) if
+// RESIDENT_MODEL_MASK selects it, otherwise none
+#define MODEL_SLOT_ARENA(type, size) \
+  ((RESIDENT_MODEL_MASK & (1u << (type))) ? (((uint32_t)(size) + 15) & ~15u) : 0u)
+
+// Arena partition of each model slot (indexed by ModelType)
+constexpr uint32_t modelArenaSize[NUM_MODEL_SLOTS] = {
+  MODEL_SLOT_ARENA(MODEL_TYPE_PERSON_DETECTION, MODEL_ARENA_SIZE_PERSON_DETECTION),
+  MODEL_SLOT_ARENA(MODEL_TYPE_VEHICLE_DETECTION, MODEL_ARENA_SIZE_VEHICLE_DETECTION),
+  MODEL_SLOT_ARENA(MODEL_TYPE_ANIMAL_DETECTION, MODEL_ARENA_SIZE_ANIMAL_DETECTION),
+  ((uint32_t)CUSTOM_MODEL_ARENA_SIZE + 15) & ~15u
+};
+
+// Tensor arena shared by the resident models. Each model owns a fixed
+// partition sized by generate_op_resolver.py, so every interpreter keeps
+// its allocations and switching never re-runs AllocateTensors().
+constexpr uint32_t kTensorArenaSize =
+  modelArenaSize[MODEL_TYPE_PERSON_DETECTION] + modelArenaSize[MODEL_TYPE_VEHICLE_DETECTION] +
+  modelArenaSize[MODEL_TYPE_ANIMAL_DETECTION] + modelArenaSize[MODEL_TYPE_CUSTOM];
+MEMORY_PLACE(TENSOR_ARENA_REGION) alignas(16) uint8_t tensor_arena[kTensorArenaSize];
+
+// Frame buffers and the arena both default to AXI SRAM (.bss is there too)
+constexpr uint32_t kAxiSramStaticBytes =
+  ((FRAME_BUFFER_REGION == MEMORY_REGION_AXI_SRAM || FRAME_BUFFER_REGION == MEMORY_REGION_DEFAULT)
+     ? FRAME_BUFFER_SIZE * FRAME_BUFFER_COUNT : 0) +
+  ((TENSOR_ARENA_REGION == MEMORY_REGION_AXI_SRAM || TENSOR_ARENA_REGION == MEMORY_REGION_DEFAULT)
+     ? kTensorArenaSize : 0);
+static_assert(kAxiSramStaticBytes <= memoryRegionSize(MEMORY_REGION_AXI_SRAM),
+              "Frame buffers + tensor arena exceed AXI SRAM: trim RESIDENT_MODEL_MASK or move a buffer");
+
+// Only the operators the models use (see model_ops.h)
+ModelOpResolver opResolver;
+
+// ===========================================
+// MODEL REGISTRY
+// ===========================================
+
+// A model with its own interpreter, arena partition and input encoding
+struct ResidentModel {
+  ModelMetadata info;
+  const tflite::Model* model;
+  tflite::MicroInterpreter* interpreter;
+  uint8_t* arena;
+  uint32_t arenaSize;
+
+  // Pixel -> input tensor encoding. Preprocessing writes straight into
+  // the input tensor, so no separate RGB888 buffer is needed.
+  InputQuantization inputQuant;
+
+  // How the output tensors are turned into detections
+  OutputDecoder decoder;
+  bool decodeErrorReported;     // Runtime decode failures are logged once
+
+  bool resident;
+};
+
+ResidentModel modelRegistry[NUM_MODEL_SLOTS];
+
+// Interpreters are constructed in place, one per slot
+alignas(tflite::MicroInterpreter)
+uint8_t interpreterStorage[NUM_MODEL_SLOTS][sizeof(tflite::MicroInterpreter)];
+
+// Model currently bound to `interpreter`
+ResidentModel* activeModel = nullptr;
+
+// Per-camera model schedule (indexed by camera ID)
+ModelType cameraModel[2] = {CAMERA_1_MODEL, CAMERA_2_MODEL};
+
+// ===========================================
+// DETECTION DECODING
+// ===========================================
+
+// Anchor tables generated with the model, e.g. from the TF Object
+// Detection API anchor generator or the YOLO export, passed as
+// -DMODEL_ANCHORS_FILE='"model_anchors.h"'. The file defines
+// SSD_ANCHOR_TABLE (SsdAnchor initializers, one per box encoding) and/or
+// YOLO_ANCHOR_TABLE (YOLO_NUM_ANCHORS normalized width, height pairs).
+// Without a table, models needing it are rejected at registerModel();
+// TFLite_Detection_PostProcess and classification models need none.
+#ifdef MODEL_ANCHORS_FILE
+#include MODEL_ANCHORS_FILE
+#endif
+
+#ifdef SSD_ANCHOR_TABLE
+const SsdAnchor ssdAnchors[] = { SSD_ANCHOR_TABLE };
+const uint16_t ssdAnchorCount = sizeof(ssdAnchors) / sizeof(ssdAnchors[0]);
+#else
+const SsdAnchor* const ssdAnchors = nullptr;
+const uint16_t ssdAnchorCount = 0;
+#endif
+
+#ifdef YOLO_ANCHOR_TABLE
+const float yoloAnchors[YOLO_NUM_ANCHORS * 2] = { YOLO_ANCHOR_TABLE };
+#else
+const float* const yoloAnchors = nullptr;
+#endif
+
+// Candidate pool shared by all decoders (one frame at a time)
+DetectionCandidates detectionCandidates;
 
 // Current model metadata
 ModelMetadata currentModel = {
@@ -345,9 +649,6 @@ ModelMetadata currentModel = {
   true                  // quantized
 };
 
-// Model loaded flag
-bool modelLoaded = false;
-
 // ===========================================
 // FUNCTION PROTOTYPES
 // ===========================================
@@ -363,14 +664,16 @@ bool initializeBothCameras();
 
 // Image capture
 bool captureImage(uint8_t cameraId, uint8_t* buffer);
+bool startFrameCapture(uint8_t slot);
+bool waitForFrame(uint32_t timeoutMs);
+void abortFrameCapture();
 
 // Image preprocessing
-void preprocessImage(uint8_t* src, int srcWidth, int srcHeight,
-                     uint8_t* dst, int dstWidth, int dstHeight);
-void resizeImageNearestNeighbor(uint8_t* src, int srcWidth, int srcHeight,
-                                uint8_t* dst, int dstWidth, int dstHeight);
+bool preprocessImage(uint8_t* src, int srcWidth, int srcHeight, TfLiteTensor* input);
+bool configureInputQuantization(TfLiteTensor* input, InputQuantization& quant);
+bool validateModel(const tflite::Model* mapped);
+bool modelMatchesKernels(const tflite::Model* mapped);
 void convertRGB565toRGB888(uint8_t* src, uint8_t* dst, int pixelCount);
-void normalizeImage(uint8_t* image, int width, int height, int channels);
 
 // ML model initialization and loading
 bool initializeMLModel();
@@ -378,6 +681,11 @@ bool loadModel(ModelMetadata& modelInfo);
 bool loadModelFromData(uint8_t* modelData, uint32_t modelSize, ModelMetadata& modelInfo);
 void unloadModel();
 bool isModelLoaded();
+bool initializeModelRegistry();
+void printModelMacroName(const char* name);
+bool registerModel(const ModelMetadata& modelInfo);
+bool activateModel(ModelType modelType);
+void evictModel(ModelType modelType);
 
 // Inference
 void runInference(uint8_t* imageData, DetectionResult* result);
@@ -387,16 +695,32 @@ void runInferenceMultiple(uint8_t* imageData, DetectionResult* results, uint8_t*
 void applyNonMaximumSuppression(DetectionResult* detections, uint8_t* numDetections);
 void filterByConfidence(DetectionResult* detections, uint8_t* numDetections, float threshold);
 void extractBoundingBoxes(TfLiteTensor* output, DetectionResult* results, uint8_t* numDetections);
+bool inferRegion(uint8_t* imageData, const DetectionFrame& region);
+bool decodeDetections(TfLiteTensor* output, const DetectionFrame& frame);
+uint8_t collectDetections(DetectionResult* results);
+bool extractClassification(TfLiteTensor* output, const DetectionFrame& frame);
+OutputDecoder detectOutputDecoder(tflite::MicroInterpreter* modelInterpreter);
+bool decoderSupported(tflite::MicroInterpreter* modelInterpreter, OutputDecoder decoder);
+bool makeTensorView(const TfLiteTensor* tensor, TensorView& view);
 
 // Detection processing
 void processDetections();
-void processCamera(uint8_t cameraId, uint8_t* frameBuffer, DetectionResult& result, DetectionBuffer& buffer);
-bool shouldTriggerAlarm(const DetectionResult& result);
+void processDetectionsPipelined();
+void processCamera(uint8_t cameraId, uint8_t* frameBuffer, DetectionResult& result, DetectionTracker& tracker);
+void processCapturedFrame(uint8_t cameraId, uint8_t* frameBuffer, DetectionResult& result, DetectionTracker& tracker);
+uint8_t scheduleTiles(uint8_t cameraId, const DetectionTracker& tracker, uint8_t* tiles);
+void trackDetections(uint8_t cameraId, DetectionTracker& tracker,
+                     const DetectionResult* detections, uint8_t numDetections);
+void handleTrackEvents(uint8_t cameraId, DetectionTracker& tracker);
+bool frameDue();
+bool isAlarmTrack(const Track& track);
+bool alarmCondition();
 void triggerAlarm();
 void updateAlarm();
 
 // Model management
 void switchModel(ModelType modelType);
+void setCameraModel(uint8_t cameraId, ModelType modelType);
 bool loadPersonDetectionModel();
 bool loadVehicleDetectionModel();
 bool loadAnimalDetectionModel();
@@ -404,8 +728,11 @@ bool loadCustomModel(uint8_t* modelData, uint32_t modelSize, const char* name);
 
 // Utility functions
 void printDetectionResult(const DetectionResult& result);
+void printTrackEvent(uint8_t cameraId, const TrackEvent& event);
 void printModelInfo(const ModelMetadata& modelInfo);
-void printMemoryUsage();
+bool printMemoryUsage();
+void printMemoryPlacement(const char* name, const void* buffer, uint32_t size);
+bool checkMemoryMap();
 float getAverageConfidence();
 void resetStatistics();
 
@@ -543,93 +870,210 @@ bool captureImage(uint8_t cameraId, uint8_t* buffer) {
   return true;
 }
 
+#if PIPELINE_ENABLED
+/**
+ * DCMI frame-event interrupt: the DMA has written a complete frame
+ */
+extern "C" void HAL_DCMI_FrameEventCallback(DCMI_HandleTypeDef* handle) {
+  (void)handle;
+  frameReady = true;
+}
+#endif
+
+/**
+ * Start a non-blocking capture into the slot's frame buffer.
+ * In pipelined mode the DCMI DMA runs in snapshot mode and signals
+ * completion through frameReady; otherwise the capture blocks.
+ */
+bool startFrameCapture(uint8_t slot) {
+  CameraSlot& target = cameraSlots[slot];
+
+  switchToCamera(target.cameraId);
+  frameReady = false;
+  captureStartTime = millis();
+
+#if PIPELINE_ENABLED
+  // Snapshot mode waits for the next VSYNC, so the buffer always receives a
+  // whole frame. Length is in 32-bit words.
+  if (HAL_DCMI_Start_DMA(&hdcmi, DCMI_MODE_SNAPSHOT,
+                         (uint32_t)target.frameBuffer,
+                         FRAME_BUFFER_SIZE / 4) != HAL_OK) {
+    handleCameraError(target.cameraId, "DMA start failed");
+    return false;
+  }
+#else
+  Camera.readFrame(target.frameBuffer);
+  frameReady = true;
+#endif
+
+  captureSlot = slot;
+  return true;
+}
+
+/**
+ * Wait for the capture in flight to complete
+ */
+bool waitForFrame(uint32_t timeoutMs) {
+  while (!frameReady) {
+    if (millis() - captureStartTime >= timeoutMs) {
+      return false;
+    }
+  }
+
+#if PIPELINE_ENABLED
+  // The DMA wrote behind the D-cache; drop stale lines before reading
+  SCB_InvalidateDCache_by_Addr((uint32_t*)cameraSlots[captureSlot].frameBuffer,
+                               FRAME_BUFFER_SIZE);
+#endif
+
+  return true;
+}
+
+/**
+ * Abort the capture in flight (e.g. after a timeout)
+ */
+void abortFrameCapture() {
+#if PIPELINE_ENABLED
+  HAL_DCMI_Stop(&hdcmi);
+#endif
+  frameReady = false;
+  captureSlot = NO_CAPTURE_IN_FLIGHT;
+}
+
 // ===========================================
 // IMAGE PREPROCESSING
 // ===========================================
 
 /**
- * Complete preprocessing pipeline:
- * 1. Resize image (320x240 -> 96x96)
+ * Complete preprocessing pipeline, in a single pass over the output:
+ * 1. Resize inputRegion of the image (full 320x240 frame or the motion
+ *    ROI -> model input) via the shared LUT kernel
  * 2. Convert RGB565 to RGB888
- * 3. Normalize pixel values (if needed)
+ * 3. Normalize/quantize each byte for the input tensor
+ * The result is written directly into the input tensor's memory.
  */
-void preprocessImage(uint8_t* src, int srcWidth, int srcHeight,
-                     uint8_t* dst, int dstWidth, int dstHeight) {
-  unsigned long startTime = micros();
+bool preprocessImage(uint8_t* src, int srcWidth, int srcHeight, TfLiteTensor* input) {
+  unsigned long startTime = tracer().nowUs();
 
-  // Step 1: Resize + Color space conversion
-  resizeImageNearestNeighbor(src, srcWidth, srcHeight, dst, dstWidth, dstHeight);
+  // NHWC input: [1, height, width, channels]
+  if (input->dims->size != 4 || input->dims->data[3] != MODEL_INPUT_CHANNELS) {
+    handleMLError("Unsupported input tensor shape");
+    return false;
+  }
+  int dstHeight = input->dims->data[1];
+  int dstWidth = input->dims->data[2];
+
+  if (inputRegion.x + inputRegion.width > srcWidth ||
+      inputRegion.y + inputRegion.height > srcHeight ||
+      !buildResizeLUT(preprocessLUT, srcWidth, inputRegion.x, inputRegion.y,
+                      inputRegion.width, inputRegion.height,
+                      dstWidth, dstHeight, PREPROCESS_RESIZE_MODE)) {
+    handleMLError("Unsupported preprocessing geometry");
+    return false;
+  }
 
-  // Step 2: Normalize (if using float model)
-  // For quantized models, normalization is handled in the model
-  // if (!currentModel.quantized) {
-  //   normalizeImage(dst, dstWidth, dstHeight, MODEL_INPUT_CHANNELS);
-  // }
+  bool success = resizeRGB565toTensor(src, input->data.data, preprocessLUT,
+                                      activeModel->inputQuant);
 
-  unsigned long endTime = micros();
+  unsigned long endTime = tracer().nowUs();
   metrics.recordPreprocessing(endTime - startTime);
+
+  return success;
 }
 
 /**
- * Resize image using nearest neighbor interpolation
- * Simultaneously converts RGB565 to RGB888
+ * Derive the pixel encoding from the model's input tensor
  */
-void resizeImageNearestNeighbor(uint8_t* src, int srcWidth, int srcHeight,
-                                uint8_t* dst, int dstWidth, int dstHeight) {
-  float xRatio = (float)srcWidth / dstWidth;
-  float yRatio = (float)srcHeight / dstHeight;
-
-  for (int y = 0; y < dstHeight; y++) {
-    for (int x = 0; x < dstWidth; x++) {
-      // Calculate source position
-      int srcX = (int)(x * xRatio);
-      int srcY = (int)(y * yRatio);
-
-      // Ensure within bounds
-      srcX = min(srcX, srcWidth - 1);
-      srcY = min(srcY, srcHeight - 1);
-
-      // Calculate indices
-      int srcIdx = (srcY * srcWidth + srcX) * 2;  // RGB565 = 2 bytes
-      int dstIdx = (y * dstWidth + x) * 3;       // RGB888 = 3 bytes
-
-      // Convert RGB565 to RGB888
-      uint16_t pixel = *((uint16_t*)&src[srcIdx]);
-      uint8_t r = ((pixel >> 11) & 0x1F) << 3;      // 5 bits -> 8 bits
-      uint8_t g = ((pixel >> 5) & 0x3F) << 2;       // 6 bits -> 8 bits
-      uint8_t b = (pixel & 0x1F) << 3;              // 5 bits -> 8 bits
-
-      dst[dstIdx] = r;
-      dst[dstIdx + 1] = g;
-      dst[dstIdx + 2] = b;
-    }
+bool configureInputQuantization(TfLiteTensor* input, InputQuantization& quant) {
+  InputFormat format;
+
+  switch (input->type) {
+    case kTfLiteUInt8:
+      format = INPUT_FORMAT_UINT8;
+      break;
+    case kTfLiteInt8:
+      format = INPUT_FORMAT_INT8;
+      break;
+    case kTfLiteFloat32:
+      format = INPUT_FORMAT_FLOAT32;
+      break;
+    default:
+      return false;
   }
+
+  return buildInputQuantization(quant, format,
+                                input->params.scale, input->params.zero_point,
+                                MODEL_INPUT_MEAN, MODEL_INPUT_STD);
 }
 
 /**
- * Convert RGB565 buffer to RGB888
+ * With int8-only kernels (MODEL_OPS_INT8 in model_ops.h), every input and
+ * output tensor must be int8. Read from the flatbuffer, before any arena
+ * is touched.
  */
-void convertRGB565toRGB888(uint8_t* src, uint8_t* dst, int pixelCount) {
-  for (int i = 0; i < pixelCount; i++) {
-    uint16_t pixel = *((uint16_t*)&src[i * 2]);
-    dst[i * 3] = ((pixel >> 11) & 0x1F) << 3;
-    dst[i * 3 + 1] = ((pixel >> 5) & 0x3F) << 2;
-    dst[i * 3 + 2] = (pixel & 0x1F) << 3;
+bool modelMatchesKernels(const tflite::Model* mapped) {
+#if MODEL_OPS_INT8
+  const tflite::SubGraph* graph = mapped->subgraphs()->Get(0);
+  for (flatbuffers::uoffset_t i = 0; i < graph->inputs()->size(); i++) {
+    if (graph->tensors()->Get(graph->inputs()->Get(i))->type() != tflite::TensorType_INT8) {
+      return false;
+    }
+  }
+  for (flatbuffers::uoffset_t i = 0; i < graph->outputs()->size(); i++) {
+    if (graph->tensors()->Get(graph->outputs()->Get(i))->type() != tflite::TensorType_INT8) {
+      return false;
+    }
   }
+#endif
+  return true;
 }
 
 /**
- * Normalize image values to [0, 1] range (for float models)
- * Note: For quantized models, this is not needed
+ * Checks that need no interpreter: schema version, one subgraph, every
+ * operator registered in opResolver, tensor types matching the kernels
  */
-void normalizeImage(uint8_t* image, int width, int height, int channels) {
-  int totalPixels = width * height * channels;
-  for (int i = 0; i < totalPixels; i++) {
-    // Convert uint8 [0, 255] to float [0, 1]
-    // This requires the input tensor to be float type
-    // For quantized models, we keep uint8 values
-    // image[i] is already in the correct format
+bool validateModel(const tflite::Model* mapped) {
+  if (mapped->version() != TFLITE_SCHEMA_VERSION) {
+    Serial.println("ERROR: Model schema version mismatch!");
+    Serial.print("  Model version: ");
+    Serial.println(mapped->version());
+    Serial.print("  Supported version: ");
+    Serial.println(TFLITE_SCHEMA_VERSION);
+    return false;
+  }
+
+  if (mapped->subgraphs() == nullptr || mapped->subgraphs()->size() == 0 ||
+      mapped->operator_codes() == nullptr) {
+    Serial.println("ERROR: Model has no subgraph!");
+    return false;
+  }
+
+  for (flatbuffers::uoffset_t i = 0; i < mapped->operator_codes()->size(); i++) {
+    const tflite::OperatorCode* code = mapped->operator_codes()->Get(i);
+    tflite::BuiltinOperator builtin = tflite::GetBuiltinCode(code);
+    bool registered = builtin == tflite::BuiltinOperator_CUSTOM
+      ? code->custom_code() != nullptr && opResolver.FindOp(code->custom_code()->c_str()) != nullptr
+      : opResolver.FindOp(builtin) != nullptr;
+    if (!registered) {
+      Serial.print("ERROR: Operator not registered in model_ops.h: ");
+      Serial.println(tflite::EnumNameBuiltinOperator(builtin));
+      return false;
+    }
+  }
+
+  if (!modelMatchesKernels(mapped)) {
+    Serial.println("ERROR: Model is not int8 end to end (see MODEL_OPS_INT8)!");
+    return false;
   }
+
+  return true;
+}
+
+/**
+ * Convert RGB565 buffer to RGB888
+ */
+void convertRGB565toRGB888(uint8_t* src, uint8_t* dst, int pixelCount) {
+  convertRGB565BufferToRGB888(src, dst, pixelCount);
 }
 
 // ===========================================
@@ -637,7 +1081,8 @@ void normalizeImage(uint8_t* image, int width, int height, int channels) {
 // ===========================================
 
 /**
- * Initialize ML model with default person detection model
+ * Initialize ML models: every model in the camera schedule is made
+ * resident up front, then the first camera's model is activated
  */
 bool initializeMLModel() {
   Serial.println("Initializing ML model...");
@@ -646,12 +1091,21 @@ bool initializeMLModel() {
   static tflite::MicroErrorReporter micro_error_reporter;
   error_reporter = &micro_error_reporter;
 
-  // Load default model (person detection)
-  if (!loadPersonDetectionModel()) {
-    Serial.println("ERROR: Failed to load person detection model!");
+  if (!initializeModelRegistry()) {
     return false;
   }
 
+  // Load every scheduled model (person detection is the default)
+  for (int camera = 0; camera < 2; camera++) {
+    if (!activateModel(cameraModel[camera])) {
+      Serial.print("ERROR: Failed to load model for camera ");
+      Serial.println(camera + 1);
+      return false;
+    }
+  }
+
+  activateModel(cameraModel[CAMERA_1_ID]);
+
   Serial.println("ML model initialized successfully");
   printModelInfo(currentModel);
 
@@ -659,9 +1113,62 @@ bool initializeMLModel() {
 }
 
 /**
- * Load model from metadata structure
+ * Partition the tensor arena between the model slots and register the
+ * model operators once
  */
-bool loadModel(ModelMetadata& modelInfo) {
+bool initializeModelRegistry() {
+  if (!registerModelOps(opResolver)) {
+    Serial.println("ERROR: Failed to register model operators!");
+    return false;
+  }
+
+  // CMSIS_NN must be defined for this file too (compiler.cpp.extra_flags),
+  // otherwise the int8 registrations fall back to the generic kernels
+  Serial.print("Kernels: ");
+#if defined(CMSIS_NN)
+  Serial.println(MODEL_OPS_INT8 ? "CMSIS-NN (int8 only)" : "CMSIS-NN");
+#else
+  Serial.println(MODEL_OPS_INT8 ? "reference (int8 only)" : "reference");
+#endif
+  if (!MODEL_OPS_GENERATED) {
+    Serial.println("WARNING: model_ops.h is the placeholder, arena sizes are not the models'");
+  }
+
+  uint32_t offset = 0;
+  for (int i = 0; i < NUM_MODEL_SLOTS; i++) {
+    ResidentModel& slot = modelRegistry[i];
+    slot.model = nullptr;
+    slot.interpreter = nullptr;
+    slot.arena = tensor_arena + offset;
+    slot.arenaSize = modelArenaSize[i];
+    slot.resident = false;
+
+    // Keep every partition 16-byte aligned
+    offset += (modelArenaSize[i] + 15) & ~15u;
+  }
+
+  if (offset > (uint32_t)kTensorArenaSize) {
+    Serial.println("ERROR: Model arena partitions exceed the tensor arena!");
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Print a model name the way generate_op_resolver.py names its macros
+ */
+void printModelMacroName(const char* name) {
+  for (const char* c = name; *c; c++) {
+    Serial.print(isalnum(*c) ? (char)toupper(*c) : '_');
+  }
+}
+
+/**
+ * Build the interpreter for a model in its own arena partition. Runs
+ * AllocateTensors() once; afterwards the model is switched in O(1).
+ */
+bool registerModel(const ModelMetadata& modelInfo) {
   Serial.println("Loading model...");
   Serial.print("  Name: ");
   Serial.println(modelInfo.name);
@@ -674,41 +1181,76 @@ bool loadModel(ModelMetadata& modelInfo) {
     return false;
   }
 
-  // Unload existing model if loaded
-  if (modelLoaded) {
-    unloadModel();
+  ResidentModel& slot = modelRegistry[modelInfo.type];
+  if (slot.arenaSize == 0) {
+    Serial.println("ERROR: No arena reserved for this model slot (RESIDENT_MODEL_MASK)!");
+    return false;
   }
 
-  // Map model into usable data structure
-  model = tflite::GetModel(modelInfo.modelData);
-  if (model->version() != TFLITE_SCHEMA_VERSION) {
-    Serial.println("ERROR: Model schema version mismatch!");
-    Serial.print("  Model version: ");
-    Serial.println(model->version());
-    Serial.print("  Supported version: ");
-    Serial.println(TFLITE_SCHEMA_VERSION);
+  // Map model into usable data structure and validate it while the
+  // resident model of this slot is still intact
+  const tflite::Model* mapped = tflite::GetModel(modelInfo.modelData);
+  if (!validateModel(mapped)) {
     return false;
   }
 
-  // Build interpreter with all operations resolver
-  static tflite::AllOpsResolver resolver;
+  // Replacing a resident model (custom slot). The new model plans its
+  // tensors in the same partition, so from here a failure leaves the
+  // slot empty.
+  evictModel(modelInfo.type);
 
-  static tflite::MicroInterpreter static_interpreter(
-    model, resolver, tensor_arena, kTensorArenaSize, error_reporter
-  );
+  tflite::MicroInterpreter* slotInterpreter =
+    new (interpreterStorage[modelInfo.type]) tflite::MicroInterpreter(
+      mapped, opResolver, slot.arena, slot.arenaSize, error_reporter
+    );
 
-  interpreter = &static_interpreter;
+  slot.model = mapped;
+  slot.interpreter = slotInterpreter;
 
   // Allocate tensors
-  TfLiteStatus allocate_status = interpreter->AllocateTensors();
+  TfLiteStatus allocate_status = slotInterpreter->AllocateTensors();
   if (allocate_status != kTfLiteOk) {
     Serial.println("ERROR: Failed to allocate tensors!");
-    printMemoryUsage();
+    Serial.print("  Arena partition: ");
+    Serial.print(slot.arenaSize);
+    Serial.println(" bytes");
+    if (modelInfo.type != MODEL_TYPE_CUSTOM) {
+      Serial.println("  model_ops.h arena size too small: regenerate it from this model");
+    }
+    if (MODEL_OPS_INT8) {
+      Serial.println("  int8-only kernels registered: is the model fully int8?");
+    }
+    evictModel(modelInfo.type);
     return false;
   }
 
-  // Get input tensor info
-  TfLiteTensor* input = interpreter->input(0);
+  // The partition comes from model_ops.h; check it against what the
+  // interpreter really uses so a stale header is caught here
+  uint32_t arenaUsed = (slotInterpreter->arena_used_bytes() + 15) & ~15u;
+  Serial.print("  Arena used: ");
+  Serial.print(arenaUsed);
+  Serial.print(" / ");
+  Serial.print(slot.arenaSize);
+  Serial.println(modelInfo.type == MODEL_TYPE_CUSTOM ? " (CUSTOM_MODEL_ARENA_SIZE)" : " (model_ops.h)");
+
+  if (modelInfo.type != MODEL_TYPE_CUSTOM &&
+      slot.arenaSize - arenaUsed > slot.arenaSize / 100 * MODEL_ARENA_TOLERANCE_PERCENT) {
+    Serial.println("ERROR: model_ops.h arena size does not match this model (stale header)!");
+    Serial.print("  Regenerate with: generate_op_resolver.py --measured ");
+    printModelMacroName(modelInfo.name);
+    Serial.print("=");
+    Serial.println(arenaUsed);
+    evictModel(modelInfo.type);
+    return false;
+  }
+
+  // Get input tensor info (NHWC image input only)
+  TfLiteTensor* input = slotInterpreter->input(0);
+  if (input->dims->size != 4 || input->dims->data[3] != MODEL_INPUT_CHANNELS) {
+    Serial.println("ERROR: Input tensor is not [1, height, width, 3]!");
+    evictModel(modelInfo.type);
+    return false;
+  }
   Serial.print("  Input dimensions: ");
   Serial.print(input->dims->data[1]);
   Serial.print("x");
@@ -716,10 +1258,17 @@ bool loadModel(ModelMetadata& modelInfo) {
   Serial.print("x");
   Serial.println(input->dims->data[3]);
   Serial.print("  Input type: ");
-  Serial.println(input->type == kTfLiteUInt8 ? "uint8" : "float32");
+  Serial.println(input->type == kTfLiteUInt8 ? "uint8" :
+                 input->type == kTfLiteInt8 ? "int8" : "float32");
+
+  if (!configureInputQuantization(input, slot.inputQuant)) {
+    Serial.println("ERROR: Unsupported input tensor type!");
+    evictModel(modelInfo.type);
+    return false;
+  }
 
   // Get output tensor info
-  TfLiteTensor* output = interpreter->output(0);
+  TfLiteTensor* output = slotInterpreter->output(0);
   Serial.print("  Output dimensions: ");
   for (int i = 0; i < output->dims->size; i++) {
     Serial.print(output->dims->data[i]);
@@ -727,13 +1276,99 @@ bool loadModel(ModelMetadata& modelInfo) {
   }
   Serial.println();
 
-  // Update current model metadata
-  currentModel = modelInfo;
-  modelLoaded = true;
+  slot.decoder = detectOutputDecoder(slotInterpreter);
+  slot.decodeErrorReported = false;
+  Serial.print("  Output decoder: ");
+  Serial.println(slot.decoder == DECODER_SSD_POSTPROCESS ? "SSD (post-processed)" :
+                 slot.decoder == DECODER_SSD_ANCHORS ? "SSD (anchors)" :
+                 slot.decoder == DECODER_YOLO_GRID ? "YOLO grid" : "classification");
+
+  if (!decoderSupported(slotInterpreter, slot.decoder)) {
+    Serial.println("ERROR: Output decoder unavailable (anchor table or tensor type, see MODEL_ANCHORS_FILE)!");
+    evictModel(modelInfo.type);
+    return false;
+  }
+
+  slot.info = modelInfo;
+  slot.resident = true;
+
+  return true;
+}
+
+/**
+ * Make a resident model the active one (O(1) pointer swap). Models that
+ * are not resident yet are loaded first.
+ */
+bool activateModel(ModelType modelType) {
+  if (modelType < 0 || modelType >= NUM_MODEL_SLOTS) {
+    return false;
+  }
+
+  ResidentModel& slot = modelRegistry[modelType];
+
+  if (!slot.resident) {
+    bool loaded = false;
+    switch (modelType) {
+      case MODEL_TYPE_PERSON_DETECTION:
+        loaded = loadPersonDetectionModel();
+        break;
+      case MODEL_TYPE_VEHICLE_DETECTION:
+        loaded = loadVehicleDetectionModel();
+        break;
+      case MODEL_TYPE_ANIMAL_DETECTION:
+        loaded = loadAnimalDetectionModel();
+        break;
+      default:
+        break;  // Custom models must be loaded with loadCustomModel()
+    }
+    if (!loaded) {
+      return false;
+    }
+  }
+
+  activeModel = &slot;
+  model = slot.model;
+  interpreter = slot.interpreter;
+  currentModel = slot.info;
 
   return true;
 }
 
+/**
+ * Destroy a model's interpreter and release its partition
+ */
+void evictModel(ModelType modelType) {
+  ResidentModel& slot = modelRegistry[modelType];
+
+  if (slot.interpreter != nullptr) {
+    slot.interpreter->~MicroInterpreter();
+    slot.interpreter = nullptr;
+  }
+  slot.model = nullptr;
+  slot.resident = false;
+
+  if (activeModel == &slot) {
+    activeModel = nullptr;
+    model = nullptr;
+    interpreter = nullptr;
+  }
+}
+
+/**
+ * Load model from metadata structure: registers it if it is not resident
+ * yet, then makes it the active model
+ */
+bool loadModel(ModelMetadata& modelInfo) {
+  ResidentModel& slot = modelRegistry[modelInfo.type];
+
+  bool alreadyResident = slot.resident && slot.info.modelData == modelInfo.modelData;
+  if (!alreadyResident && !registerModel(modelInfo)) {
+    return false;
+  }
+
+  return activateModel(modelInfo.type);
+}
+
 /**
  * Load model from raw data array
  */
@@ -744,18 +1379,11 @@ bool loadModelFromData(uint8_t* modelData, uint32_t modelSize, ModelMetadata& mo
 }
 
 /**
- * Unload current model and free resources
+ * Unload the active model and free its arena partition
  */
 void unloadModel() {
-  if (modelLoaded) {
-    // Reset interpreter
-    if (interpreter != nullptr) {
-      interpreter = nullptr;
-    }
-
-    model = nullptr;
-    modelLoaded = false;
-
+  if (activeModel != nullptr) {
+    evictModel(activeModel->info.type);
     Serial.println("Model unloaded");
   }
 }
@@ -764,7 +1392,8 @@ void unloadModel() {
  * Check if model is loaded
  */
 bool isModelLoaded() {
-  return modelLoaded && (model != nullptr) && (interpreter != nullptr);
+  return (activeModel != nullptr) && activeModel->resident &&
+         (model != nullptr) && (interpreter != nullptr);
 }
 
 /**
@@ -856,29 +1485,17 @@ bool loadCustomModel(uint8_t* modelData, uint32_t modelSize, const char* name) {
 }
 
 /**
- * Switch between different model types
+ * Switch between different model types (O(1) for resident models)
  */
 void switchModel(ModelType modelType) {
   Serial.println("Switching model...");
 
-  bool success = false;
-
-  switch (modelType) {
-    case MODEL_TYPE_PERSON_DETECTION:
-      success = loadPersonDetectionModel();
-      break;
-    case MODEL_TYPE_VEHICLE_DETECTION:
-      success = loadVehicleDetectionModel();
-      break;
-    case MODEL_TYPE_ANIMAL_DETECTION:
-      success = loadAnimalDetectionModel();
-      break;
-    default:
-      Serial.println("ERROR: Unknown model type!");
-      return;
+  if (modelType >= NUM_MODEL_SLOTS) {
+    Serial.println("ERROR: Unknown model type!");
+    return;
   }
 
-  if (success) {
+  if (activateModel(modelType)) {
     Serial.println("Model switched successfully");
   } else {
     Serial.println("ERROR: Failed to switch model!");
@@ -886,6 +1503,30 @@ void switchModel(ModelType modelType) {
   }
 }
 
+/**
+ * Schedule a model on one camera. The model is made resident immediately
+ * so the frame loop only ever switches between loaded interpreters.
+ */
+void setCameraModel(uint8_t cameraId, ModelType modelType) {
+  if (cameraId > CAMERA_2_ID) {
+    return;
+  }
+
+  ResidentModel* previous = activeModel;
+
+  if (!activateModel(modelType)) {
+    Serial.println("ERROR: Failed to load camera model!");
+    handleMLError("Camera model schedule failed");
+    return;
+  }
+  cameraModel[cameraId] = modelType;
+
+  // Loading must not change which model the current frame runs on
+  if (previous != nullptr) {
+    activateModel(previous->info.type);
+  }
+}
+
 // ===========================================
 // INFERENCE EXECUTION
 // ===========================================
@@ -901,20 +1542,17 @@ void runInference(uint8_t* imageData, DetectionResult* result) {
     return;
   }
 
-  // Get input tensor
+  // Preprocess image straight into the input tensor
   TfLiteTensor* input = interpreter->input(0);
-
-  // Preprocess image
-  preprocessImage(imageData, CAMERA_WIDTH, CAMERA_HEIGHT,
-                  preprocessingBuffer, MODEL_INPUT_WIDTH, MODEL_INPUT_HEIGHT);
-
-  // Copy preprocessed data to input tensor
-  memcpy(input->data.uint8, preprocessingBuffer, input->bytes);
+  if (!preprocessImage(imageData, CAMERA_WIDTH, CAMERA_HEIGHT, input)) {
+    result->valid = false;
+    return;
+  }
 
   // Run inference
-  unsigned long startTime = micros();
+  unsigned long startTime = tracer().nowUs();
   TfLiteStatus invokeStatus = interpreter->Invoke();
-  unsigned long endTime = micros();
+  unsigned long endTime = tracer().nowUs();
 
   // Record metrics
   metrics.recordInference(endTime - startTime);
@@ -930,56 +1568,23 @@ void runInference(uint8_t* imageData, DetectionResult* result) {
   TfLiteTensor* output = interpreter->output(0);
 
   // Post-processing start
-  unsigned long postprocessStart = micros();
-
-  // Process output based on model type
-  // For classification model (1D output)
-  if (output->dims->size == 2 || output->dims->size == 4) {
-    // Find highest confidence class
-    float maxConfidence = -1.0f;
-    int detectedClass = -1;
-
-    // Get number of classes
-    int numOutputs = output->dims->data[output->dims->size - 1];
-
-    for (int i = 0; i < min(numOutputs, NUM_CLASSES); i++) {
-      float confidence;
-      if (output->type == kTfLiteUInt8) {
-        // Quantized model - convert to float
-        confidence = (output->data.uint8[i] - output->params.zero_point) *
-                     output->params.scale;
-      } else {
-        // Float model
-        confidence = output->data.f[i];
-      }
+  unsigned long postprocessStart = tracer().nowUs();
 
-      if (confidence > maxConfidence) {
-        maxConfidence = confidence;
-        detectedClass = i;
-      }
-    }
+  // Decode all boxes (or the top class), report the strongest
+  DetectionResult detections[MAX_DETECTIONS_PER_INFERENCE];
+  uint8_t numDetections = 0;
+  extractBoundingBoxes(output, detections, &numDetections);
 
-    // Populate result
-    result->cameraId = activeCamera;
-    result->classId = detectedClass;
-    result->confidence = maxConfidence;
+  if (numDetections > 0) {
+    *result = detections[0];
+  } else {
+    result->cameraId = inferenceCamera;
     result->timestamp = millis();
-    result->valid = (maxConfidence >= DETECTION_THRESHOLD && detectedClass >= 0);
-
-    // Default bounding box (full image)
-    result->boundingBox.x = 0;
-    result->boundingBox.y = 0;
-    result->boundingBox.width = MODEL_INPUT_WIDTH;
-    result->boundingBox.height = MODEL_INPUT_HEIGHT;
+    result->valid = false;
   }
 
-  unsigned long postprocessEnd = micros();
+  unsigned long postprocessEnd = tracer().nowUs();
   metrics.recordPostprocessing(postprocessEnd - postprocessStart);
-
-  // Print inference time
-  Serial.print("Inference time: ");
-  Serial.print((endTime - startTime) / 1000.0, 2);
-  Serial.println(" ms");
 }
 
 /**
@@ -987,163 +1592,326 @@ void runInference(uint8_t* imageData, DetectionResult* result) {
  * Returns multiple detections with bounding boxes
  */
 void runInferenceMultiple(uint8_t* imageData, DetectionResult* results, uint8_t* numDetections) {
+  *numDetections = 0;
+
   if (!isModelLoaded()) {
     Serial.println("ERROR: No model loaded!");
-    *numDetections = 0;
     return;
   }
 
-  // Get input tensor
-  TfLiteTensor* input = interpreter->input(0);
+  detectionCandidates.reset(DETECTION_THRESHOLD);
+  if (inferRegion(imageData, inputRegion)) {
+    *numDetections = collectDetections(results);
+  }
 
-  // Preprocess image
-  preprocessImage(imageData, CAMERA_WIDTH, CAMERA_HEIGHT,
-                  preprocessingBuffer, MODEL_INPUT_WIDTH, MODEL_INPUT_HEIGHT);
+  // Filter by confidence threshold (decoders already applied NMS)
+  filterByConfidence(results, numDetections, DETECTION_THRESHOLD);
+}
 
-  // Copy to input tensor
-  memcpy(input->data.uint8, preprocessingBuffer, input->bytes);
+/**
+ * One model pass over a region of the frame: preprocess the region into
+ * the input tensor, invoke, and add the decoded boxes (frame pixels) to
+ * detectionCandidates. Several passes (coarse + tiles) share one NMS in
+ * collectDetections().
+ */
+bool inferRegion(uint8_t* imageData, const DetectionFrame& region) {
+  inputRegion = region;
+
+  // Preprocess image straight into the input tensor
+  TfLiteTensor* input = interpreter->input(0);
+  if (!preprocessImage(imageData, CAMERA_WIDTH, CAMERA_HEIGHT, input)) {
+    return false;
+  }
 
   // Run inference
-  unsigned long startTime = micros();
+  unsigned long startTime = tracer().nowUs();
   TfLiteStatus invokeStatus = interpreter->Invoke();
-  unsigned long endTime = micros();
+  unsigned long endTime = tracer().nowUs();
 
   metrics.recordInference(endTime - startTime);
 
   if (invokeStatus != kTfLiteOk) {
     Serial.println("ERROR: Inference failed!");
-    *numDetections = 0;
     handleMLError("Multi-inference invoke failed");
-    return;
+    return false;
   }
 
-  // Get output tensor
-  TfLiteTensor* output = interpreter->output(0);
+  // Decode this pass
+  unsigned long postprocessStart = tracer().nowUs();
+  bool decoded = decodeDetections(interpreter->output(0), region);
+  metrics.recordPostprocessing(tracer().nowUs() - postprocessStart);
+
+  return decoded;
+}
+
+// ===========================================
+// POST-PROCESSING
+// ===========================================
 
-  // Extract bounding boxes from output
-  unsigned long postprocessStart = micros();
-  extractBoundingBoxes(output, results, numDetections);
+/**
+ * Wrap a TFLM tensor for the framework-independent decoders
+ */
+bool makeTensorView(const TfLiteTensor* tensor, TensorView& view) {
+  view.data = tensor->data.data;
+  view.scale = tensor->params.scale;
+  view.zeroPoint = tensor->params.zero_point;
+
+  switch (tensor->type) {
+    case kTfLiteFloat32:
+      view.type = TENSOR_ELEMENT_FLOAT32;
+      return true;
+    case kTfLiteUInt8:
+      view.type = TENSOR_ELEMENT_UINT8;
+      return view.scale > 0.0f;
+    case kTfLiteInt8:
+      view.type = TENSOR_ELEMENT_INT8;
+      return view.scale > 0.0f;
+    default:
+      return false;
+  }
+}
 
-  // Apply NMS to remove overlapping detections
-  if (*numDetections > 1) {
-    applyNonMaximumSuppression(results, numDetections);
+/**
+ * Pick the output decoder from the model's output tensor shapes
+ */
+OutputDecoder detectOutputDecoder(tflite::MicroInterpreter* modelInterpreter) {
+  // TFLite_Detection_PostProcess: boxes, classes, scores, count
+  if (modelInterpreter->outputs_size() == 4) {
+    return DECODER_SSD_POSTPROCESS;
   }
 
-  // Filter by confidence threshold
-  filterByConfidence(results, numDetections, DETECTION_THRESHOLD);
+  // Raw SSD: [1, A, 4] box encodings + [1, A, C] class scores
+  if (modelInterpreter->outputs_size() == 2) {
+    TfLiteTensor* boxes = modelInterpreter->output(0);
+    TfLiteTensor* scores = modelInterpreter->output(1);
+    if (boxes->dims->size == 3 && boxes->dims->data[2] == 4 &&
+        scores->dims->size == 3 && scores->dims->data[1] == boxes->dims->data[1]) {
+      return DECODER_SSD_ANCHORS;
+    }
+  }
 
-  unsigned long postprocessEnd = micros();
-  metrics.recordPostprocessing(postprocessEnd - postprocessStart);
+  // YOLO grid: [1, H, W, anchors * (5 + classes)]
+  TfLiteTensor* output = modelInterpreter->output(0);
+  if (output->dims->size == 4 && output->dims->data[1] > 1 && output->dims->data[2] > 1 &&
+      output->dims->data[3] == YOLO_NUM_ANCHORS * (5 + NUM_CLASSES)) {
+    return DECODER_YOLO_GRID;
+  }
 
-  Serial.print("Detected ");
-  Serial.print(*numDetections);
-  Serial.println(" objects");
+  return DECODER_CLASSIFICATION;
 }
 
-// ===========================================
-// POST-PROCESSING
-// ===========================================
+/**
+ * Everything the decoder needs besides the tensor data: the anchor table
+ * generated with the model and output types the decoders read
+ */
+bool decoderSupported(tflite::MicroInterpreter* modelInterpreter, OutputDecoder decoder) {
+  TensorView view;
+  for (size_t i = 0; i < modelInterpreter->outputs_size(); i++) {
+    if (!makeTensorView(modelInterpreter->output(i), view)) {
+      return false;
+    }
+  }
+
+  switch (decoder) {
+    case DECODER_SSD_POSTPROCESS:
+      return modelInterpreter->output(3)->type == kTfLiteFloat32;
+    case DECODER_SSD_ANCHORS:
+      return ssdAnchors != nullptr &&
+             modelInterpreter->output(1)->dims->data[1] == ssdAnchorCount;
+    case DECODER_YOLO_GRID:
+      return yoloAnchors != nullptr;
+    case DECODER_CLASSIFICATION:
+      return true;
+  }
+  return false;
+}
 
 /**
- * Extract bounding boxes from model output
- * This is a placeholder - implement based on your model's output format
+ * Classification output: one detection covering the model's input region
+ * for the top class. Argmax and threshold run on the raw (int8/uint8)
+ * scores.
  */
-void extractBoundingBoxes(TfLiteTensor* output, DetectionResult* results, uint8_t* numDetections) {
-  // TODO: Implement based on your model's output format
-  // Different models have different output formats:
-  //
-  // 1. SSD MobileNet: [num_detections, 7] where 7 = [batch, class_id, confidence, x, y, width, height]
-  // 2. YOLO: [grid_size, grid_size, num_anchors * (num_classes + 5)]
-  // 3. Classification: [batch, num_classes]
-  //
-  // This is a simplified implementation for classification models
+bool extractClassification(TfLiteTensor* output, const DetectionFrame& frame) {
+  TensorView scores;
+  if (!makeTensorView(output, scores)) {
+    return false;
+  }
+
+  int numOutputs = output->dims->data[output->dims->size - 1];
+  uint8_t classId;
+  float confidence;
+
+  if (decodeClassification(scores, min(numOutputs, NUM_CLASSES), DETECTION_THRESHOLD,
+                           classId, confidence)) {
+    detectionCandidates.push(frame, 0.0f, 0.0f, 1.0f, 1.0f, classId, confidence);
+  }
+  return true;
+}
 
+/**
+ * Extract bounding boxes from the active model's outputs for the current
+ * inputRegion: decode, then NMS. Boxes are in camera-frame pixels.
+ */
+void extractBoundingBoxes(TfLiteTensor* output, DetectionResult* results, uint8_t* numDetections) {
   *numDetections = 0;
 
-  // For classification model, create single detection
-  float maxConfidence = -1.0f;
-  int detectedClass = -1;
+  detectionCandidates.reset(DETECTION_THRESHOLD);
+  if (decodeDetections(output, inputRegion)) {
+    *numDetections = collectDetections(results);
+  }
+}
 
-  int numOutputs = output->dims->data[output->dims->size - 1];
+/**
+ * Decode the active model's outputs into detectionCandidates. Decodes
+ * SSD / YOLO outputs straight from the (quantized) tensors; `frame` is the
+ * part of the camera frame the model saw.
+ */
+bool decodeDetections(TfLiteTensor* output, const DetectionFrame& frame) {
+  bool decoded = false;
+
+  switch (activeModel->decoder) {
+    case DECODER_SSD_POSTPROCESS: {
+      TensorView boxes, classes, scores, count;
+      if (makeTensorView(interpreter->output(0), boxes) &&
+          makeTensorView(interpreter->output(1), classes) &&
+          makeTensorView(interpreter->output(2), scores) &&
+          makeTensorView(interpreter->output(3), count) &&
+          count.type == TENSOR_ELEMENT_FLOAT32) {
+        uint16_t numBoxes = (uint16_t)((const float*)count.data)[0];
+        uint16_t capacity = interpreter->output(2)->dims->data[1];
+        decoded = decodeSSDPostprocessed(boxes, classes, scores, min(numBoxes, capacity),
+                                         frame, detectionCandidates);
+      }
+      break;
+    }
 
-  for (int i = 0; i < min(numOutputs, NUM_CLASSES); i++) {
-    float confidence;
-    if (output->type == kTfLiteUInt8) {
-      confidence = (output->data.uint8[i] - output->params.zero_point) *
-                   output->params.scale;
-    } else {
-      confidence = output->data.f[i];
+    case DECODER_SSD_ANCHORS: {
+      TensorView encodings, scores;
+      TfLiteTensor* scoreTensor = interpreter->output(1);
+      uint16_t numAnchors = scoreTensor->dims->data[1];
+      SsdConfig cfg = {
+        ssdAnchors,
+        numAnchors,
+        (uint16_t)scoreTensor->dims->data[2],
+        (uint8_t)(scoreTensor->dims->data[2] > NUM_CLASSES ? 1 : 0),  // background class
+        SSD_Y_SCALE, SSD_X_SCALE, SSD_H_SCALE, SSD_W_SCALE
+      };
+      if (numAnchors == ssdAnchorCount &&
+          makeTensorView(interpreter->output(0), encodings) &&
+          makeTensorView(scoreTensor, scores)) {
+        decoded = decodeSSDAnchors(encodings, scores, cfg, frame, detectionCandidates);
+      }
+      break;
     }
 
-    if (confidence > maxConfidence) {
-      maxConfidence = confidence;
-      detectedClass = i;
+    case DECODER_YOLO_GRID: {
+      TensorView grid;
+      YoloConfig cfg = {
+        (uint16_t)output->dims->data[2],
+        (uint16_t)output->dims->data[1],
+        YOLO_NUM_ANCHORS,
+        NUM_CLASSES,
+        yoloAnchors,
+        YOLO_OUTPUTS_ACTIVATED
+      };
+      if (makeTensorView(output, grid)) {
+        decoded = decodeYoloGrid(grid, cfg, frame, detectionCandidates);
+      }
+      break;
     }
+
+    case DECODER_CLASSIFICATION:
+      decoded = extractClassification(output, frame);
+      break;
   }
 
-  if (maxConfidence >= DETECTION_THRESHOLD && detectedClass >= 0) {
-    results[0].cameraId = activeCamera;
-    results[0].classId = detectedClass;
-    results[0].confidence = maxConfidence;
-    results[0].timestamp = millis();
-    results[0].valid = true;
-    results[0].boundingBox = {0, 0, MODEL_INPUT_WIDTH, MODEL_INPUT_HEIGHT};
-    *numDetections = 1;
+  // Checked at registerModel(); report anything left once, not per frame
+  if (!decoded && !activeModel->decodeErrorReported) {
+    activeModel->decodeErrorReported = true;
+    handleMLError("Unsupported detection output");
   }
+  return decoded;
 }
 
 /**
- * Apply Non-Maximum Suppression to remove overlapping detections
- * Sorts by confidence and removes boxes with high IoU
+ * NMS over all candidates decoded this frame, strongest first
  */
-void applyNonMaximumSuppression(DetectionResult* detections, uint8_t* numDetections) {
-  if (*numDetections <= 1) return;
-
-  // Sort detections by confidence (descending)
-  for (int i = 0; i < *numDetections - 1; i++) {
-    for (int j = i + 1; j < *numDetections; j++) {
-      if (detections[j].confidence > detections[i].confidence) {
-        DetectionResult temp = detections[i];
-        detections[i] = detections[j];
-        detections[j] = temp;
-      }
-    }
+uint8_t collectDetections(DetectionResult* results) {
+  Detection kept[MAX_DETECTIONS_PER_INFERENCE];
+  uint8_t numKept = nonMaxSuppression(detectionCandidates, NMS_IOU_THRESHOLD,
+                                      kept, MAX_DETECTIONS_PER_INFERENCE);
+
+  uint32_t timestamp = millis();
+  for (uint8_t i = 0; i < numKept; i++) {
+    DetectionResult& result = results[i];
+    result.cameraId = inferenceCamera;
+    result.classId = kept[i].classId;
+    result.confidence = kept[i].confidence;
+    result.timestamp = timestamp;
+    result.valid = true;
+    result.boundingBox = {
+      (uint16_t)kept[i].x0,
+      (uint16_t)kept[i].y0,
+      (uint16_t)(kept[i].x1 - kept[i].x0),
+      (uint16_t)(kept[i].y1 - kept[i].y0)
+    };
   }
 
-  // Remove overlapping detections
-  bool keep[MAX_DETECTIONS_PER_INFERENCE];
-  memset(keep, true, sizeof(keep));
+  return numKept;
+}
 
-  for (int i = 0; i < *numDetections; i++) {
-    if (!keep[i]) continue;
+/**
+ * Apply Non-Maximum Suppression to remove overlapping detections.
+ * Ranks an index array instead of swapping whole results, and compares
+ * boxes with integer IoU against the kept set only.
+ */
+void applyNonMaximumSuppression(DetectionResult* detections, uint8_t* numDetections) {
+  if (*numDetections <= 1) return;
 
-    for (int j = i + 1; j < *numDetections; j++) {
-      if (!keep[j]) continue;
+  uint8_t order[MAX_DETECTIONS_PER_INFERENCE];
+  uint8_t count = min(*numDetections, (uint8_t)MAX_DETECTIONS_PER_INFERENCE);
+  for (uint8_t i = 0; i < count; i++) {
+    order[i] = i;
+  }
 
-      // Only compare detections of same class
-      if (detections[i].classId == detections[j].classId) {
-        float iou = detections[i].boundingBox.calculateIoU(detections[j].boundingBox);
+  std::sort(order, order + count, [detections](uint8_t a, uint8_t b) {
+    return detections[a].confidence > detections[b].confidence;
+  });
+
+  uint32_t iouQ8 = (uint32_t)(NMS_IOU_THRESHOLD * DETPOST_IOU_ONE + 0.5f);
+  uint8_t kept[MAX_DETECTIONS_PER_INFERENCE];
+  uint8_t numKept = 0;
+
+  for (uint8_t i = 0; i < count; i++) {
+    const DetectionResult& candidate = detections[order[i]];
+    const BoundingBox& cb = candidate.boundingBox;
+    Detection c = {(int16_t)cb.x, (int16_t)cb.y, (int16_t)(cb.x + cb.width),
+                   (int16_t)(cb.y + cb.height), candidate.classId, candidate.confidence};
+
+    bool suppressed = false;
+    for (uint8_t k = 0; k < numKept && !suppressed; k++) {
+      const DetectionResult& other = detections[kept[k]];
+      const BoundingBox& ob = other.boundingBox;
+      Detection o = {(int16_t)ob.x, (int16_t)ob.y, (int16_t)(ob.x + ob.width),
+                     (int16_t)(ob.y + ob.height), other.classId, other.confidence};
+      suppressed = other.classId == candidate.classId && detectionsOverlap(o, c, iouQ8);
+    }
 
-        if (iou > NMS_IOU_THRESHOLD) {
-          // Remove lower confidence detection
-          keep[j] = false;
-        }
-      }
+    if (!suppressed) {
+      kept[numKept++] = order[i];
     }
   }
 
-  // Compact the array
-  uint8_t newCount = 0;
-  for (int i = 0; i < *numDetections; i++) {
-    if (keep[i]) {
-      if (newCount != i) {
-        detections[newCount] = detections[i];
-      }
-      newCount++;
-    }
+  // Gather survivors strongest first
+  DetectionResult survivors[MAX_DETECTIONS_PER_INFERENCE];
+  for (uint8_t i = 0; i < numKept; i++) {
+    survivors[i] = detections[kept[i]];
+  }
+  for (uint8_t i = 0; i < numKept; i++) {
+    detections[i] = survivors[i];
   }
 
-  *numDetections = newCount;
+  *numDetections = numKept;
 }
 
 /**
@@ -1169,20 +1937,85 @@ void filterByConfidence(DetectionResult* detections, uint8_t* numDetections, flo
 // ===========================================
 
 /**
- * Process detections from both cameras
+ * Process the next frame. Each call handles one frame; the cameras
+ * alternate so TARGET_FPS is the combined rate of both.
  */
 void processDetections() {
-  processCamera(CAMERA_1_ID, frameBuffer1, lastDetection1, detectionBuffer1);
-  processCamera(CAMERA_2_ID, frameBuffer2, lastDetection2, detectionBuffer2);
+#if PIPELINE_ENABLED
+  processDetectionsPipelined();
+#else
+  CameraSlot& slot = cameraSlots[sequentialSlot];
+  processCamera(slot.cameraId, slot.frameBuffer, *slot.result, *slot.tracker);
+  sequentialSlot ^= 1;
+#endif
+}
+
+/**
+ * Pipelined processing: take the frame the DMA just finished, immediately
+ * start capturing the other camera into its own buffer, then run inference
+ * on the finished frame while that transfer is in progress.
+ */
+void processDetectionsPipelined() {
+  // Prime the pipeline on the first call or after an error
+  if (captureSlot == NO_CAPTURE_IN_FLIGHT) {
+    if (!startFrameCapture(0)) {
+      metrics.recordCapture(false);
+      return;
+    }
+  }
+
+  uint8_t readySlot = captureSlot;
+  CameraSlot& slot = cameraSlots[readySlot];
+
+  TRACE_BEGIN(TRACE_CAPTURE);
+  bool captureSuccess = waitForFrame(FRAME_READY_TIMEOUT_MS);
+  TRACE_END(TRACE_CAPTURE);
+  metrics.recordCapture(captureSuccess);
+
+  if (!captureSuccess) {
+    abortFrameCapture();
+    slot.result->valid = false;
+    handleCameraError(slot.cameraId, "Frame-ready timeout");
+    return;
+  }
+
+  // Overlap: the other camera captures while this frame is processed
+  if (!startFrameCapture(readySlot ^ 1)) {
+    captureSlot = NO_CAPTURE_IN_FLIGHT;
+  }
+
+  processCapturedFrame(slot.cameraId, slot.frameBuffer, *slot.result, *slot.tracker);
 }
 
 /**
- * Process single camera: capture, infer, buffer, alarm
+ * Target-FPS scheduler: returns true when the next frame slot is due.
+ * Falls back to "now" if processing overran by more than one interval,
+ * so a slow frame does not cause a burst of catch-up frames.
+ */
+bool frameDue() {
+  unsigned long now = micros();
+
+  if ((long)(now - nextFrameTime) < 0) {
+    return false;
+  }
+
+  nextFrameTime += FRAME_INTERVAL_US;
+  if ((long)(now - nextFrameTime) >= 0) {
+    nextFrameTime = now + FRAME_INTERVAL_US;
+  }
+
+  return true;
+}
+
+/**
+ * Process single camera: capture, infer, track
  */
 void processCamera(uint8_t cameraId, uint8_t* frameBuffer,
-                   DetectionResult& result, DetectionBuffer& buffer) {
+                   DetectionResult& result, DetectionTracker& tracker) {
   // Capture image
+  TRACE_BEGIN(TRACE_CAPTURE);
   bool captureSuccess = captureImage(cameraId, frameBuffer);
+  TRACE_END(TRACE_CAPTURE);
   metrics.recordCapture(captureSuccess);
 
   if (!captureSuccess) {
@@ -1191,65 +2024,212 @@ void processCamera(uint8_t cameraId, uint8_t* frameBuffer,
     return;
   }
 
-  // Run inference
-  runInference(frameBuffer, &result);
+  processCapturedFrame(cameraId, frameBuffer, result, tracker);
+}
 
-  // Add to buffer
-  if (result.isValid()) {
-    buffer.add(result);
+/**
+ * Process an already captured frame: infer, track
+ */
+void processCapturedFrame(uint8_t cameraId, uint8_t* frameBuffer,
+                          DetectionResult& result, DetectionTracker& tracker) {
+  inferenceCamera = cameraId;
+
+  // Bind this camera's model (pointer swap, no re-allocation)
+  if (activeModel == nullptr || activeModel->info.type != cameraModel[cameraId]) {
+    if (!activateModel(cameraModel[cameraId])) {
+      result.valid = false;
+      handleMLError("Camera model not resident");
+      return;
+    }
+  }
 
-    // Update statistics
-    totalDetections++;
-    detectionCounts[result.classId]++;
+  DetectionFrame coarseRegion = {0, 0, CAMERA_WIDTH, CAMERA_HEIGHT};
+  bool coarse = true;
 
-    // Print result
-    printDetectionResult(result);
+#if MOTION_GATE_ENABLED
+  // Skip the coarse pass on static frames, crop to the motion otherwise
+  TfLiteTensor* input = interpreter->input(0);
+  MotionRegion motion;
+  if (input->dims->size != 4) {
+    handleMLError("Unsupported input tensor shape");
+    result.valid = false;
+    return;
+  }
+  coarse = updateMotionGate(motionGates[cameraId], frameBuffer, CAMERA_WIDTH, CAMERA_HEIGHT,
+                            motionConfig, input->dims->data[2], input->dims->data[1], motion);
+  if (coarse) {
+    coarseRegion = {motion.x, motion.y, motion.width, motion.height};
+  }
 
-    // Check for alarm
-    if (result.shouldAlarm()) {
-      triggerAlarm();
+  // Gated frames are not misses: a confirmed object that left while the
+  // scene was static is re-checked on the full frame instead
+  if (!coarse && tracker.staleCount(millis(), TRACKER_VERIFY_MS) > 0) {
+    coarse = true;
+  }
+#endif
+
+  // Fine-scale tiles around recent activity
+  uint8_t numTiles = 0;
+#if TILING_ENABLED
+  uint8_t tiles[TILING_MAX_TILES_PER_FRAME];
+  if (!coarse || coarseRegion.width > TILE_WIDTH * TILING_COARSE_SCALE ||
+      coarseRegion.height > TILE_HEIGHT * TILING_COARSE_SCALE) {
+    numTiles = scheduleTiles(cameraId, tracker, tiles);
+  }
+#endif
+
+  if (!coarse && numTiles == 0) {
+    // Nothing moved: tracks hold their position, up to TRACKER_MAX_AGE_MS
+    tracker.expire(millis(), TRACKER_MAX_AGE_MS);
+    handleTrackEvents(cameraId, tracker);
+    metrics.recordSkippedInference();
+    result.valid = false;
+    return;
+  }
+
+  // Between inferred frames, tracks coast on their velocity
+  if (++trackerFrame[cameraId] < TRACKER_INFERENCE_STRIDE && tracker.activeCount() > 0) {
+    tracker.predict();
+    metrics.recordSkippedInference();
+    result.valid = false;
+    return;
+  }
+  trackerFrame[cameraId] = 0;
+
+  // Run the coarse pass and the tiles, then one NMS over all of them
+  // (all objects, strongest first)
+  detectionCandidates.reset(DETECTION_THRESHOLD);
+  bool inferred = false;
+
+  if (coarse) {
+    inferred = inferRegion(frameBuffer, coarseRegion);
+  }
+
+#if TILING_ENABLED
+  for (uint8_t i = 0; i < numTiles; i++) {
+    tileSchedulers[cameraId].ran(tiles[i]);
+    metrics.recordTileInference();
+    inferred |= inferRegion(frameBuffer, tileSchedulers[cameraId].region(tiles[i]));
+  }
+#endif
+
+  DetectionResult detections[MAX_DETECTIONS_PER_INFERENCE];
+  uint8_t numDetections = inferred ? collectDetections(detections) : 0;
+  filterByConfidence(detections, &numDetections, DETECTION_THRESHOLD);
+
+  if (numDetections > 0) {
+    result = detections[0];
+  } else {
+    result.cameraId = cameraId;
+    result.valid = false;
+  }
+
+  trackDetections(cameraId, tracker, detections, numDetections);
+}
+
+#if TILING_ENABLED
+/**
+ * Update the camera's tile priorities from this frame's motion mask and
+ * the small tracked objects, and pick the tiles to run
+ */
+uint8_t scheduleTiles(uint8_t cameraId, const DetectionTracker& tracker, uint8_t* tiles) {
+  TileScheduler& scheduler = tileSchedulers[cameraId];
+  scheduler.beginFrame();
+
+#if MOTION_GATE_ENABLED
+  scheduler.markMotion(motionGates[cameraId]);
+#endif
+
+  for (uint8_t i = 0; i < TRACKER_MAX_TRACKS; i++) {
+    const Track& track = tracker.track(i);
+    if (track.active) {
+      scheduler.markBox(track.box);
+    }
+  }
+
+  return scheduler.select(tiles, TILING_MAX_TILES_PER_FRAME);
+}
+#endif
+
+/**
+ * Feed one frame's detections to the camera's tracker and handle the
+ * resulting events: each object is counted and reported once
+ */
+void trackDetections(uint8_t cameraId, DetectionTracker& tracker,
+                     const DetectionResult* detections, uint8_t numDetections) {
+  Detection boxes[MAX_DETECTIONS_PER_INFERENCE];
+  uint8_t count = 0;
+
+  for (uint8_t i = 0; i < numDetections; i++) {
+    const DetectionResult& d = detections[i];
+    if (!d.isValid()) continue;
+    const BoundingBox& b = d.boundingBox;
+    boxes[count++] = {(int16_t)b.x, (int16_t)b.y, (int16_t)(b.x + b.width),
+                      (int16_t)(b.y + b.height), d.classId, d.confidence};
+  }
+
+  tracker.update(boxes, count, millis());
+  tracker.expire(millis(), TRACKER_MAX_AGE_MS);
+  handleTrackEvents(cameraId, tracker);
+}
+
+/**
+ * Count newly confirmed objects and report track events
+ */
+void handleTrackEvents(uint8_t cameraId, DetectionTracker& tracker) {
+  TrackEvent event;
+  while (tracker.pollEvent(event)) {
+    if (event.type == TRACK_EVENT_CONFIRMED && event.track.box.classId < NUM_CLASSES) {
+      totalDetections++;
+      detectionCounts[event.track.box.classId]++;
+      detectionConfidenceSum += event.track.peakConfidence;
     }
+    printTrackEvent(cameraId, event);
   }
 }
 
 /**
- * Determine if detection should trigger alarm
+ * Determine if a confirmed track should raise the alarm
  */
-bool shouldTriggerAlarm(const DetectionResult& result) {
+bool isAlarmTrack(const Track& track) {
+  if (!track.active || !track.confirmed || track.peakConfidence < CONFIDENCE_THRESHOLD) {
+    return false;
+  }
+
   // High-confidence person detection
-  if (result.classId == CLASS_PERSON &&
-      result.confidence >= CONFIDENCE_THRESHOLD) {
+  if (track.box.classId == CLASS_PERSON) {
     return true;
   }
 
   // High-confidence vehicle detection (optional)
-  if (result.classId == CLASS_VEHICLE &&
-      result.confidence >= CONFIDENCE_THRESHOLD) {
+  if (track.box.classId == CLASS_VEHICLE) {
     // Uncomment if vehicle detection should trigger alarm
     // return true;
   }
 
   // High-confidence animal detection (optional)
-  if (result.classId == CLASS_ANIMAL &&
-      result.confidence >= CONFIDENCE_THRESHOLD) {
+  if (track.box.classId == CLASS_ANIMAL) {
     // Uncomment if animal detection should trigger alarm
     // return true;
   }
 
-  // Multiple detections in buffer (crowd detection)
-  DetectionBuffer* buffer = (result.cameraId == CAMERA_1_ID) ?
-                            &detectionBuffer1 : &detectionBuffer2;
-  if (buffer->size() >= 3) {
-    // Check if we have multiple recent detections
-    int recentDetections = 0;
-    for (int i = 0; i < min(3, buffer->size()); i++) {
-      DetectionResult* r = buffer->getLatest(i);
-      if (r && r->isValid()) {
-        recentDetections++;
-      }
+  return false;
+}
+
+/**
+ * Alarm condition: an alarming track in view, or a crowd on one camera
+ */
+bool alarmCondition() {
+  const DetectionTracker* trackers[2] = {&tracker1, &tracker2};
+
+  for (uint8_t c = 0; c < 2; c++) {
+    if (trackers[c]->confirmedCount() >= CROWD_TRACKS) {
+      return true;
     }
-    if (recentDetections >= 3) {
-      return true;  // Multiple recent detections
+    for (uint8_t i = 0; i < TRACKER_MAX_TRACKS; i++) {
+      if (isAlarmTrack(trackers[c]->track(i))) {
+        return true;
+      }
     }
   }
 
@@ -1257,19 +2237,13 @@ bool shouldTriggerAlarm(const DetectionResult& result) {
 }
 
 /**
- * Trigger alarm
+ * Trigger alarm (once per rising edge of the alarm condition)
  */
 void triggerAlarm() {
-  if (alarmActive) {
-    // Already alarming, extend duration
-    alarmStartTime = millis();
-    return;
-  }
-
   Serial.println("ALARM TRIGGERED!");
 
-  alarmActive = true;
-  alarmStartTime = millis();
+  alarmState = ALARM_ACTIVE;
+  alarmCount++;
 
   // Turn on indicators
   digitalWrite(ALARM_LED_PIN, HIGH);
@@ -1277,20 +2251,40 @@ void triggerAlarm() {
 }
 
 /**
- * Update alarm state (call in loop)
+ * Update alarm state (call in loop). The alarm follows the tracks: it
+ * stays on while an alarming object is tracked and for ALARM_DURATION_MS
+ * after it is lost, so a flickering detection does not re-trigger it.
  */
 void updateAlarm() {
-  if (!alarmActive) return;
+  bool condition = alarmCondition();
 
-  // Check if alarm duration has elapsed
-  if (millis() - alarmStartTime >= ALARM_DURATION_MS) {
-    alarmActive = false;
+  switch (alarmState) {
+    case ALARM_IDLE:
+      if (condition) {
+        triggerAlarm();
+      }
+      break;
 
-    // Turn off indicators
-    digitalWrite(ALARM_LED_PIN, LOW);
-    digitalWrite(ALARM_BUZZER_PIN, LOW);
+    case ALARM_ACTIVE:
+      if (!condition) {
+        alarmState = ALARM_HOLD;
+        alarmHoldStart = millis();
+      }
+      break;
+
+    case ALARM_HOLD:
+      if (condition) {
+        alarmState = ALARM_ACTIVE;
+      } else if (millis() - alarmHoldStart >= ALARM_DURATION_MS) {
+        alarmState = ALARM_IDLE;
 
-    Serial.println("Alarm deactivated");
+        // Turn off indicators
+        digitalWrite(ALARM_LED_PIN, LOW);
+        digitalWrite(ALARM_BUZZER_PIN, LOW);
+
+        Serial.println("Alarm deactivated");
+      }
+      break;
   }
 }
 
@@ -1327,6 +2321,40 @@ void printDetectionResult(const DetectionResult& result) {
   }
 }
 
+/**
+ * Print a track event: one line when an object is confirmed and when it
+ * is lost
+ */
+void printTrackEvent(uint8_t cameraId, const TrackEvent& event) {
+  const Track& track = event.track;
+
+  Serial.print("Camera ");
+  Serial.print(cameraId + 1);
+  Serial.print(event.type == TRACK_EVENT_CONFIRMED ? ": track " : ": lost track ");
+  Serial.print(track.id);
+  Serial.print(" ");
+  Serial.print(track.box.classId < NUM_CLASSES ? classNames[track.box.classId] : "unknown");
+  Serial.print(" (");
+  Serial.print(track.peakConfidence * 100, 1);
+  Serial.print("%) ");
+
+  if (event.type == TRACK_EVENT_CONFIRMED) {
+    Serial.print("[");
+    Serial.print(track.box.x0);
+    Serial.print(",");
+    Serial.print(track.box.y0);
+    Serial.print(",");
+    Serial.print(track.box.x1 - track.box.x0);
+    Serial.print(",");
+    Serial.print(track.box.y1 - track.box.y0);
+    Serial.println("]");
+  } else {
+    Serial.print("after ");
+    Serial.print((track.lastSeenMs - track.firstSeenMs) / 1000.0f, 1);
+    Serial.println(" s");
+  }
+}
+
 /**
  * Print model information
  */
@@ -1350,50 +2378,115 @@ void printModelInfo(const ModelMetadata& modelInfo) {
 }
 
 /**
- * Print current memory usage
+ * Print one buffer's address, region and size
  */
-void printMemoryUsage() {
-  Serial.println("=== Memory Usage ===");
+void printMemoryPlacement(const char* name, const void* buffer, uint32_t size) {
+  Serial.print(name);
+  Serial.print(": 0x");
+  Serial.print((uint32_t)(uintptr_t)buffer, HEX);
+  Serial.print(" ");
+  Serial.print(memoryRegionName(memoryRegionOf(buffer)));
+  Serial.print(", ");
+  Serial.print(size / 1024);
+  Serial.println(" KB");
+}
 
-  // Calculate tensor arena usage
-  if (interpreter != nullptr) {
-    TfLiteTensor* tensors[10];
-    int used = 0;
+/**
+ * Verify the linker honoured the memory map: the DCMI DMA must reach the
+ * frame buffers, and hot data should be where it was asked to go
+ */
+bool checkMemoryMap() {
+  if (!memoryDmaReachable(frameBuffer1) || !memoryDmaReachable(frameBuffer2)) {
+    return false;
+  }
 
-    // Estimate usage by checking tensor allocations
-    for (int i = 0; i < 10; i++) {
-      TfLiteTensor* tensor = interpreter->tensor(i);
-      if (tensor != nullptr && tensor->bytes > 0) {
-        used += tensor->bytes;
-      }
-    }
+#if MEMORY_MAP_SECTIONS
+  if ((HOT_DATA_REGION != MEMORY_REGION_DEFAULT && memoryRegionOf(&preprocessLUT) != HOT_DATA_REGION) ||
+      (TENSOR_ARENA_REGION != MEMORY_REGION_DEFAULT && memoryRegionOf(tensor_arena) != TENSOR_ARENA_REGION)) {
+    Serial.println("WARNING: Linker script lacks the memory map sections");
+  }
+#endif
+
+  return true;
+}
+
+/**
+ * Print current memory usage. Returns false if the buffers placed in a
+ * region add up to more than the region holds.
+ */
+bool printMemoryUsage() {
+  Serial.println("=== Memory Usage ===");
 
-    Serial.print("Tensor Arena: ");
-    Serial.print(used / 1024);
-    Serial.print(" KB / ");
-    Serial.print(kTensorArenaSize / 1024);
-    Serial.println(" KB");
+  // Tensor arena usage per resident model
+  // (feed back to generate_op_resolver.py --measured)
+  for (int i = 0; i < NUM_MODEL_SLOTS; i++) {
+    const ResidentModel& slot = modelRegistry[i];
+    if (!slot.resident) continue;
+
+    Serial.print("Tensor Arena [");
+    Serial.print(slot.info.name);
+    Serial.print("]: ");
+    Serial.print(slot.interpreter->arena_used_bytes());
+    Serial.print(" / ");
+    Serial.print(slot.arenaSize);
+    Serial.println(" bytes");
+
+    // Partition sized from a plan rather than the measured value
+    uint32_t used = (slot.interpreter->arena_used_bytes() + 15) & ~15u;
+    if (used < slot.arenaSize) {
+      Serial.print("  Pin with: generate_op_resolver.py --measured ");
+      printModelMacroName(slot.info.name);
+      Serial.print("=");
+      Serial.println(used);
+    }
   }
 
   // Frame buffers
   Serial.print("Frame Buffers: ");
-  Serial.print((FRAME_BUFFER_SIZE * 2) / 1024);
-  Serial.println(" KB");
-
-  // Preprocessing buffer
-  Serial.print("Preprocessing Buffer: ");
-  Serial.print((MODEL_INPUT_WIDTH * MODEL_INPUT_HEIGHT * MODEL_INPUT_CHANNELS) / 1024);
-  Serial.println(" KB");
+  Serial.print((FRAME_BUFFER_SIZE * FRAME_BUFFER_COUNT) / 1024);
+  Serial.print(" KB");
+  Serial.println(FRAME_BUFFER_SHARED ? " (shared by both cameras)" : "");
+
+  // Where each buffer ended up (memory_map.h)
+  printMemoryPlacement("  frameBuffer1", frameBuffer1, FRAME_BUFFER_SIZE);
+  if (!FRAME_BUFFER_SHARED) {
+    printMemoryPlacement("  frameBuffer2", frameBuffer2, FRAME_BUFFER_SIZE);
+  }
+  printMemoryPlacement("  tensor_arena", tensor_arena, kTensorArenaSize);
+  printMemoryPlacement("  preprocessLUT", &preprocessLUT, sizeof(preprocessLUT));
+  printMemoryPlacement("  motionGates", motionGates, sizeof(motionGates));
 
-  // Total
-  uint32_t total = (FRAME_BUFFER_SIZE * 2) +
-                   (MODEL_INPUT_WIDTH * MODEL_INPUT_HEIGHT * MODEL_INPUT_CHANNELS) +
-                   kTensorArenaSize;
+  // Total (preprocessing writes into the tensor arena, no extra buffer)
+  uint32_t total = (FRAME_BUFFER_SIZE * FRAME_BUFFER_COUNT) + kTensorArenaSize;
   Serial.print("Total: ");
   Serial.print(total / 1024);
   Serial.println(" KB");
 
+  // Per region, by where the linker actually put the buffers
+  uint32_t regionBytes[MEMORY_REGION_SDRAM + 1] = {0};
+  regionBytes[memoryRegionOf(frameBuffer1)] += FRAME_BUFFER_SIZE;
+  if (!FRAME_BUFFER_SHARED) {
+    regionBytes[memoryRegionOf(frameBuffer2)] += FRAME_BUFFER_SIZE;
+  }
+  regionBytes[memoryRegionOf(tensor_arena)] += kTensorArenaSize;
+
+  bool fits = true;
+  for (uint8_t region = 0; region <= MEMORY_REGION_SDRAM; region++) {
+    uint32_t capacity = memoryRegionSize(region);
+    if (capacity != 0 && regionBytes[region] > capacity) {
+      Serial.print("ERROR: ");
+      Serial.print(memoryRegionName(region));
+      Serial.print(" over-committed: ");
+      Serial.print(regionBytes[region] / 1024);
+      Serial.print(" KB of ");
+      Serial.print(capacity / 1024);
+      Serial.println(" KB (trim RESIDENT_MODEL_MASK)");
+      fits = false;
+    }
+  }
+
   Serial.println("===================");
+  return fits;
 }
 
 /**
@@ -1402,11 +2495,7 @@ void printMemoryUsage() {
 float getAverageConfidence() {
   if (totalDetections == 0) return 0.0f;
 
-  float sum = 0.0f;
-  if (lastDetection1.valid) sum += lastDetection1.confidence;
-  if (lastDetection2.valid) sum += lastDetection2.confidence;
-
-  return sum / totalDetections;
+  return detectionConfidenceSum / totalDetections;
 }
 
 /**
@@ -1415,8 +2504,8 @@ float getAverageConfidence() {
 void resetStatistics() {
   totalDetections = 0;
   memset(detectionCounts, 0, sizeof(detectionCounts));
-  detectionBuffer1.clear();
-  detectionBuffer2.clear();
+  detectionConfidenceSum = 0.0f;
+  alarmCount = 0;
 
   Serial.println("Statistics reset");
 }
@@ -1440,13 +2529,18 @@ void printStatistics() {
   Serial.print(getAverageConfidence() * 100);
   Serial.println("%");
 
-  Serial.println("Camera 1 Buffer: ");
-  Serial.print("  Size: ");
-  Serial.println(detectionBuffer1.size());
+  Serial.print("Alarms: ");
+  Serial.println(alarmCount);
 
-  Serial.println("Camera 2 Buffer: ");
-  Serial.print("  Size: ");
-  Serial.println(detectionBuffer2.size());
+  Serial.print("Camera 1 Tracks: ");
+  Serial.print(tracker1.confirmedCount());
+  Serial.print(" confirmed / ");
+  Serial.println(tracker1.activeCount());
+
+  Serial.print("Camera 2 Tracks: ");
+  Serial.print(tracker2.confirmedCount());
+  Serial.print(" confirmed / ");
+  Serial.println(tracker2.activeCount());
 
   Serial.println("=============================");
 
@@ -1494,6 +2588,26 @@ void setup() {
   Serial.begin(115200);
   while (!Serial && millis() < 3000);
 
+  // Cycle-accurate span timing
+  tracer().begin();
+
+  // Section-placed buffers are not zeroed at startup
+  preprocessLUT.valid = false;
+
+#if TILING_ENABLED
+  for (uint8_t i = 0; i < 2; i++) {
+    if (!tileSchedulers[i].configure(CAMERA_WIDTH, CAMERA_HEIGHT, TILE_WIDTH, TILE_HEIGHT,
+                                     TILE_OVERLAP)) {
+      Serial.println("ERROR: Tile layout exceeds TILING_MAX_TILES!");
+      while (1);  // Halt
+    }
+  }
+#endif
+  if (!checkMemoryMap()) {
+    Serial.println("ERROR: Frame buffers are not reachable by the camera DMA!");
+    while (1);  // Halt
+  }
+
   // Initialize alarm pins
   pinMode(ALARM_LED_PIN, OUTPUT);
   pinMode(ALARM_BUZZER_PIN, OUTPUT);
@@ -1518,19 +2632,25 @@ void setup() {
     while (1);  // Halt
   }
 
+  if (!printMemoryUsage()) {
+    Serial.println("ERROR: Buffers do not fit the memory map!");
+    while (1);  // Halt
+  }
+
   Serial.println("==================================");
   Serial.println("Dual Camera Object Detection");
   Serial.println("Ready to detect objects!");
   Serial.println("==================================");
+
+  nextFrameTime = micros();
 }
 
 void loop() {
   // Update alarm state
   updateAlarm();
 
-  // Process detections
-  processDetections();
-
-  // Small delay
-  delay(1000);
+  // Process the next frame when its slot is due
+  if (frameDue()) {
+    processDetections();
+  }
 }
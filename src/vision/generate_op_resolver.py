@@ -0,0 +1,633 @@
+#!/usr/bin/env python3
+"""
+Op Resolver Generator
+Reads one or more TFLite models and emits model_ops.h with:
+- A MicroMutableOpResolver<N> registering only the operators the models use
+- The tensor arena size each model needs
+
+Operators whose activations are int8 in every model are registered with
+TFLM's int8-only kernels (Register_CONV_2D_INT8() and so on). With the
+CMSIS-NN kernel build (CMSIS_NN defined, the default for Cortex-M in the
+Arduino TFLM library) these are the arm_*_s8 kernels, and the reference
+float/uint8 paths are not linked. Without CMSIS-NN they fall back to the
+generic kernels. MODEL_OPS_INT8 is 1 when every model is int8 end to end;
+the firmware then rejects models whose input/output tensors are not int8.
+
+Usage:
+    python generate_op_resolver.py person.tflite vehicle.tflite -o model_ops.h
+    python generate_op_resolver.py model_data.h:PERSON_DETECTION -o model_ops.h
+
+Inputs can be .tflite files or C arrays produced by `xxd -i` (e.g. the
+g_model array in model_template.h). An optional ":NAME" suffix sets the
+macro name used for that model's arena size.
+
+The arena size is computed from the model graph: activation tensors and
+kernel scratch buffers are planned with the same greedy first-fit strategy
+as TFLM's GreedyMemoryPlanner, then the interpreter's persistent
+allocations are added. After flashing, the firmware prints
+interpreter->arena_used_bytes(); pass that back with --measured NAME=BYTES
+to pin a model's arena to the measured value.
+
+Arduino build hook (platform.local.txt):
+    recipe.hooks.prebuild.1.pattern=python3 "{build.source.path}/generate_op_resolver.py" \
+        "{build.source.path}/model_data.h" -o "{build.source.path}/model_ops.h"
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional, Tuple
+
+
+# ===========================================
+# TFLITE SCHEMA
+# ===========================================
+
+# BuiltinOperator enum (tensorflow/lite/schema/schema.fbs) -> resolver method
+BUILTIN_OPS = {
+    0: "AddAdd",
+    1: "AddAveragePool2D",
+    2: "AddConcatenation",
+    3: "AddConv2D",
+    4: "AddDepthwiseConv2D",
+    5: "AddDepthToSpace",
+    6: "AddDequantize",
+    8: "AddFloor",
+    9: "AddFullyConnected",
+    11: "AddL2Normalization",
+    12: "AddL2Pool2D",
+    14: "AddLogistic",
+    17: "AddMaxPool2D",
+    18: "AddMul",
+    19: "AddRelu",
+    21: "AddRelu6",
+    22: "AddReshape",
+    23: "AddResizeBilinear",
+    25: "AddSoftmax",
+    26: "AddSpaceToDepth",
+    27: "AddSvdf",
+    28: "AddTanh",
+    34: "AddPad",
+    36: "AddGather",
+    37: "AddBatchToSpaceNd",
+    38: "AddSpaceToBatchNd",
+    39: "AddTranspose",
+    40: "AddMean",
+    41: "AddSub",
+    42: "AddDiv",
+    43: "AddSqueeze",
+    44: "AddUnidirectionalSequenceLSTM",
+    45: "AddStridedSlice",
+    47: "AddExp",
+    49: "AddSplit",
+    50: "AddLogSoftmax",
+    53: "AddCast",
+    54: "AddPrelu",
+    55: "AddMaximum",
+    56: "AddArgMax",
+    57: "AddMinimum",
+    58: "AddLess",
+    59: "AddNeg",
+    60: "AddPadV2",
+    61: "AddGreater",
+    62: "AddGreaterEqual",
+    63: "AddLessEqual",
+    65: "AddSlice",
+    67: "AddTransposeConv",
+    70: "AddExpandDims",
+    71: "AddEqual",
+    72: "AddNotEqual",
+    73: "AddLog",
+    74: "AddSum",
+    75: "AddSqrt",
+    76: "AddRsqrt",
+    77: "AddShape",
+    79: "AddArgMin",
+    82: "AddReduceMax",
+    83: "AddPack",
+    84: "AddLogicalOr",
+    86: "AddLogicalAnd",
+    87: "AddLogicalNot",
+    88: "AddUnpack",
+    90: "AddFloorDiv",
+    92: "AddSquare",
+    93: "AddZerosLike",
+    94: "AddFill",
+    95: "AddFloorMod",
+    97: "AddResizeNearestNeighbor",
+    98: "AddLeakyRelu",
+    99: "AddSquaredDifference",
+    100: "AddMirrorPad",
+    101: "AddAbs",
+    102: "AddSplitV",
+    104: "AddCeil",
+    106: "AddAddN",
+    107: "AddGatherNd",
+    111: "AddElu",
+    114: "AddQuantize",
+    116: "AddRound",
+    117: "AddHardSwish",
+    126: "AddBatchMatMul",
+}
+
+# Custom operators with a TFLM kernel
+CUSTOM_OPS = {
+    "TFLite_Detection_PostProcess": "AddDetectionPostprocess",
+}
+
+# Resolver method -> int8-only registration and its kernel header
+INT8_KERNELS = {
+    "AddAdd": ("Register_ADD_INT8", "add.h"),
+    "AddAveragePool2D": ("Register_AVERAGE_POOL_2D_INT8", "pooling.h"),
+    "AddConv2D": ("Register_CONV_2D_INT8", "conv.h"),
+    "AddDepthwiseConv2D": ("Register_DEPTHWISE_CONV_2D_INT8", "depthwise_conv.h"),
+    "AddFullyConnected": ("Register_FULLY_CONNECTED_INT8", "fully_connected.h"),
+    "AddMaxPool2D": ("Register_MAX_POOL_2D_INT8", "pooling.h"),
+    "AddMul": ("Register_MUL_INT8", "mul.h"),
+    "AddSoftmax": ("Register_SOFTMAX_INT8", "softmax.h"),
+}
+
+BUILTIN_CONV_2D = 3
+BUILTIN_DEPTHWISE_CONV_2D = 4
+BUILTIN_FULLY_CONNECTED = 9
+BUILTIN_CUSTOM = 32
+
+TENSOR_TYPE_INT8 = 9
+
+# TensorType enum -> element size in bytes
+TENSOR_TYPE_SIZES = {
+    0: 4,   # FLOAT32
+    1: 2,   # FLOAT16
+    2: 4,   # INT32
+    3: 1,   # UINT8
+    4: 8,   # INT64
+    6: 1,   # BOOL
+    7: 2,   # INT16
+    9: 1,   # INT8
+    10: 8,  # FLOAT64
+}
+
+# TFLM allocator constants (32-bit target)
+BUFFER_ALIGNMENT = 16
+PERSISTENT_PER_TENSOR = 16      # TfLiteEvalTensor + dims
+PERSISTENT_PER_IO_TENSOR = 72   # Full TfLiteTensor for inputs/outputs
+PERSISTENT_PER_OP = 64          # NodeAndRegistration + op user data
+PERSISTENT_PER_CHANNEL = 8      # Per-channel multiplier + shift
+PERSISTENT_FIXED = 1024         # Interpreter and allocator bookkeeping
+
+
+# ===========================================
+# FLATBUFFER READER
+# ===========================================
+
+class FlatTable:
+    """Minimal read-only view of a FlatBuffers table"""
+
+    def __init__(self, buf: bytes, pos: int):
+        self.buf = buf
+        self.pos = pos
+        vtable = pos - struct.unpack_from("<i", buf, pos)[0]
+        self.vtable = vtable
+        self.vtable_size = struct.unpack_from("<H", buf, vtable)[0]
+
+    def _field_offset(self, index: int) -> int:
+        entry = 4 + 2 * index
+        if entry >= self.vtable_size:
+            return 0
+        return struct.unpack_from("<H", self.buf, self.vtable + entry)[0]
+
+    def scalar(self, index: int, fmt: str, default=0):
+        offset = self._field_offset(index)
+        if offset == 0:
+            return default
+        return struct.unpack_from("<" + fmt, self.buf, self.pos + offset)[0]
+
+    def _indirect(self, index: int) -> Optional[int]:
+        offset = self._field_offset(index)
+        if offset == 0:
+            return None
+        at = self.pos + offset
+        return at + struct.unpack_from("<I", self.buf, at)[0]
+
+    def table(self, index: int) -> Optional["FlatTable"]:
+        target = self._indirect(index)
+        return FlatTable(self.buf, target) if target is not None else None
+
+    def string(self, index: int) -> Optional[str]:
+        target = self._indirect(index)
+        if target is None:
+            return None
+        length = struct.unpack_from("<I", self.buf, target)[0]
+        return self.buf[target + 4:target + 4 + length].decode("utf-8", "replace")
+
+    def vector_length(self, index: int) -> int:
+        target = self._indirect(index)
+        if target is None:
+            return 0
+        return struct.unpack_from("<I", self.buf, target)[0]
+
+    def scalar_vector(self, index: int, fmt: str) -> List[int]:
+        target = self._indirect(index)
+        if target is None:
+            return []
+        length = struct.unpack_from("<I", self.buf, target)[0]
+        return list(struct.unpack_from("<%d%s" % (length, fmt), self.buf, target + 4))
+
+    def table_vector(self, index: int) -> List["FlatTable"]:
+        target = self._indirect(index)
+        if target is None:
+            return []
+        length = struct.unpack_from("<I", self.buf, target)[0]
+        tables = []
+        for i in range(length):
+            at = target + 4 + 4 * i
+            tables.append(FlatTable(self.buf, at + struct.unpack_from("<I", self.buf, at)[0]))
+        return tables
+
+
+# ===========================================
+# MODEL ANALYSIS
+# ===========================================
+
+@dataclass
+class TensorInfo:
+    """Tensor metadata needed for memory planning"""
+    shape: List[int]
+    element_size: int
+    constant: bool
+    variable: bool
+    int8: bool = False
+
+    @property
+    def bytes(self) -> int:
+        count = 1
+        for dim in self.shape:
+            count *= max(dim, 1)
+        return count * self.element_size
+
+
+@dataclass
+class ModelInfo:
+    """Operators and memory requirements of one model"""
+    name: str
+    source: str
+    ops: List[str] = field(default_factory=list)
+    non_int8_ops: List[str] = field(default_factory=list)
+    unsupported: List[str] = field(default_factory=list)
+    int8_io: bool = False
+    planned_bytes: int = 0
+    persistent_bytes: int = 0
+    headroom: float = 0.0
+    measured_bytes: Optional[int] = None
+
+    @property
+    def arena_bytes(self) -> int:
+        if self.measured_bytes is not None:
+            return align(self.measured_bytes, BUFFER_ALIGNMENT)
+        planned = self.planned_bytes + self.persistent_bytes
+        return align(int(planned * (1.0 + self.headroom)), BUFFER_ALIGNMENT)
+
+
+def align(value: int, alignment: int) -> int:
+    return (value + alignment - 1) // alignment * alignment
+
+
+def load_model_bytes(path: str) -> bytes:
+    """Read a .tflite file or extract the bytes of an xxd-style C array"""
+    with open(path, "rb") as f:
+        data = f.read()
+
+    if path.endswith(".tflite"):
+        return data
+
+    text = data.decode("utf-8", "replace")
+    match = re.search(r"unsigned\s+char\s+\w+\s*\[\s*\]\s*(?:\w+\s*)*=\s*\{(.*?)\}", text, re.S)
+    if not match:
+        raise ValueError("%s: no unsigned char array found" % path)
+
+    body = re.sub(r"//[^\n]*|/\*.*?\*/", "", match.group(1), flags=re.S)
+    return bytes(int(token, 0) for token in re.findall(r"0[xX][0-9a-fA-F]+|\d+", body))
+
+
+def op_name(opcode: FlatTable) -> Tuple[int, Optional[str]]:
+    """Builtin code and custom name of an OperatorCode table"""
+    deprecated = opcode.scalar(0, "b", 0)
+    builtin = opcode.scalar(3, "i", 0)
+    return max(deprecated, builtin), opcode.string(1)
+
+
+def plan_greedy(buffers: List[Tuple[int, int, int]]) -> int:
+    """
+    First-fit placement by decreasing size, as TFLM's GreedyMemoryPlanner.
+    buffers: (size, first_use, last_use). Returns the peak offset.
+    """
+    placed = []  # (offset, size, first, last)
+    peak = 0
+
+    for size, first, last in sorted(buffers, key=lambda b: -b[0]):
+        size = align(size, BUFFER_ALIGNMENT)
+        overlapping = sorted((o, s) for o, s, f, l in placed if f <= last and first <= l)
+
+        offset = 0
+        for other_offset, other_size in overlapping:
+            if offset + size <= other_offset:
+                break
+            offset = max(offset, other_offset + other_size)
+
+        placed.append((offset, size, first, last))
+        peak = max(peak, offset + size)
+
+    return peak
+
+
+def scratch_bytes(builtin: int, tensors: List[TensorInfo], inputs: List[int]) -> int:
+    """Kernel scratch buffer estimate (CMSIS-NN im2col / depthwise buffers)"""
+    if len(inputs) < 2 or inputs[1] < 0:
+        return 0
+    filter_shape = tensors[inputs[1]].shape
+    if len(filter_shape) != 4:
+        return 0
+
+    if builtin == BUILTIN_CONV_2D:
+        # [out, kh, kw, in] -> two im2col columns of int16
+        return 2 * filter_shape[1] * filter_shape[2] * filter_shape[3] * 2
+    if builtin == BUILTIN_DEPTHWISE_CONV_2D:
+        # [1, kh, kw, channels]
+        return filter_shape[1] * filter_shape[2] * filter_shape[3] * 2
+    return 0
+
+
+def analyze_model(name: str, source: str, data: bytes) -> ModelInfo:
+    if len(data) < 8 or data[4:8] != b"TFL3":
+        raise ValueError("%s: not a TFLite flatbuffer (missing TFL3 identifier)" % source)
+
+    root = FlatTable(data, struct.unpack_from("<I", data, 0)[0])
+    info = ModelInfo(name=name, source=source)
+
+    opcodes = root.table_vector(1)
+    subgraphs = root.table_vector(2)
+    buffers = root.table_vector(4)
+
+    def read_tensors(subgraph: FlatTable) -> List[TensorInfo]:
+        result = []
+        for tensor in subgraph.table_vector(0):
+            buffer_index = tensor.scalar(2, "I", 0)
+            constant = False
+            if 0 < buffer_index < len(buffers):
+                constant = buffers[buffer_index].vector_length(0) > 0
+            tensor_type = tensor.scalar(1, "b", 0)
+            result.append(TensorInfo(
+                shape=tensor.scalar_vector(0, "i"),
+                element_size=TENSOR_TYPE_SIZES.get(tensor_type, 4),
+                constant=constant,
+                variable=bool(tensor.scalar(5, "B", 0)),
+                int8=tensor_type == TENSOR_TYPE_INT8,
+            ))
+        return result
+
+    # Operators used by any subgraph; an operator is int8 if all of its
+    # activation tensors (non-constant inputs and outputs) are int8
+    methods = {}
+    for subgraph in subgraphs:
+        graph_tensors = read_tensors(subgraph)
+        for op in subgraph.table_vector(3):
+            index = op.scalar(0, "I", 0)
+            activations = [graph_tensors[i] for i in op.scalar_vector(1, "i") + op.scalar_vector(2, "i")
+                           if i >= 0 and not graph_tensors[i].constant]
+            int8 = all(t.int8 for t in activations)
+            methods[index] = methods.get(index, True) and int8
+
+    for index in sorted(methods):
+        builtin, custom = op_name(opcodes[index])
+        if builtin == BUILTIN_CUSTOM:
+            method = CUSTOM_OPS.get(custom or "")
+            label = custom or "CUSTOM"
+        else:
+            method = BUILTIN_OPS.get(builtin)
+            label = "builtin %d" % builtin
+        if method is None:
+            info.unsupported.append(label)
+            continue
+        if method not in info.ops:
+            info.ops.append(method)
+        if not methods[index] and method not in info.non_int8_ops:
+            info.non_int8_ops.append(method)
+
+    # Memory plan for the main subgraph
+    subgraph = subgraphs[0]
+    tensors = read_tensors(subgraph)
+
+    operators = subgraph.table_vector(3)
+    graph_inputs = subgraph.scalar_vector(1, "i")
+    graph_outputs = subgraph.scalar_vector(2, "i")
+    last_op = max(len(operators) - 1, 0)
+
+    info.int8_io = all(tensors[i].int8 for i in graph_inputs + graph_outputs if i >= 0)
+
+    lifetimes: Dict[int, List[int]] = {}
+
+    def touch(tensor_index: int, op_index: int):
+        if tensor_index < 0 or tensors[tensor_index].constant or tensors[tensor_index].variable:
+            return
+        span = lifetimes.setdefault(tensor_index, [op_index, op_index])
+        span[0] = min(span[0], op_index)
+        span[1] = max(span[1], op_index)
+
+    for tensor_index in graph_inputs:
+        touch(tensor_index, 0)
+    for tensor_index in graph_outputs:
+        touch(tensor_index, last_op)
+
+    plan = []
+    per_channel = 0
+    for op_index, op in enumerate(operators):
+        op_inputs = op.scalar_vector(1, "i")
+        op_outputs = op.scalar_vector(2, "i")
+        for tensor_index in op_inputs + op_outputs:
+            touch(tensor_index, op_index)
+
+        builtin, _ = op_name(opcodes[op.scalar(0, "I", 0)])
+        scratch = scratch_bytes(builtin, tensors, op_inputs)
+        if scratch:
+            plan.append((scratch, op_index, op_index))
+
+        if builtin in (BUILTIN_CONV_2D, BUILTIN_DEPTHWISE_CONV_2D, BUILTIN_FULLY_CONNECTED):
+            if op_outputs and op_outputs[0] >= 0 and tensors[op_outputs[0]].shape:
+                per_channel += tensors[op_outputs[0]].shape[-1]
+
+    for tensor_index, (first, last) in lifetimes.items():
+        plan.append((tensors[tensor_index].bytes, first, last))
+
+    variable_bytes = sum(align(t.bytes, BUFFER_ALIGNMENT) for t in tensors if t.variable)
+
+    info.planned_bytes = plan_greedy(plan)
+    info.persistent_bytes = (PERSISTENT_FIXED +
+                             PERSISTENT_PER_TENSOR * len(tensors) +
+                             PERSISTENT_PER_IO_TENSOR * (len(graph_inputs) + len(graph_outputs)) +
+                             PERSISTENT_PER_OP * len(operators) +
+                             PERSISTENT_PER_CHANNEL * per_channel +
+                             variable_bytes)
+    return info
+
+
+# ===========================================
+# HEADER GENERATION
+# ===========================================
+
+def macro_name(name: str) -> str:
+    return re.sub(r"[^A-Z0-9]+", "_", name.upper()).strip("_")
+
+
+def render_header(models: List[ModelInfo], ops: List[str], int8_ops: List[str]) -> str:
+    lines = [
+        "/**",
+        " * Model Op Resolver (generated)",
+        " *",
+        " * Generated by generate_op_resolver.py from:",
+    ]
+    for model in models:
+        lines.append(" * - %s (%s)" % (os.path.basename(model.source), model.name))
+    lines += [
+        " *",
+        " * Do not edit by hand; re-run the generator when a model changes.",
+        " */",
+        "",
+        "#ifndef MODEL_OPS_H",
+        "#define MODEL_OPS_H",
+        "",
+        "#include <tensorflow/lite/micro/micro_mutable_op_resolver.h>",
+    ]
+    for header in sorted(set(INT8_KERNELS[method][1] for method in int8_ops)):
+        lines.append("#include <tensorflow/lite/micro/kernels/%s>" % header)
+
+    full_int8 = all(model.int8_io and not model.non_int8_ops for model in models)
+    lines += [
+        "",
+        "// 1: sizes below come from the models (0 in the checked-in placeholder)",
+        "#define MODEL_OPS_GENERATED 1",
+        "",
+        "// Number of distinct operators across all resident models",
+        "#define MODEL_OP_COUNT %d" % len(ops),
+        "",
+        "// 1 if every model is int8 end to end (int8 input/output tensors)",
+        "#define MODEL_OPS_INT8 %d" % (1 if full_int8 else 0),
+        "",
+        "// Tensor arena required by each model (bytes, 16-byte aligned)",
+    ]
+
+    sizes = []
+    for model in models:
+        if model.measured_bytes is None:
+            origin = "planned %d + persistent %d, %d%% headroom" % (
+                model.planned_bytes, model.persistent_bytes, round(model.headroom * 100))
+        else:
+            origin = "measured arena_used_bytes()"
+        sizes.append(model.arena_bytes)
+        lines.append("#define MODEL_ARENA_SIZE_%s %d  // %s" %
+                     (macro_name(model.name), model.arena_bytes, origin))
+
+    lines += [
+        "",
+        "// Largest single model / all resident models together",
+        "#define MODEL_ARENA_SIZE_MAX %d" % max(sizes),
+        "#define MODEL_ARENA_SIZE_TOTAL %d" % sum(sizes),
+        "",
+        "typedef tflite::MicroMutableOpResolver<MODEL_OP_COUNT> ModelOpResolver;",
+        "",
+        "/**",
+        " * Register exactly the operators used by the resident models",
+        " * (int8-only kernels where every model runs the op in int8)",
+        " */",
+        "inline bool registerModelOps(ModelOpResolver& resolver) {",
+    ]
+    for method in ops:
+        registration = "tflite::%s()" % INT8_KERNELS[method][0] if method in int8_ops else ""
+        lines.append("  if (resolver.%s(%s) != kTfLiteOk) return false;" % (method, registration))
+    lines += [
+        "  return true;",
+        "}",
+        "",
+        "#endif  // MODEL_OPS_H",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def main():
+    """Main entry point"""
+    parser = argparse.ArgumentParser(
+        description="Generate a MicroMutableOpResolver and arena sizes from TFLite models"
+    )
+    parser.add_argument("models", nargs="+",
+                        help="Model files (.tflite or xxd C array), optionally PATH:NAME")
+    parser.add_argument("-o", "--output", default="model_ops.h", help="Output header")
+    parser.add_argument("--headroom", type=float, default=0.10,
+                        help="Fractional headroom added to planned arena sizes")
+    parser.add_argument("--measured", action="append", default=[],
+                        metavar="NAME=BYTES",
+                        help="Use a measured arena_used_bytes() value for a model")
+    parser.add_argument("--generic-kernels", action="store_true",
+                        help="Register the type-generic kernels even for int8 operators")
+
+    args = parser.parse_args()
+
+    measured = {}
+    for entry in args.measured:
+        name, _, value = entry.partition("=")
+        measured[macro_name(name)] = int(value, 0)
+
+    models = []
+    for spec in args.models:
+        path, name = spec, None
+        if ":" in spec and not os.path.exists(spec):
+            path, name = spec.rsplit(":", 1)
+        name = name or os.path.splitext(os.path.basename(path))[0]
+
+        try:
+            info = analyze_model(name, path, load_model_bytes(path))
+        except (OSError, ValueError) as e:
+            print("ERROR: %s" % e, file=sys.stderr)
+            return 1
+        except (struct.error, IndexError):
+            print("ERROR: %s: truncated or malformed model (placeholder array?)" % path,
+                  file=sys.stderr)
+            return 1
+
+        if info.unsupported:
+            print("ERROR: %s uses operators without a TFLM kernel: %s" %
+                  (path, ", ".join(info.unsupported)), file=sys.stderr)
+            return 1
+
+        info.headroom = args.headroom
+        info.measured_bytes = measured.get(macro_name(name))
+        models.append(info)
+
+    ops = []
+    for model in models:
+        for method in model.ops:
+            if method not in ops:
+                ops.append(method)
+    ops.sort()
+
+    int8_ops = []
+    if not args.generic_kernels:
+        int8_ops = [method for method in ops if method in INT8_KERNELS and
+                    not any(method in model.non_int8_ops for model in models)]
+
+    with open(args.output, "w") as f:
+        f.write(render_header(models, ops, int8_ops))
+
+    for model in models:
+        print("%s: %d ops, arena %d bytes%s" % (model.name, len(model.ops), model.arena_bytes,
+                                                 ", int8" if model.int8_io and not model.non_int8_ops else ""))
+        if model.non_int8_ops:
+            print("  not int8: %s" % ", ".join(model.non_int8_ops))
+    print("Wrote %s (%d ops, %d int8 kernels)" % (args.output, len(ops), len(int8_ops)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,611 @@
+/**
+ * Image Preprocessing Kernels
+ *
+ * Shared RGB565 -> RGB888 resize kernels used by dual_camera_ml.cpp and
+ * nicla_vision_camera.ino:
+ * - Integer column/row lookup tables, built once per resolution
+ * - Two pixels per 32-bit word RGB565 unpacking (SWAR), with Cortex-M7
+ *   DSP intrinsics (PKHBT/SMLAD) when CMSIS is available
+ * - Nearest-neighbour, bilinear and area (box) resampling
+ * - Input quantization fused into the same pass, so frames can be written
+ *   straight into the model's input tensor
+ *
+ * Source frames are native-endian RGB565 and must be 2-byte aligned.
+ * Include after Arduino.h so the CMSIS intrinsics are visible.
+ */
+
+#ifndef IMAGE_PREPROCESSING_H
+#define IMAGE_PREPROCESSING_H
+
+#include <stdint.h>
+#include <string.h>
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+// Largest supported output width/height
+#ifndef PREPROC_MAX_OUTPUT_DIM
+#define PREPROC_MAX_OUTPUT_DIM 224
+#endif
+
+// Largest source box averaged per output pixel in area mode
+#define PREPROC_MAX_AREA_SPAN 16
+
+// Use Cortex-M DSP extension intrinsics from CMSIS
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1) && defined(__CMSIS_GCC_H)
+#define PREPROC_USE_DSP 1
+#else
+#define PREPROC_USE_DSP 0
+#endif
+
+enum ResizeMode {
+  RESIZE_NEAREST,   // Fastest, aliases on large downscales
+  RESIZE_BILINEAR,  // 2x2 interpolation, good for mild scaling
+  RESIZE_AREA       // Box average over the source footprint
+};
+
+// ===========================================
+// RESIZE LOOKUP TABLE
+// ===========================================
+
+/**
+ * Precomputed source coordinates for one (source window, output size, mode)
+ * combination. Rebuilding with unchanged parameters is a no-op, so callers
+ * can call buildResizeLUT() every frame.
+ */
+struct ResizeLUT {
+  uint16_t srcStride;   // Source row length in pixels
+  uint16_t srcX;        // Source window origin and size
+  uint16_t srcY;
+  uint16_t srcWidth;
+  uint16_t srcHeight;
+  uint16_t dstWidth;
+  uint16_t dstHeight;
+  ResizeMode mode;
+  bool valid;
+
+  // Absolute source column/row of each output column/row (left/top tap)
+  uint16_t col[PREPROC_MAX_OUTPUT_DIM];
+  uint16_t row[PREPROC_MAX_OUTPUT_DIM];
+
+  // Bilinear: weight of the right/bottom tap (0-256)
+  // Area: Q15 reciprocal of the box width/height
+  uint16_t colWeight[PREPROC_MAX_OUTPUT_DIM];
+  uint16_t rowWeight[PREPROC_MAX_OUTPUT_DIM];
+
+  // Area: box width/height in source pixels
+  uint8_t colSpan[PREPROC_MAX_OUTPUT_DIM];
+  uint8_t rowSpan[PREPROC_MAX_OUTPUT_DIM];
+
+  ResizeLUT() : srcStride(0), srcX(0), srcY(0), srcWidth(0), srcHeight(0),
+                dstWidth(0), dstHeight(0), mode(RESIZE_NEAREST), valid(false) {}
+};
+
+/**
+ * Fill one axis of the LUT
+ */
+static inline void buildResizeAxis(uint16_t srcOrigin, uint16_t srcSize, uint16_t dstSize,
+                                   ResizeMode mode, uint16_t* index,
+                                   uint16_t* weight, uint8_t* span) {
+  for (uint32_t i = 0; i < dstSize; i++) {
+    if (mode == RESIZE_NEAREST) {
+      // Sample at the centre of the output pixel's footprint
+      index[i] = srcOrigin + (uint16_t)(((2 * i + 1) * srcSize) / (2 * dstSize));
+      weight[i] = 0;
+      span[i] = 1;
+    } else if (mode == RESIZE_BILINEAR) {
+      // Centre-aligned source position in Q8
+      int32_t pos = (int32_t)((((2 * i + 1) * srcSize) << 8) / (2 * dstSize)) - 128;
+      if (pos < 0) pos = 0;
+
+      uint32_t left = pos >> 8;
+      uint32_t frac = pos & 0xFF;
+      if (left >= (uint32_t)(srcSize - 1)) {
+        left = srcSize - 2;
+        frac = 256;
+      }
+
+      index[i] = srcOrigin + left;
+      weight[i] = frac;
+      span[i] = 2;
+    } else {
+      uint32_t start = (i * srcSize) / dstSize;
+      uint32_t end = ((i + 1) * srcSize) / dstSize;
+      uint32_t count = (end > start) ? (end - start) : 1;
+      if (count > PREPROC_MAX_AREA_SPAN) count = PREPROC_MAX_AREA_SPAN;
+
+      index[i] = srcOrigin + start;
+      weight[i] = (uint16_t)(32768 / count);
+      span[i] = count;
+    }
+  }
+}
+
+/**
+ * Build (or reuse) a resize LUT for a source window of a frame.
+ * Returns false if the geometry is not supported.
+ */
+static inline bool buildResizeLUT(ResizeLUT& lut, uint16_t srcStride,
+                                  uint16_t srcX, uint16_t srcY,
+                                  uint16_t srcWidth, uint16_t srcHeight,
+                                  uint16_t dstWidth, uint16_t dstHeight,
+                                  ResizeMode mode) {
+  if (lut.valid && lut.srcStride == srcStride && lut.srcX == srcX &&
+      lut.srcY == srcY && lut.srcWidth == srcWidth && lut.srcHeight == srcHeight &&
+      lut.dstWidth == dstWidth && lut.dstHeight == dstHeight && lut.mode == mode) {
+    return true;
+  }
+
+  lut.valid = false;
+
+  if (dstWidth == 0 || dstHeight == 0 ||
+      dstWidth > PREPROC_MAX_OUTPUT_DIM || dstHeight > PREPROC_MAX_OUTPUT_DIM ||
+      srcWidth == 0 || srcHeight == 0 || srcX + srcWidth > srcStride) {
+    return false;
+  }
+
+  // Bilinear needs a right/bottom neighbour inside the window
+  if (mode == RESIZE_BILINEAR && (srcWidth < 2 || srcHeight < 2)) {
+    mode = RESIZE_NEAREST;
+  }
+
+  buildResizeAxis(srcX, srcWidth, dstWidth, mode, lut.col, lut.colWeight, lut.colSpan);
+  buildResizeAxis(srcY, srcHeight, dstHeight, mode, lut.row, lut.rowWeight, lut.rowSpan);
+
+  lut.srcStride = srcStride;
+  lut.srcX = srcX;
+  lut.srcY = srcY;
+  lut.srcWidth = srcWidth;
+  lut.srcHeight = srcHeight;
+  lut.dstWidth = dstWidth;
+  lut.dstHeight = dstHeight;
+  lut.mode = mode;
+  lut.valid = true;
+
+  return true;
+}
+
+// ===========================================
+// PIXEL PRIMITIVES
+// ===========================================
+
+/**
+ * Pack two 16-bit values into one word (lo in bits 0-15)
+ */
+static inline uint32_t pack16x2(uint32_t lo, uint32_t hi) {
+#if PREPROC_USE_DSP
+  return __PKHBT(lo, hi, 16);
+#else
+  return (lo & 0xFFFF) | (hi << 16);
+#endif
+}
+
+/**
+ * Dual 16-bit multiply-accumulate: lo(a)*lo(b) + hi(a)*hi(b) + acc
+ */
+static inline uint32_t dot16x2(uint32_t a, uint32_t b, uint32_t acc) {
+#if PREPROC_USE_DSP
+  return __SMLAD(a, b, acc);
+#else
+  return (a & 0xFFFF) * (b & 0xFFFF) + (a >> 16) * (b >> 16) + acc;
+#endif
+}
+
+/**
+ * Unpack two RGB565 pixels (one per 16-bit lane) into 8-bit channels,
+ * one per 16-bit lane. 5/6-bit fields are expanded by bit replication so
+ * full scale maps to 255.
+ */
+static inline void unpackRGB565x2(uint32_t pair, uint32_t& r, uint32_t& g, uint32_t& b) {
+  r = (pair >> 11) & 0x001F001F;
+  g = (pair >> 5) & 0x003F003F;
+  b = pair & 0x001F001F;
+
+  // Right shifts are masked so the high lane cannot leak into the low one
+  r = (r << 3) | ((r >> 2) & 0x00070007);
+  g = (g << 2) | ((g >> 4) & 0x00030003);
+  b = (b << 3) | ((b >> 2) & 0x00070007);
+}
+
+/**
+ * Expand a single RGB565 pixel into three bytes
+ */
+static inline void storeRGB565asRGB888(uint16_t pixel, uint8_t* dst) {
+  uint32_t r, g, b;
+  unpackRGB565x2(pixel, r, g, b);
+  dst[0] = r;
+  dst[1] = g;
+  dst[2] = b;
+}
+
+/**
+ * Store four RGB565 pixels (two packed pairs) as 12 RGB888 bytes using
+ * three word stores, optionally XOR-ing every byte (int8 offset)
+ */
+static inline void storeRGB565x4asRGB888(uint32_t pair01, uint32_t pair23, uint8_t* dst,
+                                         uint32_t xorMask = 0) {
+  uint32_t rA, gA, bA, rB, gB, bB;
+  unpackRGB565x2(pair01, rA, gA, bA);
+  unpackRGB565x2(pair23, rB, gB, bB);
+
+  // Lanes hold r|g<<8: bytes r0 g0 r1 g1
+  uint32_t rgA = rA | (gA << 8);
+  uint32_t rgB = rB | (gB << 8);
+
+  uint32_t w0 = (rgA & 0xFFFF) | ((bA & 0xFF) << 16) | ((rgA & 0x00FF0000) << 8);
+  uint32_t w1 = (rgA >> 24) | (((bA >> 16) & 0xFF) << 8) | (rgB << 16);
+  uint32_t w2 = (bB & 0xFF) | ((rgB >> 16) << 8) | ((bB >> 16) << 24);
+
+  w0 ^= xorMask;
+  w1 ^= xorMask;
+  w2 ^= xorMask;
+
+  memcpy(dst, &w0, 4);
+  memcpy(dst + 4, &w1, 4);
+  memcpy(dst + 8, &w2, 4);
+}
+
+// ===========================================
+// INPUT QUANTIZATION
+// ===========================================
+
+enum InputFormat {
+  INPUT_FORMAT_UINT8,
+  INPUT_FORMAT_INT8,
+  INPUT_FORMAT_FLOAT32
+};
+
+/**
+ * Mapping from 8-bit pixel values to the model's input tensor encoding,
+ * applied by the resize kernels while they write each output byte.
+ *
+ * Pixels are first normalised as real = (pixel - mean) / std, then
+ * quantized with the tensor's scale/zero_point. Common cases collapse to
+ * a straight copy (uint8, scale 1/255) or a sign flip (int8, zero_point
+ * -128) and keep the word-store fast path.
+ */
+struct InputQuantization {
+  InputFormat format;
+  bool identity;      // uint8: output == pixel
+  bool offset128;     // int8: output == pixel - 128 (XOR 0x80)
+  float floatScale;   // float32: output = pixel * floatScale + floatBias
+  float floatBias;
+  uint8_t lut[256];   // General 8-bit mapping (int8 stored as raw bits)
+
+  InputQuantization() : format(INPUT_FORMAT_UINT8), identity(true), offset128(false),
+                        floatScale(1.0f), floatBias(0.0f) {}
+};
+
+/**
+ * Build the pixel mapping for a model input.
+ * scale/zeroPoint come from the input tensor's quantization params and are
+ * ignored for float inputs.
+ */
+static inline bool buildInputQuantization(InputQuantization& quant, InputFormat format,
+                                          float scale, int32_t zeroPoint,
+                                          float mean, float std) {
+  if (std == 0.0f) {
+    return false;
+  }
+
+  quant.format = format;
+  quant.identity = false;
+  quant.offset128 = false;
+  quant.floatScale = 1.0f / std;
+  quant.floatBias = -mean / std;
+
+  if (format == INPUT_FORMAT_FLOAT32) {
+    return true;
+  }
+
+  if (scale <= 0.0f) {
+    return false;
+  }
+
+  int32_t minValue = (format == INPUT_FORMAT_INT8) ? -128 : 0;
+  int32_t maxValue = (format == INPUT_FORMAT_INT8) ? 127 : 255;
+  bool identity = true;
+  bool offset128 = true;
+
+  for (int32_t pixel = 0; pixel < 256; pixel++) {
+    float real = (pixel - mean) / std;
+    float scaled = real / scale;
+    int32_t q = (int32_t)(scaled + (scaled >= 0.0f ? 0.5f : -0.5f)) + zeroPoint;
+    if (q < minValue) q = minValue;
+    if (q > maxValue) q = maxValue;
+
+    quant.lut[pixel] = (uint8_t)q;
+    identity = identity && (q == pixel);
+    offset128 = offset128 && (q == pixel - 128);
+  }
+
+  quant.identity = (format == INPUT_FORMAT_UINT8) && identity;
+  quant.offset128 = (format == INPUT_FORMAT_INT8) && offset128;
+
+  return true;
+}
+
+// ===========================================
+// OUTPUT WRITERS
+// ===========================================
+
+// Kernels are templated on a writer so quantization happens in the same
+// pass as resampling, straight into the destination (tensor) memory.
+
+/**
+ * Raw bytes with an optional XOR (0x80 turns uint8 pixels into int8 - 128)
+ */
+template <uint32_t XorMask>
+struct ByteWriter {
+  uint8_t* dst;
+
+  explicit ByteWriter(void* out) : dst((uint8_t*)out) {}
+
+  void put(uint32_t r, uint32_t g, uint32_t b) {
+    dst[0] = r ^ (XorMask & 0xFF);
+    dst[1] = g ^ (XorMask & 0xFF);
+    dst[2] = b ^ (XorMask & 0xFF);
+    dst += 3;
+  }
+
+  void put4(uint32_t pair01, uint32_t pair23) {
+    storeRGB565x4asRGB888(pair01, pair23, dst, XorMask);
+    dst += 12;
+  }
+};
+
+/**
+ * General 8-bit quantization through a 256-entry table
+ */
+struct TableWriter {
+  uint8_t* dst;
+  const uint8_t* lut;
+
+  TableWriter(void* out, const uint8_t* table) : dst((uint8_t*)out), lut(table) {}
+
+  void put(uint32_t r, uint32_t g, uint32_t b) {
+    dst[0] = lut[r];
+    dst[1] = lut[g];
+    dst[2] = lut[b];
+    dst += 3;
+  }
+
+  void put4(uint32_t pair01, uint32_t pair23) {
+    uint32_t r, g, b;
+    unpackRGB565x2(pair01, r, g, b);
+    put(r & 0xFF, g & 0xFF, b & 0xFF);
+    put(r >> 16, g >> 16, b >> 16);
+    unpackRGB565x2(pair23, r, g, b);
+    put(r & 0xFF, g & 0xFF, b & 0xFF);
+    put(r >> 16, g >> 16, b >> 16);
+  }
+};
+
+/**
+ * Normalised float32 output
+ */
+struct FloatWriter {
+  float* dst;
+  float scale;
+  float bias;
+
+  FloatWriter(void* out, float s, float b) : dst((float*)out), scale(s), bias(b) {}
+
+  void put(uint32_t r, uint32_t g, uint32_t b) {
+    dst[0] = r * scale + bias;
+    dst[1] = g * scale + bias;
+    dst[2] = b * scale + bias;
+    dst += 3;
+  }
+
+  void put4(uint32_t pair01, uint32_t pair23) {
+    uint32_t r, g, b;
+    unpackRGB565x2(pair01, r, g, b);
+    put(r & 0xFF, g & 0xFF, b & 0xFF);
+    put(r >> 16, g >> 16, b >> 16);
+    unpackRGB565x2(pair23, r, g, b);
+    put(r & 0xFF, g & 0xFF, b & 0xFF);
+    put(r >> 16, g >> 16, b >> 16);
+  }
+};
+
+// ===========================================
+// RESIZE KERNELS
+// ===========================================
+
+/**
+ * Nearest-neighbour resize, 4 output pixels per iteration
+ */
+template <typename Writer>
+static inline void resizeNearestRGB565(const uint16_t* src, Writer& out, const ResizeLUT& lut) {
+  const uint16_t* col = lut.col;
+  uint16_t dstWidth = lut.dstWidth;
+
+  for (uint16_t y = 0; y < lut.dstHeight; y++) {
+    const uint16_t* srcRow = src + (uint32_t)lut.row[y] * lut.srcStride;
+    uint16_t x = 0;
+
+    for (; x + 4 <= dstWidth; x += 4) {
+      uint32_t pair01 = pack16x2(srcRow[col[x]], srcRow[col[x + 1]]);
+      uint32_t pair23 = pack16x2(srcRow[col[x + 2]], srcRow[col[x + 3]]);
+      out.put4(pair01, pair23);
+    }
+
+    for (; x < dstWidth; x++) {
+      uint32_t r, g, b;
+      unpackRGB565x2(srcRow[col[x]], r, g, b);
+      out.put(r, g, b);
+    }
+  }
+}
+
+/**
+ * Bilinear resize. Horizontal taps are interpolated as lane pairs with a
+ * single dual multiply-accumulate per channel.
+ */
+template <typename Writer>
+static inline void resizeBilinearRGB565(const uint16_t* src, Writer& out, const ResizeLUT& lut) {
+  for (uint16_t y = 0; y < lut.dstHeight; y++) {
+    const uint16_t* top = src + (uint32_t)lut.row[y] * lut.srcStride;
+    const uint16_t* bottom = top + lut.srcStride;
+    uint32_t wy = lut.rowWeight[y];
+
+    for (uint16_t x = 0; x < lut.dstWidth; x++) {
+      uint32_t x0 = lut.col[x];
+      uint32_t wx = lut.colWeight[x];
+      uint32_t weights = pack16x2(256 - wx, wx);
+
+      // Adjacent pixels: one (possibly unaligned) word load per row
+      uint32_t topPair, bottomPair;
+      memcpy(&topPair, top + x0, 4);
+      memcpy(&bottomPair, bottom + x0, 4);
+
+      uint32_t rT, gT, bT, rB, gB, bB;
+      unpackRGB565x2(topPair, rT, gT, bT);
+      unpackRGB565x2(bottomPair, rB, gB, bB);
+
+      uint32_t r = dot16x2(rT, weights, 0) * (256 - wy) + dot16x2(rB, weights, 0) * wy;
+      uint32_t g = dot16x2(gT, weights, 0) * (256 - wy) + dot16x2(gB, weights, 0) * wy;
+      uint32_t b = dot16x2(bT, weights, 0) * (256 - wy) + dot16x2(bB, weights, 0) * wy;
+
+      out.put((r + 32768) >> 16, (g + 32768) >> 16, (b + 32768) >> 16);
+    }
+  }
+}
+
+/**
+ * Area resize: average of the source box under each output pixel.
+ * Channel sums are accumulated two pixels at a time in 16-bit lanes.
+ */
+template <typename Writer>
+static inline void resizeAreaRGB565(const uint16_t* src, Writer& out, const ResizeLUT& lut) {
+  for (uint16_t y = 0; y < lut.dstHeight; y++) {
+    const uint16_t* srcRow = src + (uint32_t)lut.row[y] * lut.srcStride;
+    uint8_t rows = lut.rowSpan[y];
+    uint32_t rowRecip = lut.rowWeight[y];
+
+    for (uint16_t x = 0; x < lut.dstWidth; x++) {
+      uint8_t cols = lut.colSpan[x];
+      uint32_t colRecip = lut.colWeight[x];
+      uint32_t sumR = 0, sumG = 0, sumB = 0;
+
+      for (uint8_t dy = 0; dy < rows; dy++) {
+        const uint16_t* p = srcRow + (uint32_t)dy * lut.srcStride + lut.col[x];
+        uint8_t dx = 0;
+
+        for (; dx + 2 <= cols; dx += 2) {
+          uint32_t pair, r, g, b;
+          memcpy(&pair, p + dx, 4);
+          unpackRGB565x2(pair, r, g, b);
+          sumR += r;
+          sumG += g;
+          sumB += b;
+        }
+
+        if (dx < cols) {
+          uint32_t r, g, b;
+          unpackRGB565x2(p[dx], r, g, b);
+          sumR += r;
+          sumG += g;
+          sumB += b;
+        }
+      }
+
+      // Fold lanes, then divide by the box size via Q15 reciprocals
+      sumR = (sumR & 0xFFFF) + (sumR >> 16);
+      sumG = (sumG & 0xFFFF) + (sumG >> 16);
+      sumB = (sumB & 0xFFFF) + (sumB >> 16);
+
+      out.put((((sumR * colRecip + 16384) >> 15) * rowRecip + 16384) >> 15,
+              (((sumG * colRecip + 16384) >> 15) * rowRecip + 16384) >> 15,
+              (((sumB * colRecip + 16384) >> 15) * rowRecip + 16384) >> 15);
+    }
+  }
+}
+
+/**
+ * Run the kernel selected by the LUT's mode with the given writer
+ */
+template <typename Writer>
+static inline void resizeWithWriter(const uint16_t* src, Writer& out, const ResizeLUT& lut) {
+  switch (lut.mode) {
+    case RESIZE_BILINEAR:
+      resizeBilinearRGB565(src, out, lut);
+      break;
+    case RESIZE_AREA:
+      resizeAreaRGB565(src, out, lut);
+      break;
+    default:
+      resizeNearestRGB565(src, out, lut);
+      break;
+  }
+}
+
+/**
+ * Resize an RGB565 frame window to RGB888 using a prepared LUT
+ */
+static inline bool resizeRGB565toRGB888(const uint8_t* src, uint8_t* dst, const ResizeLUT& lut) {
+  if (!lut.valid || src == nullptr || dst == nullptr) {
+    return false;
+  }
+
+  ByteWriter<0> out(dst);
+  resizeWithWriter((const uint16_t*)src, out, lut);
+
+  return true;
+}
+
+/**
+ * Resize an RGB565 frame window straight into a model input tensor,
+ * quantizing each byte on the way. dst must hold
+ * dstWidth * dstHeight * 3 elements of the input format.
+ */
+static inline bool resizeRGB565toTensor(const uint8_t* src, void* dst,
+                                        const ResizeLUT& lut,
+                                        const InputQuantization& quant) {
+  if (!lut.valid || src == nullptr || dst == nullptr) {
+    return false;
+  }
+
+  const uint16_t* src16 = (const uint16_t*)src;
+
+  if (quant.format == INPUT_FORMAT_FLOAT32) {
+    FloatWriter out(dst, quant.floatScale, quant.floatBias);
+    resizeWithWriter(src16, out, lut);
+  } else if (quant.identity) {
+    ByteWriter<0> out(dst);
+    resizeWithWriter(src16, out, lut);
+  } else if (quant.offset128) {
+    ByteWriter<0x80808080> out(dst);
+    resizeWithWriter(src16, out, lut);
+  } else {
+    TableWriter out(dst, quant.lut);
+    resizeWithWriter(src16, out, lut);
+  }
+
+  return true;
+}
+
+/**
+ * Convert a contiguous RGB565 buffer to RGB888 (no scaling)
+ */
+static inline void convertRGB565BufferToRGB888(const uint8_t* src, uint8_t* dst, uint32_t pixelCount) {
+  const uint16_t* src16 = (const uint16_t*)src;
+  uint32_t i = 0;
+
+  for (; i + 4 <= pixelCount; i += 4) {
+    uint32_t pair01, pair23;
+    memcpy(&pair01, src16 + i, 4);
+    memcpy(&pair23, src16 + i + 2, 4);
+    storeRGB565x4asRGB888(pair01, pair23, dst);
+    dst += 12;
+  }
+
+  for (; i < pixelCount; i++) {
+    storeRGB565asRGB888(src16[i], dst);
+    dst += 3;
+  }
+}
+
+#endif  // IMAGE_PREPROCESSING_H
@@ -0,0 +1,135 @@
+/**
+ * Memory Map
+ *
+ * Linker-section placement for the large static buffers on the STM32H747
+ * (Cortex-M7 core). The Nicla Vision regions:
+ * - DTCM      128 KB at 0x20000000: zero wait states, CPU only (the DCMI
+ *             DMA cannot reach it); for small hot tables and the arena
+ *             of models that fit
+ * - AXI SRAM  512 KB at 0x24000000: default RAM, reachable by every DMA
+ * - D2 SRAM   288 KB at 0x30000000 (SRAM1-3): DMA-friendly, off the AXI bus
+ * - SDRAM     external, boards that have it (Portenta H7, 0xC0000000);
+ *             initialise it (SDRAM.begin()) before the camera starts
+ *
+ * Placement only takes effect with MEMORY_MAP_SECTIONS=1 and a linker
+ * script that defines the output sections (.dtcm_bss, .axi_bss, .d2_bss,
+ * .sdram_bss; see vision_system_guide_complete.md). Otherwise every buffer
+ * stays in .bss and only the DMA alignment applies. The sections are NOLOAD:
+ * buffers placed there are not zeroed at startup.
+ */
+
+#ifndef MEMORY_MAP_H
+#define MEMORY_MAP_H
+
+#include <stdint.h>
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+#define MEMORY_REGION_DEFAULT 0
+#define MEMORY_REGION_DTCM 1
+#define MEMORY_REGION_AXI_SRAM 2
+#define MEMORY_REGION_D2_SRAM 3
+#define MEMORY_REGION_SDRAM 4
+
+#ifndef MEMORY_MAP_SECTIONS
+#define MEMORY_MAP_SECTIONS 0
+#endif
+
+// Camera frame buffers (written by the DCMI DMA)
+#ifndef FRAME_BUFFER_REGION
+#define FRAME_BUFFER_REGION MEMORY_REGION_AXI_SRAM
+#endif
+
+// TFLM tensor arena
+#ifndef TENSOR_ARENA_REGION
+#define TENSOR_ARENA_REGION MEMORY_REGION_AXI_SRAM
+#endif
+
+// Small tables touched per pixel (resize LUT, motion backgrounds)
+#ifndef HOT_DATA_REGION
+#define HOT_DATA_REGION MEMORY_REGION_DTCM
+#endif
+
+// Cortex-M7 D-cache line: DMA buffers are aligned and sized to it so cache
+// maintenance never touches a neighbouring variable
+#define MEMORY_CACHE_LINE 32
+
+#if FRAME_BUFFER_REGION == MEMORY_REGION_DTCM
+#error "FRAME_BUFFER_REGION: the DCMI DMA cannot access DTCM"
+#endif
+
+// ===========================================
+// PLACEMENT
+// ===========================================
+
+#if MEMORY_MAP_SECTIONS
+#define MEMORY_PLACE_0
+#define MEMORY_PLACE_1 __attribute__((section(".dtcm_bss")))
+#define MEMORY_PLACE_2 __attribute__((section(".axi_bss")))
+#define MEMORY_PLACE_3 __attribute__((section(".d2_bss")))
+#define MEMORY_PLACE_4 __attribute__((section(".sdram_bss")))
+#else
+#define MEMORY_PLACE_0
+#define MEMORY_PLACE_1
+#define MEMORY_PLACE_2
+#define MEMORY_PLACE_3
+#define MEMORY_PLACE_4
+#endif
+
+#define MEMORY_PLACE_EXPAND(region) MEMORY_PLACE_##region
+#define MEMORY_PLACE(region) MEMORY_PLACE_EXPAND(region)
+
+// Buffer in a region, aligned for DMA and cache maintenance
+#define DMA_BUFFER(region) MEMORY_PLACE(region) __attribute__((aligned(MEMORY_CACHE_LINE)))
+
+// Round a DMA buffer size up to whole cache lines
+#define MEMORY_CACHE_ALIGN(size) \
+  (((size) + MEMORY_CACHE_LINE - 1) & ~(uint32_t)(MEMORY_CACHE_LINE - 1))
+
+// ===========================================
+// RUNTIME CHECKS
+// ===========================================
+
+/**
+ * Size of a region in bytes (0 if it depends on the board, e.g. SDRAM)
+ */
+static constexpr uint32_t memoryRegionSize(uint8_t region) {
+  return region == MEMORY_REGION_DTCM ? 0x20000UL :
+         region == MEMORY_REGION_AXI_SRAM ? 0x80000UL :
+         region == MEMORY_REGION_D2_SRAM ? 0x48000UL : 0;
+}
+
+/**
+ * Region an address lies in (by the STM32H747 memory map)
+ */
+static inline uint8_t memoryRegionOf(const void* p) {
+  uint32_t address = (uint32_t)(uintptr_t)p;
+
+  if (address >= 0x20000000UL && address < 0x20020000UL) return MEMORY_REGION_DTCM;
+  if (address >= 0x24000000UL && address < 0x24080000UL) return MEMORY_REGION_AXI_SRAM;
+  if (address >= 0x30000000UL && address < 0x30048000UL) return MEMORY_REGION_D2_SRAM;
+  if (address >= 0xC0000000UL && address < 0xD0000000UL) return MEMORY_REGION_SDRAM;
+  return MEMORY_REGION_DEFAULT;
+}
+
+static inline const char* memoryRegionName(uint8_t region) {
+  switch (region) {
+    case MEMORY_REGION_DTCM:     return "DTCM";
+    case MEMORY_REGION_AXI_SRAM: return "AXI SRAM";
+    case MEMORY_REGION_D2_SRAM:  return "D2 SRAM";
+    case MEMORY_REGION_SDRAM:    return "SDRAM";
+    default:                     return "other";
+  }
+}
+
+/**
+ * True if the DCMI/MDMA can write the buffer (anything but the TCMs)
+ */
+static inline bool memoryDmaReachable(const void* p) {
+  uint32_t address = (uint32_t)(uintptr_t)p;
+  return memoryRegionOf(p) != MEMORY_REGION_DTCM && address >= 0x00010000UL;
+}
+
+#endif  // MEMORY_MAP_H
@@ -0,0 +1,58 @@
+/**
+ * Model Op Resolver (placeholder)
+ *
+ * Hand-written stand-in in the layout generate_op_resolver.py emits, until
+ * the real models are converted. Op set of the TFLM 96x96 int8 MobileNet
+ * person-detection example; the arena sizes are that example's 136 KB
+ * kTensorArenaSize, not a measurement, and are used for all three slots.
+ * MODEL_OPS_GENERATED is 0 here, so nicla_vision_camera.ino keeps its
+ * 500 KB arena instead of these sizes.
+ *
+ * Replace it with the generator's output once the .tflite files exist:
+ *   python generate_op_resolver.py person.tflite:PERSON_DETECTION \
+ *       vehicle.tflite:VEHICLE_DETECTION animal.tflite:ANIMAL_DETECTION -o model_ops.h
+ */
+
+#ifndef MODEL_OPS_H
+#define MODEL_OPS_H
+
+#include <tensorflow/lite/micro/micro_mutable_op_resolver.h>
+#include <tensorflow/lite/micro/kernels/conv.h>
+#include <tensorflow/lite/micro/kernels/depthwise_conv.h>
+#include <tensorflow/lite/micro/kernels/pooling.h>
+#include <tensorflow/lite/micro/kernels/softmax.h>
+
+// 1: sizes below come from the models (0 in the checked-in placeholder)
+#define MODEL_OPS_GENERATED 0
+
+// Number of distinct operators across all resident models
+#define MODEL_OP_COUNT 5
+
+// 1 if every model is int8 end to end (int8 input/output tensors)
+#define MODEL_OPS_INT8 1
+
+// Tensor arena required by each model (bytes, 16-byte aligned)
+#define MODEL_ARENA_SIZE_PERSON_DETECTION 139264  // placeholder
+#define MODEL_ARENA_SIZE_VEHICLE_DETECTION 139264  // placeholder
+#define MODEL_ARENA_SIZE_ANIMAL_DETECTION 139264  // placeholder
+
+// Largest single model / all resident models together
+#define MODEL_ARENA_SIZE_MAX 139264
+#define MODEL_ARENA_SIZE_TOTAL 417792
+
+typedef tflite::MicroMutableOpResolver<MODEL_OP_COUNT> ModelOpResolver;
+
+/**
+ * Register exactly the operators used by the resident models
+ * (int8-only kernels where every model runs the op in int8)
+ */
+inline bool registerModelOps(ModelOpResolver& resolver) {
+  if (resolver.AddAveragePool2D(tflite::Register_AVERAGE_POOL_2D_INT8()) != kTfLiteOk) return false;
+  if (resolver.AddConv2D(tflite::Register_CONV_2D_INT8()) != kTfLiteOk) return false;
+  if (resolver.AddDepthwiseConv2D(tflite::Register_DEPTHWISE_CONV_2D_INT8()) != kTfLiteOk) return false;
+  if (resolver.AddReshape() != kTfLiteOk) return false;
+  if (resolver.AddSoftmax(tflite::Register_SOFTMAX_INT8()) != kTfLiteOk) return false;
+  return true;
+}
+
+#endif  // MODEL_OPS_H
@@ -18,6 +18,7 @@
 #define MODEL_DATA_H
 
 #include <stdint.h>
+#include "detection_postprocess.h"
 
 // ===========================================
 // MODEL METADATA
@@ -30,7 +31,7 @@
 #define MODEL_INPUT_HEIGHT 96
 #define MODEL_INPUT_CHANNELS 3
 #define MODEL_NUM_CLASSES 3
-#define MODEL_QUANTIZED true
+#define MODEL_QUANTIZED true  // Full int8: model_ops.h then uses int8-only kernels
 
 // ===========================================
 // MODEL DATA
@@ -71,7 +72,8 @@ const char* model_class_labels[] = {
 #define MODEL_INPUT_MEAN 0.0f
 #define MODEL_INPUT_STD 255.0f
 
-// Output scaling parameters (for quantized models)
+// Output scaling parameters (for quantized models whose output tensor
+// carries no quantization parameters)
 #define MODEL_OUTPUT_SCALE 1.0f
 #define MODEL_OUTPUT_ZERO_POINT 0
 
@@ -101,34 +103,25 @@ void modelPreprocessInput(uint8_t* input, uint8_t* output) {
  * Override default postprocessing for model-specific output handling
  */
 void modelPostprocessOutput(TfLiteTensor* output, DetectionResult* result) {
-  // Default implementation: find max confidence
+  // Default implementation: find max confidence (in the quantized domain
+  // for int8/uint8 outputs)
   // Customize for your model's output format
 
-  float maxConfidence = -1.0f;
-  int detectedClass = -1;
+  TensorView scores;
+  scores.data = output->data.data;
+  scores.scale = output->params.scale > 0.0f ? output->params.scale : MODEL_OUTPUT_SCALE;
+  scores.zeroPoint = output->params.scale > 0.0f ? output->params.zero_point : MODEL_OUTPUT_ZERO_POINT;
+  scores.type = output->type == kTfLiteInt8 ? TENSOR_ELEMENT_INT8 :
+                output->type == kTfLiteUInt8 ? TENSOR_ELEMENT_UINT8 : TENSOR_ELEMENT_FLOAT32;
 
   int numOutputs = output->dims->data[output->dims->size - 1];
+  uint8_t detectedClass = 0;
+  float maxConfidence = 0.0f;
 
-  for (int i = 0; i < min(numOutputs, MODEL_NUM_CLASSES); i++) {
-    float confidence;
-
-    if (output->type == kTfLiteUInt8) {
-      // Quantized model
-      confidence = (output->data.uint8[i] - MODEL_OUTPUT_ZERO_POINT) * MODEL_OUTPUT_SCALE;
-    } else {
-      // Float model
-      confidence = output->data.f[i];
-    }
-
-    if (confidence > maxConfidence) {
-      maxConfidence = confidence;
-      detectedClass = i;
-    }
-  }
-
+  result->valid = decodeClassification(scores, min(numOutputs, MODEL_NUM_CLASSES),
+                                       MODEL_DETECTION_THRESHOLD, detectedClass, maxConfidence);
   result->classId = detectedClass;
   result->confidence = maxConfidence;
-  result->valid = (maxConfidence >= MODEL_DETECTION_THRESHOLD);
 }
 
 /**
@@ -0,0 +1,266 @@
+/**
+ * Motion Gate
+ *
+ * Cheap change detector run on each RGB565 frame before inference:
+ * - The frame is reduced to a grid of block luma means, sampling a sparse
+ *   pixel lattice inside every block (a few thousand pixels per frame)
+ * - Each block is compared with an exponential moving average background
+ * - Inference only runs when enough blocks changed; the bounding box of the
+ *   changed blocks becomes the region of interest handed to the model
+ *
+ * A frame is forced through every maxSkippedFrames so objects that stopped
+ * moving are still re-checked. Background learning is slower on moving
+ * blocks so a passing object is not absorbed immediately. The per-block
+ * change mask of the last frame is kept for the tile scheduler.
+ */
+
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include <stdint.h>
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+// Block edge in source pixels and sampling step inside a block
+#ifndef MOTION_BLOCK_SIZE
+#define MOTION_BLOCK_SIZE 16
+#endif
+
+#ifndef MOTION_SAMPLE_STEP
+#define MOTION_SAMPLE_STEP 4
+#endif
+
+// Largest grid supported (640x480 at 16 px blocks)
+#ifndef MOTION_MAX_BLOCKS
+#define MOTION_MAX_BLOCKS 1200
+#endif
+
+struct MotionGateConfig {
+  uint8_t blockThreshold;     // Luma change (0-255) for a block to count as moving
+  uint16_t minBlocks;         // Moving blocks needed to run inference
+  uint8_t learnShift;         // Background EMA rate: 1 / 2^learnShift per frame
+  uint16_t roiMargin;         // Pixels added around the moving blocks
+  uint16_t minRoiSize;        // Smallest ROI edge (avoid upscaling tiny crops)
+  uint16_t maxSkippedFrames;  // Force an inference after this many skips
+};
+
+/**
+ * Region of interest in frame pixels
+ */
+struct MotionRegion {
+  uint16_t x;
+  uint16_t y;
+  uint16_t width;
+  uint16_t height;
+  uint16_t movingBlocks;
+};
+
+/**
+ * Per-camera background model
+ */
+struct MotionGate {
+  uint16_t background[MOTION_MAX_BLOCKS];  // Block luma, Q4
+  uint32_t movingMask[(MOTION_MAX_BLOCKS + 31) / 32];  // Changed in the last frame
+  uint16_t blocksX;
+  uint16_t blocksY;
+  uint16_t skippedFrames;
+  bool initialized;
+
+  MotionGate() : blocksX(0), blocksY(0), skippedFrames(0), initialized(false) {
+    clearMask();
+  }
+
+  void reset() {
+    initialized = false;
+    skippedFrames = 0;
+    clearMask();
+  }
+
+  void clearMask() {
+    for (uint16_t i = 0; i < (MOTION_MAX_BLOCKS + 31) / 32; i++) {
+      movingMask[i] = 0;
+    }
+  }
+
+  bool blockMoving(uint16_t bx, uint16_t by) const {
+    uint32_t index = (uint32_t)by * blocksX + bx;
+    return (movingMask[index >> 5] >> (index & 31)) & 1;
+  }
+};
+
+// ===========================================
+// BLOCK LUMA
+// ===========================================
+
+/**
+ * BT.601 luma of an RGB565 pixel (0-255)
+ */
+static inline uint32_t motionLuma(uint16_t pixel) {
+  uint32_t r = (pixel >> 8) & 0xF8;
+  uint32_t g = (pixel >> 3) & 0xFC;
+  uint32_t b = (pixel << 3) & 0xF8;
+  return (r * 77 + g * 150 + b * 29) >> 8;
+}
+
+/**
+ * Mean luma of one block, Q4
+ */
+static inline uint16_t motionBlockLuma(const uint16_t* frame, uint16_t stride,
+                                       uint16_t x0, uint16_t y0) {
+  const uint32_t samples = (MOTION_BLOCK_SIZE / MOTION_SAMPLE_STEP) *
+                           (MOTION_BLOCK_SIZE / MOTION_SAMPLE_STEP);
+  uint32_t sum = 0;
+
+  for (uint16_t y = 0; y < MOTION_BLOCK_SIZE; y += MOTION_SAMPLE_STEP) {
+    const uint16_t* row = frame + (uint32_t)(y0 + y) * stride + x0;
+    for (uint16_t x = 0; x < MOTION_BLOCK_SIZE; x += MOTION_SAMPLE_STEP) {
+      sum += motionLuma(row[x]);
+    }
+  }
+
+  return (uint16_t)((sum << 4) / samples);
+}
+
+// ===========================================
+// REGION OF INTEREST
+// ===========================================
+
+/**
+ * Grow [start, start + size) to at least `target`, centred, inside [0, limit)
+ */
+static inline void motionGrowSpan(uint16_t& start, uint16_t& size, uint32_t target,
+                                  uint16_t limit) {
+  if (target > limit) target = limit;
+  if (size >= target) return;
+
+  int32_t grown = (int32_t)start - (int32_t)(target - size) / 2;
+  if (grown < 0) grown = 0;
+  if (grown + (int32_t)target > limit) grown = limit - target;
+
+  start = (uint16_t)grown;
+  size = (uint16_t)target;
+}
+
+/**
+ * Expand the moving-block box by the margin and minimum size, then match
+ * the model input's aspect ratio so the crop is not distorted
+ */
+static inline void motionShapeRegion(MotionRegion& region, uint16_t width, uint16_t height,
+                                     const MotionGateConfig& cfg,
+                                     uint16_t aspectW, uint16_t aspectH) {
+  motionGrowSpan(region.x, region.width, (uint32_t)region.width + 2 * cfg.roiMargin, width);
+  motionGrowSpan(region.y, region.height, (uint32_t)region.height + 2 * cfg.roiMargin, height);
+  motionGrowSpan(region.x, region.width, cfg.minRoiSize, width);
+  motionGrowSpan(region.y, region.height, cfg.minRoiSize, height);
+
+  if (aspectW == 0 || aspectH == 0) return;
+
+  // Widen whichever side is short of the target aspect
+  uint32_t wantWidth = ((uint32_t)region.height * aspectW + aspectH - 1) / aspectH;
+  if (wantWidth > region.width) {
+    motionGrowSpan(region.x, region.width, wantWidth, width);
+  } else {
+    uint32_t wantHeight = ((uint32_t)region.width * aspectH + aspectW - 1) / aspectW;
+    motionGrowSpan(region.y, region.height, wantHeight, height);
+  }
+}
+
+// ===========================================
+// GATE
+// ===========================================
+
+/**
+ * Update the background with a new frame and decide whether to run
+ * inference. Returns true to run it; `region` then holds the crop (full
+ * frame on the first frame and on forced re-checks).
+ * aspectW/aspectH: model input width/height, used to shape the crop.
+ */
+static inline bool updateMotionGate(MotionGate& gate, const uint8_t* frame,
+                                    uint16_t width, uint16_t height,
+                                    const MotionGateConfig& cfg,
+                                    uint16_t aspectW, uint16_t aspectH,
+                                    MotionRegion& region) {
+  const uint16_t* pixels = (const uint16_t*)frame;
+  uint16_t blocksX = width / MOTION_BLOCK_SIZE;
+  uint16_t blocksY = height / MOTION_BLOCK_SIZE;
+
+  region.x = 0;
+  region.y = 0;
+  region.width = width;
+  region.height = height;
+  region.movingBlocks = 0;
+  gate.clearMask();
+
+  if ((uint32_t)blocksX * blocksY > MOTION_MAX_BLOCKS || blocksX == 0 || blocksY == 0) {
+    return true;  // Unsupported geometry: never gate
+  }
+
+  // First frame (or new geometry): seed the background, run inference
+  if (!gate.initialized || gate.blocksX != blocksX || gate.blocksY != blocksY) {
+    for (uint16_t by = 0; by < blocksY; by++) {
+      for (uint16_t bx = 0; bx < blocksX; bx++) {
+        gate.background[by * blocksX + bx] =
+          motionBlockLuma(pixels, width, bx * MOTION_BLOCK_SIZE, by * MOTION_BLOCK_SIZE);
+      }
+    }
+    gate.blocksX = blocksX;
+    gate.blocksY = blocksY;
+    gate.skippedFrames = 0;
+    gate.initialized = true;
+    return true;
+  }
+
+  const int32_t threshold = (int32_t)cfg.blockThreshold << 4;
+  uint16_t minX = blocksX, minY = blocksY, maxX = 0, maxY = 0;
+  uint16_t moving = 0;
+
+  for (uint16_t by = 0; by < blocksY; by++) {
+    for (uint16_t bx = 0; bx < blocksX; bx++) {
+      uint16_t& bg = gate.background[by * blocksX + bx];
+      int32_t current = motionBlockLuma(pixels, width, bx * MOTION_BLOCK_SIZE,
+                                        by * MOTION_BLOCK_SIZE);
+      int32_t delta = current - (int32_t)bg;
+      bool changed = (delta > threshold) || (delta < -threshold);
+
+      // Moving blocks are learned 4x slower
+      uint8_t shift = changed ? cfg.learnShift + 2 : cfg.learnShift;
+      int32_t step = (delta >= 0) ? (delta >> shift) : -((-delta) >> shift);
+      bg = (uint16_t)((int32_t)bg + step);
+
+      if (changed) {
+        uint32_t index = (uint32_t)by * blocksX + bx;
+        gate.movingMask[index >> 5] |= 1UL << (index & 31);
+        moving++;
+        if (bx < minX) minX = bx;
+        if (bx > maxX) maxX = bx;
+        if (by < minY) minY = by;
+        if (by > maxY) maxY = by;
+      }
+    }
+  }
+
+  region.movingBlocks = moving;
+
+  if (moving < cfg.minBlocks) {
+    if (gate.skippedFrames < cfg.maxSkippedFrames) {
+      gate.skippedFrames++;
+      return false;
+    }
+    gate.skippedFrames = 0;
+    return true;  // Forced full-frame re-check
+  }
+
+  gate.skippedFrames = 0;
+
+  region.x = minX * MOTION_BLOCK_SIZE;
+  region.y = minY * MOTION_BLOCK_SIZE;
+  region.width = (maxX - minX + 1) * MOTION_BLOCK_SIZE;
+  region.height = (maxY - minY + 1) * MOTION_BLOCK_SIZE;
+  motionShapeRegion(region, width, height, cfg, aspectW, aspectH);
+
+  return true;
+}
+
+#endif  // MOTION_GATE_H
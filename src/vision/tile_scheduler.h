@@ -0,0 +1,221 @@
+/**
+ * Tile Scheduler
+ *
+ * Fine-scale pass for small, distant objects: the frame is covered by
+ * overlapping tiles at model resolution (1:1 source pixels), and a few of
+ * them are run per frame next to the coarse full-frame / motion-ROI pass:
+ * - Tiles gain priority from moving motion-gate blocks inside them and
+ *   from tracked objects small enough to fit in a tile
+ * - Tiles with no activity for TILING_IDLE_FRAMES are skipped; optionally
+ *   every tile is revisited after TILING_REFRESH_FRAMES
+ * - Longer-waiting tiles win ties, so active tiles take turns
+ *
+ * At most maxTiles tiles run per frame, which bounds the worst-case cost.
+ * Tile regions are DetectionFrames, so the decoders map detections into
+ * frame pixels and one NMS pass merges tiles and the coarse pass.
+ */
+
+#ifndef TILE_SCHEDULER_H
+#define TILE_SCHEDULER_H
+
+#include <stdint.h>
+#include "detection_postprocess.h"
+#include "motion_gate.h"
+
+// ===========================================
+// CONFIGURATION
+// ===========================================
+
+#ifndef TILING_MAX_TILES
+#define TILING_MAX_TILES 16
+#endif
+
+#ifndef TILING_IDLE_FRAMES
+#define TILING_IDLE_FRAMES 8         // Frames after the last activity a tile stays eligible
+#endif
+
+#ifndef TILING_REFRESH_FRAMES
+#define TILING_REFRESH_FRAMES 0      // Revisit idle tiles after this many frames (0 = never)
+#endif
+
+// select() marks taken tiles in a 32-bit mask
+static_assert(TILING_MAX_TILES <= 32, "TILING_MAX_TILES must fit the 32-bit select() mask");
+
+#define TILING_MOTION_WEIGHT 4       // Priority per moving block in the tile
+#define TILING_TRACK_WEIGHT 32       // Priority per small tracked object in the tile
+
+// ===========================================
+// SCHEDULER
+// ===========================================
+
+struct TileState {
+  DetectionFrame region;
+  uint32_t lastActive;         // Frame of the last motion / track inside
+  uint32_t lastRun;
+  uint16_t activity;           // Priority gathered this frame
+  bool seen;                   // Had activity at least once
+};
+
+class TileScheduler {
+ public:
+  TileScheduler() : _count(0), _frame(0) {}
+
+  /**
+   * Lay out overlapping tiles over the frame, spread evenly so every
+   * neighbour overlaps by at least `overlap` pixels
+   * @return false if the layout needs more than TILING_MAX_TILES tiles
+   */
+  bool configure(uint16_t frameWidth, uint16_t frameHeight,
+                 uint16_t tileWidth, uint16_t tileHeight, uint16_t overlap) {
+    _count = 0;
+    if (tileWidth == 0 || tileHeight == 0 || overlap >= tileWidth || overlap >= tileHeight) {
+      return false;
+    }
+
+    uint16_t cols = spans(frameWidth, tileWidth, overlap);
+    uint16_t rows = spans(frameHeight, tileHeight, overlap);
+    if ((uint32_t)cols * rows > TILING_MAX_TILES) {
+      return false;
+    }
+
+    uint16_t width = tileWidth < frameWidth ? tileWidth : frameWidth;
+    uint16_t height = tileHeight < frameHeight ? tileHeight : frameHeight;
+
+    for (uint16_t r = 0; r < rows; r++) {
+      for (uint16_t c = 0; c < cols; c++) {
+        TileState& tile = _tiles[_count++];
+        tile.region.x = cols > 1 ? (uint16_t)((uint32_t)c * (frameWidth - width) / (cols - 1)) : 0;
+        tile.region.y = rows > 1 ? (uint16_t)((uint32_t)r * (frameHeight - height) / (rows - 1)) : 0;
+        tile.region.width = width;
+        tile.region.height = height;
+        tile.lastActive = 0;
+        tile.lastRun = 0;
+        tile.activity = 0;
+        tile.seen = false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Start a frame: clears this frame's activity
+   */
+  void beginFrame() {
+    _frame++;
+    for (uint8_t i = 0; i < _count; i++) {
+      _tiles[i].activity = 0;
+    }
+  }
+
+  /**
+   * Credit the moving blocks of the last motion-gate update to the tiles
+   * containing their centres
+   */
+  void markMotion(const MotionGate& gate) {
+    for (uint16_t by = 0; by < gate.blocksY; by++) {
+      for (uint16_t bx = 0; bx < gate.blocksX; bx++) {
+        if (!gate.blockMoving(bx, by)) continue;
+        mark(bx * MOTION_BLOCK_SIZE + MOTION_BLOCK_SIZE / 2,
+             by * MOTION_BLOCK_SIZE + MOTION_BLOCK_SIZE / 2, TILING_MOTION_WEIGHT);
+      }
+    }
+  }
+
+  /**
+   * Credit a tracked object; only boxes that fit in a tile count, larger
+   * ones are resolved by the coarse pass
+   */
+  void markBox(const Detection& box) {
+    if (_count == 0 ||
+        box.x1 - box.x0 > _tiles[0].region.width || box.y1 - box.y0 > _tiles[0].region.height) {
+      return;
+    }
+    mark((box.x0 + box.x1) / 2, (box.y0 + box.y1) / 2, TILING_TRACK_WEIGHT);
+  }
+
+  /**
+   * Pick up to maxTiles eligible tiles, highest priority first
+   * @return number of tiles written to `tiles`
+   */
+  uint8_t select(uint8_t* tiles, uint8_t maxTiles) const {
+    uint8_t selected = 0;
+    uint32_t taken = 0;
+
+    while (selected < maxTiles) {
+      int16_t best = -1;
+      uint32_t bestScore = 0;
+
+      for (uint8_t i = 0; i < _count; i++) {
+        if (taken & (1UL << i)) continue;
+        uint32_t score = priority(_tiles[i]);
+        if (score > bestScore) {
+          bestScore = score;
+          best = i;
+        }
+      }
+
+      if (best < 0) break;
+      taken |= 1UL << best;
+      tiles[selected++] = (uint8_t)best;
+    }
+    return selected;
+  }
+
+  /**
+   * Record that a tile was run this frame
+   */
+  void ran(uint8_t tile) {
+    _tiles[tile].lastRun = _frame;
+  }
+
+  const DetectionFrame& region(uint8_t tile) const { return _tiles[tile].region; }
+  uint8_t count() const { return _count; }
+
+ private:
+  static uint16_t spans(uint16_t length, uint16_t tile, uint16_t overlap) {
+    if (length <= tile) return 1;
+    uint16_t step = tile - overlap;
+    return (uint16_t)((length - tile + step - 1) / step + 1);
+  }
+
+  void mark(int32_t x, int32_t y, uint16_t weight) {
+    for (uint8_t i = 0; i < _count; i++) {
+      TileState& tile = _tiles[i];
+      const DetectionFrame& r = tile.region;
+      if (x >= r.x && x < r.x + r.width && y >= r.y && y < r.y + r.height) {
+        tile.activity += weight;
+        tile.lastActive = _frame;
+        tile.seen = true;
+      }
+    }
+  }
+
+  /**
+   * 0 = skip. Activity this frame dominates; waiting time breaks ties and
+   * keeps recently active tiles in rotation.
+   */
+  uint32_t priority(const TileState& tile) const {
+    uint32_t waited = _frame - tile.lastRun;
+    if (waited == 0) {
+      return 0;
+    }
+
+    bool recent = tile.seen && _frame - tile.lastActive <= TILING_IDLE_FRAMES;
+#if TILING_REFRESH_FRAMES > 0
+    bool refresh = waited >= TILING_REFRESH_FRAMES;
+#else
+    bool refresh = false;
+#endif
+    if (!recent && !refresh) {
+      return 0;
+    }
+
+    return ((uint32_t)tile.activity << 8) + (waited < 255 ? waited : 255);
+  }
+
+  TileState _tiles[TILING_MAX_TILES];
+  uint8_t _count;
+  uint32_t _frame;
+};
+
+#endif  // TILE_SCHEDULER_H